@@ -0,0 +1,58 @@
+//
+// Copyright (c) 2021-present, Trail of Bits, Inc.
+// All rights reserved.
+//
+// This source code is licensed in accordance with the terms specified in
+// the LICENSE file found in the root directory of this source tree.
+//
+
+#include "allocationcounter.h"
+
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+#include <malloc.h>
+
+namespace {
+
+std::atomic<std::size_t> allocation_count{0};
+std::atomic<std::size_t> heap_size{0};
+
+void releaseMemory(void *ptr) noexcept {
+  if (ptr == nullptr) {
+    return;
+  }
+
+  heap_size.fetch_sub(malloc_usable_size(ptr), std::memory_order_relaxed);
+  std::free(ptr);
+}
+
+}
+
+void *operator new(std::size_t size) {
+  allocation_count.fetch_add(1, std::memory_order_relaxed);
+
+  auto ptr = std::malloc(size != 0 ? size : 1);
+  if (ptr == nullptr) {
+    throw std::bad_alloc();
+  }
+
+  heap_size.fetch_add(malloc_usable_size(ptr), std::memory_order_relaxed);
+  return ptr;
+}
+
+void operator delete(void *ptr) noexcept { releaseMemory(ptr); }
+void operator delete(void *ptr, std::size_t) noexcept { releaseMemory(ptr); }
+
+namespace btfparse {
+
+std::size_t getAllocationCount() noexcept {
+  return allocation_count.load(std::memory_order_relaxed);
+}
+
+std::size_t getHeapSize() noexcept {
+  return heap_size.load(std::memory_order_relaxed);
+}
+
+} // namespace btfparse
@@ -0,0 +1,24 @@
+//
+// Copyright (c) 2021-present, Trail of Bits, Inc.
+// All rights reserved.
+//
+// This source code is licensed in accordance with the terms specified in
+// the LICENSE file found in the root directory of this source tree.
+//
+
+#pragma once
+
+#include <cstddef>
+
+namespace btfparse {
+
+// Returns how many times the global operator new has been called so far.
+// The replacement operators live in their own translation unit so that
+// they are never inlined into the benchmarks
+std::size_t getAllocationCount() noexcept;
+
+// Returns how many bytes are currently allocated through the global
+// operator new, including the allocator rounding
+std::size_t getHeapSize() noexcept;
+
+} // namespace btfparse
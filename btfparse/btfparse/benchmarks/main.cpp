@@ -0,0 +1,773 @@
+//
+// Copyright (c) 2021-present, Trail of Bits, Inc.
+// All rights reserved.
+//
+// This source code is licensed in accordance with the terms specified in
+// the LICENSE file found in the root directory of this source tree.
+//
+
+#include "allocationcounter.h"
+#include "btf.h"
+#include "btfbuilder.h"
+#include "btfheadergenerator.h"
+#include "btfstringtable.h"
+
+#include <benchmark/benchmark.h>
+#include <btfparse/ibtflayout.h>
+
+#include <cstdlib>
+#include <fstream>
+#include <iterator>
+#include <random>
+
+namespace btfparse {
+
+namespace {
+
+// Path of the BTF blob used by the kernel corpus
+const std::string kKernelBTFPathVariable{"BTFPARSE_BENCHMARK_BTF_PATH"};
+const std::string kDefaultKernelBTFPath{"/sys/kernel/btf/vmlinux"};
+
+const std::uint32_t kSyntheticStructCount{10000U};
+const std::size_t kLookupCount{100000U};
+
+enum class Corpus {
+  Synthetic,
+  Kernel,
+};
+
+enum class GeneratorPhase {
+  SaveBTFTypeMap,
+  AdjustTypeNames,
+  ScanTypes,
+  MaterializePadding,
+  CreateTypeTree,
+  AdjustTypedefDependencyLoops,
+  CreateTypeQueue,
+  GenerateHeader,
+};
+
+const auto kGeneratorPhaseCount{
+    static_cast<int>(GeneratorPhase::GenerateHeader) + 1};
+
+void setHeapSizeCounter(benchmark::State &state, std::size_t heap_size) {
+  state.counters["heap_bytes"] = benchmark::Counter(
+      static_cast<double>(heap_size), benchmark::Counter::kDefaults,
+      benchmark::Counter::kIs1024);
+}
+
+void setAllocationCounter(benchmark::State &state, std::size_t allocations) {
+  state.counters["allocations"] = benchmark::Counter(
+      static_cast<double>(allocations), benchmark::Counter::kAvgIterations);
+}
+
+// Every struct comes with a pointer to itself, a typedef, a const
+// qualifier, an enum and a function prototype, so that all the common
+// parsers and generator paths are exercised
+std::vector<std::uint8_t> generateSyntheticCorpus() {
+  BTFBuilder builder;
+
+  auto int_id = builder.addInt("int", 4);
+  auto long_id = builder.addInt("long int", 8);
+
+  for (std::uint32_t i = 0; i < kSyntheticStructCount; ++i) {
+    auto index = std::to_string(i);
+
+    // The struct is immediately followed by the pointer to itself
+    auto struct_id = builder.nextTypeID();
+    builder.addStruct("struct_" + index, 24,
+                      {
+                          {"value", int_id, 0},
+                          {"next", struct_id + 1, 64},
+                          {"counter", long_id, 128},
+                      });
+
+    auto ptr_id = builder.addPtr(struct_id);
+
+    auto typedef_id =
+        builder.addType("struct_" + index + "_t", BTFKind::Typedef, 0,
+                        struct_id);
+
+    builder.addType({}, BTFKind::Const, 0, typedef_id);
+
+    std::vector<std::uint32_t> enum_value_list;
+    for (std::uint32_t value = 0; value < 4; ++value) {
+      enum_value_list.push_back(
+          builder.addString("ENUM_" + index + "_" + std::to_string(value)));
+
+      enum_value_list.push_back(value);
+    }
+
+    builder.addType("enum_" + index, BTFKind::Enum, 4, 4, enum_value_list);
+    builder.addType({}, BTFKind::FuncProto, 2, int_id,
+                    {builder.addString("self"), ptr_id, 0, long_id});
+  }
+
+  return builder.build();
+}
+
+std::vector<std::uint8_t> readKernelCorpus() {
+  auto path = kDefaultKernelBTFPath;
+  if (auto env_var = std::getenv(kKernelBTFPathVariable.c_str());
+      env_var != nullptr) {
+    path = env_var;
+  }
+
+  std::ifstream input_file(path, std::ios::binary);
+  if (!input_file) {
+    return {};
+  }
+
+  return std::vector<std::uint8_t>(std::istreambuf_iterator<char>(input_file),
+                                   std::istreambuf_iterator<char>());
+}
+
+// Returns nullptr if the corpus is not available, after skipping the
+// benchmark
+const std::vector<std::uint8_t> *getCorpus(benchmark::State &state) {
+  static const auto kSyntheticCorpus{generateSyntheticCorpus()};
+  static const auto kKernelCorpus{readKernelCorpus()};
+
+  if (static_cast<Corpus>(state.range(0)) == Corpus::Synthetic) {
+    return &kSyntheticCorpus;
+  }
+
+  if (kKernelCorpus.empty()) {
+    state.SkipWithError(("Failed to read the kernel corpus. Set the " +
+                         kKernelBTFPathVariable + " environment variable")
+                            .c_str());
+
+    return nullptr;
+  }
+
+  return &kKernelCorpus;
+}
+
+// Repeats the initialization steps of the BTF class, so that individual
+// parsing stages can be measured in isolation
+BTFFileList createBTFFileList(const std::vector<std::uint8_t> &corpus) {
+  auto file_reader_res =
+      IFileReader::createFromBuffer(corpus.data(), corpus.size());
+
+  if (file_reader_res.failed()) {
+    throw std::runtime_error(file_reader_res.takeError().toString());
+  }
+
+  BTFFile btf_file;
+  btf_file.file_reader = file_reader_res.takeValue();
+
+  auto &file_reader = *btf_file.file_reader.get();
+
+  auto opt_error = BTF::detectEndianness(btf_file.little_endian, file_reader);
+  if (opt_error.has_value()) {
+    throw std::runtime_error(opt_error->toString());
+  }
+
+  file_reader.setEndianness(btf_file.little_endian);
+
+  auto btf_header_res = BTF::readBTFHeader(file_reader);
+  if (btf_header_res.failed()) {
+    throw std::runtime_error(btf_header_res.takeError().toString());
+  }
+
+  btf_file.btf_header = btf_header_res.takeValue();
+
+  BTFFileList btf_file_list;
+  btf_file_list.push_back(std::move(btf_file));
+
+  return btf_file_list;
+}
+
+BTFStringTable createStringTable(const BTFFileList &btf_file_list) {
+  auto string_table_res = BTFStringTable::create(btf_file_list);
+  if (string_table_res.failed()) {
+    throw std::runtime_error(string_table_res.takeError().toString());
+  }
+
+  return string_table_res.takeValue();
+}
+
+IBTF::Ptr createBTF(const std::vector<std::uint8_t> &corpus,
+                    const BTFOptions &options) {
+  auto btf_res = IBTF::createFromBuffer(corpus.data(), corpus.size(), options);
+  if (btf_res.failed()) {
+    throw std::runtime_error(btf_res.takeError().toString());
+  }
+
+  return btf_res.takeValue();
+}
+
+std::vector<std::uint32_t> generateTypeIDList(const IBTF &btf, bool random) {
+  std::vector<std::uint32_t> type_id_list(kLookupCount);
+
+  std::mt19937 generator;
+  std::uniform_int_distribution<std::uint32_t> distribution(1, btf.count());
+
+  for (std::size_t i = 0; i < type_id_list.size(); ++i) {
+    type_id_list[i] =
+        random ? distribution(generator)
+               : static_cast<std::uint32_t>(i % btf.count()) + 1U;
+  }
+
+  return type_id_list;
+}
+
+bool runGeneratorPhase(BTFHeaderGenerator::Context &context,
+                       GeneratorPhase phase, const IBTF::Ptr &btf) {
+  switch (phase) {
+  case GeneratorPhase::SaveBTFTypeMap:
+    return BTFHeaderGenerator::saveBTFTypeMap(context, btf);
+
+  case GeneratorPhase::AdjustTypeNames:
+    return BTFHeaderGenerator::adjustTypeNames(context);
+
+  case GeneratorPhase::ScanTypes:
+    BTFHeaderGenerator::scanTypes(context);
+    return true;
+
+  case GeneratorPhase::MaterializePadding:
+    return BTFHeaderGenerator::materializePadding(context);
+
+  case GeneratorPhase::CreateTypeTree:
+    return BTFHeaderGenerator::createTypeTree(context);
+
+  case GeneratorPhase::AdjustTypedefDependencyLoops:
+    return BTFHeaderGenerator::adjustTypedefDependencyLoops(context);
+
+  case GeneratorPhase::CreateTypeQueue:
+    return BTFHeaderGenerator::createTypeQueue(context);
+
+  case GeneratorPhase::GenerateHeader: {
+    return BTFHeaderGenerator::generateHeader(
+        context, BTFHeaderGeneratorOptions{},
+        [](std::string_view chunk) -> bool {
+          benchmark::DoNotOptimize(chunk.data());
+          return true;
+        });
+  }
+  }
+
+  return false;
+}
+
+void BM_StringTableLookup(benchmark::State &state) {
+  auto corpus = getCorpus(state);
+  if (corpus == nullptr) {
+    return;
+  }
+
+  auto btf_file_list = createBTFFileList(*corpus);
+  auto string_table = createStringTable(btf_file_list);
+
+  // Look up every string in the section, in order
+  const auto &btf_header = btf_file_list.front().btf_header;
+  auto string_section_offset = btf_header.hdr_len + btf_header.str_off;
+
+  std::vector<std::uint64_t> offset_list{0};
+  for (std::uint32_t i = 1; i < btf_header.str_len; ++i) {
+    if (corpus->at(string_section_offset + i - 1) == 0) {
+      offset_list.push_back(i);
+    }
+  }
+
+  std::size_t allocations{};
+
+  for (auto _ : state) {
+    auto allocation_count_start = getAllocationCount();
+
+    for (const auto &offset : offset_list) {
+      auto string_res = string_table.get(offset);
+      if (string_res.failed()) {
+        state.SkipWithError(string_res.takeError().toString().c_str());
+        return;
+      }
+
+      benchmark::DoNotOptimize(string_res.takeValue());
+    }
+
+    allocations += getAllocationCount() - allocation_count_start;
+  }
+
+  setAllocationCounter(state, allocations);
+  state.SetItemsProcessed(static_cast<std::int64_t>(
+      state.iterations() * static_cast<std::int64_t>(offset_list.size())));
+
+  state.SetBytesProcessed(
+      static_cast<std::int64_t>(state.iterations() * btf_header.str_len));
+}
+
+void BM_ParseTypeSections(benchmark::State &state) {
+  auto corpus = getCorpus(state);
+  if (corpus == nullptr) {
+    return;
+  }
+
+  auto btf_file_list = createBTFFileList(*corpus);
+  auto string_table = createStringTable(btf_file_list);
+
+  BTFOptions options;
+  options.thread_count = static_cast<std::size_t>(state.range(1));
+
+  std::size_t type_count{};
+  std::size_t allocations{};
+
+  for (auto _ : state) {
+    auto allocation_count_start = getAllocationCount();
+
+    auto btf_type_map_res =
+        BTF::parseTypeSections(btf_file_list, string_table, 1, options);
+
+    if (btf_type_map_res.failed()) {
+      state.SkipWithError(btf_type_map_res.takeError().toString().c_str());
+      return;
+    }
+
+    type_count = btf_type_map_res.takeValue().size();
+    allocations += getAllocationCount() - allocation_count_start;
+  }
+
+  setAllocationCounter(state, allocations);
+  state.SetItemsProcessed(static_cast<std::int64_t>(
+      state.iterations() * static_cast<std::int64_t>(type_count)));
+
+  state.SetBytesProcessed(static_cast<std::int64_t>(
+      state.iterations() * btf_file_list.front().btf_header.type_len));
+}
+
+void BM_IndexTypeSections(benchmark::State &state) {
+  auto corpus = getCorpus(state);
+  if (corpus == nullptr) {
+    return;
+  }
+
+  auto btf_file_list = createBTFFileList(*corpus);
+
+  std::size_t type_count{};
+  std::size_t allocations{};
+
+  for (auto _ : state) {
+    auto allocation_count_start = getAllocationCount();
+
+    BTFTypeIndex btf_type_index;
+    auto opt_error = BTF::indexTypeSections(btf_type_index, btf_file_list);
+    if (opt_error.has_value()) {
+      state.SkipWithError(opt_error->toString().c_str());
+      return;
+    }
+
+    type_count = btf_type_index.size();
+    allocations += getAllocationCount() - allocation_count_start;
+  }
+
+  setAllocationCounter(state, allocations);
+  state.SetItemsProcessed(static_cast<std::int64_t>(
+      state.iterations() * static_cast<std::int64_t>(type_count)));
+
+  state.SetBytesProcessed(static_cast<std::int64_t>(
+      state.iterations() * btf_file_list.front().btf_header.type_len));
+}
+
+void BM_CreateFromBuffer(benchmark::State &state) {
+  auto corpus = getCorpus(state);
+  if (corpus == nullptr) {
+    return;
+  }
+
+  BTFOptions options;
+  options.decoding_mode = static_cast<BTFOptions::DecodingMode>(state.range(1));
+
+  std::size_t type_count{};
+  std::size_t allocations{};
+  std::size_t heap_size{};
+
+  for (auto _ : state) {
+    auto allocation_count_start = getAllocationCount();
+    auto heap_size_start = getHeapSize();
+
+    auto btf_res =
+        IBTF::createFromBuffer(corpus->data(), corpus->size(), options);
+
+    if (btf_res.failed()) {
+      state.SkipWithError(btf_res.takeError().toString().c_str());
+      return;
+    }
+
+    auto btf = btf_res.takeValue();
+
+    // The memory retained by the object, measured before it is destroyed
+    heap_size = getHeapSize() - heap_size_start;
+    type_count = btf->count();
+    allocations += getAllocationCount() - allocation_count_start;
+  }
+
+  setAllocationCounter(state, allocations);
+  setHeapSizeCounter(state, heap_size);
+  state.SetItemsProcessed(static_cast<std::int64_t>(
+      state.iterations() * static_cast<std::int64_t>(type_count)));
+
+  state.SetBytesProcessed(static_cast<std::int64_t>(
+      state.iterations() * static_cast<std::int64_t>(corpus->size())));
+}
+
+// Snapshots are validated (size and checksum) when they are opened, but
+// no type is decoded
+void BM_CreateFromSnapshotBuffer(benchmark::State &state) {
+  auto corpus = getCorpus(state);
+  if (corpus == nullptr) {
+    return;
+  }
+
+  auto btf = createBTF(*corpus, BTFOptions{});
+  if (!btf) {
+    state.SkipWithError("Failed to parse the corpus");
+    return;
+  }
+
+  auto snapshot_res = IBTF::createSnapshotBuffer(*btf.get());
+  if (snapshot_res.failed()) {
+    state.SkipWithError(snapshot_res.takeError().toString().c_str());
+    return;
+  }
+
+  auto snapshot = snapshot_res.takeValue();
+
+  std::size_t allocations{};
+
+  for (auto _ : state) {
+    auto allocation_count_start = getAllocationCount();
+
+    auto snapshot_btf_res =
+        IBTF::createFromSnapshotBuffer(snapshot.data(), snapshot.size());
+
+    if (snapshot_btf_res.failed()) {
+      state.SkipWithError(snapshot_btf_res.takeError().toString().c_str());
+      return;
+    }
+
+    benchmark::DoNotOptimize(snapshot_btf_res.takeValue());
+    allocations += getAllocationCount() - allocation_count_start;
+  }
+
+  setAllocationCounter(state, allocations);
+  state.SetItemsProcessed(static_cast<std::int64_t>(
+      state.iterations() * static_cast<std::int64_t>(btf->count())));
+
+  state.SetBytesProcessed(static_cast<std::int64_t>(
+      state.iterations() * static_cast<std::int64_t>(snapshot.size())));
+}
+
+// Lazy instances decode each type on first access, so after the first
+// iteration this measures the cost of the cached lookup path
+void BM_GetTypeRef(benchmark::State &state) {
+  auto corpus = getCorpus(state);
+  if (corpus == nullptr) {
+    return;
+  }
+
+  BTFOptions options;
+  options.decoding_mode = static_cast<BTFOptions::DecodingMode>(state.range(2));
+
+  auto btf = createBTF(*corpus, options);
+  auto type_id_list = generateTypeIDList(*btf, state.range(1) != 0);
+
+  std::size_t allocations{};
+
+  for (auto _ : state) {
+    auto allocation_count_start = getAllocationCount();
+
+    for (const auto &type_id : type_id_list) {
+      benchmark::DoNotOptimize(btf->getTypeRef(type_id));
+    }
+
+    allocations += getAllocationCount() - allocation_count_start;
+  }
+
+  setAllocationCounter(state, allocations);
+  state.SetItemsProcessed(static_cast<std::int64_t>(
+      state.iterations() * static_cast<std::int64_t>(type_id_list.size())));
+}
+
+// Compact instances return the views they decoded when they were created;
+// the other ones build all the views on the first call
+void BM_GetTypeView(benchmark::State &state) {
+  auto corpus = getCorpus(state);
+  if (corpus == nullptr) {
+    return;
+  }
+
+  BTFOptions options;
+  options.decoding_mode = static_cast<BTFOptions::DecodingMode>(state.range(2));
+
+  auto btf = createBTF(*corpus, options);
+  auto type_id_list = generateTypeIDList(*btf, state.range(1) != 0);
+
+  std::size_t allocations{};
+
+  for (auto _ : state) {
+    auto allocation_count_start = getAllocationCount();
+
+    for (const auto &type_id : type_id_list) {
+      benchmark::DoNotOptimize(btf->getTypeView(type_id));
+    }
+
+    allocations += getAllocationCount() - allocation_count_start;
+  }
+
+  setAllocationCounter(state, allocations);
+  state.SetItemsProcessed(static_cast<std::int64_t>(
+      state.iterations() * static_cast<std::int64_t>(type_id_list.size())));
+}
+
+void BM_GetType(benchmark::State &state) {
+  auto corpus = getCorpus(state);
+  if (corpus == nullptr) {
+    return;
+  }
+
+  auto btf = createBTF(*corpus, BTFOptions{});
+  auto type_id_list = generateTypeIDList(*btf, state.range(1) != 0);
+
+  std::size_t allocations{};
+
+  for (auto _ : state) {
+    auto allocation_count_start = getAllocationCount();
+
+    for (const auto &type_id : type_id_list) {
+      benchmark::DoNotOptimize(btf->getType(type_id));
+    }
+
+    allocations += getAllocationCount() - allocation_count_start;
+  }
+
+  setAllocationCounter(state, allocations);
+  state.SetItemsProcessed(static_cast<std::int64_t>(
+      state.iterations() * static_cast<std::int64_t>(type_id_list.size())));
+}
+
+// The index is built by a lookup that happens before the timed loop
+void BM_FindByName(benchmark::State &state) {
+  auto corpus = getCorpus(state);
+  if (corpus == nullptr) {
+    return;
+  }
+
+  auto btf = createBTF(*corpus, BTFOptions{});
+
+  std::vector<std::string> name_list;
+  for (const auto &id : btf->findByKind(BTFKind::Struct)) {
+    const auto &btf_struct = std::get<StructBTFType>(*btf->getTypeRef(id));
+    if (btf_struct.opt_name.has_value()) {
+      name_list.push_back(btf_struct.opt_name.value());
+    }
+  }
+
+  std::size_t allocations{};
+
+  for (auto _ : state) {
+    auto allocation_count_start = getAllocationCount();
+
+    for (const auto &name : name_list) {
+      benchmark::DoNotOptimize(btf->findByName(name, BTFKind::Struct));
+    }
+
+    allocations += getAllocationCount() - allocation_count_start;
+  }
+
+  setAllocationCounter(state, allocations);
+  state.SetItemsProcessed(static_cast<std::int64_t>(
+      state.iterations() * static_cast<std::int64_t>(name_list.size())));
+}
+
+// With the cache argument set, the sizes are computed once before the
+// timed loop, so only the memoized lookups are measured
+void BM_GetSize(benchmark::State &state) {
+  auto corpus = getCorpus(state);
+  if (corpus == nullptr) {
+    return;
+  }
+
+  auto btf = createBTF(*corpus, BTFOptions{});
+  auto warm_cache = state.range(1) != 0;
+
+  auto create_layout = [&btf]() {
+    auto layout_res = IBTFLayout::create(*btf);
+    if (layout_res.failed()) {
+      throw std::runtime_error("Failed to create the layout");
+    }
+
+    return layout_res.takeValue();
+  };
+
+  auto get_sizes = [&btf](const IBTFLayout &layout) {
+    for (std::uint32_t id = 1; id <= btf->count(); ++id) {
+      auto size_res = layout.getSize(id);
+      if (!size_res.failed()) {
+        benchmark::DoNotOptimize(size_res.takeValue());
+      }
+    }
+  };
+
+  auto layout = create_layout();
+  if (warm_cache) {
+    get_sizes(*layout);
+  }
+
+  for (auto _ : state) {
+    if (!warm_cache) {
+      state.PauseTiming();
+      layout = create_layout();
+      state.ResumeTiming();
+    }
+
+    get_sizes(*layout);
+  }
+
+  state.SetItemsProcessed(
+      static_cast<std::int64_t>(state.iterations() * btf->count()));
+}
+
+// Only the selected phase is timed; the phases that come before it are
+// replayed on a fresh context at the start of each iteration
+void BM_GeneratorPhase(benchmark::State &state) {
+  auto corpus = getCorpus(state);
+  if (corpus == nullptr) {
+    return;
+  }
+
+  auto btf = createBTF(*corpus, BTFOptions{});
+  auto phase = static_cast<GeneratorPhase>(state.range(1));
+
+  std::size_t allocations{};
+
+  for (auto _ : state) {
+    state.PauseTiming();
+
+    BTFHeaderGenerator::Context context;
+    for (int i = 0; i < static_cast<int>(phase); ++i) {
+      if (!runGeneratorPhase(context, static_cast<GeneratorPhase>(i), btf)) {
+        state.SkipWithError("Failed to prepare the generator context");
+        return;
+      }
+    }
+
+    state.ResumeTiming();
+
+    auto allocation_count_start = getAllocationCount();
+
+    if (!runGeneratorPhase(context, phase, btf)) {
+      state.SkipWithError("The generator phase has failed");
+      return;
+    }
+
+    allocations += getAllocationCount() - allocation_count_start;
+
+    // Keep the context destructor out of the measurement
+    state.PauseTiming();
+    context = {};
+    state.ResumeTiming();
+  }
+
+  setAllocationCounter(state, allocations);
+  state.SetItemsProcessed(static_cast<std::int64_t>(
+      state.iterations() * static_cast<std::int64_t>(btf->count())));
+}
+
+void BM_GenerateHeader(benchmark::State &state) {
+  auto corpus = getCorpus(state);
+  if (corpus == nullptr) {
+    return;
+  }
+
+  auto btf = createBTF(*corpus, BTFOptions{});
+  auto generator = IBTFHeaderGenerator::create();
+
+  BTFHeaderGeneratorOptions options;
+  options.thread_count = static_cast<std::size_t>(state.range(1));
+
+  std::string header;
+  std::size_t allocations{};
+
+  for (auto _ : state) {
+    auto allocation_count_start = getAllocationCount();
+
+    if (!generator->generate(header, btf, options)) {
+      state.SkipWithError("Failed to generate the header");
+      return;
+    }
+
+    allocations += getAllocationCount() - allocation_count_start;
+  }
+
+  setAllocationCounter(state, allocations);
+  state.SetItemsProcessed(static_cast<std::int64_t>(
+      state.iterations() * static_cast<std::int64_t>(btf->count())));
+
+  state.SetBytesProcessed(static_cast<std::int64_t>(
+      state.iterations() * static_cast<std::int64_t>(header.size())));
+}
+
+void applyCorpusArguments(benchmark::internal::Benchmark *benchmark) {
+  benchmark->ArgName("corpus")->DenseRange(0, 1);
+}
+
+} // namespace
+
+// Arguments: corpus (0 = synthetic, 1 = kernel)
+BENCHMARK(BM_StringTableLookup)->Apply(applyCorpusArguments);
+
+// Arguments: corpus, thread count
+BENCHMARK(BM_ParseTypeSections)
+    ->ArgNames({"corpus", "threads"})
+    ->ArgsProduct({{0, 1}, {1, 2, 4}})
+    ->UseRealTime();
+
+// Arguments: corpus
+BENCHMARK(BM_IndexTypeSections)->Apply(applyCorpusArguments);
+
+// Arguments: corpus, decoding mode (0 = eager, 1 = lazy, 2 = compact)
+BENCHMARK(BM_CreateFromBuffer)
+    ->ArgNames({"corpus", "mode"})
+    ->ArgsProduct({{0, 1}, {0, 1, 2}});
+
+// Arguments: corpus
+BENCHMARK(BM_CreateFromSnapshotBuffer)->Apply(applyCorpusArguments);
+
+// Arguments: corpus, random access, decoding mode
+BENCHMARK(BM_GetTypeRef)
+    ->ArgNames({"corpus", "random", "mode"})
+    ->ArgsProduct({{0, 1}, {0, 1}, {0, 1, 2}});
+
+// Arguments: corpus, random access, decoding mode
+BENCHMARK(BM_GetTypeView)
+    ->ArgNames({"corpus", "random", "mode"})
+    ->ArgsProduct({{0, 1}, {0, 1}, {0, 2}});
+
+// Arguments: corpus, random access
+BENCHMARK(BM_GetType)
+    ->ArgNames({"corpus", "random"})
+    ->ArgsProduct({{0, 1}, {0, 1}});
+
+// Arguments: corpus
+BENCHMARK(BM_FindByName)->Apply(applyCorpusArguments);
+
+// Arguments: corpus, cache
+BENCHMARK(BM_GetSize)
+    ->ArgNames({"corpus", "cache"})
+    ->ArgsProduct({{0, 1}, {0, 1}});
+
+// Arguments: corpus, generator phase (in execution order)
+BENCHMARK(BM_GeneratorPhase)
+    ->ArgNames({"corpus", "phase"})
+    ->ArgsProduct({{0, 1},
+                   benchmark::CreateDenseRange(0, kGeneratorPhaseCount - 1,
+                                               1)});
+
+// Arguments: corpus, thread count
+BENCHMARK(BM_GenerateHeader)
+    ->ArgNames({"corpus", "threads"})
+    ->ArgsProduct({{0, 1}, {1, 2, 4}})
+    ->UseRealTime();
+
+} // namespace btfparse
+
+BENCHMARK_MAIN();
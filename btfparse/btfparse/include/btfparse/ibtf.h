@@ -9,13 +9,20 @@
 #pragma once
 
 #include <btfparse/error.h>
+#include <btfparse/istream.h>
 #include <btfparse/result.h>
 
+#include <array>
+#include <chrono>
 #include <filesystem>
+#include <functional>
+#include <iterator>
 #include <memory>
 #include <optional>
 #include <sstream>
+#include <string_view>
 #include <unordered_map>
+#include <variant>
 #include <vector>
 
 namespace btfparse {
@@ -43,6 +50,13 @@ struct BTFErrorInformation final {
     InvalidVarBTFTypeEncoding,
     InvalidDataSecBTFTypeEncoding,
     InvalidStringOffset,
+    InvalidBaseBTF,
+    InvalidELFFile,
+    ELFSectionNotFound,
+    InvalidSnapshot,
+    UnsupportedSnapshotVersion,
+    SnapshotChecksumMismatch,
+    UnsupportedOptions,
   };
 
   struct FileRange final {
@@ -145,6 +159,34 @@ struct BTFErrorInformationPrinter final {
     case BTFErrorInformation::Code::InvalidStringOffset:
       buffer << "Invalid string offset";
       break;
+
+    case BTFErrorInformation::Code::InvalidBaseBTF:
+      buffer << "Invalid base BTF";
+      break;
+
+    case BTFErrorInformation::Code::InvalidELFFile:
+      buffer << "Invalid ELF file";
+      break;
+
+    case BTFErrorInformation::Code::ELFSectionNotFound:
+      buffer << "ELF section not found";
+      break;
+
+    case BTFErrorInformation::Code::InvalidSnapshot:
+      buffer << "Invalid snapshot";
+      break;
+
+    case BTFErrorInformation::Code::UnsupportedSnapshotVersion:
+      buffer << "Unsupported snapshot version";
+      break;
+
+    case BTFErrorInformation::Code::SnapshotChecksumMismatch:
+      buffer << "Snapshot checksum mismatch";
+      break;
+
+    case BTFErrorInformation::Code::UnsupportedOptions:
+      buffer << "Unsupported options";
+      break;
     }
 
     buffer << "'";
@@ -329,26 +371,564 @@ using BTFType =
                  FuncBTFType, FuncProtoBTFType, VarBTFType, DataSecBTFType,
                  FloatBTFType>;
 
-using BTFTypeMap = std::unordered_map<std::uint32_t, BTFType>;
+/// A contiguous list of elements borrowed from an IBTF object. It remains
+/// valid as long as the object that returned it is alive
+template <typename Element> class BTFViewList final {
+public:
+  BTFViewList() = default;
+
+  BTFViewList(const Element *data_ptr, std::size_t element_count) noexcept
+      : list_data(data_ptr), list_size(element_count) {}
+
+  const Element *begin() const noexcept { return list_data; }
+  const Element *end() const noexcept { return list_data + list_size; }
+
+  std::size_t size() const noexcept { return list_size; }
+  bool empty() const noexcept { return list_size == 0; }
+
+  const Element &operator[](std::size_t index) const noexcept {
+    return list_data[index];
+  }
+
+  const Element &back() const noexcept { return list_data[list_size - 1]; }
+
+private:
+  const Element *list_data{nullptr};
+  std::size_t list_size{};
+};
+
+// Non-owning counterparts of the BTFType structures. Names point inside
+// the string sections and lists inside storage that is shared by all the
+// types of an IBTF object, so views can be copied and passed around
+// without allocating. Types that have neither names nor lists (pointers,
+// arrays and qualifiers) are represented by the same structures
+
+struct IntBTFTypeView final {
+  std::string_view name;
+  std::uint32_t size{};
+  IntBTFType::Encoding encoding{IntBTFType::Encoding::None};
+
+  std::uint8_t offset{};
+  std::uint8_t bits{};
+};
+
+struct TypedefBTFTypeView final {
+  std::string_view name;
+  std::uint32_t type{};
+};
+
+struct EnumBTFTypeView final {
+  struct Value final {
+    std::string_view name;
+    std::int32_t val{};
+  };
+
+  using ValueList = BTFViewList<Value>;
+
+  std::optional<std::string_view> opt_name;
+  std::uint32_t size{};
+  ValueList value_list;
+};
+
+struct FuncProtoBTFTypeView final {
+  struct Param final {
+    std::optional<std::string_view> opt_name;
+    std::uint32_t type{};
+  };
+
+  using ParamList = BTFViewList<Param>;
+
+  std::uint32_t return_type{};
+  ParamList param_list;
+  bool is_variadic{false};
+};
+
+struct StructBTFTypeView final {
+  struct Member final {
+    std::optional<std::string_view> opt_name;
+    std::uint32_t type{};
+    std::uint32_t offset{};
+    std::optional<std::uint8_t> opt_bitfield_size;
+  };
+
+  using MemberList = BTFViewList<Member>;
+
+  std::optional<std::string_view> opt_name;
+  std::uint32_t size{};
+  MemberList member_list;
+};
+
+struct UnionBTFTypeView final {
+  using Member = StructBTFTypeView::Member;
+  using MemberList = BTFViewList<Member>;
+
+  std::optional<std::string_view> opt_name;
+  std::uint32_t size{};
+  MemberList member_list;
+};
+
+struct FwdBTFTypeView final {
+  std::string_view name;
+  bool is_union{false};
+};
+
+struct FuncBTFTypeView final {
+  std::string_view name;
+  std::uint32_t type{};
+  FuncBTFType::Linkage linkage{FuncBTFType::Linkage::Static};
+};
+
+struct FloatBTFTypeView final {
+  std::string_view name;
+  std::uint32_t size{};
+};
+
+struct VarBTFTypeView final {
+  std::string_view name;
+  std::uint32_t type{};
+  std::uint32_t linkage{};
+};
+
+struct DataSecBTFTypeView final {
+  using Variable = DataSecBTFType::Variable;
+  using VariableList = BTFViewList<Variable>;
+
+  std::string_view name;
+  std::uint32_t size{};
+  VariableList variable_list;
+};
+
+// The alternatives are in the same order as the ones of BTFType
+using BTFTypeView =
+    std::variant<std::monostate, IntBTFTypeView, PtrBTFType, ArrayBTFType,
+                 StructBTFTypeView, UnionBTFTypeView, EnumBTFTypeView,
+                 FwdBTFTypeView, TypedefBTFTypeView, VolatileBTFType,
+                 ConstBTFType, RestrictBTFType, FuncBTFTypeView,
+                 FuncProtoBTFTypeView, VarBTFTypeView, DataSecBTFTypeView,
+                 FloatBTFTypeView>;
+
+/// Dense, ID-indexed storage for BTF types
+///
+/// Type IDs are assigned sequentially, so each type is stored in a
+/// vector slot at index (id - first_id) instead of a hash table node.
+/// The first ID is recorded on the first insertion, which lets a split
+/// BTF map start right after the IDs of its base. Slots holding a
+/// std::monostate value are holes and are skipped by the iterators, which
+/// always walk the types in ID order. Like std::vector, insertions can
+/// invalidate existing references and iterators
+class BTFTypeMap final {
+public:
+  using key_type = std::uint32_t;
+  using mapped_type = BTFType;
+  using value_type = std::pair<const key_type, mapped_type>;
+  using size_type = std::size_t;
+
+private:
+  using Storage = std::vector<value_type>;
+
+  template <typename StorageIterator, typename Value> class Iterator final {
+  public:
+    using iterator_category = std::forward_iterator_tag;
+    using value_type = Value;
+    using difference_type = std::ptrdiff_t;
+    using pointer = Value *;
+    using reference = Value &;
+
+    Iterator() = default;
+
+    Iterator(StorageIterator begin_it, StorageIterator end_it)
+        : current(begin_it), end(end_it) {
+      skipHoles();
+    }
+
+    template <typename OtherStorageIterator, typename OtherValue>
+    Iterator(const Iterator<OtherStorageIterator, OtherValue> &other)
+        : current(other.current), end(other.end) {}
+
+    reference operator*() const { return *current; }
+    pointer operator->() const { return &(*current); }
+
+    Iterator &operator++() {
+      ++current;
+      skipHoles();
+
+      return *this;
+    }
+
+    Iterator operator++(int) {
+      auto previous = *this;
+      ++(*this);
+
+      return previous;
+    }
+
+    template <typename OtherStorageIterator, typename OtherValue>
+    bool
+    operator==(const Iterator<OtherStorageIterator, OtherValue> &other) const {
+      return current == other.current;
+    }
+
+    template <typename OtherStorageIterator, typename OtherValue>
+    bool
+    operator!=(const Iterator<OtherStorageIterator, OtherValue> &other) const {
+      return current != other.current;
+    }
+
+  private:
+    StorageIterator current{};
+    StorageIterator end{};
+
+    void skipHoles() {
+      while (current != end &&
+             std::holds_alternative<std::monostate>(current->second)) {
+        ++current;
+      }
+    }
+
+    template <typename, typename> friend class Iterator;
+  };
+
+public:
+  using iterator = Iterator<Storage::iterator, value_type>;
+  using const_iterator = Iterator<Storage::const_iterator, const value_type>;
+
+  BTFTypeMap() = default;
+  ~BTFTypeMap() = default;
+
+  BTFTypeMap(const BTFTypeMap &) = default;
+  BTFTypeMap(BTFTypeMap &&) noexcept = default;
+
+  BTFTypeMap &operator=(const BTFTypeMap &other);
+  BTFTypeMap &operator=(BTFTypeMap &&) noexcept = default;
+
+  iterator begin() noexcept { return iterator(storage.begin(), storage.end()); }
+  iterator end() noexcept { return iterator(storage.end(), storage.end()); }
+
+  const_iterator begin() const noexcept {
+    return const_iterator(storage.begin(), storage.end());
+  }
+
+  const_iterator end() const noexcept {
+    return const_iterator(storage.end(), storage.end());
+  }
+
+  const_iterator cbegin() const noexcept { return begin(); }
+  const_iterator cend() const noexcept { return end(); }
+
+  iterator find(key_type id) noexcept;
+  const_iterator find(key_type id) const noexcept;
+
+  mapped_type &at(key_type id);
+  const mapped_type &at(key_type id) const;
+
+  size_type count(key_type id) const noexcept;
+
+  std::pair<iterator, bool> insert(value_type value);
+
+  void reserve(size_type capacity);
+  void clear() noexcept;
+
+  size_type size() const noexcept { return type_count; }
+  bool empty() const noexcept { return type_count == 0; }
+
+  key_type firstID() const noexcept { return first_id; }
+
+private:
+  Storage storage;
+  key_type first_id{1U};
+  size_type type_count{0U};
+
+  std::optional<size_type> getIndex(key_type id) const noexcept;
+};
+
 using PathList = std::vector<std::filesystem::path>;
 
+// Receives the name and the duration of each phase of a parse or of a
+// header generation, as soon as it completes. Must not throw
+using BTFTraceCallback = std::function<void(
+    std::string_view phase, std::chrono::nanoseconds duration)>;
+
+// Only collected when btfparse is built with BTFPARSE_ENABLE_TELEMETRY
+// (see IBTF::isTelemetryEnabled). The counters cover the creation of the
+// IBTF object, and not the types that are decoded lazily afterwards
+struct BTFParseStats final {
+  struct KindStats final {
+    std::uint64_t type_count{};
+    std::chrono::nanoseconds decode_time{};
+  };
+
+  // Indexed by BTFKind
+  using KindStatsList =
+      std::array<KindStats, static_cast<std::size_t>(BTFKind::Float) + 1>;
+
+  // Size of the headers, type and string sections that were parsed
+  std::uint64_t bytes_read{};
+
+  // Calls made to the IStream passed to createFromStream. The other
+  // sources, and the streams that are memory resident, are read in place
+  std::uint64_t stream_read_count{};
+  std::uint64_t stream_seek_count{};
+
+  std::uint64_t string_lookup_count{};
+  KindStatsList kind_stats_list{};
+
+  std::chrono::nanoseconds parse_time{};
+};
+
+struct BTFOptions final {
+  enum class DecodingMode {
+    // All the types are decoded before the IBTF object is returned
+    Eager,
+
+    // Only the type headers are scanned ahead of time; each type is
+    // decoded (and then cached) the first time it is requested. Types
+    // that fail to decode are reported as missing
+    Lazy,
+
+    // All the types are validated and decoded before the IBTF object is
+    // returned, but only as views (see getTypeView): names are not copied,
+    // and all the lists share a few blocks that are allocated up front.
+    // getTypeRef creates (and then caches) the owned copy of a type the
+    // first time it is requested
+    Compact,
+  };
+
+  DecodingMode decoding_mode{DecodingMode::Eager};
+
+  // Number of tasks used to decode the types in Eager mode, or 0 to use
+  // one task per core. The result is identical to the sequential decoding,
+  // including which error is reported
+  std::size_t thread_count{1U};
+
+  // Merges the structurally equivalent types of all the files once they
+  // have been decoded, giving each distinct type a single canonical ID
+  // (see IBTF::getCanonicalID). The canonical types are renumbered in ID
+  // order. Only supported in Eager mode, and deduplicated objects can not
+  // be used as the base of split objects
+  bool deduplicate{false};
+
+  using TaskList = std::vector<std::function<void()>>;
+
+  // Runs all the given tasks and returns once they have completed. When
+  // not set, a new thread is started for each task
+  using Executor = std::function<void(const TaskList &task_list)>;
+  Executor executor;
+
+  // Telemetry; ignored unless btfparse is built with
+  // BTFPARSE_ENABLE_TELEMETRY. The stats callback is called once the
+  // parse has completed, whether it has succeeded or not, and must not
+  // throw
+  using StatsCallback = std::function<void(const BTFParseStats &stats)>;
+  StatsCallback stats_callback;
+  BTFTraceCallback trace_callback;
+};
+
+/// A contiguous list of type IDs borrowed from an IBTF object. It remains
+/// valid as long as the object that returned it is alive
+class BTFTypeIDRange final {
+public:
+  BTFTypeIDRange() = default;
+
+  BTFTypeIDRange(const std::uint32_t *begin_ptr,
+                 const std::uint32_t *end_ptr) noexcept
+      : range_begin(begin_ptr), range_end(end_ptr) {}
+
+  const std::uint32_t *begin() const noexcept { return range_begin; }
+  const std::uint32_t *end() const noexcept { return range_end; }
+
+  std::size_t size() const noexcept {
+    return static_cast<std::size_t>(range_end - range_begin);
+  }
+
+  bool empty() const noexcept { return range_begin == range_end; }
+
+  std::uint32_t operator[](std::size_t index) const noexcept {
+    return range_begin[index];
+  }
+
+private:
+  const std::uint32_t *range_begin{nullptr};
+  const std::uint32_t *range_end{nullptr};
+};
+
 class IBTF {
 public:
   using Ptr = std::unique_ptr<IBTF>;
+  using SharedPtr = std::shared_ptr<const IBTF>;
 
   static Result<Ptr, BTFError>
   createFromPath(const std::filesystem::path &path) noexcept;
 
+  static Result<Ptr, BTFError>
+  createFromPath(const std::filesystem::path &path,
+                 const BTFOptions &options) noexcept;
+
   static Result<Ptr, BTFError>
   createFromPathList(const PathList &path_list) noexcept;
 
+  static Result<Ptr, BTFError>
+  createFromPathList(const PathList &path_list,
+                     const BTFOptions &options) noexcept;
+
+  /// The buffer is not copied, and must outlive the returned object
+  static Result<Ptr, BTFError> createFromBuffer(const std::uint8_t *data,
+                                                std::size_t size) noexcept;
+
+  static Result<Ptr, BTFError>
+  createFromBuffer(const std::uint8_t *data, std::size_t size,
+                   const BTFOptions &options) noexcept;
+
+  static Result<Ptr, BTFError> createFromStream(IStream::Ptr stream) noexcept;
+
+  static Result<Ptr, BTFError>
+  createFromStream(IStream::Ptr stream, const BTFOptions &options) noexcept;
+
+  /// Parses the .BTF section of an ELF file (i.e. vmlinux, an eBPF object)
+  static Result<Ptr, BTFError>
+  createFromELF(const std::filesystem::path &path) noexcept;
+
+  static Result<Ptr, BTFError>
+  createFromELF(const std::filesystem::path &path,
+                const BTFOptions &options) noexcept;
+
+  /// Same as createFromELF, for an ELF image that is already in memory.
+  /// The image is not copied, and must outlive the returned object
+  static Result<Ptr, BTFError> createFromELFBuffer(const std::uint8_t *data,
+                                                   std::size_t size) noexcept;
+
+  static Result<Ptr, BTFError>
+  createFromELFBuffer(const std::uint8_t *data, std::size_t size,
+                      const BTFOptions &options) noexcept;
+
+  /// Receives each type while it is decoded. The view is only valid during
+  /// the call. Return false to stop the parsing
+  using ParseCallback = std::function<bool(std::uint32_t id,
+                                           const BTFTypeView &btf_type_view)>;
+
+  /// Decodes the types one at a time and passes them to the callback in
+  /// ID order, without creating an IBTF object. Nothing is kept after the
+  /// callback returns, so memory use does not depend on the number of
+  /// types. If an error is found, the callback has already received all
+  /// the types that precede it. Stopping early is not an error
+  static std::optional<BTFError>
+  parseFromPath(const std::filesystem::path &path,
+                const ParseCallback &callback);
+
+  static std::optional<BTFError>
+  parseFromPathList(const PathList &path_list, const ParseCallback &callback);
+
+  /// The buffer is not copied, and must outlive the call
+  static std::optional<BTFError> parseFromBuffer(const std::uint8_t *data,
+                                                 std::size_t size,
+                                                 const ParseCallback &callback);
+
+  /// Parses a split BTF file (i.e. /sys/kernel/btf/<module>) on top of an
+  /// already parsed base, which is shared rather than decoded again. The
+  /// base must have been created by this library. Type ids and string
+  /// offsets continue after the ones of the base, and the returned
+  /// object exposes both the base and the split types
+  static Result<Ptr, BTFError>
+  createSplitFromPath(SharedPtr base_btf,
+                      const std::filesystem::path &path) noexcept;
+
+  static Result<Ptr, BTFError>
+  createSplitFromPath(SharedPtr base_btf, const std::filesystem::path &path,
+                      const BTFOptions &options) noexcept;
+
+  /// Parses the .BTF section of a kernel module (.ko) on top of its base
+  static Result<Ptr, BTFError>
+  createSplitFromELF(SharedPtr base_btf,
+                     const std::filesystem::path &path) noexcept;
+
+  static Result<Ptr, BTFError>
+  createSplitFromELF(SharedPtr base_btf, const std::filesystem::path &path,
+                     const BTFOptions &options) noexcept;
+
+  /// Loads a snapshot created by saveSnapshot. The file is mapped in
+  /// memory and validated, but the types are only decoded (straight from
+  /// the mapped image) the first time they are requested
+  static Result<Ptr, BTFError>
+  createFromSnapshot(const std::filesystem::path &path) noexcept;
+
+  /// Same as createFromSnapshot, for a snapshot that is already in memory.
+  /// The buffer is not copied, and must outlive the returned object
+  static Result<Ptr, BTFError>
+  createFromSnapshotBuffer(const std::uint8_t *data, std::size_t size) noexcept;
+
+  /// Writes all the types of the given object (including the ones of its
+  /// base, for split BTF) to a snapshot file
+  static std::optional<BTFError>
+  saveSnapshot(const IBTF &btf, const std::filesystem::path &path) noexcept;
+
+  /// Same as saveSnapshot, returning the snapshot in a memory buffer
+  static Result<std::vector<std::uint8_t>, BTFError>
+  createSnapshotBuffer(const IBTF &btf) noexcept;
+
   virtual std::optional<BTFType> getType(std::uint32_t id) const noexcept = 0;
   virtual std::optional<BTFKind> getKind(std::uint32_t id) const noexcept = 0;
 
+  /// Returns a borrowed pointer to the given type, or nullptr if the id is
+  /// not valid. The pointer remains valid as long as this object is alive
+  virtual const BTFType *getTypeRef(std::uint32_t id) const noexcept = 0;
+
+  /// Returns a view of the given type, or std::nullopt if the id is not
+  /// valid. Views never allocate in Compact mode; the other objects build
+  /// the views of all their types the first time this method is called.
+  /// The view remains valid as long as this object is alive
+  virtual std::optional<BTFTypeView>
+  getTypeView(std::uint32_t id) const noexcept = 0;
+
   virtual std::uint32_t count() const noexcept = 0;
   virtual BTFTypeMap getAll() const noexcept = 0;
 
+  /// Maps a type ID of the original files to the ID of its canonical type
+  /// when the object has been deduplicated (see BTFOptions::deduplicate);
+  /// otherwise, each type keeps its ID. Returns std::nullopt if the id is
+  /// not valid
+  virtual std::optional<std::uint32_t>
+  getCanonicalID(std::uint32_t original_id) const noexcept = 0;
+
+  /// Returns the IDs of the types with the given name, sorted by kind and
+  /// then by ID. The name and kind indexes are built in a single pass the
+  /// first time any of the find methods is called; lookups are then
+  /// constant time, and are safe to perform from multiple threads
+  virtual BTFTypeIDRange findByName(std::string_view name) const noexcept = 0;
+
+  /// Same as findByName, only returning the types of the given kind in
+  /// ID order
+  virtual BTFTypeIDRange findByName(std::string_view name,
+                                    BTFKind kind) const noexcept = 0;
+
+  /// Returns the IDs of all the types of the given kind, in ID order
+  virtual BTFTypeIDRange findByKind(BTFKind kind) const noexcept = 0;
+
+  /// Return false from the callback to stop the iteration
+  using ForEachCallback =
+      std::function<bool(std::uint32_t id, const BTFType &btf_type)>;
+
+  /// Walks all the types in ID order without copying them. Returns false
+  /// if the iteration has been stopped by the callback
+  virtual bool forEach(const ForEachCallback &callback) const = 0;
+
+  /// Calls the visitor with the concrete type (i.e. IntBTFType, PtrBTFType,
+  /// ...) of the given id. Returns false if the id is not valid
+  template <typename Visitor>
+  bool visit(std::uint32_t id, Visitor &&visitor) const {
+    const auto *btf_type = getTypeRef(id);
+    if (btf_type == nullptr) {
+      return false;
+    }
+
+    std::visit(std::forward<Visitor>(visitor), *btf_type);
+    return true;
+  }
+
   static BTFKind getBTFTypeKind(const BTFType &btf_type) noexcept;
+  static BTFKind getBTFTypeKind(const BTFTypeView &btf_type_view) noexcept;
+
+  // True if btfparse was built with BTFPARSE_ENABLE_TELEMETRY, i.e. if
+  // the stats and trace callbacks of the options are used
+  static bool isTelemetryEnabled() noexcept;
 
   IBTF() = default;
   virtual ~IBTF() = default;
@@ -0,0 +1,111 @@
+//
+// Copyright (c) 2021-present, Trail of Bits, Inc.
+// All rights reserved.
+//
+// This source code is licensed in accordance with the terms specified in
+// the LICENSE file found in the root directory of this source tree.
+//
+
+#pragma once
+
+#include <btfparse/ibtfheadergenerator.h>
+
+#include <filesystem>
+#include <optional>
+#include <ostream>
+#include <sstream>
+#include <string>
+
+namespace btfparse {
+
+struct BTFHeaderCacheErrorInformation final {
+  enum class Code {
+    Unknown,
+    MemoryAllocationFailure,
+    FileNotFound,
+    IOError,
+    InvalidBTF,
+    HeaderGenerationFailed,
+  };
+
+  Code code{Code::Unknown};
+
+  // Message of the underlying error, if any
+  std::optional<std::string> opt_details;
+};
+
+struct BTFHeaderCacheErrorInformationPrinter final {
+  std::string
+  operator()(const BTFHeaderCacheErrorInformation &error_information) const {
+    std::stringstream buffer;
+    buffer << "Error: '";
+
+    switch (error_information.code) {
+    case BTFHeaderCacheErrorInformation::Code::Unknown:
+      buffer << "Unknown error";
+      break;
+
+    case BTFHeaderCacheErrorInformation::Code::MemoryAllocationFailure:
+      buffer << "Memory allocation failure";
+      break;
+
+    case BTFHeaderCacheErrorInformation::Code::FileNotFound:
+      buffer << "File not found";
+      break;
+
+    case BTFHeaderCacheErrorInformation::Code::IOError:
+      buffer << "IO error";
+      break;
+
+    case BTFHeaderCacheErrorInformation::Code::InvalidBTF:
+      buffer << "Invalid BTF data";
+      break;
+
+    case BTFHeaderCacheErrorInformation::Code::HeaderGenerationFailed:
+      buffer << "Header generation failed";
+      break;
+    }
+
+    buffer << "'";
+
+    if (error_information.opt_details.has_value()) {
+      buffer << ", Details: " << error_information.opt_details.value();
+    }
+
+    return buffer.str();
+  }
+};
+
+using BTFHeaderCacheError = Error<BTFHeaderCacheErrorInformation,
+                                  BTFHeaderCacheErrorInformationPrinter>;
+
+// Stores the generated headers in a directory, keyed by a SHA-256 digest
+// of the BTF files and of the generator options. On a cache hit, the BTF
+// files are only hashed and never parsed
+class IBTFHeaderCache {
+public:
+  using Ptr = std::unique_ptr<IBTFHeaderCache>;
+
+  // The cache directory is created if it does not exist
+  static Result<Ptr, BTFHeaderCacheError>
+  create(const std::filesystem::path &cache_directory) noexcept;
+
+  IBTFHeaderCache() = default;
+  virtual ~IBTFHeaderCache() = default;
+
+  // Writes the header for the given BTF files to the stream, generating
+  // and storing it first on a cache miss. New cache entries are written
+  // to a temporary file and then renamed, so that concurrent users never
+  // observe a partial header
+  std::optional<BTFHeaderCacheError>
+  generate(std::ostream &stream, const PathList &path_list) const;
+
+  virtual std::optional<BTFHeaderCacheError>
+  generate(std::ostream &stream, const PathList &path_list,
+           const BTFHeaderGeneratorOptions &options) const = 0;
+
+  IBTFHeaderCache(const IBTFHeaderCache &) = delete;
+  IBTFHeaderCache &operator=(const IBTFHeaderCache &) = delete;
+};
+
+} // namespace btfparse
@@ -10,8 +10,60 @@
 
 #include <btfparse/ibtf.h>
 
+#include <chrono>
+#include <functional>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <vector>
+
 namespace btfparse {
 
+// Only collected when btfparse is built with BTFPARSE_ENABLE_TELEMETRY
+// (see IBTF::isTelemetryEnabled)
+struct BTFHeaderGeneratorStats final {
+  struct Phase final {
+    std::string name;
+    std::chrono::nanoseconds duration{};
+  };
+
+  // In the order they have run. The generation stops at the first phase
+  // that fails
+  std::vector<Phase> phase_list;
+
+  // Size of the chunks passed to the output callback
+  std::uint64_t output_size{};
+
+  std::chrono::nanoseconds generation_time{};
+};
+
+struct BTFHeaderGeneratorOptions final {
+  // When at least one root type is given, only the root types and their
+  // dependencies are emitted. Structs and unions that are only reached
+  // through a pointer are forward declared instead. Names are matched
+  // against the top level types (structs, unions, enums, typedefs and
+  // forward declarations), and a name may select more than one of them
+  std::vector<std::string> root_type_name_list;
+  std::vector<std::uint32_t> root_type_id_list;
+
+  // Number of tasks used to render the declarations, or 0 to use one task
+  // per core. The output is identical to the sequential rendering, and is
+  // still passed to the callback one declaration at a time, in order
+  std::size_t thread_count{1U};
+
+  // Runs the rendering tasks, in the same way as BTFOptions::executor.
+  // When not set, a new thread is started for each task
+  BTFOptions::Executor executor;
+
+  // Telemetry, in the same way as BTFOptions::stats_callback and
+  // BTFOptions::trace_callback
+  using StatsCallback =
+      std::function<void(const BTFHeaderGeneratorStats &stats)>;
+
+  StatsCallback stats_callback;
+  BTFTraceCallback trace_callback;
+};
+
 class IBTFHeaderGenerator {
 public:
   using Ptr = std::unique_ptr<IBTFHeaderGenerator>;
@@ -20,7 +72,26 @@ public:
   IBTFHeaderGenerator() = default;
   virtual ~IBTFHeaderGenerator() = default;
 
-  virtual bool generate(std::string &header, const IBTF::Ptr &btf) const = 0;
+  // Receives the header one top level declaration at a time. Returning
+  // false stops the generation. Since the output is not buffered, the
+  // stream and callback overloads may have already written part of the
+  // header when the generation fails
+  using OutputCallback = std::function<bool(std::string_view chunk)>;
+
+  bool generate(std::string &header, const IBTF::Ptr &btf) const;
+
+  bool generate(std::string &header, const IBTF::Ptr &btf,
+                const BTFHeaderGeneratorOptions &options) const;
+
+  bool generate(std::ostream &stream, const IBTF::Ptr &btf) const;
+
+  bool generate(std::ostream &stream, const IBTF::Ptr &btf,
+                const BTFHeaderGeneratorOptions &options) const;
+
+  bool generate(const OutputCallback &callback, const IBTF::Ptr &btf) const;
+
+  virtual bool generate(const OutputCallback &callback, const IBTF::Ptr &btf,
+                        const BTFHeaderGeneratorOptions &options) const = 0;
 
   IBTFHeaderGenerator(const IBTFHeaderGenerator &) = delete;
   IBTFHeaderGenerator &operator=(const IBTFHeaderGenerator &) = delete;
@@ -0,0 +1,187 @@
+//
+// Copyright (c) 2021-present, Trail of Bits, Inc.
+// All rights reserved.
+//
+// This source code is licensed in accordance with the terms specified in
+// the LICENSE file found in the root directory of this source tree.
+//
+
+#pragma once
+
+#include <btfparse/ibtf.h>
+
+#include <optional>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace btfparse {
+
+struct BTFLayoutErrorInformation final {
+  enum class Code {
+    Unknown,
+    MemoryAllocationFailure,
+    InvalidTypeID,
+    TypeNotFound,
+    IncompleteType,
+    TypeLoop,
+    SizeOverflow,
+    InvalidMemberPath,
+    MemberNotFound,
+    NotAStructOrUnion,
+    NotAPointer,
+    NotAnArray,
+    ArrayIndexOutOfRange,
+    UnalignedPointer,
+  };
+
+  Code code{Code::Unknown};
+
+  // The type that caused the error, if any
+  std::optional<std::uint32_t> opt_type_id;
+};
+
+struct BTFLayoutErrorInformationPrinter final {
+  std::string
+  operator()(const BTFLayoutErrorInformation &error_information) const {
+    std::stringstream buffer;
+    buffer << "Error: '";
+
+    switch (error_information.code) {
+    case BTFLayoutErrorInformation::Code::Unknown:
+      buffer << "Unknown error";
+      break;
+
+    case BTFLayoutErrorInformation::Code::MemoryAllocationFailure:
+      buffer << "Memory allocation failure";
+      break;
+
+    case BTFLayoutErrorInformation::Code::InvalidTypeID:
+      buffer << "Invalid type ID";
+      break;
+
+    case BTFLayoutErrorInformation::Code::TypeNotFound:
+      buffer << "Type not found";
+      break;
+
+    case BTFLayoutErrorInformation::Code::IncompleteType:
+      buffer << "The type has no size";
+      break;
+
+    case BTFLayoutErrorInformation::Code::TypeLoop:
+      buffer << "The type depends on itself";
+      break;
+
+    case BTFLayoutErrorInformation::Code::SizeOverflow:
+      buffer << "The type size overflows";
+      break;
+
+    case BTFLayoutErrorInformation::Code::InvalidMemberPath:
+      buffer << "Invalid member path";
+      break;
+
+    case BTFLayoutErrorInformation::Code::MemberNotFound:
+      buffer << "Member not found";
+      break;
+
+    case BTFLayoutErrorInformation::Code::NotAStructOrUnion:
+      buffer << "The type is not a struct or union";
+      break;
+
+    case BTFLayoutErrorInformation::Code::NotAPointer:
+      buffer << "The type is not a pointer";
+      break;
+
+    case BTFLayoutErrorInformation::Code::NotAnArray:
+      buffer << "The type is not an array";
+      break;
+
+    case BTFLayoutErrorInformation::Code::ArrayIndexOutOfRange:
+      buffer << "Array index out of range";
+      break;
+
+    case BTFLayoutErrorInformation::Code::UnalignedPointer:
+      buffer << "The pointer is not byte aligned";
+      break;
+    }
+
+    buffer << "'";
+
+    if (error_information.opt_type_id.has_value()) {
+      buffer << ", Type ID: " << error_information.opt_type_id.value();
+    }
+
+    return buffer.str();
+  }
+};
+
+using BTFLayoutError =
+    Error<BTFLayoutErrorInformation, BTFLayoutErrorInformationPrinter>;
+
+struct BTFMemberLocation final {
+  // Offsets (in bytes) of the pointers that are followed to reach the
+  // member. Each one is relative to the object reached through the
+  // previous pointer, starting from the root type
+  std::vector<std::uint64_t> pointer_offset_list;
+
+  // The member type, as declared (typedefs and qualifiers are kept)
+  std::uint32_t type{};
+
+  // Offset and size of the member, in bits. The offset is relative to
+  // the object reached through the last pointer
+  std::uint64_t bit_offset{};
+  std::uint64_t bit_size{};
+
+  // Only set for bitfields
+  std::optional<std::uint8_t> opt_bitfield_size;
+};
+
+/// Computes the size, alignment and member offsets of the types of an
+/// IBTF object. The results are memoized, so repeated queries are
+/// answered without walking the type chains again. Queries can be issued
+/// from multiple threads
+class IBTFLayout {
+public:
+  using Ptr = std::unique_ptr<IBTFLayout>;
+
+  /// The BTF object is not copied, and must outlive the returned object
+  static Result<Ptr, BTFLayoutError> create(const IBTF &btf) noexcept;
+
+  IBTFLayout() = default;
+  virtual ~IBTFLayout() = default;
+
+  /// Returns the size of the given type in bytes. Typedefs, qualifiers
+  /// and arrays are resolved. Pointers have the size of the host pointers
+  virtual Result<std::uint64_t, BTFLayoutError>
+  getSize(std::uint32_t id) const noexcept = 0;
+
+  /// Returns the alignment of the given type in bytes, following the same
+  /// rules as libbpf: structs and unions with misaligned members, or with
+  /// a size that is not a multiple of their alignment, are packed
+  virtual Result<std::uint64_t, BTFLayoutError>
+  getAlignment(std::uint32_t id) const noexcept = 0;
+
+  /// Skips the typedefs and the const, volatile and restrict qualifiers
+  virtual Result<std::uint32_t, BTFLayoutError>
+  resolveType(std::uint32_t id) const noexcept = 0;
+
+  /// Resolves a member path relative to the given struct or union, i.e.
+  /// "signal->rlim[1].rlim_cur". Use '.' to access a member, "->" to
+  /// access a member through a pointer and "[n]" to index an array.
+  /// Members of anonymous structs and unions are found as in C
+  virtual Result<BTFMemberLocation, BTFLayoutError>
+  resolveMemberPath(std::uint32_t id,
+                    std::string_view path) const noexcept = 0;
+
+  /// Same as the other overload, with a path that starts with the name of
+  /// the root type, i.e. "task_struct.signal->rlim". Structs are looked up
+  /// first, then unions and then typedefs
+  virtual Result<BTFMemberLocation, BTFLayoutError>
+  resolveMemberPath(std::string_view path) const noexcept = 0;
+
+  IBTFLayout(const IBTFLayout &) = delete;
+  IBTFLayout &operator=(const IBTFLayout &) = delete;
+};
+
+} // namespace btfparse
@@ -0,0 +1,135 @@
+//
+// Copyright (c) 2021-present, Trail of Bits, Inc.
+// All rights reserved.
+//
+// This source code is licensed in accordance with the terms specified in
+// the LICENSE file found in the root directory of this source tree.
+//
+
+#pragma once
+
+#include <btfparse/ibtf.h>
+
+#include <chrono>
+#include <filesystem>
+#include <map>
+#include <memory>
+#include <optional>
+#include <sstream>
+#include <string>
+
+namespace btfparse {
+
+struct BTFModuleWatcherErrorInformation final {
+  enum class Code {
+    Unknown,
+    MemoryAllocationFailure,
+    FileNotFound,
+    IOError,
+    InvalidBTF,
+  };
+
+  Code code{Code::Unknown};
+
+  // Name of the module and message of the underlying error, if any
+  std::optional<std::string> opt_details;
+};
+
+struct BTFModuleWatcherErrorInformationPrinter final {
+  std::string
+  operator()(const BTFModuleWatcherErrorInformation &error_information) const {
+    std::stringstream buffer;
+    buffer << "Error: '";
+
+    switch (error_information.code) {
+    case BTFModuleWatcherErrorInformation::Code::Unknown:
+      buffer << "Unknown error";
+      break;
+
+    case BTFModuleWatcherErrorInformation::Code::MemoryAllocationFailure:
+      buffer << "Memory allocation failure";
+      break;
+
+    case BTFModuleWatcherErrorInformation::Code::FileNotFound:
+      buffer << "File not found";
+      break;
+
+    case BTFModuleWatcherErrorInformation::Code::IOError:
+      buffer << "IO error";
+      break;
+
+    case BTFModuleWatcherErrorInformation::Code::InvalidBTF:
+      buffer << "Invalid BTF data";
+      break;
+    }
+
+    buffer << "'";
+
+    if (error_information.opt_details.has_value()) {
+      buffer << ", Details: " << error_information.opt_details.value();
+    }
+
+    return buffer.str();
+  }
+};
+
+using BTFModuleWatcherError = Error<BTFModuleWatcherErrorInformation,
+                                    BTFModuleWatcherErrorInformationPrinter>;
+
+// The base types and the split BTF objects of the modules that were
+// loaded at the time of an update. Module sets are never modified once
+// published, and each module object is shared by all the sets that
+// contain it
+struct BTFModuleSet final {
+  using Ptr = std::shared_ptr<const BTFModuleSet>;
+  using ModuleMap = std::map<std::string, IBTF::SharedPtr>;
+
+  IBTF::SharedPtr base_btf;
+  ModuleMap module_map;
+};
+
+// Keeps the types of the kernel modules up to date. The base BTF file
+// (vmlinux) is parsed once; each update only parses the modules that
+// have appeared since the previous one, and drops the ones that are
+// gone. Readers get the latest module set with a pointer copy, and keep
+// using it for as long as they need, even while updates are running
+class IBTFModuleWatcher {
+public:
+  using Ptr = std::unique_ptr<IBTFModuleWatcher>;
+
+  // Watches /sys/kernel/btf
+  static Result<Ptr, BTFModuleWatcherError> create() noexcept;
+
+  static Result<Ptr, BTFModuleWatcherError>
+  create(const std::filesystem::path &btf_directory) noexcept;
+
+  // The options are used for both the base and the module types
+  static Result<Ptr, BTFModuleWatcherError>
+  create(const std::filesystem::path &btf_directory,
+         const BTFOptions &options) noexcept;
+
+  IBTFModuleWatcher() = default;
+  virtual ~IBTFModuleWatcher() = default;
+
+  // May be called from any thread. This is not lock-free: it takes a
+  // short lock to copy the pointer, but it never waits for an update to
+  // finish parsing modules
+  virtual BTFModuleSet::Ptr getModuleSet() const noexcept = 0;
+
+  // Compares the directory with the current module set, and publishes a
+  // new set if anything has changed. A module that fails to parse is
+  // left out and its error is returned, but the other changes are still
+  // published
+  virtual std::optional<BTFModuleWatcherError> update() = 0;
+
+  // Waits until the directory changes or the timeout expires, and then
+  // updates. sysfs does not report every change through inotify, so the
+  // timeout is also the polling interval
+  virtual std::optional<BTFModuleWatcherError>
+  update(std::chrono::milliseconds timeout) = 0;
+
+  IBTFModuleWatcher(const IBTFModuleWatcher &) = delete;
+  IBTFModuleWatcher &operator=(const IBTFModuleWatcher &) = delete;
+};
+
+} // namespace btfparse
@@ -0,0 +1,160 @@
+//
+// Copyright (c) 2021-present, Trail of Bits, Inc.
+// All rights reserved.
+//
+// This source code is licensed in accordance with the terms specified in
+// the LICENSE file found in the root directory of this source tree.
+//
+
+#pragma once
+
+#include <btfparse/ibtf.h>
+
+#include <optional>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace btfparse {
+
+struct BTFTypeHasherErrorInformation final {
+  enum class Code {
+    Unknown,
+    MemoryAllocationFailure,
+    InvalidTypeID,
+  };
+
+  Code code{Code::Unknown};
+
+  // The type that caused the error, if any
+  std::optional<std::uint32_t> opt_type_id;
+};
+
+struct BTFTypeHasherErrorInformationPrinter final {
+  std::string
+  operator()(const BTFTypeHasherErrorInformation &error_information) const {
+    std::stringstream buffer;
+    buffer << "Error: '";
+
+    switch (error_information.code) {
+    case BTFTypeHasherErrorInformation::Code::Unknown:
+      buffer << "Unknown error";
+      break;
+
+    case BTFTypeHasherErrorInformation::Code::MemoryAllocationFailure:
+      buffer << "Memory allocation failure";
+      break;
+
+    case BTFTypeHasherErrorInformation::Code::InvalidTypeID:
+      buffer << "Invalid type ID";
+      break;
+    }
+
+    buffer << "'";
+
+    if (error_information.opt_type_id.has_value()) {
+      buffer << ", Type ID: " << error_information.opt_type_id.value();
+    }
+
+    return buffer.str();
+  }
+};
+
+using BTFTypeHasherError =
+    Error<BTFTypeHasherErrorInformation, BTFTypeHasherErrorInformationPrinter>;
+
+enum class BTFDiffChange {
+  Added,
+  Removed,
+  Changed,
+};
+
+// A struct or union member, or an enum value. The old fields are set
+// when the member exists in the old object, and the new ones when it
+// exists in the new object
+struct BTFMemberDiff final {
+  BTFDiffChange change{BTFDiffChange::Changed};
+
+  // Empty for anonymous members
+  std::string name;
+
+  // Struct and union members: the member type, and its offset in bits
+  std::optional<std::uint32_t> opt_old_type;
+  std::optional<std::uint32_t> opt_new_type;
+
+  std::optional<std::uint32_t> opt_old_offset;
+  std::optional<std::uint32_t> opt_new_offset;
+
+  // Set when the member type or its bitfield size are not structurally
+  // the same anymore
+  bool type_changed{false};
+
+  // Enum values
+  std::optional<std::int32_t> opt_old_value;
+  std::optional<std::int32_t> opt_new_value;
+};
+
+// A named struct, union or enum. Members are only listed for changed
+// types: the old ones in their original order, followed by the added ones
+struct BTFTypeDiff final {
+  BTFDiffChange change{BTFDiffChange::Changed};
+
+  BTFKind kind{BTFKind::Struct};
+  std::string name;
+
+  std::optional<std::uint32_t> opt_old_id;
+  std::optional<std::uint32_t> opt_new_id;
+
+  std::optional<std::uint32_t> opt_old_size;
+  std::optional<std::uint32_t> opt_new_size;
+
+  std::vector<BTFMemberDiff> member_diff_list;
+};
+
+// Sorted by kind and then by name
+using BTFDiff = std::vector<BTFTypeDiff>;
+
+/// Computes structural hashes of the types of an IBTF object: two types
+/// with the same hash have the same shape, no matter which IDs they and
+/// the types they reference have been assigned. Hashes are memoized, do
+/// not depend on the host, and remain the same across runs. Queries can
+/// be issued from multiple threads
+class IBTFTypeHasher {
+public:
+  using Ptr = std::unique_ptr<IBTFTypeHasher>;
+
+  /// The BTF object is not copied, and must outlive the returned object
+  static Result<Ptr, BTFTypeHasherError> create(const IBTF &btf) noexcept;
+
+  /// Compares the named structs, unions and enums of two objects. Types
+  /// are matched by kind and name; anonymous types are compared as part
+  /// of the types that contain them
+  static Result<BTFDiff, BTFTypeHasherError>
+  diff(const IBTF &old_btf, const IBTF &new_btf) noexcept;
+
+  /// Same as the other overload, reusing the hashes that the given
+  /// objects have already computed (i.e. when comparing a kernel against
+  /// many others)
+  static Result<BTFDiff, BTFTypeHasherError>
+  diff(const IBTFTypeHasher &old_hasher,
+       const IBTFTypeHasher &new_hasher) noexcept;
+
+  IBTFTypeHasher() = default;
+  virtual ~IBTFTypeHasher() = default;
+
+  /// Names, sizes, encodings, member offsets and the referenced types are
+  /// all part of the hash, while parameter names are not. A pointer to a
+  /// named struct, union or enum only hashes its name, so the pointer
+  /// cycles of the kernel types are never followed; the pointee is
+  /// compared on its own. Cycles that do not go through a named type
+  /// (only found in malformed data) are cut with a placeholder
+  virtual Result<std::uint64_t, BTFTypeHasherError>
+  getHash(std::uint32_t id) const noexcept = 0;
+
+  virtual const IBTF &btf() const noexcept = 0;
+
+  IBTFTypeHasher(const IBTFTypeHasher &) = delete;
+  IBTFTypeHasher &operator=(const IBTFTypeHasher &) = delete;
+};
+
+} // namespace btfparse
@@ -0,0 +1,51 @@
+//
+// Copyright (c) 2021-present, Trail of Bits, Inc.
+// All rights reserved.
+//
+// This source code is licensed in accordance with the terms specified in
+// the LICENSE file found in the root directory of this source tree.
+//
+
+#pragma once
+
+#include <btfparse/ibtf.h>
+
+#include <memory>
+
+namespace btfparse {
+
+// A fixed set of worker threads, each with its own task queue. Workers
+// run their own tasks newest first, and steal the oldest tasks of the
+// other queues once theirs is empty. A task may itself call run(): its
+// subtasks are queued on the current worker, where idle workers can
+// steal them, so a few large jobs (such as the parallel decoding of a
+// big kernel) do not leave the other threads waiting
+class IBTFWorkerPool {
+public:
+  using Ptr = std::unique_ptr<IBTFWorkerPool>;
+
+  // Starts one worker per core
+  static Ptr create();
+
+  // A thread count of 0 starts one worker per core. Fewer workers are
+  // started if the system runs out of threads
+  static Ptr create(std::size_t thread_count);
+
+  IBTFWorkerPool() = default;
+  virtual ~IBTFWorkerPool() = default;
+
+  // The number of workers that have been started. When it is 0, run()
+  // executes the tasks on the calling thread
+  virtual std::size_t threadCount() const noexcept = 0;
+
+  // Runs all the given tasks and returns once they have completed. The
+  // calling thread also runs tasks while it waits. Tasks must not throw.
+  // This has the same signature as BTFOptions::Executor, so the pool can
+  // be shared by the parses and header generations that run on it
+  virtual void run(const BTFOptions::TaskList &task_list) = 0;
+
+  IBTFWorkerPool(const IBTFWorkerPool &) = delete;
+  IBTFWorkerPool &operator=(const IBTFWorkerPool &) = delete;
+};
+
+} // namespace btfparse
@@ -7,346 +7,1534 @@
 //
 
 #include "btf.h"
+#include "btftelemetry.h"
+#include "btftypededup.h"
 
-#include <unordered_map>
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <mutex>
+#include <thread>
 
 namespace btfparse {
 
 namespace {
 
-const std::unordered_map<BTFKind, BTFTypeParser> kBTFParserMap{
-    {BTFKind::Int, BTF::parseIntData},
-    {BTFKind::Ptr, BTF::parsePtrData},
-    {BTFKind::Const, BTF::parseConstData},
-    {BTFKind::Array, BTF::parseArrayData},
-    {BTFKind::Typedef, BTF::parseTypedefData},
-    {BTFKind::Enum, BTF::parseEnumData},
-    {BTFKind::FuncProto, BTF::parseFuncProtoData},
-    {BTFKind::Volatile, BTF::parseVolatileData},
-    {BTFKind::Struct, BTF::parseStructData},
-    {BTFKind::Union, BTF::parseUnionData},
-    {BTFKind::Fwd, BTF::parseFwdData},
-    {BTFKind::Func, BTF::parseFuncData},
-    {BTFKind::Float, BTF::parseFloatData},
-    {BTFKind::Restrict, BTF::parseRestrictData},
-    {BTFKind::Var, BTF::parseVarData},
-    {BTFKind::DataSec, BTF::parseDataSecData}};
-
-template <typename Type>
-std::optional<BTFError>
-parseStructOrUnionData(Type &output, const BTFFileList &btf_file_list,
-                       const BTFTypeHeader &btf_type_header,
-                       IFileReader &file_reader) noexcept {
+// How many lazily decoded types are allocated at once
+const std::size_t kLazyTypeBlockSize{1024U};
 
-  static_assert(std::is_same<Type, StructBTFType>::value ||
-                    std::is_same<Type, UnionBTFType>::value,
-                "Type must be either StructBTFType or UnionBTFType");
+// How many vector records are copied out of the type data at once
+const std::size_t kRecordBatchSize{64U};
 
-  try {
-    output = {};
+// The vector records that follow the type headers (struct members, enum
+// values, parameters and variables) are only made of 32-bit fields: they
+// are read with a single bounds check, and byte swapped in batches rather
+// than one field at a time. The callback receives the fields of each
+// record in order
+template <std::size_t kFieldCount, bool kByteSwap, typename Callback>
+std::optional<BTFError> decodeRecordList(IFileReader &file_reader,
+                                         std::size_t record_count,
+                                         Callback callback) {
 
-    output.size = btf_type_header.size_or_type;
+  auto record_res = file_reader.tryReadRecord(record_count * kFieldCount *
+                                              sizeof(std::uint32_t));
 
-    if (btf_type_header.name_off != 0) {
-      auto name_res = BTF::parseString(btf_file_list, btf_type_header.name_off);
-      if (name_res.failed()) {
-        return name_res.takeError();
-      }
+  if (record_res.failed()) {
+    return BTF::convertFileReaderError(record_res.takeError());
+  }
+
+  auto record = record_res.takeValue();
+
+  std::array<std::uint32_t, kRecordBatchSize * kFieldCount> field_list;
 
-      output.opt_name = name_res.takeValue();
+  for (std::size_t start = 0; start < record_count;
+       start += kRecordBatchSize) {
+
+    auto batch_size = std::min(record_count - start, kRecordBatchSize);
+    record.u32Array<kByteSwap>(field_list.data(),
+                               batch_size * kFieldCount);
+
+    for (std::size_t i = 0; i < batch_size; ++i) {
+      auto opt_error = callback(&field_list[i * kFieldCount]);
+      if (opt_error.has_value()) {
+        return opt_error;
+      }
     }
+  }
 
-    for (std::uint32_t i = 0; i < btf_type_header.vlen; ++i) {
-      typename Type::Member member{};
+  return std::nullopt;
+}
 
-      auto member_name_off = file_reader.u32();
-      if (member_name_off != 0) {
-        auto member_name_res = BTF::parseString(btf_file_list, member_name_off);
-        if (member_name_res.failed()) {
-          return member_name_res.takeError();
-        }
+template <bool kByteSwap>
+BTFTypeHeader decodeTypeHeader(RecordReader &record) {
+  BTFTypeHeader btf_type_header;
+  btf_type_header.name_off = record.u32<kByteSwap>();
+
+  auto info = record.u32<kByteSwap>();
+  btf_type_header.vlen = info & 0xFFFFUL;
+  btf_type_header.kind = (info & 0x1F000000UL) >> 24UL;
+  btf_type_header.kind_flag = (info & 0x80000000UL) != 0;
 
-        member.opt_name = member_name_res.takeValue();
+  btf_type_header.size_or_type = record.u32<kByteSwap>();
+
+  return btf_type_header;
+}
+
+// Walks the type headers of all the files in ID order. The callback receives
+// the index entry of each type, and returns false to stop the walk. Only
+// the type headers are read: the variable-length data that follows each
+// one is skipped by computing its size
+template <typename Callback>
+std::optional<BTFError> walkTypeSections(const BTFFileList &btf_file_list,
+                                         Callback callback) {
+  for (std::size_t file_index = 0; file_index < btf_file_list.size();
+       ++file_index) {
+
+    const auto &btf_file = btf_file_list[file_index];
+    const auto &btf_header = btf_file.btf_header;
+    auto &file_reader = *btf_file.file_reader.get();
+
+    std::uint64_t current_offset = btf_header.hdr_len + btf_header.type_off;
+    auto type_section_end_offset = current_offset + btf_header.type_len;
+
+    while (current_offset < type_section_end_offset) {
+      auto opt_seek_error = file_reader.trySeek(current_offset);
+      if (opt_seek_error.has_value()) {
+        return BTF::convertFileReaderError(opt_seek_error.value());
+      }
+
+      auto btf_type_header_res = BTF::parseTypeHeader(file_reader);
+      if (btf_type_header_res.failed()) {
+        return btf_type_header_res.takeError();
       }
 
-      member.type = file_reader.u32();
+      auto btf_type_header = btf_type_header_res.takeValue();
 
-      auto offset = file_reader.u32();
-      if (btf_type_header.kind_flag) {
-        member.offset = offset & 0xFFFFFFUL;
-        member.opt_bitfield_size = static_cast<std::uint8_t>(offset >> 24);
+      BTFErrorInformation::FileRange file_range{current_offset,
+                                                kBTFTypeHeaderSize};
 
-      } else {
-        member.offset = offset;
+      if (btf_type_header.kind > static_cast<std::uint8_t>(BTFKind::Float)) {
+        return BTFError{
+            BTFErrorInformation{BTFErrorInformation::Code::InvalidBTFKind,
+                                file_range},
+        };
       }
 
-      output.member_list.push_back(std::move(member));
+      auto btf_kind = static_cast<BTFKind>(btf_type_header.kind);
+      if (btf_kind == BTFKind::Void) {
+        return BTFError{
+            BTFErrorInformation{BTFErrorInformation::Code::UnsupportedBTFKind,
+                                file_range},
+        };
+      }
+
+      if (!callback(BTFTypeIndexEntry{file_index, current_offset, btf_kind,
+                                      btf_type_header.vlen})) {
+        return std::nullopt;
+      }
+
+      current_offset += kBTFTypeHeaderSize +
+                        BTF::getTypeDataSize(btf_kind, btf_type_header.vlen);
     }
+  }
 
-    return std::nullopt;
+  return std::nullopt;
+}
+
+template <bool kByteSwap, typename Type>
+std::optional<BTFError>
+parseStructOrUnionData(Type &output, const BTFStringTable &string_table,
+                       const BTFTypeHeader &btf_type_header,
+                       IFileReader &file_reader,
+                       BTFTypeViewTable &view_table) noexcept {
+
+  static_assert(std::is_same<Type, StructBTFTypeView>::value ||
+                    std::is_same<Type, UnionBTFTypeView>::value,
+                "Type must be either StructBTFTypeView or UnionBTFTypeView");
+
+  output = {};
 
-  } catch (const FileReaderError &error) {
-    return BTF::convertFileReaderError(error);
+  output.size = btf_type_header.size_or_type;
+
+  if (btf_type_header.name_off != 0) {
+    auto name_res = string_table.get(btf_type_header.name_off);
+    if (name_res.failed()) {
+      return name_res.takeError();
+    }
+
+    output.opt_name = name_res.takeValue();
   }
+
+  static_assert(kStructOrUnionMemberSize == 3 * sizeof(std::uint32_t),
+                "Unexpected struct member size");
+
+  return decodeRecordList<3, kByteSwap>(
+      file_reader, btf_type_header.vlen,
+      [&](const std::uint32_t *field_list) -> std::optional<BTFError> {
+        typename Type::Member member{};
+
+        auto member_name_off = field_list[0];
+        if (member_name_off != 0) {
+          auto member_name_res = string_table.get(member_name_off);
+          if (member_name_res.failed()) {
+            return member_name_res.takeError();
+          }
+
+          member.opt_name = member_name_res.takeValue();
+        }
+
+        member.type = field_list[1];
+
+        auto offset = field_list[2];
+        if (btf_type_header.kind_flag) {
+          member.offset = offset & 0xFFFFFFUL;
+          member.opt_bitfield_size = static_cast<std::uint8_t>(offset >> 24);
+
+        } else {
+          member.offset = offset;
+        }
+
+        view_table.append(output.member_list, member);
+        return std::nullopt;
+      });
 }
 
 } // namespace
 
 struct BTF::PrivateData final {
+  struct LazyType final {
+    std::atomic_bool decoded{false};
+    BTFType btf_type;
+  };
+
+  using LazyTypeBlock = std::array<LazyType, kLazyTypeBlockSize>;
+
+  // Split BTF: the types with an id lower than first_type_id, and the
+  // strings below the base string table size, belong to the base
+  IBTF::SharedPtr base_btf;
+  std::uint32_t first_type_id{1U};
+
+  BTFFileList btf_file_list;
+  BTFStringTable string_table;
   BTFTypeMap btf_type_map;
+
+  // Set when the types have been deduplicated: the canonical ID of each
+  // original type, at index (id - first_type_id)
+  bool deduplicated{false};
+  BTFTypeDedup::RemapTable remap_table;
+
+  bool lazy{false};
+  BTFTypeIndex btf_type_index;
+  // The decoded types are stored in blocks that are only allocated when
+  // one of their types is first requested
+  std::unique_ptr<std::atomic<LazyTypeBlock *>[]> lazy_type_block_list;
+  std::vector<std::unique_ptr<LazyTypeBlock>> lazy_type_block_storage;
+  std::mutex lazy_type_list_mutex;
+
+  // Lazy mode: reused by each decodeType call, under lazy_type_list_mutex
+  BTFTypeViewTable lazy_scratch_table;
+
+  // Compact mode: the views are decoded by the constructor, and the owned
+  // copies returned by getTypeRef are created on demand, like lazy types.
+  // The other modes build the views from their types on the first
+  // getTypeView call
+  bool compact{false};
+  std::once_flag type_view_table_once_flag;
+  BTFTypeViewTable type_view_table;
+
+  // Built by the first findByName/findByKind call. Like every once flag
+  // in this library, it stays unset if building throws, and the next
+  // call tries again
+  std::once_flag name_index_once_flag;
+  BTFNameIndex name_index;
 };
 
+Result<IBTF::Ptr, BTFError>
+BTF::create(std::vector<IFileReader::Ptr> file_reader_list,
+            const BTFOptions &options, IBTF::SharedPtr base_btf) noexcept {
+  BTFParseStats stats;
+  std::optional<BTFError> opt_error;
+  Ptr btf;
+
+  {
+    BTFPhaseTimer parse_timer(options.trace_callback, "parse",
+                              &stats.parse_time);
+
+    try {
+      btf.reset(new BTF(std::move(file_reader_list), options,
+                        std::move(base_btf), stats));
+
+    } catch (const std::bad_alloc &) {
+      opt_error = BTFError(BTFErrorInformation{
+          BTFErrorInformation::Code::MemoryAllocationFailure,
+      });
+
+    } catch (const BTFError &e) {
+      opt_error = e;
+    }
+  }
+
+  if (kTelemetryEnabled && options.stats_callback) {
+    options.stats_callback(stats);
+  }
+
+  if (opt_error.has_value()) {
+    return opt_error.value();
+  }
+
+  return btf;
+}
+
 BTF::~BTF() {}
 
 std::optional<BTFType> BTF::getType(std::uint32_t id) const noexcept {
-  auto btf_type_map_it = d->btf_type_map.find(id);
-  if (btf_type_map_it == d->btf_type_map.end()) {
+  const auto *btf_type = getTypeRef(id);
+  if (btf_type == nullptr) {
     return std::nullopt;
   }
 
-  return btf_type_map_it->second;
+  return *btf_type;
 }
 
 std::optional<BTFKind> BTF::getKind(std::uint32_t id) const noexcept {
+  if (id < d->first_type_id) {
+    if (d->base_btf) {
+      return d->base_btf->getKind(id);
+    }
+
+    return std::nullopt;
+  }
+
+  if (d->lazy) {
+    auto index = id - d->first_type_id;
+    if (index >= d->btf_type_index.size()) {
+      return std::nullopt;
+    }
+
+    return d->btf_type_index[index].kind;
+  }
+
+  if (d->compact) {
+    auto index = id - d->first_type_id;
+    if (index >= d->type_view_table.size()) {
+      return std::nullopt;
+    }
+
+    return getBTFTypeKind(d->type_view_table[index]);
+  }
+
+  const auto *btf_type = getTypeRef(id);
+  if (btf_type == nullptr) {
+    return std::nullopt;
+  }
+
+  return getBTFTypeKind(*btf_type);
+}
+
+const BTFType *BTF::getTypeRef(std::uint32_t id) const noexcept {
+  if (id < d->first_type_id) {
+    if (d->base_btf) {
+      return d->base_btf->getTypeRef(id);
+    }
+
+    return nullptr;
+  }
+
+  if (d->lazy || d->compact) {
+    return getLazyTypeRef(id);
+  }
+
   auto btf_type_map_it = d->btf_type_map.find(id);
   if (btf_type_map_it == d->btf_type_map.end()) {
+    return nullptr;
+  }
+
+  return &btf_type_map_it->second;
+}
+
+std::optional<BTFTypeView> BTF::getTypeView(std::uint32_t id) const noexcept {
+  if (id < d->first_type_id) {
+    if (d->base_btf) {
+      return d->base_btf->getTypeView(id);
+    }
+
+    return std::nullopt;
+  }
+
+  const auto *type_view_table = getTypeViewTable();
+  if (type_view_table == nullptr) {
+    return std::nullopt;
+  }
+
+  auto index = static_cast<std::size_t>(id - d->first_type_id);
+  if (index >= type_view_table->size()) {
+    return std::nullopt;
+  }
+
+  const auto &btf_type_view = (*type_view_table)[index];
+  if (std::holds_alternative<std::monostate>(btf_type_view)) {
     return std::nullopt;
   }
 
-  const auto &btf_type = btf_type_map_it->second;
-  return getBTFTypeKind(btf_type);
+  return btf_type_view;
+}
+
+std::uint32_t BTF::count() const noexcept {
+  auto type_count = d->lazy      ? d->btf_type_index.size()
+                    : d->compact ? d->type_view_table.size()
+                                 : d->btf_type_map.size();
+  return d->first_type_id - 1 + static_cast<std::uint32_t>(type_count);
+}
+
+BTFTypeMap BTF::getAll() const noexcept {
+  if (!d->lazy && !d->compact && !d->base_btf) {
+    return d->btf_type_map;
+  }
+
+  BTFTypeMap btf_type_map;
+  btf_type_map.reserve(count());
+
+  forEach([&btf_type_map](std::uint32_t id, const BTFType &btf_type) {
+    btf_type_map.insert({id, btf_type});
+    return true;
+  });
+
+  return btf_type_map;
+}
+
+std::optional<std::uint32_t>
+BTF::getCanonicalID(std::uint32_t original_id) const noexcept {
+  // The base can not be deduplicated, so its types keep their IDs
+  if (original_id < d->first_type_id) {
+    if (d->base_btf) {
+      return d->base_btf->getCanonicalID(original_id);
+    }
+
+    return original_id;
+  }
+
+  if (!d->deduplicated) {
+    if (original_id > count()) {
+      return std::nullopt;
+    }
+
+    return original_id;
+  }
+
+  auto index = static_cast<std::size_t>(original_id - d->first_type_id);
+  if (index >= d->remap_table.size()) {
+    return std::nullopt;
+  }
+
+  return d->remap_table[index];
+}
+
+BTFTypeIDRange BTF::findByName(std::string_view name) const noexcept {
+  const auto *name_index = getNameIndex();
+  if (name_index == nullptr) {
+    return {};
+  }
+
+  return name_index->findByName(name);
+}
+
+BTFTypeIDRange BTF::findByName(std::string_view name,
+                               BTFKind kind) const noexcept {
+  const auto *name_index = getNameIndex();
+  if (name_index == nullptr) {
+    return {};
+  }
+
+  return name_index->findByName(name, kind);
+}
+
+BTFTypeIDRange BTF::findByKind(BTFKind kind) const noexcept {
+  const auto *name_index = getNameIndex();
+  if (name_index == nullptr) {
+    return {};
+  }
+
+  return name_index->findByKind(kind);
+}
+
+bool BTF::forEach(const ForEachCallback &callback) const {
+  if (d->base_btf && !d->base_btf->forEach(callback)) {
+    return false;
+  }
+
+  if (d->lazy || d->compact) {
+    auto type_count = count() - (d->first_type_id - 1);
+
+    for (std::uint32_t i = 0; i < type_count; ++i) {
+      auto id = d->first_type_id + i;
+
+      const auto *btf_type = getLazyTypeRef(id);
+      if (btf_type != nullptr && !callback(id, *btf_type)) {
+        return false;
+      }
+    }
+
+    return true;
+  }
+
+  for (const auto &btf_type_map_p : d->btf_type_map) {
+    if (!callback(btf_type_map_p.first, btf_type_map_p.second)) {
+      return false;
+    }
+  }
+
+  return true;
+}
+
+const BTFStringTable &BTF::stringTable() const noexcept {
+  return d->string_table;
+}
+
+const BTFTypeViewTable *BTF::getTypeViewTable() const noexcept {
+  if (d->compact) {
+    return &d->type_view_table;
+  }
+
+  try {
+    std::call_once(d->type_view_table_once_flag, [this]() {
+      d->type_view_table.build(*this, d->first_type_id, count());
+    });
+
+    return &d->type_view_table;
+
+  } catch (const std::exception &) {
+    return nullptr;
+  }
+}
+
+const BTFNameIndex *BTF::getNameIndex() const noexcept {
+  try {
+    std::call_once(d->name_index_once_flag, [this]() {
+      BTFNameIndex::EntryList entry_list;
+      entry_list.reserve(count());
+
+      collectNameIndexEntries(entry_list);
+      d->name_index.build(entry_list);
+    });
+
+    return &d->name_index;
+
+  } catch (const std::exception &) {
+    return nullptr;
+  }
+}
+
+void BTF::collectNameIndexEntries(BTFNameIndex::EntryList &entry_list) const {
+  // The base was created by this library, as checked by the constructor.
+  // Its names are pointing inside the base, which outlives this object
+  if (d->base_btf) {
+    static_cast<const BTF &>(*d->base_btf).collectNameIndexEntries(entry_list);
+  }
+
+  if (d->compact) {
+    for (std::size_t i = 0; i < d->type_view_table.size(); ++i) {
+      const auto &btf_type_view = d->type_view_table[i];
+
+      entry_list.push_back({d->first_type_id + static_cast<std::uint32_t>(i),
+                            getBTFTypeKind(btf_type_view),
+                            BTFNameIndex::getTypeName(btf_type_view)});
+    }
+
+    return;
+  }
+
+  if (!d->lazy) {
+    for (const auto &btf_type_map_p : d->btf_type_map) {
+      const auto &btf_type = btf_type_map_p.second;
+
+      entry_list.push_back({btf_type_map_p.first, getBTFTypeKind(btf_type),
+                            BTFNameIndex::getTypeName(btf_type)});
+    }
+
+    return;
+  }
+
+  // Lazy objects only read the type headers, so that building the index
+  // does not decode all the types. The names are taken straight from the
+  // string table, which already interns them. The file readers are shared
+  // with the lazy decoding
+  std::lock_guard<std::mutex> lock(d->lazy_type_list_mutex);
+
+  for (std::size_t i = 0; i < d->btf_type_index.size(); ++i) {
+    const auto &btf_type_index_entry = d->btf_type_index[i];
+
+    BTFNameIndex::Entry entry;
+    entry.id = d->first_type_id + static_cast<std::uint32_t>(i);
+    entry.kind = btf_type_index_entry.kind;
+
+    const auto &btf_file = d->btf_file_list[btf_type_index_entry.file_index];
+    auto &file_reader = *btf_file.file_reader.get();
+
+    if (!file_reader.trySeek(btf_type_index_entry.offset).has_value()) {
+      auto btf_type_header_res = parseTypeHeader(file_reader);
+      if (!btf_type_header_res.failed()) {
+        auto name_off = btf_type_header_res.value().name_off;
+
+        if (name_off != 0) {
+          auto name_res = d->string_table.get(name_off);
+          if (!name_res.failed()) {
+            entry.name = name_res.takeValue();
+          }
+        }
+      }
+    }
+
+    entry_list.push_back(entry);
+  }
+}
+
+BTF::BTF(std::vector<IFileReader::Ptr> file_reader_list,
+         const BTFOptions &options, IBTF::SharedPtr base_btf,
+         BTFParseStats &stats)
+    : d(new PrivateData) {
+  // Deduplication needs all the types, and renumbers them
+  if (options.deduplicate &&
+      options.decoding_mode != BTFOptions::DecodingMode::Eager) {
+    throw BTFError(BTFErrorInformation{
+        BTFErrorInformation::Code::UnsupportedOptions,
+    });
+  }
+
+  const BTF *base_btf_impl{nullptr};
+  if (base_btf) {
+    base_btf_impl = dynamic_cast<const BTF *>(base_btf.get());
+    if (base_btf_impl == nullptr || base_btf_impl->d->deduplicated) {
+      throw BTFError(BTFErrorInformation{
+          BTFErrorInformation::Code::InvalidBaseBTF,
+      });
+    }
+
+    d->first_type_id = base_btf->count() + 1;
+    d->base_btf = std::move(base_btf);
+  }
+
+  BTFPhaseTimer open_timer(options.trace_callback, "openBTFFileList",
+                           nullptr);
+
+  auto btf_file_list_res = openBTFFileList(std::move(file_reader_list));
+  if (btf_file_list_res.failed()) {
+    throw btf_file_list_res.takeError();
+  }
+
+  auto btf_file_list = btf_file_list_res.takeValue();
+  open_timer.stop();
+
+  if (kTelemetryEnabled) {
+    for (const auto &btf_file : btf_file_list) {
+      const auto &btf_header = btf_file.btf_header;
+      stats.bytes_read += static_cast<std::uint64_t>(btf_header.hdr_len) +
+                          btf_header.type_len + btf_header.str_len;
+    }
+  }
+
+  BTFPhaseTimer string_table_timer(options.trace_callback,
+                                   "createStringTable", nullptr);
+
+  auto string_table_res =
+      base_btf_impl != nullptr
+          ? BTFStringTable::create(btf_file_list, base_btf_impl->stringTable())
+          : BTFStringTable::create(btf_file_list);
+
+  if (string_table_res.failed()) {
+    throw string_table_res.takeError();
+  }
+
+  d->string_table = string_table_res.takeValue();
+  string_table_timer.stop();
+
+  auto kind_stats_list = kTelemetryEnabled && options.stats_callback
+                             ? &stats.kind_stats_list
+                             : nullptr;
+
+  std::optional<BTFError> opt_decoding_error;
+
+  if (options.decoding_mode == BTFOptions::DecodingMode::Lazy) {
+    BTFPhaseTimer index_timer(options.trace_callback, "indexTypeSections",
+                              nullptr);
+
+    opt_decoding_error = indexTypeSections(d->btf_type_index, btf_file_list);
+    d->lazy = true;
+
+  } else if (options.decoding_mode == BTFOptions::DecodingMode::Compact) {
+    BTFPhaseTimer decode_timer(options.trace_callback, "decodeTypeViews",
+                               nullptr);
+
+    opt_decoding_error = decodeTypeViews(d->type_view_table, btf_file_list,
+                                         d->string_table, kind_stats_list);
+    d->compact = true;
+
+  } else {
+    BTFPhaseTimer decode_timer(options.trace_callback, "parseTypeSections",
+                               nullptr);
+
+    auto btf_type_map_res =
+        parseTypeSections(btf_file_list, d->string_table, d->first_type_id,
+                          options, kind_stats_list);
+
+    if (btf_type_map_res.failed()) {
+      opt_decoding_error = btf_type_map_res.takeError();
+    } else {
+      d->btf_type_map = btf_type_map_res.takeValue();
+    }
+  }
+
+  // Recorded before throwing, so that failed parses report it as well
+  stats.string_lookup_count = d->string_table.lookupCount();
+  if (opt_decoding_error.has_value()) {
+    throw opt_decoding_error.value();
+  }
+
+  if (options.deduplicate) {
+    BTFPhaseTimer dedup_timer(options.trace_callback, "deduplicateTypes",
+                              nullptr);
+
+    d->remap_table =
+        BTFTypeDedup::deduplicate(d->btf_type_map, d->base_btf.get());
+
+    d->deduplicated = true;
+  }
+
+  if (d->lazy || d->compact) {
+    auto type_count =
+        d->lazy ? d->btf_type_index.size() : d->type_view_table.size();
+
+    auto lazy_type_block_count =
+        (type_count + kLazyTypeBlockSize - 1) / kLazyTypeBlockSize;
+
+    d->lazy_type_block_list.reset(
+        new std::atomic<PrivateData::LazyTypeBlock *>[lazy_type_block_count]);
+
+    for (std::size_t i = 0; i < lazy_type_block_count; ++i) {
+      d->lazy_type_block_list[i].store(nullptr, std::memory_order_relaxed);
+    }
+  }
+
+  // The string table references the memory-resident files in place
+  d->btf_file_list = std::move(btf_file_list);
+}
+
+const BTFType *BTF::getLazyTypeRef(std::uint32_t id) const noexcept {
+  if (id < d->first_type_id) {
+    return nullptr;
+  }
+
+  auto index = static_cast<std::size_t>(id - d->first_type_id);
+  if (index >= count() - (d->first_type_id - 1)) {
+    return nullptr;
+  }
+
+  auto &lazy_type_block = d->lazy_type_block_list[index / kLazyTypeBlockSize];
+  auto lazy_type_block_ptr = lazy_type_block.load(std::memory_order_acquire);
+
+  // The file readers are not thread safe, so decoding happens under the
+  // lock. Decoded types are never modified again and can be read without it
+  if (lazy_type_block_ptr == nullptr ||
+      !(*lazy_type_block_ptr)[index % kLazyTypeBlockSize].decoded.load(
+          std::memory_order_acquire)) {
+
+    std::lock_guard<std::mutex> lock(d->lazy_type_list_mutex);
+
+    lazy_type_block_ptr = lazy_type_block.load(std::memory_order_relaxed);
+    if (lazy_type_block_ptr == nullptr) {
+      try {
+        d->lazy_type_block_storage.push_back(
+            std::make_unique<PrivateData::LazyTypeBlock>());
+
+      } catch (const std::bad_alloc &) {
+        return nullptr;
+      }
+
+      lazy_type_block_ptr = d->lazy_type_block_storage.back().get();
+      lazy_type_block.store(lazy_type_block_ptr, std::memory_order_release);
+    }
+
+    auto &lazy_type = (*lazy_type_block_ptr)[index % kLazyTypeBlockSize];
+    if (!lazy_type.decoded.load(std::memory_order_relaxed)) {
+      if (d->compact) {
+        try {
+          lazy_type.btf_type =
+              BTFTypeViewTable::createType(d->type_view_table[index]);
+
+        } catch (const std::bad_alloc &) {
+          // The type is not marked as decoded, so the next call will try
+          // again
+          return nullptr;
+        }
+
+      } else {
+        const auto &btf_type_index_entry = d->btf_type_index[index];
+
+        auto &file_reader =
+            *d->btf_file_list[btf_type_index_entry.file_index].file_reader;
+
+        auto btf_type_res =
+            decodeType(file_reader, d->string_table, btf_type_index_entry,
+                       d->lazy_scratch_table);
+
+        // Types that fail to decode are left empty and reported as missing
+        if (!btf_type_res.failed()) {
+          lazy_type.btf_type = btf_type_res.takeValue();
+        }
+      }
+
+      lazy_type.decoded.store(true, std::memory_order_release);
+    }
+  }
+
+  const auto &lazy_type = (*lazy_type_block_ptr)[index % kLazyTypeBlockSize];
+  if (std::holds_alternative<std::monostate>(lazy_type.btf_type)) {
+    return nullptr;
+  }
+
+  return &lazy_type.btf_type;
+}
+
+Result<BTFFileList, BTFError>
+BTF::openBTFFileList(std::vector<IFileReader::Ptr> file_reader_list) noexcept {
+  try {
+    BTFFileList btf_file_list;
+
+    for (auto &file_reader_ptr : file_reader_list) {
+      BTFFile btf_file;
+      btf_file.file_reader = std::move(file_reader_ptr);
+
+      auto &file_reader = *btf_file.file_reader.get();
+
+      bool little_endian{false};
+      auto opt_error = detectEndianness(little_endian, file_reader);
+      if (opt_error.has_value()) {
+        return opt_error.value();
+      }
+
+      file_reader.setEndianness(little_endian);
+      btf_file.little_endian = little_endian;
+
+      auto btf_header_res = readBTFHeader(file_reader);
+      if (btf_header_res.failed()) {
+        return btf_header_res.takeError();
+      }
+
+      btf_file.btf_header = btf_header_res.takeValue();
+      btf_file_list.push_back(std::move(btf_file));
+    }
+
+    return btf_file_list;
+
+  } catch (const std::bad_alloc &) {
+    return BTFError(BTFErrorInformation{
+        BTFErrorInformation::Code::MemoryAllocationFailure,
+    });
+  }
+}
+
+std::optional<BTFError>
+BTF::parseTypes(std::vector<IFileReader::Ptr> file_reader_list,
+                const ParseCallback &callback) {
+  auto btf_file_list_res = openBTFFileList(std::move(file_reader_list));
+  if (btf_file_list_res.failed()) {
+    return btf_file_list_res.takeError();
+  }
+
+  auto btf_file_list = btf_file_list_res.takeValue();
+
+  auto string_table_res = BTFStringTable::create(btf_file_list);
+  if (string_table_res.failed()) {
+    return string_table_res.takeError();
+  }
+
+  auto string_table = string_table_res.takeValue();
+
+  // Each type is decoded in the same scratch table, which only grows to
+  // the size of the largest type. Exceptions thrown by the callback are
+  // propagated to the caller
+  BTFTypeViewTable scratch_table;
+  std::optional<BTFError> opt_decoding_error;
+  std::uint32_t type_id{1U};
+
+  auto opt_error = walkTypeSections(
+      btf_file_list, [&](const BTFTypeIndexEntry &btf_type_index_entry) {
+        try {
+          BTFTypeViewTable::Capacity capacity;
+          BTFTypeViewTable::addTypeCapacity(capacity,
+                                            btf_type_index_entry.kind,
+                                            btf_type_index_entry.vlen);
+
+          scratch_table.reset(capacity);
+
+        } catch (const std::bad_alloc &) {
+          opt_decoding_error = BTFError(BTFErrorInformation{
+              BTFErrorInformation::Code::MemoryAllocationFailure,
+          });
+
+          return false;
+        }
+
+        auto &file_reader =
+            *btf_file_list[btf_type_index_entry.file_index].file_reader;
+
+        auto btf_type_view_res = decodeTypeView(
+            file_reader, string_table, btf_type_index_entry, scratch_table);
+
+        if (btf_type_view_res.failed()) {
+          opt_decoding_error = btf_type_view_res.takeError();
+          return false;
+        }
+
+        return callback(type_id++, btf_type_view_res.takeValue());
+      });
+
+  if (opt_decoding_error.has_value()) {
+    return opt_decoding_error;
+  }
+
+  return opt_error;
+}
+
+BTFError BTF::convertFileReaderError(const FileReaderError &error) noexcept {
+  const auto &file_reader_error_info = error.get();
+
+  BTFErrorInformation::Code error_code{BTFErrorInformation::Code::Unknown};
+  switch (file_reader_error_info.code) {
+  case FileReaderErrorInformation::Code::Unknown:
+    error_code = BTFErrorInformation::Code::Unknown;
+    break;
+
+  case FileReaderErrorInformation::Code::MemoryAllocationFailure:
+    error_code = BTFErrorInformation::Code::MemoryAllocationFailure;
+    break;
+
+  case FileReaderErrorInformation::Code::FileNotFound:
+    error_code = BTFErrorInformation::Code::FileNotFound;
+    break;
+
+  case FileReaderErrorInformation::Code::IOError:
+    error_code = BTFErrorInformation::Code::IOError;
+    break;
+
+  case FileReaderErrorInformation::Code::InvalidELFFile:
+    error_code = BTFErrorInformation::Code::InvalidELFFile;
+    break;
+
+  case FileReaderErrorInformation::Code::ELFSectionNotFound:
+    error_code = BTFErrorInformation::Code::ELFSectionNotFound;
+    break;
+  }
+
+  std::optional<BTFErrorInformation::FileRange> opt_file_range;
+  if (file_reader_error_info.opt_read_operation.has_value()) {
+    const auto &read_operation =
+        file_reader_error_info.opt_read_operation.value();
+
+    opt_file_range = BTFErrorInformation::FileRange{
+        read_operation.offset,
+        read_operation.size,
+    };
+  }
+
+  return BTFError{
+      BTFErrorInformation{
+          error_code,
+          opt_file_range,
+      },
+  };
+}
+
+std::optional<BTFError>
+BTF::detectEndianness(bool &little_endian, IFileReader &file_reader) noexcept {
+  auto opt_seek_error = file_reader.trySeek(0);
+  if (opt_seek_error.has_value()) {
+    return convertFileReaderError(opt_seek_error.value());
+  }
+
+  file_reader.setEndianness(true);
+
+  auto record_res = file_reader.tryReadRecord(2);
+  if (record_res.failed()) {
+    return convertFileReaderError(record_res.takeError());
+  }
+
+  auto magic = record_res.takeValue().u16();
+  if (magic == kLittleEndianMagicValue) {
+    little_endian = true;
+
+  } else if (magic == kBigEndianMagicValue) {
+    little_endian = false;
+
+  } else {
+    return BTFError{
+        BTFErrorInformation{
+            BTFErrorInformation::Code::InvalidMagicValue,
+        },
+    };
+  }
+
+  return std::nullopt;
+}
+
+Result<BTFHeader, BTFError>
+BTF::readBTFHeader(IFileReader &file_reader) noexcept {
+  auto opt_seek_error = file_reader.trySeek(0);
+  if (opt_seek_error.has_value()) {
+    return convertFileReaderError(opt_seek_error.value());
+  }
+
+  auto record_res = file_reader.tryReadRecord(kBTFHeaderSize);
+  if (record_res.failed()) {
+    return convertFileReaderError(record_res.takeError());
+  }
+
+  auto record = record_res.takeValue();
+
+  BTFHeader btf_header{};
+  btf_header.magic = record.u16();
+  btf_header.version = record.u8();
+  btf_header.flags = record.u8();
+  btf_header.hdr_len = record.u32();
+  btf_header.type_off = record.u32();
+  btf_header.type_len = record.u32();
+  btf_header.str_off = record.u32();
+  btf_header.str_len = record.u32();
+
+  return btf_header;
+}
+
+Result<BTFTypeMap, BTFError>
+BTF::parseTypeSections(const BTFFileList &btf_file_list,
+                       const BTFStringTable &string_table,
+                       std::uint32_t first_type_id,
+                       const BTFOptions &options) noexcept {
+  return parseTypeSections(btf_file_list, string_table, first_type_id, options,
+                           nullptr);
+}
+
+Result<BTFTypeMap, BTFError> BTF::parseTypeSections(
+    const BTFFileList &btf_file_list, const BTFStringTable &string_table,
+    std::uint32_t first_type_id, const BTFOptions &options,
+    BTFParseStats::KindStatsList *kind_stats_list) noexcept {
+  BTFTypeIndex btf_type_index;
+  auto opt_index_error = indexTypeSections(btf_type_index, btf_file_list);
+
+  // Decode the types that precede the first index error (if any), so that
+  // errors are reported in the same order they appear in the file
+  BTFTypeMap btf_type_map;
+
+  try {
+    btf_type_map.reserve(btf_type_index.size());
+
+  } catch (const std::bad_alloc &) {
+    return BTFError(BTFErrorInformation{
+        BTFErrorInformation::Code::MemoryAllocationFailure,
+    });
+  }
+
+  // Parallel decoding needs one reader per task, which can only be
+  // created for memory-resident files
+  auto parallel_decoding =
+      getThreadCount(options) > 1 &&
+      std::all_of(btf_file_list.begin(), btf_file_list.end(),
+                  [](const BTFFile &btf_file) {
+                    return btf_file.file_reader->buffer().has_value();
+                  });
+
+  if (parallel_decoding) {
+    auto opt_error = decodeTypesInParallel(btf_type_map, btf_type_index,
+                                           btf_file_list, string_table,
+                                           first_type_id, options,
+                                           kind_stats_list);
+    if (opt_error.has_value()) {
+      return opt_error.value();
+    }
+
+  } else {
+    auto type_id = first_type_id;
+    BTFTypeViewTable scratch_table;
+    BTFKindStatsRecorder kind_stats_recorder(kind_stats_list);
+
+    for (const auto &btf_type_index_entry : btf_type_index) {
+      auto &file_reader =
+          *btf_file_list[btf_type_index_entry.file_index].file_reader;
+
+      kind_stats_recorder.start();
+      auto btf_type_res = decodeType(file_reader, string_table,
+                                     btf_type_index_entry, scratch_table);
+
+      if (btf_type_res.failed()) {
+        return btf_type_res.takeError();
+      }
+
+      btf_type_map.insert({type_id, btf_type_res.takeValue()});
+      kind_stats_recorder.stop(btf_type_index_entry.kind);
+      ++type_id;
+    }
+  }
+
+  if (opt_index_error.has_value()) {
+    return opt_index_error.value();
+  }
+
+  return btf_type_map;
+}
+
+std::optional<BTFError>
+BTF::decodeTypeViews(BTFTypeViewTable &view_table,
+                     const BTFFileList &btf_file_list,
+                     const BTFStringTable &string_table,
+                     BTFParseStats::KindStatsList *kind_stats_list) noexcept {
+  BTFTypeIndex btf_type_index;
+  auto opt_index_error = indexTypeSections(btf_type_index, btf_file_list);
+
+  // The index is enough to size the blocks of the table, which are then
+  // allocated only once. As in parseTypeSections, the types that precede
+  // the first index error are decoded first
+  try {
+    BTFTypeViewTable::Capacity capacity;
+    for (const auto &btf_type_index_entry : btf_type_index) {
+      BTFTypeViewTable::addTypeCapacity(capacity, btf_type_index_entry.kind,
+                                        btf_type_index_entry.vlen);
+    }
+
+    view_table.reset(capacity);
+    BTFKindStatsRecorder kind_stats_recorder(kind_stats_list);
+
+    for (const auto &btf_type_index_entry : btf_type_index) {
+      auto &file_reader =
+          *btf_file_list[btf_type_index_entry.file_index].file_reader;
+
+      kind_stats_recorder.start();
+      auto btf_type_view_res = decodeTypeView(file_reader, string_table,
+                                              btf_type_index_entry, view_table);
+
+      if (btf_type_view_res.failed()) {
+        return btf_type_view_res.takeError();
+      }
+
+      view_table.push(btf_type_view_res.takeValue());
+      kind_stats_recorder.stop(btf_type_index_entry.kind);
+    }
+
+  } catch (const std::bad_alloc &) {
+    return BTFError(BTFErrorInformation{
+        BTFErrorInformation::Code::MemoryAllocationFailure,
+    });
+  }
+
+  return opt_index_error;
+}
+
+std::size_t BTF::getThreadCount(const BTFOptions &options) noexcept {
+  if (options.thread_count != 0) {
+    return options.thread_count;
+  }
+
+  return std::max(std::thread::hardware_concurrency(), 1U);
 }
 
-std::uint32_t BTF::count() const noexcept {
-  return static_cast<std::uint32_t>(d->btf_type_map.size());
-}
+std::optional<BTFError> BTF::decodeTypesInParallel(
+    BTFTypeMap &btf_type_map, const BTFTypeIndex &btf_type_index,
+    const BTFFileList &btf_file_list, const BTFStringTable &string_table,
+    std::uint32_t first_type_id, const BTFOptions &options,
+    BTFParseStats::KindStatsList *kind_stats_list) noexcept {
 
-BTFTypeMap BTF::getAll() const noexcept { return d->btf_type_map; }
+  struct Task final {
+    std::size_t start{};
+    std::size_t end{};
 
-BTF::BTF(const PathList &path_list) : d(new PrivateData) {
-  BTFFileList btf_file_list;
+    std::vector<BTFType> btf_type_list;
+    std::optional<BTFError> opt_error;
 
-  for (const auto &path : path_list) {
-    auto file_reader_res = IFileReader::open(path);
-    if (file_reader_res.failed()) {
-      throw convertFileReaderError(file_reader_res.takeError());
+    // Merged once all the tasks have completed
+    BTFParseStats::KindStatsList kind_stats_list{};
+  };
+
+  try {
+    auto task_count = std::min(getThreadCount(options), btf_type_index.size());
+    if (task_count == 0) {
+      return std::nullopt;
     }
 
-    BTFFile btf_file;
-    btf_file.file_reader = file_reader_res.takeValue();
+    auto task_size = (btf_type_index.size() + task_count - 1) / task_count;
 
-    auto &file_reader = *btf_file.file_reader.get();
+    std::vector<Task> task_list(task_count);
+    BTFOptions::TaskList task_function_list;
 
-    bool little_endian{false};
-    auto opt_error = detectEndianness(little_endian, file_reader);
-    if (opt_error.has_value()) {
-      throw opt_error.value();
-    }
+    for (std::size_t i = 0; i < task_count; ++i) {
+      auto *task = &task_list[i];
+      task->start = std::min(i * task_size, btf_type_index.size());
+      task->end = std::min(task->start + task_size, btf_type_index.size());
 
-    file_reader.setEndianness(little_endian);
+      auto task_kind_stats_list =
+          kind_stats_list != nullptr ? &task->kind_stats_list : nullptr;
 
-    auto btf_header_res = readBTFHeader(file_reader);
-    if (btf_header_res.failed()) {
-      throw btf_header_res.takeError();
+      task_function_list.push_back([task, &btf_type_index, &btf_file_list,
+                                    &string_table, task_kind_stats_list]() {
+        task->opt_error = decodeTypeRange(
+            task->btf_type_list, btf_type_index, task->start, task->end,
+            btf_file_list, string_table, task_kind_stats_list);
+      });
     }
 
-    btf_file.btf_header = btf_header_res.takeValue();
-    btf_file_list.push_back(std::move(btf_file));
-  }
-
-  auto btf_type_map_res = parseTypeSections(btf_file_list);
-  if (btf_type_map_res.failed()) {
-    throw btf_type_map_res.takeError();
-  }
-
-  d->btf_type_map = btf_type_map_res.takeValue();
-}
+    runTasks(task_function_list, options);
 
-BTFError BTF::convertFileReaderError(const FileReaderError &error) noexcept {
-  const auto &file_reader_error_info = error.get();
+    if (kind_stats_list != nullptr) {
+      for (const auto &task : task_list) {
+        addKindStats(*kind_stats_list, task.kind_stats_list);
+      }
+    }
 
-  BTFErrorInformation::Code error_code{BTFErrorInformation::Code::Unknown};
-  switch (file_reader_error_info.code) {
-  case FileReaderErrorInformation::Code::Unknown:
-    error_code = BTFErrorInformation::Code::Unknown;
-    break;
+    // Each task stops at its first error, so the first failed task in
+    // file order holds the same error the sequential decoding would return
+    auto type_id = first_type_id;
 
-  case FileReaderErrorInformation::Code::MemoryAllocationFailure:
-    error_code = BTFErrorInformation::Code::MemoryAllocationFailure;
-    break;
+    for (auto &task : task_list) {
+      for (auto &btf_type : task.btf_type_list) {
+        btf_type_map.insert({type_id, std::move(btf_type)});
+        ++type_id;
+      }
 
-  case FileReaderErrorInformation::Code::FileNotFound:
-    error_code = BTFErrorInformation::Code::FileNotFound;
-    break;
+      if (task.opt_error.has_value()) {
+        return task.opt_error;
+      }
 
-  case FileReaderErrorInformation::Code::IOError:
-    error_code = BTFErrorInformation::Code::IOError;
-    break;
-  }
+      if (task.btf_type_list.size() != task.end - task.start) {
+        return BTFError(BTFErrorInformation{
+            BTFErrorInformation::Code::Unknown,
+        });
+      }
+    }
 
-  std::optional<BTFErrorInformation::FileRange> opt_file_range;
-  if (file_reader_error_info.opt_read_operation.has_value()) {
-    const auto &read_operation =
-        file_reader_error_info.opt_read_operation.value();
+    return std::nullopt;
 
-    opt_file_range = BTFErrorInformation::FileRange{
-        read_operation.offset,
-        read_operation.size,
-    };
+  } catch (const std::bad_alloc &) {
+    return BTFError(BTFErrorInformation{
+        BTFErrorInformation::Code::MemoryAllocationFailure,
+    });
   }
-
-  return BTFError{
-      BTFErrorInformation{
-          error_code,
-          opt_file_range,
-      },
-  };
 }
 
 std::optional<BTFError>
-BTF::detectEndianness(bool &little_endian, IFileReader &file_reader) noexcept {
+BTF::decodeTypeRange(std::vector<BTFType> &btf_type_list,
+                     const BTFTypeIndex &btf_type_index, std::size_t start,
+                     std::size_t end, const BTFFileList &btf_file_list,
+                     const BTFStringTable &string_table,
+                     BTFParseStats::KindStatsList *kind_stats_list) noexcept {
   try {
-    file_reader.seek(0);
-    file_reader.setEndianness(true);
+    btf_type_list.clear();
+    btf_type_list.reserve(end - start);
 
-    auto magic = file_reader.u16();
-    if (magic == kLittleEndianMagicValue) {
-      little_endian = true;
+    std::vector<IFileReader::Ptr> file_reader_list(btf_file_list.size());
+    BTFTypeViewTable scratch_table;
+    BTFKindStatsRecorder kind_stats_recorder(kind_stats_list);
 
-    } else if (magic == kBigEndianMagicValue) {
-      little_endian = false;
+    for (auto i = start; i < end; ++i) {
+      const auto &btf_type_index_entry = btf_type_index[i];
 
-    } else {
-      return BTFError{
-          BTFErrorInformation{
-              BTFErrorInformation::Code::InvalidMagicValue,
-          },
-      };
+      auto &file_reader = file_reader_list[btf_type_index_entry.file_index];
+      if (!file_reader) {
+        const auto &btf_file = btf_file_list[btf_type_index_entry.file_index];
+        auto buffer = btf_file.file_reader->buffer().value();
+
+        auto file_reader_res =
+            IFileReader::createFromBuffer(buffer.data, buffer.size);
+
+        if (file_reader_res.failed()) {
+          return convertFileReaderError(file_reader_res.takeError());
+        }
+
+        file_reader = file_reader_res.takeValue();
+        file_reader->setEndianness(btf_file.little_endian);
+      }
+
+      kind_stats_recorder.start();
+      auto btf_type_res = decodeType(*file_reader, string_table,
+                                     btf_type_index_entry, scratch_table);
+
+      if (btf_type_res.failed()) {
+        return btf_type_res.takeError();
+      }
+
+      btf_type_list.push_back(btf_type_res.takeValue());
+      kind_stats_recorder.stop(btf_type_index_entry.kind);
     }
 
     return std::nullopt;
 
-  } catch (const FileReaderError &error) {
-    return convertFileReaderError(error);
+  } catch (const std::bad_alloc &) {
+    return BTFError(BTFErrorInformation{
+        BTFErrorInformation::Code::MemoryAllocationFailure,
+    });
+
+  } catch (const std::bad_optional_access &) {
+    return BTFError(BTFErrorInformation{
+        BTFErrorInformation::Code::Unknown,
+    });
   }
 }
 
-Result<BTFHeader, BTFError>
-BTF::readBTFHeader(IFileReader &file_reader) noexcept {
-  try {
-    file_reader.seek(0);
+void BTF::runTasks(const BTFOptions::TaskList &task_list,
+                   const BTFOptions &options) {
+  if (options.executor) {
+    options.executor(task_list);
+    return;
+  }
+
+  // The first task is run on the current thread. Tasks that can't get
+  // a thread of their own are also run here
+  std::vector<std::thread> thread_list;
+  for (std::size_t i = 1; i < task_list.size(); ++i) {
+    try {
+      thread_list.emplace_back(task_list[i]);
 
-    BTFHeader btf_header{};
-    btf_header.magic = file_reader.u16();
-    btf_header.version = file_reader.u8();
-    btf_header.flags = file_reader.u8();
-    btf_header.hdr_len = file_reader.u32();
-    btf_header.type_off = file_reader.u32();
-    btf_header.type_len = file_reader.u32();
-    btf_header.str_off = file_reader.u32();
-    btf_header.str_len = file_reader.u32();
+    } catch (const std::system_error &) {
+      task_list[i]();
+    }
+  }
 
-    return btf_header;
+  if (!task_list.empty()) {
+    task_list.front()();
+  }
 
-  } catch (const FileReaderError &error) {
-    return convertFileReaderError(error);
+  for (auto &thread : thread_list) {
+    thread.join();
   }
 }
 
-Result<BTFTypeMap, BTFError>
-BTF::parseTypeSections(const BTFFileList &btf_file_list) noexcept {
-  BTFTypeMap btf_type_map;
-
-  std::uint32_t type_id{1U};
+std::optional<BTFError>
+BTF::indexTypeSections(BTFTypeIndex &btf_type_index,
+                       const BTFFileList &btf_file_list) noexcept {
+  btf_type_index.clear();
 
   try {
-    for (auto &btf_file : btf_file_list) {
-      const auto &btf_header = btf_file.btf_header;
-      auto &file_reader = *btf_file.file_reader.get();
+    return walkTypeSections(
+        btf_file_list, [&](const BTFTypeIndexEntry &btf_type_index_entry) {
+          btf_type_index.push_back(btf_type_index_entry);
+          return true;
+        });
+
+  } catch (const std::bad_alloc &) {
+    return BTFError(BTFErrorInformation{
+        BTFErrorInformation::Code::MemoryAllocationFailure,
+    });
+  }
+}
 
-      auto type_section_start_offset = btf_header.hdr_len + btf_header.type_off;
-      auto type_section_end_offset =
-          type_section_start_offset + btf_header.type_len;
+std::size_t BTF::getTypeDataSize(BTFKind btf_kind,
+                                 std::uint16_t vlen) noexcept {
+  switch (btf_kind) {
+  case BTFKind::Int:
+    return kIntBTFTypeSize;
 
-      file_reader.seek(type_section_start_offset);
+  case BTFKind::Array:
+    return kArrayBTFTypeSize;
 
-      for (;;) {
-        auto current_offset = file_reader.offset();
-        if (current_offset >= type_section_end_offset) {
-          break;
-        }
+  case BTFKind::Struct:
+  case BTFKind::Union:
+    return kStructOrUnionMemberSize * vlen;
 
-        auto btf_type_header_res = parseTypeHeader(file_reader);
-        if (btf_type_header_res.failed()) {
-          return btf_type_header_res.takeError();
-        }
+  case BTFKind::Enum:
+    return kEnumValueBTFTypeSize * vlen;
 
-        auto btf_type_header = btf_type_header_res.takeValue();
+  case BTFKind::FuncProto:
+    return kFuncProtoParamSize * vlen;
 
-        BTFErrorInformation::FileRange file_range{current_offset,
-                                                  kBTFTypeHeaderSize};
+  case BTFKind::Var:
+    return kVarDataSize;
 
-        if (btf_type_header.kind > static_cast<std::uint8_t>(BTFKind::Float)) {
-          return BTFError{
-              BTFErrorInformation{BTFErrorInformation::Code::InvalidBTFKind,
-                                  file_range},
-          };
-        }
+  case BTFKind::DataSec:
+    return kVarSecInfoSize * vlen;
 
-        auto btf_kind = static_cast<BTFKind>(btf_type_header.kind);
+  case BTFKind::Void:
+  case BTFKind::Ptr:
+  case BTFKind::Fwd:
+  case BTFKind::Typedef:
+  case BTFKind::Volatile:
+  case BTFKind::Const:
+  case BTFKind::Restrict:
+  case BTFKind::Func:
+  case BTFKind::Float:
+    break;
+  }
 
-        auto parser_it = kBTFParserMap.find(btf_kind);
-        if (parser_it == kBTFParserMap.end()) {
-          return BTFError{
-              BTFErrorInformation{BTFErrorInformation::Code::UnsupportedBTFKind,
-                                  file_range},
-          };
-        }
+  return 0;
+}
+
+Result<BTFType, BTFError>
+BTF::decodeType(IFileReader &file_reader, const BTFStringTable &string_table,
+                const BTFTypeIndexEntry &btf_type_index_entry,
+                BTFTypeViewTable &scratch_table) noexcept {
+  try {
+    BTFTypeViewTable::Capacity capacity;
+    BTFTypeViewTable::addTypeCapacity(capacity, btf_type_index_entry.kind,
+                                      btf_type_index_entry.vlen);
 
-        const auto &parser = parser_it->second;
+    scratch_table.reset(capacity);
 
-        auto btf_type_res = parser(btf_file_list, btf_type_header, file_reader);
-        if (btf_type_res.failed()) {
-          return btf_type_res.takeError();
-        }
+  } catch (const std::bad_alloc &) {
+    return BTFError(BTFErrorInformation{
+        BTFErrorInformation::Code::MemoryAllocationFailure,
+    });
+  }
 
-        btf_type_map.insert({type_id, btf_type_res.takeValue()});
-        ++type_id;
-      }
-    }
+  auto btf_type_view_res = decodeTypeView(file_reader, string_table,
+                                          btf_type_index_entry, scratch_table);
+
+  if (btf_type_view_res.failed()) {
+    return btf_type_view_res.takeError();
+  }
 
-    return btf_type_map;
+  try {
+    return BTFTypeViewTable::createType(btf_type_view_res.takeValue());
 
-  } catch (const FileReaderError &error) {
-    return convertFileReaderError(error);
+  } catch (const std::bad_alloc &) {
+    return BTFError(BTFErrorInformation{
+        BTFErrorInformation::Code::MemoryAllocationFailure,
+    });
   }
 }
 
-Result<BTFTypeHeader, BTFError>
-BTF::parseTypeHeader(IFileReader &file_reader) noexcept {
+Result<BTFTypeView, BTFError>
+BTF::decodeTypeView(IFileReader &file_reader,
+                    const BTFStringTable &string_table,
+                    const BTFTypeIndexEntry &btf_type_index_entry,
+                    BTFTypeViewTable &view_table) noexcept {
+  auto opt_seek_error = file_reader.trySeek(btf_type_index_entry.offset);
+  if (opt_seek_error.has_value()) {
+    return convertFileReaderError(opt_seek_error.value());
+  }
+
+  auto record_res = file_reader.tryReadRecord(kBTFTypeHeaderSize);
+  if (record_res.failed()) {
+    return convertFileReaderError(record_res.takeError());
+  }
+
+  // The byte order is checked once per type: the header and the data that
+  // follows it are then decoded by the matching specialization
+  auto record = record_res.takeValue();
 
   try {
-    BTFTypeHeader btf_type_common;
-    btf_type_common.name_off = file_reader.u32();
+    if (record.byteSwap()) {
+      return decodeTypeData<true>(string_table, decodeTypeHeader<true>(record),
+                                  btf_type_index_entry.kind, file_reader,
+                                  view_table);
+    }
+
+    return decodeTypeData<false>(string_table, decodeTypeHeader<false>(record),
+                                 btf_type_index_entry.kind, file_reader,
+                                 view_table);
+
+  } catch (const std::bad_alloc &) {
+    return BTFError(BTFErrorInformation{
+        BTFErrorInformation::Code::MemoryAllocationFailure,
+    });
+  }
+}
+
+template <bool kByteSwap>
+Result<BTFTypeView, BTFError>
+BTF::decodeTypeData(const BTFStringTable &string_table,
+                    const BTFTypeHeader &btf_type_header, BTFKind kind,
+                    IFileReader &file_reader,
+                    BTFTypeViewTable &view_table) noexcept {
+  switch (kind) {
+  case BTFKind::Int:
+    return parseIntData<kByteSwap>(string_table, btf_type_header, file_reader,
+                                   view_table);
+
+  case BTFKind::Ptr:
+    return parsePtrData(string_table, btf_type_header, file_reader,
+                        view_table);
+
+  case BTFKind::Const:
+    return parseConstData(string_table, btf_type_header, file_reader,
+                          view_table);
+
+  case BTFKind::Array:
+    return parseArrayData<kByteSwap>(string_table, btf_type_header,
+                                     file_reader, view_table);
+
+  case BTFKind::Typedef:
+    return parseTypedefData(string_table, btf_type_header, file_reader,
+                            view_table);
+
+  case BTFKind::Enum:
+    return parseEnumData<kByteSwap>(string_table, btf_type_header,
+                                    file_reader, view_table);
+
+  case BTFKind::FuncProto:
+    return parseFuncProtoData<kByteSwap>(string_table, btf_type_header,
+                                         file_reader, view_table);
+
+  case BTFKind::Volatile:
+    return parseVolatileData(string_table, btf_type_header, file_reader,
+                             view_table);
+
+  case BTFKind::Struct:
+    return parseStructData<kByteSwap>(string_table, btf_type_header,
+                                      file_reader, view_table);
+
+  case BTFKind::Union:
+    return parseUnionData<kByteSwap>(string_table, btf_type_header,
+                                     file_reader, view_table);
+
+  case BTFKind::Fwd:
+    return parseFwdData(string_table, btf_type_header, file_reader,
+                        view_table);
+
+  case BTFKind::Func:
+    return parseFuncData(string_table, btf_type_header, file_reader,
+                         view_table);
+
+  case BTFKind::Float:
+    return parseFloatData(string_table, btf_type_header, file_reader,
+                          view_table);
+
+  case BTFKind::Restrict:
+    return parseRestrictData(string_table, btf_type_header, file_reader,
+                             view_table);
+
+  case BTFKind::Var:
+    return parseVarData<kByteSwap>(string_table, btf_type_header,
+                                   file_reader, view_table);
+
+  case BTFKind::DataSec:
+    return parseDataSecData<kByteSwap>(string_table, btf_type_header,
+                                       file_reader, view_table);
+
+  case BTFKind::Void:
+    break;
+  }
 
-    auto info = file_reader.u32();
-    btf_type_common.vlen = info & 0xFFFFUL;
-    btf_type_common.kind = (info & 0x1F000000UL) >> 24UL;
-    btf_type_common.kind_flag = (info & 0x80000000UL) != 0;
+  return BTFError(BTFErrorInformation{
+      BTFErrorInformation::Code::Unknown,
+  });
+}
 
-    btf_type_common.size_or_type = file_reader.u32();
+Result<BTFTypeHeader, BTFError>
+BTF::parseTypeHeader(IFileReader &file_reader) noexcept {
 
-    return btf_type_common;
+  auto record_res = file_reader.tryReadRecord(kBTFTypeHeaderSize);
+  if (record_res.failed()) {
+    return convertFileReaderError(record_res.takeError());
+  }
 
-  } catch (const FileReaderError &error) {
-    return convertFileReaderError(error);
+  auto record = record_res.takeValue();
+  if (record.byteSwap()) {
+    return decodeTypeHeader<true>(record);
   }
+
+  return decodeTypeHeader<false>(record);
 }
 
-Result<BTFType, BTFError>
-BTF::parseIntData(const BTFFileList &btf_file_list,
+template <bool kByteSwap>
+Result<BTFTypeView, BTFError>
+BTF::parseIntData(const BTFStringTable &string_table,
                   const BTFTypeHeader &btf_type_header,
-                  IFileReader &file_reader) noexcept {
+                  IFileReader &file_reader,
+                  BTFTypeViewTable &) noexcept {
 
   BTFErrorInformation::FileRange file_range{
       file_reader.offset() - kBTFTypeHeaderSize,
@@ -379,78 +1567,79 @@ BTF::parseIntData(const BTFFileList &btf_file_list,
   }
   }
 
-  try {
-    auto name_res = parseString(btf_file_list, btf_type_header.name_off);
-    if (name_res.failed()) {
-      return name_res.takeError();
-    }
-
-    IntBTFType output;
-    output.name = name_res.takeValue();
-    output.size = btf_type_header.size_or_type;
+  auto name_res = string_table.get(btf_type_header.name_off);
+  if (name_res.failed()) {
+    return name_res.takeError();
+  }
 
-    auto integer_info = file_reader.u32();
+  IntBTFTypeView output;
+  output.name = name_res.takeValue();
+  output.size = btf_type_header.size_or_type;
 
-    auto encoding = (integer_info & 0x0F000000UL) >> 24;
+  auto record_res = file_reader.tryReadRecord(kIntBTFTypeSize);
+  if (record_res.failed()) {
+    return convertFileReaderError(record_res.takeError());
+  }
 
-    int is_signed = (encoding & 1) != 0;
-    int is_char = (encoding & 2) != 0;
-    int is_bool = (encoding & 4) != 0;
+  auto integer_info = record_res.takeValue().u32<kByteSwap>();
 
-    if (is_signed + is_char + is_bool > 1) {
-      return BTFError{
-          BTFErrorInformation{
-              BTFErrorInformation::Code::InvalidIntBTFTypeEncoding,
-              file_range,
-          },
-      };
-    }
+  auto encoding = (integer_info & 0x0F000000UL) >> 24;
 
-    if (is_signed != 0) {
-      output.encoding = IntBTFType::Encoding::Signed;
+  int is_signed = (encoding & 1) != 0;
+  int is_char = (encoding & 2) != 0;
+  int is_bool = (encoding & 4) != 0;
 
-    } else if (is_char != 0) {
-      output.encoding = IntBTFType::Encoding::Char;
+  if (is_signed + is_char + is_bool > 1) {
+    return BTFError{
+        BTFErrorInformation{
+            BTFErrorInformation::Code::InvalidIntBTFTypeEncoding,
+            file_range,
+        },
+    };
+  }
 
-    } else if (is_bool != 0) {
-      output.encoding = IntBTFType::Encoding::Bool;
+  if (is_signed != 0) {
+    output.encoding = IntBTFType::Encoding::Signed;
 
-    } else {
-      output.encoding = IntBTFType::Encoding::None;
-    }
+  } else if (is_char != 0) {
+    output.encoding = IntBTFType::Encoding::Char;
 
-    output.bits = integer_info & 0x000000ff;
-    if (output.bits > 128 || output.bits > btf_type_header.size_or_type * 8) {
+  } else if (is_bool != 0) {
+    output.encoding = IntBTFType::Encoding::Bool;
 
-      return BTFError{
-          BTFErrorInformation{
-              BTFErrorInformation::Code::InvalidIntBTFTypeEncoding,
-              file_range,
-          },
-      };
-    }
+  } else {
+    output.encoding = IntBTFType::Encoding::None;
+  }
 
-    output.offset = (integer_info & 0x00ff0000) >> 16;
-    if (output.offset + output.bits > btf_type_header.size_or_type * 8) {
+  output.bits = integer_info & 0x000000ff;
+  if (output.bits > 128 || output.bits > btf_type_header.size_or_type * 8) {
 
-      return BTFError{
-          BTFErrorInformation{
-              BTFErrorInformation::Code::InvalidIntBTFTypeEncoding,
-              file_range,
-          },
-      };
-    }
+    return BTFError{
+        BTFErrorInformation{
+            BTFErrorInformation::Code::InvalidIntBTFTypeEncoding,
+            file_range,
+        },
+    };
+  }
 
-    return BTFType{output};
+  output.offset = (integer_info & 0x00ff0000) >> 16;
+  if (output.offset + output.bits > btf_type_header.size_or_type * 8) {
 
-  } catch (const FileReaderError &error) {
-    return convertFileReaderError(error);
+    return BTFError{
+        BTFErrorInformation{
+            BTFErrorInformation::Code::InvalidIntBTFTypeEncoding,
+            file_range,
+        },
+    };
   }
+
+  return BTFTypeView{output};
 }
 
-Result<BTFType, BTFError>
-BTF::parsePtrData(const BTFFileList &, const BTFTypeHeader &btf_type_header,
-                  IFileReader &file_reader) noexcept {
+Result<BTFTypeView, BTFError>
+BTF::parsePtrData(const BTFStringTable &, const BTFTypeHeader &btf_type_header,
+                  IFileReader &file_reader,
+                  BTFTypeViewTable &) noexcept {
 
   BTFErrorInformation::FileRange file_range{
       file_reader.offset() - kBTFTypeHeaderSize, kBTFTypeHeaderSize};
@@ -469,12 +1658,14 @@ BTF::parsePtrData(const BTFFileList &, const BTFTypeHeader &btf_type_header,
   PtrBTFType output;
   output.type = btf_type_header.size_or_type;
 
-  return BTFType{output};
+  return BTFTypeView{output};
 }
 
-Result<BTFType, BTFError>
-BTF::parseConstData(const BTFFileList &, const BTFTypeHeader &btf_type_header,
-                    IFileReader &file_reader) noexcept {
+Result<BTFTypeView, BTFError>
+BTF::parseConstData(const BTFStringTable &,
+                    const BTFTypeHeader &btf_type_header,
+                    IFileReader &file_reader,
+                    BTFTypeViewTable &) noexcept {
 
   BTFErrorInformation::FileRange file_range{
       file_reader.offset() - kBTFTypeHeaderSize, kBTFTypeHeaderSize};
@@ -493,12 +1684,15 @@ BTF::parseConstData(const BTFFileList &, const BTFTypeHeader &btf_type_header,
   ConstBTFType output;
   output.type = btf_type_header.size_or_type;
 
-  return BTFType{output};
+  return BTFTypeView{output};
 }
 
-Result<BTFType, BTFError>
-BTF::parseArrayData(const BTFFileList &, const BTFTypeHeader &btf_type_header,
-                    IFileReader &file_reader) noexcept {
+template <bool kByteSwap>
+Result<BTFTypeView, BTFError>
+BTF::parseArrayData(const BTFStringTable &,
+                    const BTFTypeHeader &btf_type_header,
+                    IFileReader &file_reader,
+                    BTFTypeViewTable &) noexcept {
 
   BTFErrorInformation::FileRange file_range{
       file_reader.offset() - kBTFTypeHeaderSize,
@@ -515,23 +1709,26 @@ BTF::parseArrayData(const BTFFileList &, const BTFTypeHeader &btf_type_header,
     };
   }
 
-  try {
-    ArrayBTFType output;
-    output.type = file_reader.u32();
-    output.index_type = file_reader.u32();
-    output.nelems = file_reader.u32();
+  auto record_res = file_reader.tryReadRecord(kArrayBTFTypeSize);
+  if (record_res.failed()) {
+    return convertFileReaderError(record_res.takeError());
+  }
 
-    return BTFType{output};
+  auto record = record_res.takeValue();
 
-  } catch (const FileReaderError &error) {
-    return convertFileReaderError(error);
-  }
+  ArrayBTFType output;
+  output.type = record.u32<kByteSwap>();
+  output.index_type = record.u32<kByteSwap>();
+  output.nelems = record.u32<kByteSwap>();
+
+  return BTFTypeView{output};
 }
 
-Result<BTFType, BTFError>
-BTF::parseTypedefData(const BTFFileList &btf_file_list,
+Result<BTFTypeView, BTFError>
+BTF::parseTypedefData(const BTFStringTable &string_table,
                       const BTFTypeHeader &btf_type_header,
-                      IFileReader &file_reader) noexcept {
+                      IFileReader &file_reader,
+                      BTFTypeViewTable &) noexcept {
 
   BTFErrorInformation::FileRange file_range{
       file_reader.offset() - kBTFTypeHeaderSize, kBTFTypeHeaderSize};
@@ -547,22 +1744,24 @@ BTF::parseTypedefData(const BTFFileList &btf_file_list,
     };
   }
 
-  auto name_res = parseString(btf_file_list, btf_type_header.name_off);
+  auto name_res = string_table.get(btf_type_header.name_off);
   if (name_res.failed()) {
     return name_res.takeError();
   }
 
-  TypedefBTFType output;
+  TypedefBTFTypeView output;
   output.name = name_res.takeValue();
   output.type = btf_type_header.size_or_type;
 
-  return BTFType{output};
+  return BTFTypeView{output};
 }
 
-Result<BTFType, BTFError>
-BTF::parseEnumData(const BTFFileList &btf_file_list,
+template <bool kByteSwap>
+Result<BTFTypeView, BTFError>
+BTF::parseEnumData(const BTFStringTable &string_table,
                    const BTFTypeHeader &btf_type_header,
-                   IFileReader &file_reader) noexcept {
+                   IFileReader &file_reader,
+                   BTFTypeViewTable &view_table) noexcept {
 
   BTFErrorInformation::FileRange file_range{
       file_reader.offset() - kBTFTypeHeaderSize,
@@ -593,53 +1792,60 @@ BTF::parseEnumData(const BTFFileList &btf_file_list,
     };
   }
 
-  try {
-    EnumBTFType output;
-    output.size = btf_type_header.size_or_type;
-
-    if (btf_type_header.name_off != 0) {
-      auto name_res = parseString(btf_file_list, btf_type_header.name_off);
-      if (name_res.failed()) {
-        return name_res.takeError();
-      }
+  EnumBTFTypeView output;
+  output.size = btf_type_header.size_or_type;
 
-      output.opt_name = name_res.takeValue();
+  if (btf_type_header.name_off != 0) {
+    auto name_res = string_table.get(btf_type_header.name_off);
+    if (name_res.failed()) {
+      return name_res.takeError();
     }
 
-    for (std::uint32_t i = 0; i < btf_type_header.vlen; ++i) {
-      auto value_name_off = file_reader.u32();
-      if (value_name_off == 0) {
-        return BTFError{
-            BTFErrorInformation{
-                BTFErrorInformation::Code::InvalidEnumBTFTypeEncoding,
-                file_range,
-            },
-        };
-      }
+    output.opt_name = name_res.takeValue();
+  }
 
-      auto value_name_res = parseString(btf_file_list, value_name_off);
-      if (value_name_res.failed()) {
-        return value_name_res.takeError();
-      }
+  static_assert(kEnumValueBTFTypeSize == 2 * sizeof(std::uint32_t),
+                "Unexpected enum value size");
+
+  auto opt_error = decodeRecordList<2, kByteSwap>(
+      file_reader, btf_type_header.vlen,
+      [&](const std::uint32_t *field_list) -> std::optional<BTFError> {
+        auto value_name_off = field_list[0];
+        if (value_name_off == 0) {
+          return BTFError{
+              BTFErrorInformation{
+                  BTFErrorInformation::Code::InvalidEnumBTFTypeEncoding,
+                  file_range,
+              },
+          };
+        }
 
-      EnumBTFType::Value enum_value{};
-      enum_value.name = value_name_res.takeValue();
-      enum_value.val = static_cast<std::int32_t>(file_reader.u32());
+        auto value_name_res = string_table.get(value_name_off);
+        if (value_name_res.failed()) {
+          return value_name_res.takeError();
+        }
 
-      output.value_list.push_back(std::move(enum_value));
-    }
+        EnumBTFTypeView::Value enum_value{};
+        enum_value.name = value_name_res.takeValue();
+        enum_value.val = static_cast<std::int32_t>(field_list[1]);
 
-    return BTFType{output};
+        view_table.append(output.value_list, enum_value);
+        return std::nullopt;
+      });
 
-  } catch (const FileReaderError &error) {
-    return convertFileReaderError(error);
+  if (opt_error.has_value()) {
+    return opt_error.value();
   }
+
+  return BTFTypeView{output};
 }
 
-Result<BTFType, BTFError>
-BTF::parseFuncProtoData(const BTFFileList &btf_file_list,
+template <bool kByteSwap>
+Result<BTFTypeView, BTFError>
+BTF::parseFuncProtoData(const BTFStringTable &string_table,
                         const BTFTypeHeader &btf_type_header,
-                        IFileReader &file_reader) noexcept {
+                        IFileReader &file_reader,
+                        BTFTypeViewTable &view_table) noexcept {
 
   BTFErrorInformation::FileRange file_range{
       file_reader.offset() - kBTFTypeHeaderSize, kBTFTypeHeaderSize};
@@ -653,48 +1859,54 @@ BTF::parseFuncProtoData(const BTFFileList &btf_file_list,
     };
   }
 
-  try {
-    FuncProtoBTFType output;
-    output.return_type = btf_type_header.size_or_type;
+  FuncProtoBTFTypeView output;
+  output.return_type = btf_type_header.size_or_type;
 
-    for (std::uint32_t i = 0; i < btf_type_header.vlen; ++i) {
-      FuncProtoBTFType::Param param{};
+  static_assert(kFuncProtoParamSize == 2 * sizeof(std::uint32_t),
+                "Unexpected parameter size");
 
-      auto param_name_off = file_reader.u32();
-      if (param_name_off != 0) {
-        auto param_name_res = parseString(btf_file_list, param_name_off);
-        if (param_name_res.failed()) {
-          return param_name_res.takeError();
-        }
+  auto opt_error = decodeRecordList<2, kByteSwap>(
+      file_reader, btf_type_header.vlen,
+      [&](const std::uint32_t *field_list) -> std::optional<BTFError> {
+        FuncProtoBTFTypeView::Param param{};
 
-        param.opt_name = param_name_res.takeValue();
-      }
+        auto param_name_off = field_list[0];
+        if (param_name_off != 0) {
+          auto param_name_res = string_table.get(param_name_off);
+          if (param_name_res.failed()) {
+            return param_name_res.takeError();
+          }
 
-      param.type = file_reader.u32();
+          param.opt_name = param_name_res.takeValue();
+        }
 
-      output.param_list.push_back(std::move(param));
-    }
+        param.type = field_list[1];
 
-    if (!output.param_list.empty()) {
-      const auto &last_element = output.param_list.back();
+        view_table.append(output.param_list, param);
+        return std::nullopt;
+      });
 
-      if (!last_element.opt_name.has_value() && last_element.type == 0) {
-        output.param_list.pop_back();
-        output.is_variadic = true;
-      }
-    }
+  if (opt_error.has_value()) {
+    return opt_error.value();
+  }
 
-    return BTFType{output};
+  if (!output.param_list.empty()) {
+    const auto &last_element = output.param_list.back();
 
-  } catch (const FileReaderError &error) {
-    return convertFileReaderError(error);
+    if (!last_element.opt_name.has_value() && last_element.type == 0) {
+      view_table.popBack(output.param_list);
+      output.is_variadic = true;
+    }
   }
+
+  return BTFTypeView{output};
 }
 
-Result<BTFType, BTFError>
-BTF::parseVolatileData(const BTFFileList &,
+Result<BTFTypeView, BTFError>
+BTF::parseVolatileData(const BTFStringTable &,
                        const BTFTypeHeader &btf_type_header,
-                       IFileReader &file_reader) noexcept {
+                       IFileReader &file_reader,
+                       BTFTypeViewTable &) noexcept {
 
   BTFErrorInformation::FileRange file_range{
       file_reader.offset() - kBTFTypeHeaderSize, kBTFTypeHeaderSize};
@@ -713,45 +1925,50 @@ BTF::parseVolatileData(const BTFFileList &,
   VolatileBTFType output;
   output.type = btf_type_header.size_or_type;
 
-  return BTFType{output};
+  return BTFTypeView{output};
 }
 
-Result<BTFType, BTFError>
-BTF::parseStructData(const BTFFileList &btf_file_list,
+template <bool kByteSwap>
+Result<BTFTypeView, BTFError>
+BTF::parseStructData(const BTFStringTable &string_table,
                      const BTFTypeHeader &btf_type_header,
-                     IFileReader &file_reader) noexcept {
+                     IFileReader &file_reader,
+                     BTFTypeViewTable &view_table) noexcept {
 
-  StructBTFType output;
-  auto opt_error = parseStructOrUnionData(output, btf_file_list,
-                                          btf_type_header, file_reader);
+  StructBTFTypeView output;
+  auto opt_error = parseStructOrUnionData<kByteSwap>(
+      output, string_table, btf_type_header, file_reader, view_table);
 
   if (opt_error.has_value()) {
     return opt_error.value();
   }
 
-  return BTFType{output};
+  return BTFTypeView{output};
 }
 
-Result<BTFType, BTFError>
-BTF::parseUnionData(const BTFFileList &btf_file_list,
+template <bool kByteSwap>
+Result<BTFTypeView, BTFError>
+BTF::parseUnionData(const BTFStringTable &string_table,
                     const BTFTypeHeader &btf_type_header,
-                    IFileReader &file_reader) noexcept {
+                    IFileReader &file_reader,
+                    BTFTypeViewTable &view_table) noexcept {
 
-  UnionBTFType output;
-  auto opt_error = parseStructOrUnionData(output, btf_file_list,
-                                          btf_type_header, file_reader);
+  UnionBTFTypeView output;
+  auto opt_error = parseStructOrUnionData<kByteSwap>(
+      output, string_table, btf_type_header, file_reader, view_table);
 
   if (opt_error.has_value()) {
     return opt_error.value();
   }
 
-  return BTFType{output};
+  return BTFTypeView{output};
 }
 
-Result<BTFType, BTFError>
-BTF::parseFwdData(const BTFFileList &btf_file_list,
+Result<BTFTypeView, BTFError>
+BTF::parseFwdData(const BTFStringTable &string_table,
                   const BTFTypeHeader &btf_type_header,
-                  IFileReader &file_reader) noexcept {
+                  IFileReader &file_reader,
+                  BTFTypeViewTable &) noexcept {
 
   BTFErrorInformation::FileRange file_range{
       file_reader.offset() - kBTFTypeHeaderSize, kBTFTypeHeaderSize};
@@ -767,22 +1984,23 @@ BTF::parseFwdData(const BTFFileList &btf_file_list,
     };
   }
 
-  auto name_res = parseString(btf_file_list, btf_type_header.name_off);
+  auto name_res = string_table.get(btf_type_header.name_off);
   if (name_res.failed()) {
     return name_res.takeError();
   }
 
-  FwdBTFType output;
+  FwdBTFTypeView output;
   output.name = name_res.takeValue();
   output.is_union = btf_type_header.kind_flag;
 
-  return BTFType{output};
+  return BTFTypeView{output};
 }
 
-Result<BTFType, BTFError>
-BTF::parseFuncData(const BTFFileList &btf_file_list,
+Result<BTFTypeView, BTFError>
+BTF::parseFuncData(const BTFStringTable &string_table,
                    const BTFTypeHeader &btf_type_header,
-                   IFileReader &file_reader) noexcept {
+                   IFileReader &file_reader,
+                   BTFTypeViewTable &) noexcept {
 
   BTFErrorInformation::FileRange file_range{
       file_reader.offset() - kBTFTypeHeaderSize, kBTFTypeHeaderSize};
@@ -798,23 +2016,24 @@ BTF::parseFuncData(const BTFFileList &btf_file_list,
     };
   }
 
-  auto name_res = parseString(btf_file_list, btf_type_header.name_off);
+  auto name_res = string_table.get(btf_type_header.name_off);
   if (name_res.failed()) {
     return name_res.takeError();
   }
 
-  FuncBTFType output;
+  FuncBTFTypeView output;
   output.name = name_res.takeValue();
   output.type = btf_type_header.size_or_type;
   output.linkage = static_cast<FuncBTFType::Linkage>(btf_type_header.vlen);
 
-  return BTFType{output};
+  return BTFTypeView{output};
 }
 
-Result<BTFType, BTFError>
-BTF::parseFloatData(const BTFFileList &btf_file_list,
+Result<BTFTypeView, BTFError>
+BTF::parseFloatData(const BTFStringTable &string_table,
                     const BTFTypeHeader &btf_type_header,
-                    IFileReader &file_reader) noexcept {
+                    IFileReader &file_reader,
+                    BTFTypeViewTable &) noexcept {
 
   BTFErrorInformation::FileRange file_range{
       file_reader.offset() - kBTFTypeHeaderSize, kBTFTypeHeaderSize};
@@ -847,22 +2066,23 @@ BTF::parseFloatData(const BTFFileList &btf_file_list,
     };
   }
 
-  auto name_res = parseString(btf_file_list, btf_type_header.name_off);
+  auto name_res = string_table.get(btf_type_header.name_off);
   if (name_res.failed()) {
     return name_res.takeError();
   }
 
-  FloatBTFType output;
+  FloatBTFTypeView output;
   output.name = name_res.takeValue();
   output.size = btf_type_header.size_or_type;
 
-  return BTFType{output};
+  return BTFTypeView{output};
 }
 
-Result<BTFType, BTFError>
-BTF::parseRestrictData(const BTFFileList &,
+Result<BTFTypeView, BTFError>
+BTF::parseRestrictData(const BTFStringTable &,
                        const BTFTypeHeader &btf_type_header,
-                       IFileReader &file_reader) noexcept {
+                       IFileReader &file_reader,
+                       BTFTypeViewTable &) noexcept {
 
   BTFErrorInformation::FileRange file_range{
       file_reader.offset() - kBTFTypeHeaderSize, kBTFTypeHeaderSize};
@@ -881,13 +2101,15 @@ BTF::parseRestrictData(const BTFFileList &,
   RestrictBTFType output;
   output.type = btf_type_header.size_or_type;
 
-  return BTFType{output};
+  return BTFTypeView{output};
 }
 
-Result<BTFType, BTFError>
-BTF::parseVarData(const BTFFileList &btf_file_list,
+template <bool kByteSwap>
+Result<BTFTypeView, BTFError>
+BTF::parseVarData(const BTFStringTable &string_table,
                   const BTFTypeHeader &btf_type_header,
-                  IFileReader &file_reader) noexcept {
+                  IFileReader &file_reader,
+                  BTFTypeViewTable &) noexcept {
 
   BTFErrorInformation::FileRange file_range{file_reader.offset() -
                                                 kBTFTypeHeaderSize,
@@ -904,29 +2126,30 @@ BTF::parseVarData(const BTFFileList &btf_file_list,
     };
   }
 
-  auto name_res = parseString(btf_file_list, btf_type_header.name_off);
+  auto name_res = string_table.get(btf_type_header.name_off);
   if (name_res.failed()) {
     return name_res.takeError();
   }
 
-  VarBTFType output;
+  VarBTFTypeView output;
   output.name = name_res.takeValue();
   output.type = btf_type_header.size_or_type;
 
-  try {
-    output.linkage = file_reader.u32();
-
-    return BTFType{output};
-
-  } catch (const FileReaderError &error) {
-    return convertFileReaderError(error);
+  auto record_res = file_reader.tryReadRecord(kVarDataSize);
+  if (record_res.failed()) {
+    return convertFileReaderError(record_res.takeError());
   }
+
+  output.linkage = record_res.takeValue().u32<kByteSwap>();
+  return BTFTypeView{output};
 }
 
-Result<BTFType, BTFError>
-BTF::parseDataSecData(const BTFFileList &btf_file_list,
+template <bool kByteSwap>
+Result<BTFTypeView, BTFError>
+BTF::parseDataSecData(const BTFStringTable &string_table,
                       const BTFTypeHeader &btf_type_header,
-                      IFileReader &file_reader) noexcept {
+                      IFileReader &file_reader,
+                      BTFTypeViewTable &view_table) noexcept {
 
   BTFErrorInformation::FileRange file_range{
       file_reader.offset() - kBTFTypeHeaderSize,
@@ -941,93 +2164,35 @@ BTF::parseDataSecData(const BTFFileList &btf_file_list,
     };
   }
 
-  auto name_res = parseString(btf_file_list, btf_type_header.name_off);
+  auto name_res = string_table.get(btf_type_header.name_off);
   if (name_res.failed()) {
     return name_res.takeError();
   }
 
-  DataSecBTFType output;
+  DataSecBTFTypeView output;
   output.name = name_res.takeValue();
   output.size = btf_type_header.size_or_type;
 
-  try {
-    for (std::uint32_t i = 0; i < btf_type_header.vlen; ++i) {
-      DataSecBTFType::Variable variable{};
-      variable.type = file_reader.u32();
-      variable.offset = file_reader.u32();
-      variable.size = file_reader.u32();
-
-      output.variable_list.push_back(std::move(variable));
-    }
-
-    return BTFType{output};
-
-  } catch (const FileReaderError &error) {
-    return convertFileReaderError(error);
-  }
-}
-
-Result<std::string, BTFError> BTF::parseString(const BTFFileList &btf_file_list,
-                                               std::uint64_t offset) noexcept {
-  std::uint32_t start_offset{};
-
-  for (const auto &btf_file : btf_file_list) {
-    auto end_offset = start_offset + btf_file.btf_header.str_len;
-    auto relative_offset = offset - start_offset;
-
-    if (relative_offset < end_offset) {
-      auto &file_reader = *btf_file.file_reader.get();
-
-      auto absolute_offset = btf_file.btf_header.hdr_len +
-                             btf_file.btf_header.str_off + relative_offset;
-
-      return parseString(file_reader, absolute_offset);
-    }
-
-    start_offset = end_offset;
-  }
-
-  return BTFError{
-      BTFErrorInformation{
-          BTFErrorInformation::Code::InvalidStringOffset,
-          btfparse::BTFErrorInformation::FileRange{offset, 0},
-      },
-  };
-}
-
-Result<std::string, BTFError> BTF::parseString(IFileReader &file_reader,
-                                               std::uint64_t offset) noexcept {
-
-  Result<std::string, BTFError> output;
-
-  auto original_offset{file_reader.offset()};
-
-  try {
-    file_reader.seek(offset);
-    std::string buffer;
-
-    for (;;) {
-      auto ch = static_cast<char>(file_reader.u8());
-      if (ch == 0) {
-        break;
-      }
-
-      buffer.push_back(ch);
-    }
+  static_assert(kVarSecInfoSize == 3 * sizeof(std::uint32_t),
+                "Unexpected variable size");
 
-    output = buffer;
+  auto opt_error = decodeRecordList<3, kByteSwap>(
+      file_reader, btf_type_header.vlen,
+      [&](const std::uint32_t *field_list) -> std::optional<BTFError> {
+        DataSecBTFTypeView::Variable variable{};
+        variable.type = field_list[0];
+        variable.offset = field_list[1];
+        variable.size = field_list[2];
 
-  } catch (const FileReaderError &error) {
-    return convertFileReaderError(error);
-  }
+        view_table.append(output.variable_list, variable);
+        return std::nullopt;
+      });
 
-  try {
-    file_reader.seek(original_offset);
-  } catch (const FileReaderError &error) {
-    output = convertFileReaderError(error);
+  if (opt_error.has_value()) {
+    return opt_error.value();
   }
 
-  return output;
+  return BTFTypeView{output};
 }
 
 } // namespace btfparse
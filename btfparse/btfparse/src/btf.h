@@ -9,6 +9,9 @@
 #pragma once
 
 #include "btf_types.h"
+#include "btfnameindex.h"
+#include "btfstringtable.h"
+#include "btftypeviewtable.h"
 
 #include <btfparse/ibtf.h>
 #include <btfparse/ifilereader.h>
@@ -17,19 +20,12 @@
 
 namespace btfparse {
 
-struct BTFFile final {
-  BTFHeader btf_header;
-  IFileReader::Ptr file_reader;
-};
-
-using BTFFileList = std::vector<BTFFile>;
-
-using BTFTypeParser = Result<BTFType, BTFError> (*)(const BTFFileList &,
-                                                    const BTFTypeHeader &,
-                                                    IFileReader &);
-
 class BTF final : public IBTF {
 public:
+  static Result<IBTF::Ptr, BTFError>
+  create(std::vector<IFileReader::Ptr> file_reader_list,
+         const BTFOptions &options, IBTF::SharedPtr base_btf) noexcept;
+
   virtual ~BTF() override;
 
   virtual std::optional<BTFType>
@@ -38,16 +34,52 @@ public:
   virtual std::optional<BTFKind>
   getKind(std::uint32_t id) const noexcept override;
 
+  virtual const BTFType *getTypeRef(std::uint32_t id) const noexcept override;
+
+  virtual std::optional<BTFTypeView>
+  getTypeView(std::uint32_t id) const noexcept override;
+
   virtual std::uint32_t count() const noexcept override;
   virtual BTFTypeMap getAll() const noexcept override;
 
+  virtual std::optional<std::uint32_t>
+  getCanonicalID(std::uint32_t original_id) const noexcept override;
+
+  virtual BTFTypeIDRange
+  findByName(std::string_view name) const noexcept override;
+
+  virtual BTFTypeIDRange findByName(std::string_view name,
+                                    BTFKind kind) const noexcept override;
+
+  virtual BTFTypeIDRange findByKind(BTFKind kind) const noexcept override;
+
+  virtual bool forEach(const ForEachCallback &callback) const override;
+
+  const BTFStringTable &stringTable() const noexcept;
+
 private:
   struct PrivateData;
   std::unique_ptr<PrivateData> d;
 
-  BTF(const PathList &path_list);
+  BTF(std::vector<IFileReader::Ptr> file_reader_list,
+      const BTFOptions &options, IBTF::SharedPtr base_btf,
+      BTFParseStats &stats);
+
+  const BTFType *getLazyTypeRef(std::uint32_t id) const noexcept;
+
+  const BTFTypeViewTable *getTypeViewTable() const noexcept;
+
+  const BTFNameIndex *getNameIndex() const noexcept;
+  void collectNameIndexEntries(BTFNameIndex::EntryList &entry_list) const;
 
 public:
+  static Result<BTFFileList, BTFError>
+  openBTFFileList(std::vector<IFileReader::Ptr> file_reader_list) noexcept;
+
+  static std::optional<BTFError>
+  parseTypes(std::vector<IFileReader::Ptr> file_reader_list,
+             const ParseCallback &callback);
+
   static BTFError convertFileReaderError(const FileReaderError &error) noexcept;
 
   static std::optional<BTFError>
@@ -57,91 +89,174 @@ public:
   readBTFHeader(IFileReader &file_reader) noexcept;
 
   static Result<BTFTypeMap, BTFError>
-  parseTypeSections(const BTFFileList &btf_file_list) noexcept;
+  parseTypeSections(const BTFFileList &btf_file_list,
+                    const BTFStringTable &string_table,
+                    std::uint32_t first_type_id,
+                    const BTFOptions &options) noexcept;
 
-  static Result<BTFTypeHeader, BTFError>
-  parseTypeHeader(IFileReader &file_reader) noexcept;
+  // The types of each kind are counted into the list, if not null
+  static Result<BTFTypeMap, BTFError>
+  parseTypeSections(const BTFFileList &btf_file_list,
+                    const BTFStringTable &string_table,
+                    std::uint32_t first_type_id, const BTFOptions &options,
+                    BTFParseStats::KindStatsList *kind_stats_list) noexcept;
 
-  static Result<BTFType, BTFError>
-  parseIntData(const BTFFileList &btf_file_list,
-               const BTFTypeHeader &btf_type_header,
-               IFileReader &file_reader) noexcept;
+  static std::optional<BTFError>
+  decodeTypeViews(BTFTypeViewTable &view_table,
+                  const BTFFileList &btf_file_list,
+                  const BTFStringTable &string_table,
+                  BTFParseStats::KindStatsList *kind_stats_list) noexcept;
 
-  static Result<BTFType, BTFError>
-  parsePtrData(const BTFFileList &, const BTFTypeHeader &btf_type_header,
-               IFileReader &file_reader) noexcept;
+  static std::size_t getThreadCount(const BTFOptions &options) noexcept;
 
-  static Result<BTFType, BTFError>
-  parseConstData(const BTFFileList &, const BTFTypeHeader &btf_type_header,
-                 IFileReader &file_reader) noexcept;
+  static std::optional<BTFError>
+  decodeTypesInParallel(BTFTypeMap &btf_type_map,
+                        const BTFTypeIndex &btf_type_index,
+                        const BTFFileList &btf_file_list,
+                        const BTFStringTable &string_table,
+                        std::uint32_t first_type_id,
+                        const BTFOptions &options,
+                        BTFParseStats::KindStatsList *kind_stats_list) noexcept;
 
-  static Result<BTFType, BTFError>
-  parseArrayData(const BTFFileList &, const BTFTypeHeader &btf_type_header,
-                 IFileReader &file_reader) noexcept;
+  static std::optional<BTFError>
+  decodeTypeRange(std::vector<BTFType> &btf_type_list,
+                  const BTFTypeIndex &btf_type_index, std::size_t start,
+                  std::size_t end, const BTFFileList &btf_file_list,
+                  const BTFStringTable &string_table,
+                  BTFParseStats::KindStatsList *kind_stats_list) noexcept;
+
+  static void runTasks(const BTFOptions::TaskList &task_list,
+                       const BTFOptions &options);
+
+  static std::optional<BTFError>
+  indexTypeSections(BTFTypeIndex &btf_type_index,
+                    const BTFFileList &btf_file_list) noexcept;
+
+  static std::size_t getTypeDataSize(BTFKind btf_kind,
+                                     std::uint16_t vlen) noexcept;
 
   static Result<BTFType, BTFError>
-  parseTypedefData(const BTFFileList &btf_file_list,
+  decodeType(IFileReader &file_reader, const BTFStringTable &string_table,
+             const BTFTypeIndexEntry &btf_type_index_entry,
+             BTFTypeViewTable &scratch_table) noexcept;
+
+  static Result<BTFTypeView, BTFError>
+  decodeTypeView(IFileReader &file_reader, const BTFStringTable &string_table,
+                 const BTFTypeIndexEntry &btf_type_index_entry,
+                 BTFTypeViewTable &view_table) noexcept;
+
+  static Result<BTFTypeHeader, BTFError>
+  parseTypeHeader(IFileReader &file_reader) noexcept;
+
+  // Dispatches on the type kind. kByteSwap is the byte order of the file,
+  // which decodeTypeView reads from the type header
+  template <bool kByteSwap>
+  static Result<BTFTypeView, BTFError>
+  decodeTypeData(const BTFStringTable &string_table,
+                 const BTFTypeHeader &btf_type_header, BTFKind kind,
+                 IFileReader &file_reader,
+                 BTFTypeViewTable &view_table) noexcept;
+
+  template <bool kByteSwap>
+  static Result<BTFTypeView, BTFError>
+  parseIntData(const BTFStringTable &string_table,
+               const BTFTypeHeader &btf_type_header,
+               IFileReader &file_reader,
+               BTFTypeViewTable &) noexcept;
+
+  static Result<BTFTypeView, BTFError>
+  parsePtrData(const BTFStringTable &, const BTFTypeHeader &btf_type_header,
+               IFileReader &file_reader,
+               BTFTypeViewTable &) noexcept;
+
+  static Result<BTFTypeView, BTFError>
+  parseConstData(const BTFStringTable &, const BTFTypeHeader &btf_type_header,
+                 IFileReader &file_reader,
+                 BTFTypeViewTable &) noexcept;
+
+  template <bool kByteSwap>
+  static Result<BTFTypeView, BTFError>
+  parseArrayData(const BTFStringTable &, const BTFTypeHeader &btf_type_header,
+                 IFileReader &file_reader,
+                 BTFTypeViewTable &) noexcept;
+
+  static Result<BTFTypeView, BTFError>
+  parseTypedefData(const BTFStringTable &string_table,
                    const BTFTypeHeader &btf_type_header,
-                   IFileReader &file_reader) noexcept;
+                   IFileReader &file_reader,
+                   BTFTypeViewTable &) noexcept;
 
-  static Result<BTFType, BTFError>
-  parseEnumData(const BTFFileList &btf_file_list,
+  template <bool kByteSwap>
+  static Result<BTFTypeView, BTFError>
+  parseEnumData(const BTFStringTable &string_table,
                 const BTFTypeHeader &btf_type_header,
-                IFileReader &file_reader) noexcept;
+                IFileReader &file_reader,
+                BTFTypeViewTable &view_table) noexcept;
 
-  static Result<BTFType, BTFError>
-  parseFuncProtoData(const BTFFileList &btf_file_list,
+  template <bool kByteSwap>
+  static Result<BTFTypeView, BTFError>
+  parseFuncProtoData(const BTFStringTable &string_table,
                      const BTFTypeHeader &btf_type_header,
-                     IFileReader &file_reader) noexcept;
-
-  static Result<BTFType, BTFError>
-  parseVolatileData(const BTFFileList &, const BTFTypeHeader &btf_type_header,
-                    IFileReader &file_reader) noexcept;
-
-  static Result<BTFType, BTFError>
-  parseStructData(const BTFFileList &btf_file_list,
+                     IFileReader &file_reader,
+                     BTFTypeViewTable &view_table) noexcept;
+
+  static Result<BTFTypeView, BTFError>
+  parseVolatileData(const BTFStringTable &,
+                    const BTFTypeHeader &btf_type_header,
+                    IFileReader &file_reader,
+                    BTFTypeViewTable &) noexcept;
+
+  template <bool kByteSwap>
+  static Result<BTFTypeView, BTFError>
+  parseStructData(const BTFStringTable &string_table,
                   const BTFTypeHeader &btf_type_header,
-                  IFileReader &file_reader) noexcept;
+                  IFileReader &file_reader,
+                  BTFTypeViewTable &view_table) noexcept;
 
-  static Result<BTFType, BTFError>
-  parseUnionData(const BTFFileList &btf_file_list,
+  template <bool kByteSwap>
+  static Result<BTFTypeView, BTFError>
+  parseUnionData(const BTFStringTable &string_table,
                  const BTFTypeHeader &btf_type_header,
-                 IFileReader &file_reader) noexcept;
+                 IFileReader &file_reader,
+                 BTFTypeViewTable &view_table) noexcept;
 
-  static Result<BTFType, BTFError>
-  parseFwdData(const BTFFileList &btf_file_list,
+  static Result<BTFTypeView, BTFError>
+  parseFwdData(const BTFStringTable &string_table,
                const BTFTypeHeader &btf_type_header,
-               IFileReader &file_reader) noexcept;
+               IFileReader &file_reader,
+               BTFTypeViewTable &) noexcept;
 
-  static Result<BTFType, BTFError>
-  parseFuncData(const BTFFileList &btf_file_list,
+  static Result<BTFTypeView, BTFError>
+  parseFuncData(const BTFStringTable &string_table,
                 const BTFTypeHeader &btf_type_header,
-                IFileReader &file_reader) noexcept;
+                IFileReader &file_reader,
+                BTFTypeViewTable &) noexcept;
 
-  static Result<BTFType, BTFError>
-  parseFloatData(const BTFFileList &btf_file_list,
+  static Result<BTFTypeView, BTFError>
+  parseFloatData(const BTFStringTable &string_table,
                  const BTFTypeHeader &btf_type_header,
-                 IFileReader &file_reader) noexcept;
-
-  static Result<BTFType, BTFError>
-  parseRestrictData(const BTFFileList &, const BTFTypeHeader &btf_type_header,
-                    IFileReader &file_reader) noexcept;
-
-  static Result<BTFType, BTFError>
-  parseVarData(const BTFFileList &btf_file_list,
+                 IFileReader &file_reader,
+                 BTFTypeViewTable &) noexcept;
+
+  static Result<BTFTypeView, BTFError>
+  parseRestrictData(const BTFStringTable &,
+                    const BTFTypeHeader &btf_type_header,
+                    IFileReader &file_reader,
+                    BTFTypeViewTable &) noexcept;
+
+  template <bool kByteSwap>
+  static Result<BTFTypeView, BTFError>
+  parseVarData(const BTFStringTable &string_table,
                const BTFTypeHeader &btf_type_header,
-               IFileReader &file_reader) noexcept;
+               IFileReader &file_reader,
+               BTFTypeViewTable &) noexcept;
 
-  static Result<BTFType, BTFError>
-  parseDataSecData(const BTFFileList &btf_file_list,
+  template <bool kByteSwap>
+  static Result<BTFTypeView, BTFError>
+  parseDataSecData(const BTFStringTable &string_table,
                    const BTFTypeHeader &btf_type_header,
-                   IFileReader &file_reader) noexcept;
-
-  static Result<std::string, BTFError>
-  parseString(const BTFFileList &btf_file_list, std::uint64_t offset) noexcept;
-
-  static Result<std::string, BTFError>
-  parseString(IFileReader &file_reader, std::uint64_t offset) noexcept;
+                   IFileReader &file_reader,
+                   BTFTypeViewTable &view_table) noexcept;
 
   friend class IBTF;
 };
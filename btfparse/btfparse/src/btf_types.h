@@ -8,19 +8,25 @@
 
 #pragma once
 
+#include <btfparse/ibtf.h>
+#include <btfparse/ifilereader.h>
+
 #include <cstdint>
 #include <optional>
 #include <string>
 #include <variant>
+#include <vector>
 
 namespace btfparse {
 
 const std::uint32_t kLittleEndianMagicValue{0xEB9F};
 const std::uint32_t kBigEndianMagicValue{0x9FEB};
+const std::size_t kBTFHeaderSize{24U};
 const std::size_t kBTFTypeHeaderSize{12U};
 const std::size_t kIntBTFTypeSize{4U};
 const std::size_t kArrayBTFTypeSize{12U};
 const std::size_t kEnumValueBTFTypeSize{8U};
+const std::size_t kFuncProtoParamSize{8U};
 const std::size_t kStructOrUnionMemberSize{12U};
 const std::size_t kVarDataSize{4U};
 const std::size_t kVarSecInfoSize{12U};
@@ -44,4 +50,21 @@ struct BTFTypeHeader final {
   std::uint32_t size_or_type{};
 };
 
+struct BTFFile final {
+  BTFHeader btf_header;
+  bool little_endian{true};
+  IFileReader::Ptr file_reader;
+};
+
+using BTFFileList = std::vector<BTFFile>;
+
+struct BTFTypeIndexEntry final {
+  std::size_t file_index{};
+  std::uint64_t offset{};
+  BTFKind kind{BTFKind::Void};
+  std::uint16_t vlen{};
+};
+
+using BTFTypeIndex = std::vector<BTFTypeIndexEntry>;
+
 } // namespace btfparse
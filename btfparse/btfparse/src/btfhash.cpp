@@ -0,0 +1,153 @@
+//
+// Copyright (c) 2021-present, Trail of Bits, Inc.
+// All rights reserved.
+//
+// This source code is licensed in accordance with the terms specified in
+// the LICENSE file found in the root directory of this source tree.
+//
+
+#include "btfhash.h"
+
+namespace btfparse {
+
+namespace {
+
+const std::array<std::uint32_t, 64> kSHA256RoundConstantList{
+    0x428A2F98U, 0x71374491U, 0xB5C0FBCFU, 0xE9B5DBA5U, 0x3956C25BU,
+    0x59F111F1U, 0x923F82A4U, 0xAB1C5ED5U, 0xD807AA98U, 0x12835B01U,
+    0x243185BEU, 0x550C7DC3U, 0x72BE5D74U, 0x80DEB1FEU, 0x9BDC06A7U,
+    0xC19BF174U, 0xE49B69C1U, 0xEFBE4786U, 0x0FC19DC6U, 0x240CA1CCU,
+    0x2DE92C6FU, 0x4A7484AAU, 0x5CB0A9DCU, 0x76F988DAU, 0x983E5152U,
+    0xA831C66DU, 0xB00327C8U, 0xBF597FC7U, 0xC6E00BF3U, 0xD5A79147U,
+    0x06CA6351U, 0x14292967U, 0x27B70A85U, 0x2E1B2138U, 0x4D2C6DFCU,
+    0x53380D13U, 0x650A7354U, 0x766A0ABBU, 0x81C2C92EU, 0x92722C85U,
+    0xA2BFE8A1U, 0xA81A664BU, 0xC24B8B70U, 0xC76C51A3U, 0xD192E819U,
+    0xD6990624U, 0xF40E3585U, 0x106AA070U, 0x19A4C116U, 0x1E376C08U,
+    0x2748774CU, 0x34B0BCB5U, 0x391C0CB3U, 0x4ED8AA4AU, 0x5B9CCA4FU,
+    0x682E6FF3U, 0x748F82EEU, 0x78A5636FU, 0x84C87814U, 0x8CC70208U,
+    0x90BEFFFAU, 0xA4506CEBU, 0xBEF9A3F7U, 0xC67178F2U,
+};
+
+std::uint32_t rotateRight(std::uint32_t value, unsigned int count) {
+  return (value >> count) | (value << (32U - count));
+}
+
+} // namespace
+
+void SHA256Hash::update(const std::uint8_t *data, std::size_t size) {
+  message_size += size;
+
+  for (std::size_t i = 0; i < size; ++i) {
+    block[block_size++] = data[i];
+    if (block_size == block.size()) {
+      processBlock();
+    }
+  }
+}
+
+void SHA256Hash::update(std::uint64_t value) {
+  for (std::size_t i = 0; i < sizeof(value); ++i) {
+    auto byte = static_cast<std::uint8_t>(value >> (i * 8));
+    update(&byte, 1);
+  }
+}
+
+void SHA256Hash::update(std::string_view value) {
+  update(static_cast<std::uint64_t>(value.size()));
+  update(reinterpret_cast<const std::uint8_t *>(value.data()), value.size());
+}
+
+SHA256Hash::Digest SHA256Hash::finalize() {
+  auto message_bit_count = message_size * 8;
+
+  block[block_size++] = 0x80;
+  if (block_size > block.size() - 8) {
+    while (block_size < block.size()) {
+      block[block_size++] = 0;
+    }
+
+    processBlock();
+  }
+
+  while (block_size < block.size() - 8) {
+    block[block_size++] = 0;
+  }
+
+  // The message length is the only big endian field
+  for (std::size_t i = 0; i < 8; ++i) {
+    block[block_size++] =
+        static_cast<std::uint8_t>(message_bit_count >> ((7 - i) * 8));
+  }
+
+  processBlock();
+
+  Digest digest;
+  for (std::size_t i = 0; i < state.size(); ++i) {
+    for (std::size_t j = 0; j < 4; ++j) {
+      digest[i * 4 + j] = static_cast<std::uint8_t>(state[i] >> ((3 - j) * 8));
+    }
+  }
+
+  return digest;
+}
+
+void SHA256Hash::processBlock() {
+  std::array<std::uint32_t, 64> schedule;
+  for (std::size_t i = 0; i < 16; ++i) {
+    schedule[i] = (static_cast<std::uint32_t>(block[i * 4]) << 24) |
+                  (static_cast<std::uint32_t>(block[i * 4 + 1]) << 16) |
+                  (static_cast<std::uint32_t>(block[i * 4 + 2]) << 8) |
+                  static_cast<std::uint32_t>(block[i * 4 + 3]);
+  }
+
+  for (std::size_t i = 16; i < schedule.size(); ++i) {
+    auto s0 = rotateRight(schedule[i - 15], 7) ^
+              rotateRight(schedule[i - 15], 18) ^ (schedule[i - 15] >> 3);
+
+    auto s1 = rotateRight(schedule[i - 2], 17) ^
+              rotateRight(schedule[i - 2], 19) ^ (schedule[i - 2] >> 10);
+
+    schedule[i] = schedule[i - 16] + s0 + schedule[i - 7] + s1;
+  }
+
+  auto a = state[0];
+  auto b = state[1];
+  auto c = state[2];
+  auto d = state[3];
+  auto e = state[4];
+  auto f = state[5];
+  auto g = state[6];
+  auto h = state[7];
+
+  for (std::size_t i = 0; i < schedule.size(); ++i) {
+    auto s1 = rotateRight(e, 6) ^ rotateRight(e, 11) ^ rotateRight(e, 25);
+    auto choice = (e & f) ^ (~e & g);
+    auto temp1 = h + s1 + choice + kSHA256RoundConstantList[i] + schedule[i];
+
+    auto s0 = rotateRight(a, 2) ^ rotateRight(a, 13) ^ rotateRight(a, 22);
+    auto majority = (a & b) ^ (a & c) ^ (b & c);
+    auto temp2 = s0 + majority;
+
+    h = g;
+    g = f;
+    f = e;
+    e = d + temp1;
+    d = c;
+    c = b;
+    b = a;
+    a = temp1 + temp2;
+  }
+
+  state[0] += a;
+  state[1] += b;
+  state[2] += c;
+  state[3] += d;
+  state[4] += e;
+  state[5] += f;
+  state[6] += g;
+  state[7] += h;
+
+  block_size = 0;
+}
+
+} // namespace btfparse
@@ -0,0 +1,76 @@
+//
+// Copyright (c) 2021-present, Trail of Bits, Inc.
+// All rights reserved.
+//
+// This source code is licensed in accordance with the terms specified in
+// the LICENSE file found in the root directory of this source tree.
+//
+
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <string_view>
+
+namespace btfparse {
+
+const std::uint64_t kFNVOffsetBasis{0xCBF29CE484222325ULL};
+const std::uint64_t kFNVPrime{0x100000001B3ULL};
+
+// 64-bit FNV-1a. Values are hashed in little endian order, so the result
+// does not depend on the host
+class FNV1aHash final {
+public:
+  void update(const std::uint8_t *data, std::size_t size) {
+    for (std::size_t i = 0; i < size; ++i) {
+      hash ^= data[i];
+      hash *= kFNVPrime;
+    }
+  }
+
+  void update(std::uint64_t value) {
+    for (std::size_t i = 0; i < sizeof(value); ++i) {
+      auto byte = static_cast<std::uint8_t>(value >> (i * 8));
+      update(&byte, 1);
+    }
+  }
+
+  void update(std::string_view value) {
+    update(static_cast<std::uint64_t>(value.size()));
+    update(reinterpret_cast<const std::uint8_t *>(value.data()),
+           value.size());
+  }
+
+  std::uint64_t value() const { return hash; }
+
+private:
+  std::uint64_t hash{kFNVOffsetBasis};
+};
+
+// SHA-256, for the keys that must not collide (i.e. the header cache).
+// Integers are hashed in the same little endian order as FNV1aHash
+class SHA256Hash final {
+public:
+  using Digest = std::array<std::uint8_t, 32>;
+
+  void update(const std::uint8_t *data, std::size_t size);
+  void update(std::uint64_t value);
+  void update(std::string_view value);
+
+  // Pads the message; the object must not be updated afterwards
+  Digest finalize();
+
+private:
+  std::array<std::uint32_t, 8> state{
+      0x6A09E667U, 0xBB67AE85U, 0x3C6EF372U, 0xA54FF53AU,
+      0x510E527FU, 0x9B05688CU, 0x1F83D9ABU, 0x5BE0CD19U,
+  };
+
+  std::array<std::uint8_t, 64> block{};
+  std::size_t block_size{};
+  std::uint64_t message_size{};
+
+  void processBlock();
+};
+
+} // namespace btfparse
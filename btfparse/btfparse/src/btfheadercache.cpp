@@ -0,0 +1,246 @@
+//
+// Copyright (c) 2021-present, Trail of Bits, Inc.
+// All rights reserved.
+//
+// This source code is licensed in accordance with the terms specified in
+// the LICENSE file found in the root directory of this source tree.
+//
+
+#include "btfheadercache.h"
+#include "btf.h"
+#include "btfhash.h"
+
+#include <atomic>
+#include <fstream>
+#include <iomanip>
+
+#include <unistd.h>
+
+namespace btfparse {
+
+namespace {
+
+// Bump this whenever the generator output changes, so that the entries
+// created by older versions are not reused
+const std::string kCacheFormatVersion{"btfparse-header-cache-v2"};
+
+const std::string kCacheEntryExtension{".h"};
+
+std::atomic_uint64_t temporary_file_counter{0};
+
+} // namespace
+
+struct BTFHeaderCache::PrivateData final {
+  std::filesystem::path cache_directory;
+};
+
+Result<IBTFHeaderCache::Ptr, BTFHeaderCacheError>
+BTFHeaderCache::create(const std::filesystem::path &cache_directory) noexcept {
+  try {
+    std::error_code error;
+    std::filesystem::create_directories(cache_directory, error);
+    if (error || !std::filesystem::is_directory(cache_directory, error)) {
+      return BTFHeaderCacheError(BTFHeaderCacheErrorInformation{
+          BTFHeaderCacheErrorInformation::Code::IOError,
+          "Failed to create the cache directory: " + cache_directory.string(),
+      });
+    }
+
+    return Ptr(new BTFHeaderCache(cache_directory));
+
+  } catch (const std::bad_alloc &) {
+    return BTFHeaderCacheError(BTFHeaderCacheErrorInformation{
+        BTFHeaderCacheErrorInformation::Code::MemoryAllocationFailure,
+    });
+  }
+}
+
+BTFHeaderCache::~BTFHeaderCache() {}
+
+std::optional<BTFHeaderCacheError>
+BTFHeaderCache::generate(std::ostream &stream, const PathList &path_list,
+                         const BTFHeaderGeneratorOptions &options) const {
+  try {
+    std::vector<IFileReader::Ptr> file_reader_list;
+    for (const auto &path : path_list) {
+      auto file_reader_res = IFileReader::open(path);
+      if (file_reader_res.failed()) {
+        return convertFileReaderError(file_reader_res.takeError());
+      }
+
+      file_reader_list.push_back(file_reader_res.takeValue());
+    }
+
+    auto cache_key_res = computeCacheKey(file_reader_list, options);
+    if (cache_key_res.failed()) {
+      return cache_key_res.takeError();
+    }
+
+    auto cache_key = cache_key_res.takeValue();
+    auto cache_entry_path =
+        d->cache_directory / (cache_key + kCacheEntryExtension);
+
+    // Cache hit: entries are only ever renamed into place once complete,
+    // so anything we can open is a full header
+    {
+      std::ifstream cache_entry(cache_entry_path, std::ios::binary);
+      if (cache_entry.is_open()) {
+        stream << cache_entry.rdbuf();
+        if (!stream) {
+          return BTFHeaderCacheError(BTFHeaderCacheErrorInformation{
+              BTFHeaderCacheErrorInformation::Code::IOError,
+              "Failed to write the cached header to the output stream",
+          });
+        }
+
+        return std::nullopt;
+      }
+    }
+
+    // Cache miss: parse the files we have already opened, and write the
+    // header to both the output stream and a temporary file
+    auto btf_res = BTF::create(std::move(file_reader_list), BTFOptions{},
+                               nullptr);
+    if (btf_res.failed()) {
+      return BTFHeaderCacheError(BTFHeaderCacheErrorInformation{
+          BTFHeaderCacheErrorInformation::Code::InvalidBTF,
+          btf_res.takeError().toString(),
+      });
+    }
+
+    auto btf = btf_res.takeValue();
+
+    auto header_generator = IBTFHeaderGenerator::create();
+    if (!header_generator) {
+      return BTFHeaderCacheError(BTFHeaderCacheErrorInformation{
+          BTFHeaderCacheErrorInformation::Code::MemoryAllocationFailure,
+      });
+    }
+
+    auto temporary_file_path = cache_entry_path;
+    temporary_file_path += ".tmp." + std::to_string(getpid()) + "." +
+                           std::to_string(temporary_file_counter++);
+
+    // Failing to store the entry is not fatal; the header is still
+    // written to the output stream
+    std::ofstream temporary_file(temporary_file_path,
+                                 std::ios::binary | std::ios::trunc);
+
+    auto succeeded = header_generator->generate(
+        [&](std::string_view chunk) -> bool {
+          stream.write(chunk.data(),
+                       static_cast<std::streamsize>(chunk.size()));
+
+          if (temporary_file.is_open()) {
+            temporary_file.write(chunk.data(),
+                                 static_cast<std::streamsize>(chunk.size()));
+          }
+
+          return static_cast<bool>(stream);
+        },
+        btf, options);
+
+    auto store_entry = succeeded && temporary_file.is_open() &&
+                       static_cast<bool>(temporary_file);
+
+    temporary_file.close();
+    store_entry = store_entry && !temporary_file.fail();
+
+    std::error_code error;
+    if (store_entry) {
+      std::filesystem::rename(temporary_file_path, cache_entry_path, error);
+    }
+
+    if (!store_entry || error) {
+      std::filesystem::remove(temporary_file_path, error);
+    }
+
+    if (!stream) {
+      return BTFHeaderCacheError(BTFHeaderCacheErrorInformation{
+          BTFHeaderCacheErrorInformation::Code::IOError,
+          "Failed to write the header to the output stream",
+      });
+    }
+
+    if (!succeeded) {
+      return BTFHeaderCacheError(BTFHeaderCacheErrorInformation{
+          BTFHeaderCacheErrorInformation::Code::HeaderGenerationFailed,
+      });
+    }
+
+    return std::nullopt;
+
+  } catch (const std::bad_alloc &) {
+    return BTFHeaderCacheError(BTFHeaderCacheErrorInformation{
+        BTFHeaderCacheErrorInformation::Code::MemoryAllocationFailure,
+    });
+  }
+}
+
+BTFHeaderCache::BTFHeaderCache(const std::filesystem::path &cache_directory)
+    : d(new PrivateData) {
+  d->cache_directory = cache_directory;
+}
+
+Result<std::string, BTFHeaderCacheError> BTFHeaderCache::computeCacheKey(
+    const std::vector<IFileReader::Ptr> &file_reader_list,
+    const BTFHeaderGeneratorOptions &options) noexcept {
+  try {
+    SHA256Hash hash;
+    hash.update(kCacheFormatVersion);
+
+    hash.update(static_cast<std::uint64_t>(file_reader_list.size()));
+    for (const auto &file_reader : file_reader_list) {
+      auto opt_buffer = file_reader->buffer();
+      if (!opt_buffer.has_value()) {
+        return BTFHeaderCacheError(BTFHeaderCacheErrorInformation{
+            BTFHeaderCacheErrorInformation::Code::IOError,
+            "The BTF file is not memory resident",
+        });
+      }
+
+      const auto &buffer = opt_buffer.value();
+      hash.update(static_cast<std::uint64_t>(buffer.size));
+      hash.update(buffer.data, buffer.size);
+    }
+
+    hash.update(static_cast<std::uint64_t>(options.root_type_name_list.size()));
+    for (const auto &root_type_name : options.root_type_name_list) {
+      hash.update(root_type_name);
+    }
+
+    hash.update(static_cast<std::uint64_t>(options.root_type_id_list.size()));
+    for (const auto &root_type_id : options.root_type_id_list) {
+      hash.update(static_cast<std::uint64_t>(root_type_id));
+    }
+
+    std::stringstream buffer;
+    buffer << std::hex << std::setfill('0');
+    for (auto byte : hash.finalize()) {
+      buffer << std::setw(2) << static_cast<unsigned int>(byte);
+    }
+
+    return buffer.str();
+
+  } catch (const std::bad_alloc &) {
+    return BTFHeaderCacheError(BTFHeaderCacheErrorInformation{
+        BTFHeaderCacheErrorInformation::Code::MemoryAllocationFailure,
+    });
+  }
+}
+
+BTFHeaderCacheError
+BTFHeaderCache::convertFileReaderError(const FileReaderError &error) noexcept {
+  auto code = BTFHeaderCacheErrorInformation::Code::IOError;
+  if (error.get().code == FileReaderErrorInformation::Code::FileNotFound) {
+    code = BTFHeaderCacheErrorInformation::Code::FileNotFound;
+
+  } else if (error.get().code ==
+             FileReaderErrorInformation::Code::MemoryAllocationFailure) {
+    code = BTFHeaderCacheErrorInformation::Code::MemoryAllocationFailure;
+  }
+
+  return BTFHeaderCacheError(BTFHeaderCacheErrorInformation{code});
+}
+
+} // namespace btfparse
@@ -0,0 +1,48 @@
+//
+// Copyright (c) 2021-present, Trail of Bits, Inc.
+// All rights reserved.
+//
+// This source code is licensed in accordance with the terms specified in
+// the LICENSE file found in the root directory of this source tree.
+//
+
+#pragma once
+
+#include <btfparse/ibtfheadercache.h>
+#include <btfparse/ifilereader.h>
+
+#include <vector>
+
+namespace btfparse {
+
+class BTFHeaderCache final : public IBTFHeaderCache {
+public:
+  static Result<IBTFHeaderCache::Ptr, BTFHeaderCacheError>
+  create(const std::filesystem::path &cache_directory) noexcept;
+
+  virtual ~BTFHeaderCache() override;
+
+  using IBTFHeaderCache::generate;
+
+  virtual std::optional<BTFHeaderCacheError>
+  generate(std::ostream &stream, const PathList &path_list,
+           const BTFHeaderGeneratorOptions &options) const override;
+
+private:
+  struct PrivateData;
+  std::unique_ptr<PrivateData> d;
+
+  BTFHeaderCache(const std::filesystem::path &cache_directory);
+
+public:
+  // Returns the name of the cache entry for the given files (which must
+  // be memory resident) and options
+  static Result<std::string, BTFHeaderCacheError>
+  computeCacheKey(const std::vector<IFileReader::Ptr> &file_reader_list,
+                  const BTFHeaderGeneratorOptions &options) noexcept;
+
+  static BTFHeaderCacheError
+  convertFileReaderError(const FileReaderError &error) noexcept;
+};
+
+} // namespace btfparse
@@ -7,6 +7,8 @@
 //
 
 #include "btfheadergenerator.h"
+#include "btf.h"
+#include "btftelemetry.h"
 
 #include <algorithm>
 #include <optional>
@@ -20,6 +22,14 @@ namespace btfparse {
 
 namespace {
 
+// Queues shorter than this amount of declarations per task are rendered
+// sequentially, since the tasks would cost more than they save
+const std::size_t kMinTaskDeclarationCount{256};
+
+// How many declarations each task renders before the output is passed to
+// the callback
+const std::size_t kTaskDeclarationCount{1024};
+
 template <typename Type> const Type &getTypeAs(const BTFType &btf_type) {
   if (!std::holds_alternative<Type>(btf_type)) {
     throw std::logic_error("Invalid getTypeAs in file " __FILE__ " at line " +
@@ -38,116 +48,145 @@ template <typename Type> Type &getTypeAsMutable(BTFType &btf_type) {
   return std::get<Type>(btf_type);
 }
 
-bool createInverseTypeTree(BTFHeaderGenerator::Context &context) {
-  context.inverse_type_tree = {};
-
-  for (const auto &p : context.type_tree) {
-    const auto &parent_id = p.first;
-    const auto &child_link_map = p.second;
+BTFTypeIDSet collectChildNodes(const BTFHeaderGenerator::Context &context,
+                               std::uint32_t start) {
+  BTFTypeIDSet visited{start};
+  std::vector<std::uint32_t> queue{start};
 
-    for (const auto &c : child_link_map) {
-      const auto &child_id = c.first;
+  while (!queue.empty()) {
+    auto id = queue.back();
+    queue.pop_back();
 
-      auto it = context.inverse_type_tree.find(child_id);
-      if (it == context.inverse_type_tree.end()) {
-        auto insert_status = context.inverse_type_tree.insert({child_id, {}});
-        it = insert_status.first;
+    for (const auto &edge : context.type_tree.edges(id)) {
+      if (visited.insert(edge.id())) {
+        queue.push_back(edge.id());
       }
-
-      auto &parent_links = it->second;
-      parent_links.insert(parent_id);
     }
   }
 
-  return true;
+  return visited;
 }
 
-std::unordered_set<std::uint32_t>
-collectChildNodes(BTFHeaderGenerator::Context context, std::uint32_t start) {
-  std::unordered_set<std::uint32_t> next_queue{start};
-  std::unordered_set<std::uint32_t> visited;
-
-  while (!next_queue.empty()) {
-    auto queue = std::move(next_queue);
-    next_queue.clear();
-
-    for (const auto &id : queue) {
-      if (visited.count(id) > 0) {
-        continue;
-      }
-
-      visited.insert(id);
-
-      auto type_tree_it = context.type_tree.find(id);
-      if (type_tree_it == context.type_tree.end()) {
-        continue;
+// Visits the root types when generating a subset of the types, and all
+// the top level types otherwise
+template <typename Callback>
+bool forEachRootType(const BTFHeaderGenerator::Context &context,
+                     Callback callback) {
+  if (context.opt_root_type_list.has_value()) {
+    for (const auto &id : context.opt_root_type_list.value()) {
+      if (!callback(id)) {
+        return false;
       }
+    }
 
-      const auto &type_map = type_tree_it->second;
-      for (const auto &p : type_map) {
-        const auto &child_id = p.first;
-        next_queue.insert(child_id);
+  } else {
+    for (const auto &id : context.top_level_type_list) {
+      if (!callback(id)) {
+        return false;
       }
     }
   }
 
-  return visited;
+  return true;
 }
 
 } // namespace
 
 BTFHeaderGenerator::~BTFHeaderGenerator() {}
 
-bool BTFHeaderGenerator::generate(std::string &header,
-                                  const IBTF::Ptr &btf) const {
-  header.clear();
+bool BTFHeaderGenerator::generate(
+    const OutputCallback &callback, const IBTF::Ptr &btf,
+    const BTFHeaderGeneratorOptions &options) const {
 
-  Context context;
-  if (!saveBTFTypeMap(context, btf)) {
-    return false;
-  }
+  BTFHeaderGeneratorStats stats;
+  auto record_stats = kTelemetryEnabled && options.stats_callback;
 
-  if (!adjustTypeNames(context)) {
-    return false;
-  }
+  BTFPhaseTimer generation_timer(options.trace_callback, "generate",
+                                 &stats.generation_time);
 
-  scanTypes(context);
+  auto run_phase = [&](std::string_view phase,
+                       auto &&phase_function) -> bool {
+    std::chrono::nanoseconds duration{};
+    BTFPhaseTimer phase_timer(options.trace_callback, phase, &duration);
 
-  if (!materializePadding(context)) {
-    return false;
-  }
+    auto succeeded = phase_function();
+    phase_timer.stop();
 
-  if (!createTypeTree(context)) {
-    return false;
-  }
+    if (record_stats) {
+      stats.phase_list.push_back({std::string(phase), duration});
+    }
 
-  if (!adjustTypedefDependencyLoops(context)) {
-    return false;
-  }
+    return succeeded;
+  };
 
-  if (!createTypeQueue(context)) {
-    return false;
+  OutputCallback counting_callback;
+  if (record_stats) {
+    counting_callback = [&](std::string_view chunk) -> bool {
+      stats.output_size += chunk.size();
+      return callback(chunk);
+    };
   }
 
-  std::stringstream buffer;
-  if (!generateHeader(context, buffer)) {
-    return false;
-  }
+  const auto &output_callback = record_stats ? counting_callback : callback;
 
-  header = buffer.str();
-  return true;
+  Context context;
+  auto succeeded =
+      run_phase("saveBTFTypeMap",
+                [&]() { return saveBTFTypeMap(context, btf); }) &&
+      run_phase("adjustTypeNames",
+                [&]() { return adjustTypeNames(context); }) &&
+      run_phase("scanTypes",
+                [&]() {
+                  scanTypes(context);
+                  return true;
+                }) &&
+      run_phase("resolveRootTypes",
+                [&]() { return resolveRootTypes(context, options); }) &&
+      run_phase("materializePadding",
+                [&]() { return materializePadding(context); }) &&
+      run_phase("createTypeTree", [&]() { return createTypeTree(context); }) &&
+      run_phase("adjustTypedefDependencyLoops",
+                [&]() { return adjustTypedefDependencyLoops(context); }) &&
+      run_phase("createTypeQueue",
+                [&]() { return createTypeQueue(context); }) &&
+      run_phase("generateHeader", [&]() {
+        return generateHeader(context, options, output_callback);
+      });
+
+  generation_timer.stop();
+
+  if (record_stats) {
+    options.stats_callback(stats);
+  }
+
+  return succeeded;
 }
 
 BTFHeaderGenerator::BTFHeaderGenerator() {}
 
 bool BTFHeaderGenerator::saveBTFTypeMap(Context &context,
                                         const IBTF::Ptr &btf) {
-  auto btf_type_map = btf->getAll();
-  if (btf_type_map.size() == 0) {
+  if (btf->count() == 0) {
     return false;
   }
 
-  context.btf_type_map = std::move(btf_type_map);
+  // The generator renames types and rewrites the member lists in place, so
+  // it needs its own copy: build it directly instead of going through a
+  // temporary map
+  context.btf_type_map.clear();
+  context.btf_type_map.reserve(btf->count());
+
+  btf->forEach([&context](std::uint32_t id, const BTFType &btf_type) {
+    context.btf_type_map.insert({id, btf_type});
+    return true;
+  });
+
+  auto layout_res = IBTFLayout::create(*btf);
+  if (layout_res.failed()) {
+    return false;
+  }
+
+  context.layout = layout_res.takeValue();
   return true;
 }
 
@@ -358,13 +397,13 @@ bool BTFHeaderGenerator::materializeStructPadding(
       current_offset += member.opt_bitfield_size.value();
 
     } else {
-      auto opt_type_size = getBTFTypeSize(context, member.type);
-      if (!opt_type_size.has_value()) {
+      auto type_size_res = context.layout->getSize(member.type);
+      if (type_size_res.failed()) {
         return false;
       }
 
-      auto type_size = opt_type_size.value();
-      current_offset += type_size;
+      auto type_bit_size = type_size_res.takeValue() * 8;
+      current_offset += static_cast<std::uint32_t>(type_bit_size);
     }
   }
 
@@ -404,109 +443,6 @@ bool BTFHeaderGenerator::isBitfield(const StructBTFType::Member &member) {
           member.opt_bitfield_size.value() != 0);
 }
 
-std::optional<std::uint32_t>
-BTFHeaderGenerator::getBTFTypeSize(const Context &context,
-                                   const BTFType &type) {
-
-  switch (IBTF::getBTFTypeKind(type)) {
-  case BTFKind::Void: {
-    return std::nullopt;
-  }
-
-  case BTFKind::Int: {
-    const auto &btf_type = std::get<IntBTFType>(type);
-    return btf_type.size * 8;
-  }
-
-  case BTFKind::Ptr: {
-    return sizeof(void *) * 8;
-  }
-
-  case BTFKind::Array: {
-    const auto &btf_type = std::get<ArrayBTFType>(type);
-
-    auto opt_elem_size = getBTFTypeSize(context, btf_type.type);
-    if (!opt_elem_size.has_value()) {
-      return opt_elem_size;
-    }
-
-    return opt_elem_size.value() * btf_type.nelems;
-  }
-
-  case BTFKind::Struct: {
-    const auto &btf_type = std::get<StructBTFType>(type);
-    return btf_type.size * 8;
-  }
-
-  case BTFKind::Union: {
-    const auto &btf_type = std::get<UnionBTFType>(type);
-    return btf_type.size * 8;
-  }
-
-  case BTFKind::Enum: {
-    const auto &btf_type = std::get<EnumBTFType>(type);
-    return btf_type.size * 8;
-  }
-
-  case BTFKind::Fwd: {
-    return std::nullopt;
-  }
-
-  case BTFKind::Typedef: {
-    const auto &btf_type = std::get<TypedefBTFType>(type);
-    return getBTFTypeSize(context, btf_type.type);
-  }
-
-  case BTFKind::Volatile: {
-    const auto &btf_type = std::get<VolatileBTFType>(type);
-    return getBTFTypeSize(context, btf_type.type);
-  }
-
-  case BTFKind::Const: {
-    const auto &btf_type = std::get<ConstBTFType>(type);
-    return getBTFTypeSize(context, btf_type.type);
-  }
-
-  case BTFKind::Restrict: {
-    return std::nullopt;
-  }
-
-  case BTFKind::Func: {
-    return std::nullopt;
-  }
-
-  case BTFKind::FuncProto: {
-    return std::nullopt;
-  }
-
-  case BTFKind::Var: {
-    return std::nullopt;
-  }
-
-  case BTFKind::DataSec: {
-    return std::nullopt;
-  }
-
-  case BTFKind::Float: {
-    const auto &btf_type = std::get<FloatBTFType>(type);
-    return btf_type.size * 8;
-  }
-  }
-
-  return 0;
-}
-
-std::optional<std::uint32_t>
-BTFHeaderGenerator::getBTFTypeSize(const Context &context, std::uint32_t type) {
-
-  auto type_it = context.btf_type_map.find(type);
-  if (type_it == context.btf_type_map.end()) {
-    return std::nullopt;
-  }
-
-  return getBTFTypeSize(context, type_it->second);
-}
-
 bool BTFHeaderGenerator::isValidTypeId(const Context &context,
                                        std::uint32_t id) {
   return context.btf_type_map.count(id) > 0;
@@ -602,6 +538,67 @@ void BTFHeaderGenerator::scanTypes(Context &context) {
   context.btf_type_id_generator = context.highest_btf_type_id + 1;
 }
 
+bool BTFHeaderGenerator::resolveRootTypes(
+    Context &context, const BTFHeaderGeneratorOptions &options) {
+
+  context.opt_root_type_list = std::nullopt;
+
+  if (options.root_type_name_list.empty() &&
+      options.root_type_id_list.empty()) {
+    return true;
+  }
+
+  std::vector<std::uint32_t> root_type_list;
+  BTFTypeIDSet visited_root_type_list;
+
+  for (const auto &id : options.root_type_id_list) {
+    if (!isTopLevelTypeDeclaration(context, id)) {
+      return false;
+    }
+
+    if (visited_root_type_list.insert(id)) {
+      root_type_list.push_back(id);
+    }
+  }
+
+  if (!options.root_type_name_list.empty()) {
+    std::unordered_map<std::string, std::vector<std::uint32_t>> name_map;
+    for (const auto &name : options.root_type_name_list) {
+      name_map.insert({name, {}});
+    }
+
+    // Go through the types in ID order, so that the output does not
+    // depend on how the top level type list is hashed
+    for (const auto &p : context.btf_type_map) {
+      const auto &id = p.first;
+      if (!isTopLevelTypeDeclaration(context, id)) {
+        continue;
+      }
+
+      auto name_map_it = name_map.find(getTypeName(context, id).value());
+      if (name_map_it != name_map.end()) {
+        name_map_it->second.push_back(id);
+      }
+    }
+
+    for (const auto &name : options.root_type_name_list) {
+      const auto &id_list = name_map.at(name);
+      if (id_list.empty()) {
+        return false;
+      }
+
+      for (const auto &id : id_list) {
+        if (visited_root_type_list.insert(id)) {
+          root_type_list.push_back(id);
+        }
+      }
+    }
+  }
+
+  context.opt_root_type_list = std::move(root_type_list);
+  return true;
+}
+
 bool BTFHeaderGenerator::getTypeDependencies(
     const Context &context, std::vector<std::uint32_t> &dependency_list,
     std::uint32_t id) {
@@ -814,21 +811,21 @@ bool BTFHeaderGenerator::setTypeName(Context &context, std::uint32_t id,
   }
 }
 
-void BTFHeaderGenerator::resetIndent(Context &context) {
-  context.indent_level = 0;
+void BTFHeaderGenerator::resetIndent(EmissionState &state) {
+  state.indent_level = 0;
 }
 
-void BTFHeaderGenerator::increaseIndent(Context &context) {
-  ++context.indent_level;
+void BTFHeaderGenerator::increaseIndent(EmissionState &state) {
+  ++state.indent_level;
 }
 
-void BTFHeaderGenerator::decreaseIndent(Context &context) {
-  --context.indent_level;
+void BTFHeaderGenerator::decreaseIndent(EmissionState &state) {
+  --state.indent_level;
 }
 
-void BTFHeaderGenerator::generateIndent(const Context &context,
+void BTFHeaderGenerator::generateIndent(const EmissionState &state,
                                         std::stringstream &buffer) {
-  for (std::size_t i = 0; i < context.indent_level; ++i) {
+  for (std::size_t i = 0; i < state.indent_level; ++i) {
     buffer << "  ";
   }
 }
@@ -842,21 +839,31 @@ bool BTFHeaderGenerator::createTypeTree(Context &context) {
   // * Union
   // * Enum
   // * Typedef
-  context.visited_type_list = {0};
+  context.visited_type_list.clear();
+  context.visited_type_list.reserve(context.btf_type_id_generator + 1U);
+  context.visited_type_list.insert(0);
+
+  auto succeeded =
+      forEachRootType(context, [&context](std::uint32_t id) -> bool {
+        std::vector<std::uint32_t> dependency_list;
+        if (!getTypeDependencies(context, dependency_list, id)) {
+          return false;
+        }
 
-  for (const auto &id : context.top_level_type_list) {
-    std::vector<std::uint32_t> dependency_list;
-    if (!getTypeDependencies(context, dependency_list, id)) {
-      return false;
-    }
+        for (const auto &dependency_id : dependency_list) {
+          if (!createTypeTreeHelper(context, false, id, dependency_id)) {
+            return false;
+          }
+        }
 
-    for (const auto &dependency_id : dependency_list) {
-      if (!createTypeTreeHelper(context, false, id, dependency_id)) {
-        return false;
-      }
-    }
+        return true;
+      });
+
+  if (!succeeded) {
+    return false;
   }
 
+  context.type_tree.finalize();
   return true;
 }
 
@@ -865,142 +872,151 @@ bool BTFHeaderGenerator::createTypeTreeHelper(Context &context,
                                               const std::uint32_t &parent,
                                               const std::uint32_t &id) {
 
-  // Ignore void types
-  if (id == 0) {
-    return true;
-  }
+  // The types are visited in depth-first order using an explicit work
+  // list, so that long dependency chains do not exhaust the stack.
+  // Children are pushed in reverse so that they are visited in the same
+  // order as they are listed
+  auto &work_list = context.type_tree_work_list;
+  work_list.clear();
+  work_list.push_back({parent, id, inside_pointer});
 
-  const auto &btf_type = context.btf_type_map.at(id);
+  std::vector<std::uint32_t> dependency_list;
 
-  auto btf_kind = btfparse::IBTF::getBTFTypeKind(btf_type);
+  auto push_dependencies = [&work_list, &dependency_list](
+                               std::uint32_t dependency_parent,
+                               bool dependency_inside_pointer) -> void {
+    for (auto it = dependency_list.rbegin(); it != dependency_list.rend();
+         ++it) {
+      work_list.push_back({dependency_parent, *it, dependency_inside_pointer});
+    }
+  };
 
-  if (btf_kind == btfparse::BTFKind::Ptr) {
-    const auto &ptr_btf_type = getTypeAs<btfparse::PtrBTFType>(btf_type);
-    return createTypeTreeHelper(context, true, parent, ptr_btf_type.type);
+  while (!work_list.empty()) {
+    auto node = work_list.back();
+    work_list.pop_back();
 
-  } else if (btf_kind == btfparse::BTFKind::Array) {
-    const auto &array_btf_type = getTypeAs<btfparse::ArrayBTFType>(btf_type);
-    return createTypeTreeHelper(context, inside_pointer, parent,
-                                array_btf_type.type);
+    // Ignore void types
+    if (node.id == 0) {
+      continue;
+    }
 
-  } else if (btf_kind == btfparse::BTFKind::Volatile) {
-    const auto &volatile_btf_type =
-        getTypeAs<btfparse::VolatileBTFType>(btf_type);
+    const auto &btf_type = context.btf_type_map.at(node.id);
 
-    return createTypeTreeHelper(context, inside_pointer, parent,
-                                volatile_btf_type.type);
+    auto btf_kind = btfparse::IBTF::getBTFTypeKind(btf_type);
 
-  } else if (btf_kind == btfparse::BTFKind::Const) {
-    const auto &const_btf_type = getTypeAs<btfparse::ConstBTFType>(btf_type);
-    return createTypeTreeHelper(context, inside_pointer, parent,
-                                const_btf_type.type);
+    if (btf_kind == btfparse::BTFKind::Ptr) {
+      const auto &ptr_btf_type = getTypeAs<btfparse::PtrBTFType>(btf_type);
+      work_list.push_back({node.parent, ptr_btf_type.type, true});
+      continue;
 
-  } else if (btf_kind == btfparse::BTFKind::Restrict) {
-    const auto &restrict_btf_type =
-        getTypeAs<btfparse::RestrictBTFType>(btf_type);
+    } else if (btf_kind == btfparse::BTFKind::Array) {
+      const auto &array_btf_type = getTypeAs<btfparse::ArrayBTFType>(btf_type);
+      work_list.push_back(
+          {node.parent, array_btf_type.type, node.inside_pointer});
 
-    return createTypeTreeHelper(context, inside_pointer, parent,
-                                restrict_btf_type.type);
+      continue;
 
-  } else if (btf_kind == btfparse::BTFKind::FuncProto) {
-    const auto &func_proto_btf_type =
-        getTypeAs<btfparse::FuncProtoBTFType>(btf_type);
+    } else if (btf_kind == btfparse::BTFKind::Volatile) {
+      const auto &volatile_btf_type =
+          getTypeAs<btfparse::VolatileBTFType>(btf_type);
 
-    if (!createTypeTreeHelper(context, inside_pointer, parent,
-                              func_proto_btf_type.return_type)) {
-      return false;
-    }
+      work_list.push_back(
+          {node.parent, volatile_btf_type.type, node.inside_pointer});
 
-    for (const auto &param : func_proto_btf_type.param_list) {
-      if (!createTypeTreeHelper(context, inside_pointer, parent, param.type)) {
-        return false;
-      }
-    }
+      continue;
 
-    return true;
+    } else if (btf_kind == btfparse::BTFKind::Const) {
+      const auto &const_btf_type = getTypeAs<btfparse::ConstBTFType>(btf_type);
+      work_list.push_back(
+          {node.parent, const_btf_type.type, node.inside_pointer});
+
+      continue;
 
-  } else if (!isTopLevelTypeDeclaration(context, id)) {
-    if (btf_kind == btfparse::BTFKind::Union ||
-        btf_kind == btfparse::BTFKind::Struct) {
+    } else if (btf_kind == btfparse::BTFKind::Restrict) {
+      const auto &restrict_btf_type =
+          getTypeAs<btfparse::RestrictBTFType>(btf_type);
 
-      std::vector<std::uint32_t> dependency_list;
-      if (!getTypeDependencies(context, dependency_list, id)) {
-        return false;
+      work_list.push_back(
+          {node.parent, restrict_btf_type.type, node.inside_pointer});
+
+      continue;
+
+    } else if (btf_kind == btfparse::BTFKind::FuncProto) {
+      const auto &func_proto_btf_type =
+          getTypeAs<btfparse::FuncProtoBTFType>(btf_type);
+
+      dependency_list.clear();
+      dependency_list.push_back(func_proto_btf_type.return_type);
+
+      for (const auto &param : func_proto_btf_type.param_list) {
+        dependency_list.push_back(param.type);
       }
 
-      // Recurse into anonymous structs/unions. there should be no
-      // way to cull this out: since it has no name, there is no
-      // chance we have seen this already
-      //
-      // Since this is a nested type, we have to clear the 'inside_pointer'
-      // flag
-      for (const auto &dependency_id : dependency_list) {
-        if (!createTypeTreeHelper(context, false, parent, dependency_id)) {
+      push_dependencies(node.parent, node.inside_pointer);
+      continue;
+
+    } else if (!isTopLevelTypeDeclaration(context, node.id)) {
+      if (btf_kind == btfparse::BTFKind::Union ||
+          btf_kind == btfparse::BTFKind::Struct) {
+
+        if (!getTypeDependencies(context, dependency_list, node.id)) {
           return false;
         }
+
+        // Recurse into anonymous structs/unions. there should be no
+        // way to cull this out: since it has no name, there is no
+        // chance we have seen this already
+        //
+        // Since this is a nested type, we have to clear the 'inside_pointer'
+        // flag
+        push_dependencies(node.parent, false);
+        continue;
       }
 
-      return true;
-    }
+      switch (btf_kind) {
+      case btfparse::BTFKind::Int:
+      case btfparse::BTFKind::Float:
+      case btfparse::BTFKind::Enum:
+        break;
 
-    switch (btf_kind) {
-    case btfparse::BTFKind::Int:
-    case btfparse::BTFKind::Float:
-    case btfparse::BTFKind::Enum:
-      break;
+      default: {
+        std::stringstream error_buffer;
+        error_buffer << "Invalid state. Encountered a BTF type #" << node.id
+                     << " of unexpected kind: " << static_cast<int>(btf_kind);
 
-    default: {
-      std::stringstream error_buffer;
-      error_buffer << "Invalid state. Encountered a BTF type #" << id
-                   << " of unexpected kind: " << static_cast<int>(btf_kind);
+        throw std::logic_error(error_buffer.str());
+      }
+      }
 
-      throw std::logic_error(error_buffer.str());
-    }
+      continue;
     }
 
-    return true;
-  }
-
-  auto link_list_it = context.type_tree.find(parent);
-  if (link_list_it == context.type_tree.end()) {
-    auto insert_status = context.type_tree.insert({parent, {}});
-    link_list_it = insert_status.first;
-  }
+    // this is a weak reference only if we can forward declare it
+    auto weak_reference =
+        node.inside_pointer && (btf_kind == btfparse::BTFKind::Struct ||
+                                btf_kind == btfparse::BTFKind::Union);
 
-  auto &link_list = link_list_it->second;
+    // Duplicated links are merged by createTypeTree, always upgrading from
+    // weak to strong
+    context.type_tree.addEdge(node.parent, node.id, weak_reference);
 
-  // this is a weak reference only if we can forward declare it
-  auto weak_reference =
-      inside_pointer && (btf_kind == btfparse::BTFKind::Struct ||
-                         btf_kind == btfparse::BTFKind::Union);
-
-  auto link_it = link_list.find(id);
-  if (link_it == link_list.end()) {
-    link_list.insert({id, weak_reference});
-  } else {
-    // always upgrade from weak to strong link
-    auto &link_kind = link_it->second;
-    if (link_kind) {
-      link_kind = weak_reference;
+    // When generating a subset of the types, the ones that are only reached
+    // through a pointer are forward declared by createTypeQueue, so their
+    // dependencies are not needed
+    if (weak_reference && context.opt_root_type_list.has_value()) {
+      continue;
     }
-  }
-
-  if (context.visited_type_list.count(id) > 0) {
-    // Do not recurse into this type if we have seen it already
-    return true;
-  }
 
-  context.visited_type_list.insert(id);
-
-  std::vector<std::uint32_t> dependency_list;
-  if (!getTypeDependencies(context, dependency_list, id)) {
-    return false;
-  }
+    if (!context.visited_type_list.insert(node.id)) {
+      // Do not recurse into this type if we have seen it already
+      continue;
+    }
 
-  for (const auto &dependency_id : dependency_list) {
-    if (!createTypeTreeHelper(context, false, id, dependency_id)) {
+    if (!getTypeDependencies(context, dependency_list, node.id)) {
       return false;
     }
+
+    push_dependencies(node.id, false);
   }
 
   return true;
@@ -1011,7 +1027,9 @@ bool BTFHeaderGenerator::adjustTypedefDependencyLoops(Context &context) {
   // that need to be re-evaluated
   bool try_again{false};
 
-  std::unordered_map<std::uint32_t, std::uint32_t> typedef_map;
+  // Pairs of (typedef, struct), in the order they have been found
+  std::vector<std::pair<std::uint32_t, std::uint32_t>> typedef_list;
+  BTFTypeIDSet patched_typedef_list;
 
   do {
     try_again = false;
@@ -1027,12 +1045,7 @@ bool BTFHeaderGenerator::adjustTypedefDependencyLoops(Context &context) {
 
       auto is_union = btf_kind == btfparse::BTFKind::Union;
 
-      auto struct_dependency_list_it = context.type_tree.find(struct_id);
-      if (struct_dependency_list_it == context.type_tree.end()) {
-        continue;
-      }
-
-      auto &struct_dependency_list = struct_dependency_list_it->second;
+      auto struct_dependency_list = context.type_tree.edges(struct_id);
       if (struct_dependency_list.empty()) {
         continue;
       }
@@ -1045,8 +1058,8 @@ bool BTFHeaderGenerator::adjustTypedefDependencyLoops(Context &context) {
 
       const auto &struct_name = opt_struct_name.value();
 
-      for (const auto &p : struct_dependency_list) {
-        auto &typedef_id = p.first;
+      for (const auto &struct_edge : struct_dependency_list) {
+        auto typedef_id = struct_edge.id();
         auto &typedef_btf_type = context.btf_type_map.at(typedef_id);
 
         btf_kind = btfparse::IBTF::getBTFTypeKind(typedef_btf_type);
@@ -1054,24 +1067,26 @@ bool BTFHeaderGenerator::adjustTypedefDependencyLoops(Context &context) {
           continue;
         }
 
-        auto typedef_dependency_list_it = context.type_tree.find(typedef_id);
-        if (typedef_dependency_list_it == context.type_tree.end()) {
-          // This typedef may not have a top level dependency. If that is
-          // the case, then skip it
-          continue;
-        }
+        // This typedef may not have a top level dependency. If that is
+        // the case, then the search below will skip it
+        auto typedef_dependency_list = context.type_tree.edges(typedef_id);
 
-        auto &typedef_dependency_list = typedef_dependency_list_it->second;
-        if (typedef_dependency_list.count(struct_id) == 0) {
+        auto typedef_edge_it = std::find_if(
+            typedef_dependency_list.begin(), typedef_dependency_list.end(),
+            [struct_id](const BTFTypeGraph::Edge &edge) -> bool {
+              return edge.id() == struct_id;
+            });
+
+        if (typedef_edge_it == typedef_dependency_list.end()) {
           continue;
         }
 
-        typedef_dependency_list.erase(struct_id);
-
         auto fwd_id = getOrCreateFwdType(context, is_union, struct_name);
-        typedef_dependency_list.insert({fwd_id, false});
+        *typedef_edge_it = BTFTypeGraph::Edge(fwd_id, false);
 
-        typedef_map.insert({typedef_id, struct_id});
+        if (patched_typedef_list.insert(typedef_id)) {
+          typedef_list.emplace_back(typedef_id, struct_id);
+        }
 
         try_again = true;
       }
@@ -1081,22 +1096,19 @@ bool BTFHeaderGenerator::adjustTypedefDependencyLoops(Context &context) {
   // Update the types that depend on the typedefs we patched. Since
   // the typedef and the struct are now generated together, we can
   // just change the typedef parents to point to the struct
-  createInverseTypeTree(context);
+  context.inverse_type_tree = context.type_tree.createInverse();
 
-  std::unordered_map<std::uint32_t, std::unordered_set<std::uint32_t>>
-      child_node_list_map;
+  std::unordered_map<std::uint32_t, BTFTypeIDSet> child_node_list_map;
 
-  for (const auto &p : typedef_map) {
+  for (const auto &p : typedef_list) {
     const auto &typedef_id = p.first;
     const auto &typedef_struct_id = p.second;
 
-    auto inverse_type_tree_it = context.inverse_type_tree.find(typedef_id);
-    if (inverse_type_tree_it == context.inverse_type_tree.end()) {
+    auto typedef_user_list = context.inverse_type_tree.edges(typedef_id);
+    if (typedef_user_list.empty()) {
       continue;
     }
 
-    const auto &typedef_user_list = inverse_type_tree_it->second;
-
     auto child_node_list_map_it = child_node_list_map.find(typedef_struct_id);
 
     if (child_node_list_map_it == child_node_list_map.end()) {
@@ -1110,7 +1122,8 @@ bool BTFHeaderGenerator::adjustTypedefDependencyLoops(Context &context) {
 
     const auto &struct_child_nodes = child_node_list_map_it->second;
 
-    for (const auto &typedef_user : typedef_user_list) {
+    for (const auto &typedef_user_edge : typedef_user_list) {
+      auto typedef_user = typedef_user_edge.id();
       if (typedef_user == typedef_struct_id) {
         continue;
       }
@@ -1119,88 +1132,91 @@ bool BTFHeaderGenerator::adjustTypedefDependencyLoops(Context &context) {
         continue;
       }
 
-      auto type_tree_it = context.type_tree.find(typedef_user);
-      if (type_tree_it == context.type_tree.end()) {
+      if (context.type_tree.edges(typedef_user).empty()) {
         continue;
       }
 
-      auto &typedef_user_deps = type_tree_it->second;
-
-      typedef_user_deps.erase(typedef_struct_id);
-      typedef_user_deps.insert({typedef_struct_id, false});
+      // Merged by finalize into a strong link, replacing the existing
+      // one if there is any
+      context.type_tree.addEdge(typedef_user, typedef_struct_id, false);
     }
   }
 
+  context.type_tree.finalize();
   return true;
 }
 
 bool BTFHeaderGenerator::createTypeQueue(Context &context) {
   context.type_queue.clear();
-  context.visited_type_list = {0};
+  context.type_queue.reserve(context.top_level_type_list.size());
 
-  for (const auto &id : context.top_level_type_list) {
-    if (!createTypeQueueHelper(context, id)) {
-      return false;
-    }
-  }
+  context.visited_type_list.clear();
+  context.visited_type_list.reserve(context.btf_type_id_generator + 1U);
+  context.visited_type_list.insert(0);
 
-  return true;
+  return forEachRootType(context, [&context](std::uint32_t id) -> bool {
+    return createTypeQueueHelper(context, id);
+  });
 }
 
 bool BTFHeaderGenerator::createTypeQueueHelper(Context &context,
                                                const std::uint32_t &id) {
-  if (id == 0) {
-    return true;
-  }
 
-  if (context.visited_type_list.count(id) > 0) {
-    return true;
-  }
+  // Post-order traversal using an explicit work list: a type is queued
+  // once all of its links have been queued
+  auto &work_list = context.type_queue_work_list;
+  work_list.clear();
 
-  context.visited_type_list.insert(id);
+  auto visit = [&context, &work_list](std::uint32_t type_id) {
+    if (type_id != 0 && context.visited_type_list.insert(type_id)) {
+      work_list.push_back({type_id, 0});
+    }
+  };
 
-  auto link_list_it = context.type_tree.find(id);
-  if (link_list_it != context.type_tree.end()) {
-    auto &link_list = link_list_it->second;
+  visit(id);
 
-    for (const auto &p : link_list) {
-      auto linked_type = p.first;
-      const auto &weak_reference = p.second;
+  while (!work_list.empty()) {
+    auto &node = work_list.back();
 
-      if (weak_reference) {
-        const auto &btf_type = context.btf_type_map.at(linked_type);
+    auto edge_list = context.type_tree.edges(node.id);
+    auto edge_it = edge_list.begin() + node.next_edge;
 
-        auto btf_kind = btfparse::IBTF::getBTFTypeKind(btf_type);
-        bool is_union;
+    if (edge_it == edge_list.end()) {
+      context.type_queue.push_back(node.id);
+      work_list.pop_back();
 
-        if (btf_kind == btfparse::BTFKind::Union) {
-          is_union = true;
+      continue;
+    }
 
-        } else if (btf_kind == btfparse::BTFKind::Struct) {
-          is_union = false;
+    ++node.next_edge;
 
-        } else {
-          return false;
-        }
+    auto linked_type = edge_it->id();
 
-        auto opt_type_name = getTypeName(context, linked_type);
-        auto fwd_type_id =
-            getOrCreateFwdType(context, is_union, opt_type_name.value());
+    if (edge_it->weak()) {
+      const auto &btf_type = context.btf_type_map.at(linked_type);
 
-        if (!createTypeQueueHelper(context, fwd_type_id)) {
-          return false;
-        }
+      auto btf_kind = btfparse::IBTF::getBTFTypeKind(btf_type);
+      bool is_union;
 
-        linked_type = fwd_type_id;
-      }
+      if (btf_kind == btfparse::BTFKind::Union) {
+        is_union = true;
+
+      } else if (btf_kind == btfparse::BTFKind::Struct) {
+        is_union = false;
 
-      if (!createTypeQueueHelper(context, linked_type)) {
+      } else {
         return false;
       }
+
+      auto opt_type_name = getTypeName(context, linked_type);
+      linked_type =
+          getOrCreateFwdType(context, is_union, opt_type_name.value());
     }
+
+    // This may invalidate the node reference
+    visit(linked_type);
   }
 
-  context.type_queue.push_back(id);
   return true;
 }
 
@@ -1209,81 +1225,81 @@ bool BTFHeaderGenerator::isTopLevelTypeDeclaration(const Context &context,
   return context.top_level_type_list.count(id) > 0;
 }
 
-void BTFHeaderGenerator::setVariableName(Context &context,
+void BTFHeaderGenerator::setVariableName(EmissionState &state,
                                          const std::string &name) {
-  context.opt_variable_name = name;
+  state.opt_variable_name = name;
 }
 
 std::optional<std::string>
-BTFHeaderGenerator::takeVariableName(Context &context) {
-  auto opt_variable_name = std::move(context.opt_variable_name);
-  context.opt_variable_name = std::nullopt;
+BTFHeaderGenerator::takeVariableName(EmissionState &state) {
+  auto opt_variable_name = std::move(state.opt_variable_name);
+  state.opt_variable_name = std::nullopt;
 
   return opt_variable_name;
 }
 
-void BTFHeaderGenerator::pushVariableName(Context &context) {
-  context.variable_name_stack.push_back(std::move(context.opt_variable_name));
-  context.opt_variable_name = std::nullopt;
+void BTFHeaderGenerator::pushVariableName(EmissionState &state) {
+  state.variable_name_stack.push_back(std::move(state.opt_variable_name));
+  state.opt_variable_name = std::nullopt;
 }
 
-void BTFHeaderGenerator::popVariableName(Context &context) {
-  if (context.variable_name_stack.empty()) {
-    context.opt_variable_name = std::nullopt;
+void BTFHeaderGenerator::popVariableName(EmissionState &state) {
+  if (state.variable_name_stack.empty()) {
+    state.opt_variable_name = std::nullopt;
   } else {
-    context.opt_variable_name = std::move(context.variable_name_stack.back());
-    context.variable_name_stack.pop_back();
+    state.opt_variable_name = std::move(state.variable_name_stack.back());
+    state.variable_name_stack.pop_back();
   }
 }
 
-void BTFHeaderGenerator::setTypedefName(Context &context,
+void BTFHeaderGenerator::setTypedefName(EmissionState &state,
                                         const std::string &name) {
-  context.opt_typedef_name = name;
+  state.opt_typedef_name = name;
 }
 
 std::optional<std::string>
-BTFHeaderGenerator::takeTypedefName(Context &context) {
-  auto opt_typedef_name = std::move(context.opt_typedef_name);
-  context.opt_typedef_name = std::nullopt;
+BTFHeaderGenerator::takeTypedefName(EmissionState &state) {
+  auto opt_typedef_name = std::move(state.opt_typedef_name);
+  state.opt_typedef_name = std::nullopt;
 
   return opt_typedef_name;
 }
 
-void BTFHeaderGenerator::pushTypedefName(Context &context) {
-  context.typedef_name_stack.push_back(std::move(context.opt_typedef_name));
-  context.opt_typedef_name = std::nullopt;
+void BTFHeaderGenerator::pushTypedefName(EmissionState &state) {
+  state.typedef_name_stack.push_back(std::move(state.opt_typedef_name));
+  state.opt_typedef_name = std::nullopt;
 }
 
-void BTFHeaderGenerator::popTypedefName(Context &context) {
-  if (context.typedef_name_stack.empty()) {
-    context.opt_typedef_name = std::nullopt;
+void BTFHeaderGenerator::popTypedefName(EmissionState &state) {
+  if (state.typedef_name_stack.empty()) {
+    state.opt_typedef_name = std::nullopt;
   } else {
-    context.opt_typedef_name = std::move(context.typedef_name_stack.back());
-    context.typedef_name_stack.pop_back();
+    state.opt_typedef_name = std::move(state.typedef_name_stack.back());
+    state.typedef_name_stack.pop_back();
   }
 }
 
-void BTFHeaderGenerator::pushState(Context &context) {
-  pushVariableName(context);
-  pushModifierList(context);
-  pushTypedefName(context);
+void BTFHeaderGenerator::pushState(EmissionState &state) {
+  pushVariableName(state);
+  pushModifierList(state);
+  pushTypedefName(state);
 }
 
-void BTFHeaderGenerator::popState(Context &context) {
-  popVariableName(context);
-  popModifierList(context);
-  popTypedefName(context);
+void BTFHeaderGenerator::popState(EmissionState &state) {
+  popVariableName(state);
+  popModifierList(state);
+  popTypedefName(state);
 }
 
-void BTFHeaderGenerator::resetState(Context &context) {
-  context.modifier_list_stack.clear();
-  context.modifier_list.clear();
+void BTFHeaderGenerator::resetState(EmissionState &state) {
+  state.modifier_list_stack.clear();
+  state.modifier_list.clear();
 
-  context.typedef_name_stack.clear();
-  context.opt_typedef_name = std::nullopt;
+  state.typedef_name_stack.clear();
+  state.opt_typedef_name = std::nullopt;
 
-  context.variable_name_stack.clear();
-  context.opt_variable_name = std::nullopt;
+  state.variable_name_stack.clear();
+  state.opt_variable_name = std::nullopt;
 }
 
 std::uint32_t BTFHeaderGenerator::getOrCreateFwdType(Context &context,
@@ -1307,7 +1323,8 @@ std::uint32_t BTFHeaderGenerator::getOrCreateFwdType(Context &context,
 }
 
 template <typename Type>
-bool generateStructOrUnion(BTFHeaderGenerator::Context &context,
+bool generateStructOrUnion(const BTFHeaderGenerator::Context &context,
+                           BTFHeaderGenerator::EmissionState &state,
                            std::stringstream &buffer, std::uint32_t id,
                            const Type &btf_type, bool as_type_definition) {
 
@@ -1315,10 +1332,10 @@ bool generateStructOrUnion(BTFHeaderGenerator::Context &context,
                     std::is_same<Type, UnionBTFType>::value,
                 "Invalid type passed to generateStructOrUnion");
 
-  BTFHeaderGenerator::generateTypeHeader(context, buffer, id);
-  BTFHeaderGenerator::generateIndent(context, buffer);
+  BTFHeaderGenerator::generateTypeHeader(state, buffer, id);
+  BTFHeaderGenerator::generateIndent(state, buffer);
 
-  if (!BTFHeaderGenerator::generateLeftModifiers(context, buffer)) {
+  if (!BTFHeaderGenerator::generateLeftModifiers(context, state, buffer)) {
     return false;
   }
 
@@ -1337,18 +1354,18 @@ bool generateStructOrUnion(BTFHeaderGenerator::Context &context,
                    (!as_type_definition && !btf_type.opt_name.has_value());
 
   if (emit_body) {
-    BTFHeaderGenerator::pushState(context);
+    BTFHeaderGenerator::pushState(state);
 
     buffer << " {\n";
 
-    BTFHeaderGenerator::increaseIndent(context);
+    BTFHeaderGenerator::increaseIndent(state);
 
     for (const auto &member : btf_type.member_list) {
       if (member.opt_name.has_value()) {
-        BTFHeaderGenerator::setVariableName(context, member.opt_name.value());
+        BTFHeaderGenerator::setVariableName(state, member.opt_name.value());
       }
 
-      if (!BTFHeaderGenerator::generateType(context, buffer, member.type,
+      if (!BTFHeaderGenerator::generateType(context, state, buffer, member.type,
                                             false)) {
         return false;
       }
@@ -1366,62 +1383,65 @@ bool generateStructOrUnion(BTFHeaderGenerator::Context &context,
       buffer << ";\n";
     }
 
-    BTFHeaderGenerator::decreaseIndent(context);
-    BTFHeaderGenerator::generateIndent(context, buffer);
+    BTFHeaderGenerator::decreaseIndent(state);
+    BTFHeaderGenerator::generateIndent(state, buffer);
 
     buffer << "}";
 
-    BTFHeaderGenerator::popState(context);
+    BTFHeaderGenerator::popState(state);
   }
 
-  if (!BTFHeaderGenerator::generateMiddleModifiers(context, buffer)) {
+  if (!BTFHeaderGenerator::generateMiddleModifiers(context, state, buffer)) {
     return false;
   }
 
-  opt_name = BTFHeaderGenerator::takeVariableName(context);
+  opt_name = BTFHeaderGenerator::takeVariableName(state);
   if (!opt_name.has_value()) {
-    opt_name = BTFHeaderGenerator::takeTypedefName(context);
+    opt_name = BTFHeaderGenerator::takeTypedefName(state);
   }
 
   if (opt_name.has_value()) {
     buffer << " " << opt_name.value();
   }
 
-  if (!BTFHeaderGenerator::generateRightModifiers(context, buffer)) {
+  if (!BTFHeaderGenerator::generateRightModifiers(context, state, buffer)) {
     return false;
   }
 
   return true;
 }
 
-bool BTFHeaderGenerator::generateType(Context &context,
+bool BTFHeaderGenerator::generateType(const Context &context,
+                                      EmissionState &state,
                                       std::stringstream &buffer,
                                       std::uint32_t id,
                                       const StructBTFType &struct_btf_type,
                                       bool as_type_definition) {
-  return generateStructOrUnion(context, buffer, id, struct_btf_type,
+  return generateStructOrUnion(context, state, buffer, id, struct_btf_type,
                                as_type_definition);
 }
 
-bool BTFHeaderGenerator::generateType(Context &context,
+bool BTFHeaderGenerator::generateType(const Context &context,
+                                      EmissionState &state,
                                       std::stringstream &buffer,
                                       std::uint32_t id,
                                       const UnionBTFType &union_btf_type,
                                       bool as_type_definition) {
-  return generateStructOrUnion(context, buffer, id, union_btf_type,
+  return generateStructOrUnion(context, state, buffer, id, union_btf_type,
                                as_type_definition);
 }
 
-bool BTFHeaderGenerator::generateType(Context &context,
+bool BTFHeaderGenerator::generateType(const Context &context,
+                                      EmissionState &state,
                                       std::stringstream &buffer,
                                       std::uint32_t id,
                                       const EnumBTFType &enum_btf_type,
                                       bool as_type_definition) {
 
-  generateTypeHeader(context, buffer, id);
-  generateIndent(context, buffer);
+  generateTypeHeader(state, buffer, id);
+  generateIndent(state, buffer);
 
-  if (!generateLeftModifiers(context, buffer)) {
+  if (!generateLeftModifiers(context, state, buffer)) {
     return false;
   }
 
@@ -1437,14 +1457,14 @@ bool BTFHeaderGenerator::generateType(Context &context,
   if (emit_body) {
     buffer << " {\n";
 
-    increaseIndent(context);
+    increaseIndent(state);
 
     for (auto value_it = enum_btf_type.value_list.begin();
          value_it != enum_btf_type.value_list.end(); ++value_it) {
 
       const auto &value = *value_it;
 
-      generateIndent(context, buffer);
+      generateIndent(state, buffer);
 
       buffer << value.name << " = " << value.val;
       if (std::next(value_it, 1) != enum_btf_type.value_list.end()) {
@@ -1454,80 +1474,81 @@ bool BTFHeaderGenerator::generateType(Context &context,
       buffer << "\n";
     }
 
-    decreaseIndent(context);
-    generateIndent(context, buffer);
+    decreaseIndent(state);
+    generateIndent(state, buffer);
 
     buffer << "}";
   }
 
-  if (!generateMiddleModifiers(context, buffer)) {
+  if (!generateMiddleModifiers(context, state, buffer)) {
     return false;
   }
 
-  auto opt_name = BTFHeaderGenerator::takeVariableName(context);
+  auto opt_name = BTFHeaderGenerator::takeVariableName(state);
   if (!opt_name.has_value()) {
-    opt_name = BTFHeaderGenerator::takeTypedefName(context);
+    opt_name = BTFHeaderGenerator::takeTypedefName(state);
   }
 
   if (opt_name.has_value()) {
     buffer << " " << opt_name.value();
   }
 
-  if (!generateRightModifiers(context, buffer)) {
+  if (!generateRightModifiers(context, state, buffer)) {
     return false;
   }
 
   return true;
 }
 
-bool BTFHeaderGenerator::generateType(Context &context,
+bool BTFHeaderGenerator::generateType(const Context &context,
+                                      EmissionState &state,
                                       std::stringstream &buffer,
                                       std::uint32_t id,
                                       const TypedefBTFType &typedef_btf_type,
                                       bool as_type_definition) {
 
   if (as_type_definition) {
-    generateTypeHeader(context, buffer, id);
+    generateTypeHeader(state, buffer, id);
 
     buffer << "typedef\n";
-    increaseIndent(context);
+    increaseIndent(state);
 
-    setTypedefName(context, typedef_btf_type.name);
-    if (!generateType(context, buffer, typedef_btf_type.type, false)) {
+    setTypedefName(state, typedef_btf_type.name);
+    if (!generateType(context, state, buffer, typedef_btf_type.type, false)) {
       return false;
     }
 
-    auto opt_name = BTFHeaderGenerator::takeTypedefName(context);
+    auto opt_name = BTFHeaderGenerator::takeTypedefName(state);
     if (opt_name.has_value()) {
       buffer << " " << opt_name.value();
     }
 
-    decreaseIndent(context);
+    decreaseIndent(state);
 
   } else {
-    generateTypeHeader(context, buffer, id);
-    generateIndent(context, buffer);
+    generateTypeHeader(state, buffer, id);
+    generateIndent(state, buffer);
 
-    if (!generateLeftModifiers(context, buffer)) {
+    if (!generateLeftModifiers(context, state, buffer)) {
       return false;
     }
 
     buffer << typedef_btf_type.name;
 
-    if (!generateMiddleModifiers(context, buffer)) {
+    if (!generateMiddleModifiers(context, state, buffer)) {
       return false;
     }
 
-    auto opt_name = BTFHeaderGenerator::takeVariableName(context);
+    auto opt_name = BTFHeaderGenerator::takeVariableName(state);
     if (!opt_name.has_value()) {
-      opt_name = BTFHeaderGenerator::takeTypedefName(context);
+      opt_name = BTFHeaderGenerator::takeTypedefName(state);
     }
 
     if (opt_name.has_value()) {
       buffer << " " << opt_name.value();
     }
 
-    if (!generateRightModifiers(context, buffer)) {
+    if (!generateRightModifiers(context, state, buffer)) {
       return false;
     }
   }
@@ -1535,34 +1556,35 @@ bool BTFHeaderGenerator::generateType(Context &context,
   return true;
 }
 
-bool BTFHeaderGenerator::generateType(Context &context,
+bool BTFHeaderGenerator::generateType(const Context &context,
+                                      EmissionState &state,
                                       std::stringstream &buffer,
                                       std::uint32_t id,
                                       const IntBTFType &int_btf_type, bool) {
 
-  generateTypeHeader(context, buffer, id);
-  generateIndent(context, buffer);
+  generateTypeHeader(state, buffer, id);
+  generateIndent(state, buffer);
 
-  if (!generateLeftModifiers(context, buffer)) {
+  if (!generateLeftModifiers(context, state, buffer)) {
     return false;
   }
 
   buffer << int_btf_type.name;
 
-  if (!generateMiddleModifiers(context, buffer)) {
+  if (!generateMiddleModifiers(context, state, buffer)) {
     return false;
   }
 
-  auto opt_name = BTFHeaderGenerator::takeVariableName(context);
+  auto opt_name = BTFHeaderGenerator::takeVariableName(state);
   if (!opt_name.has_value()) {
-    opt_name = BTFHeaderGenerator::takeTypedefName(context);
+    opt_name = BTFHeaderGenerator::takeTypedefName(state);
   }
 
   if (opt_name.has_value()) {
     buffer << " " << opt_name.value();
   }
 
-  if (!generateRightModifiers(context, buffer)) {
+  if (!generateRightModifiers(context, state, buffer)) {
     return false;
   }
 
@@ -1570,63 +1592,65 @@ bool BTFHeaderGenerator::generateType(Context &context,
 }
 
 bool BTFHeaderGenerator::generateType(
-    Context &context, std::stringstream &buffer, std::uint32_t id,
-    const FuncProtoBTFType &func_proto_btf_type, bool as_type_definition) {
+    const Context &context, EmissionState &state, std::stringstream &buffer,
+    std::uint32_t id, const FuncProtoBTFType &func_proto_btf_type,
+    bool as_type_definition) {
 
-  filterFuncProtoModifiers(context);
-  generateTypeHeader(context, buffer, id);
-  increaseIndent(context);
+  filterFuncProtoModifiers(context, state);
+  generateTypeHeader(state, buffer, id);
+  increaseIndent(state);
 
-  pushState(context);
+  pushState(state);
 
-  if (!generateType(context, buffer, func_proto_btf_type.return_type, false)) {
+  if (!generateType(context, state, buffer, func_proto_btf_type.return_type,
+                    false)) {
     return false;
   }
 
-  popState(context);
+  popState(state);
 
-  increaseIndent(context);
-  generateIndent(context, buffer);
+  increaseIndent(state);
+  generateIndent(state, buffer);
 
   buffer << "\n";
 
-  generateIndent(context, buffer);
+  generateIndent(state, buffer);
 
   buffer << "(";
 
-  if (!generateLeftModifiers(context, buffer)) {
+  if (!generateLeftModifiers(context, state, buffer)) {
     return false;
   }
 
-  if (!generateMiddleModifiers(context, buffer)) {
+  if (!generateMiddleModifiers(context, state, buffer)) {
     return false;
   }
 
-  auto opt_name = BTFHeaderGenerator::takeVariableName(context);
+  auto opt_name = BTFHeaderGenerator::takeVariableName(state);
   if (!opt_name.has_value()) {
-    opt_name = BTFHeaderGenerator::takeTypedefName(context);
+    opt_name = BTFHeaderGenerator::takeTypedefName(state);
   }
 
   if (opt_name.has_value()) {
     buffer << " " << opt_name.value();
   }
 
-  if (!generateRightModifiers(context, buffer)) {
+  if (!generateRightModifiers(context, state, buffer)) {
     return false;
   }
 
   buffer << ")(\n";
 
-  increaseIndent(context);
+  increaseIndent(state);
 
-  pushState(context);
+  pushState(state);
 
   for (auto param_it = func_proto_btf_type.param_list.begin();
        param_it != func_proto_btf_type.param_list.end(); ++param_it) {
 
     const auto &param = *param_it;
 
-    if (!generateType(context, buffer, param.type, false)) {
+    if (!generateType(context, state, buffer, param.type, false)) {
       return false;
     }
 
@@ -1640,120 +1664,130 @@ bool BTFHeaderGenerator::generateType(
     buffer << "\n";
   }
 
-  popState(context);
+  popState(state);
 
   if (func_proto_btf_type.is_variadic) {
-    generateIndent(context, buffer);
+    generateIndent(state, buffer);
     buffer << "...\n";
   }
 
-  decreaseIndent(context);
+  decreaseIndent(state);
 
-  generateIndent(context, buffer);
+  generateIndent(state, buffer);
   buffer << ")";
 
-  decreaseIndent(context);
-  decreaseIndent(context);
+  decreaseIndent(state);
+  decreaseIndent(state);
 
   return true;
 }
 
-bool BTFHeaderGenerator::generateType(Context &context,
+bool BTFHeaderGenerator::generateType(const Context &context,
+                                      EmissionState &state,
                                       std::stringstream &buffer,
                                       std::uint32_t id,
                                       const FloatBTFType &float_btf_type,
                                       bool) {
 
-  generateTypeHeader(context, buffer, id);
-  generateIndent(context, buffer);
+  generateTypeHeader(state, buffer, id);
+  generateIndent(state, buffer);
 
-  if (!generateLeftModifiers(context, buffer)) {
+  if (!generateLeftModifiers(context, state, buffer)) {
     return false;
   }
 
   buffer << float_btf_type.name;
 
-  if (!generateMiddleModifiers(context, buffer)) {
+  if (!generateMiddleModifiers(context, state, buffer)) {
     return false;
   }
 
-  auto opt_name = BTFHeaderGenerator::takeVariableName(context);
+  auto opt_name = BTFHeaderGenerator::takeVariableName(state);
   if (!opt_name.has_value()) {
-    opt_name = BTFHeaderGenerator::takeTypedefName(context);
+    opt_name = BTFHeaderGenerator::takeTypedefName(state);
   }
 
   if (opt_name.has_value()) {
     buffer << " " << opt_name.value();
   }
 
-  if (!generateRightModifiers(context, buffer)) {
+  if (!generateRightModifiers(context, state, buffer)) {
     return false;
   }
 
   return true;
 }
 
-bool BTFHeaderGenerator::generateType(Context &context,
+bool BTFHeaderGenerator::generateType(const Context &context,
+                                      EmissionState &state,
                                       std::stringstream &buffer,
                                       std::uint32_t id,
                                       const PtrBTFType &ptr_btf_type,
                                       bool as_type_definition) {
 
-  pushModifier(context, id);
-  return generateType(context, buffer, ptr_btf_type.type, as_type_definition);
+  pushModifier(state, id);
+  return generateType(context, state, buffer, ptr_btf_type.type,
+                      as_type_definition);
 }
 
-bool BTFHeaderGenerator::generateType(Context &context,
+bool BTFHeaderGenerator::generateType(const Context &context,
+                                      EmissionState &state,
                                       std::stringstream &buffer,
                                       std::uint32_t id,
                                       const ArrayBTFType &array_btf_type,
                                       bool as_type_definition) {
 
-  pushModifier(context, id);
-  return generateType(context, buffer, array_btf_type.type, as_type_definition);
+  pushModifier(state, id);
+  return generateType(context, state, buffer, array_btf_type.type,
+                      as_type_definition);
 }
 
-bool BTFHeaderGenerator::generateType(Context &context,
+bool BTFHeaderGenerator::generateType(const Context &context,
+                                      EmissionState &state,
                                       std::stringstream &buffer,
                                       std::uint32_t id,
                                       const VolatileBTFType &volatile_btf_type,
                                       bool as_type_definition) {
 
-  pushModifier(context, id);
-  return generateType(context, buffer, volatile_btf_type.type,
+  pushModifier(state, id);
+  return generateType(context, state, buffer, volatile_btf_type.type,
                       as_type_definition);
 }
 
-bool BTFHeaderGenerator::generateType(Context &context,
+bool BTFHeaderGenerator::generateType(const Context &context,
+                                      EmissionState &state,
                                       std::stringstream &buffer,
                                       std::uint32_t id,
                                       const ConstBTFType &const_btf_type,
                                       bool as_type_definition) {
 
-  pushModifier(context, id);
-  return generateType(context, buffer, const_btf_type.type, as_type_definition);
+  pushModifier(state, id);
+  return generateType(context, state, buffer, const_btf_type.type,
+                      as_type_definition);
 }
 
-bool BTFHeaderGenerator::generateType(Context &context,
+bool BTFHeaderGenerator::generateType(const Context &context,
+                                      EmissionState &state,
                                       std::stringstream &buffer,
                                       std::uint32_t id,
                                       const RestrictBTFType &restrict_btf_type,
                                       bool as_type_definition) {
 
-  pushModifier(context, id);
-  return generateType(context, buffer, restrict_btf_type.type,
+  pushModifier(state, id);
+  return generateType(context, state, buffer, restrict_btf_type.type,
                       as_type_definition);
 }
 
-bool BTFHeaderGenerator::generateType(Context &context,
+bool BTFHeaderGenerator::generateType(const Context &context,
+                                      EmissionState &state,
                                       std::stringstream &buffer,
                                       std::uint32_t id,
                                       const FwdBTFType &fwd_btf_type, bool) {
 
-  BTFHeaderGenerator::generateTypeHeader(context, buffer, id);
-  BTFHeaderGenerator::generateIndent(context, buffer);
+  BTFHeaderGenerator::generateTypeHeader(state, buffer, id);
+  BTFHeaderGenerator::generateIndent(state, buffer);
 
-  if (!BTFHeaderGenerator::generateLeftModifiers(context, buffer)) {
+  if (!BTFHeaderGenerator::generateLeftModifiers(context, state, buffer)) {
     return false;
   }
 
@@ -1761,33 +1795,34 @@ bool BTFHeaderGenerator::generateType(Context &context,
 
   buffer << " " << fwd_btf_type.name;
 
-  if (!BTFHeaderGenerator::generateMiddleModifiers(context, buffer)) {
+  if (!BTFHeaderGenerator::generateMiddleModifiers(context, state, buffer)) {
     return false;
   }
 
-  auto opt_name = BTFHeaderGenerator::takeVariableName(context);
+  auto opt_name = BTFHeaderGenerator::takeVariableName(state);
   if (!opt_name.has_value()) {
-    opt_name = BTFHeaderGenerator::takeTypedefName(context);
+    opt_name = BTFHeaderGenerator::takeTypedefName(state);
   }
 
   if (opt_name.has_value()) {
     buffer << " " << opt_name.value();
   }
 
-  if (!BTFHeaderGenerator::generateRightModifiers(context, buffer)) {
+  if (!BTFHeaderGenerator::generateRightModifiers(context, state, buffer)) {
     return false;
   }
 
   return true;
 }
 
-bool BTFHeaderGenerator::generateType(Context &context,
+bool BTFHeaderGenerator::generateType(const Context &context,
+                                      EmissionState &state,
                                       std::stringstream &buffer,
                                       std::uint32_t id,
                                       bool as_type_definition) {
 
   if (id == 0) {
-    return generateVoidType(context, buffer);
+    return generateVoidType(context, state, buffer);
   }
 
   const auto &btf_type = context.btf_type_map.at(id);
@@ -1795,76 +1830,80 @@ bool BTFHeaderGenerator::generateType(Context &context,
   switch (btfparse::IBTF::getBTFTypeKind(btf_type)) {
   case btfparse::BTFKind::Struct: {
     const auto &struct_btf_type = getTypeAs<StructBTFType>(btf_type);
-    return generateType(context, buffer, id, struct_btf_type,
+    return generateType(context, state, buffer, id, struct_btf_type,
                         as_type_definition);
   }
 
   case btfparse::BTFKind::Union: {
     const auto &union_btf_type = getTypeAs<UnionBTFType>(btf_type);
-    return generateType(context, buffer, id, union_btf_type,
+    return generateType(context, state, buffer, id, union_btf_type,
                         as_type_definition);
   }
 
   case btfparse::BTFKind::Enum: {
     const auto &enum_btf_type = getTypeAs<EnumBTFType>(btf_type);
-    return generateType(context, buffer, id, enum_btf_type, as_type_definition);
+    return generateType(context, state, buffer, id, enum_btf_type,
+                        as_type_definition);
   }
 
   case btfparse::BTFKind::Typedef: {
     const auto &typedef_btf_type = getTypeAs<TypedefBTFType>(btf_type);
-    return generateType(context, buffer, id, typedef_btf_type,
+    return generateType(context, state, buffer, id, typedef_btf_type,
                         as_type_definition);
   }
 
   case btfparse::BTFKind::Int: {
     const auto &int_btf_type = getTypeAs<IntBTFType>(btf_type);
-    return generateType(context, buffer, id, int_btf_type, as_type_definition);
+    return generateType(context, state, buffer, id, int_btf_type,
+                        as_type_definition);
   }
 
   case btfparse::BTFKind::FuncProto: {
     const auto &func_proto_btf_type = getTypeAs<FuncProtoBTFType>(btf_type);
-    return generateType(context, buffer, id, func_proto_btf_type,
+    return generateType(context, state, buffer, id, func_proto_btf_type,
                         as_type_definition);
   }
 
   case btfparse::BTFKind::Float: {
     const auto &float_btf_type = getTypeAs<FloatBTFType>(btf_type);
-    return generateType(context, buffer, id, float_btf_type,
+    return generateType(context, state, buffer, id, float_btf_type,
                         as_type_definition);
   }
 
   case btfparse::BTFKind::Ptr: {
     const auto &ptr_btf_type = getTypeAs<PtrBTFType>(btf_type);
-    return generateType(context, buffer, id, ptr_btf_type, as_type_definition);
+    return generateType(context, state, buffer, id, ptr_btf_type,
+                        as_type_definition);
   }
 
   case btfparse::BTFKind::Array: {
     const auto &array_btf_type = getTypeAs<ArrayBTFType>(btf_type);
-    return generateType(context, buffer, id, array_btf_type,
+    return generateType(context, state, buffer, id, array_btf_type,
                         as_type_definition);
   }
 
   case btfparse::BTFKind::Volatile: {
     const auto &volatile_btf_type = getTypeAs<VolatileBTFType>(btf_type);
-    return generateType(context, buffer, id, volatile_btf_type,
+    return generateType(context, state, buffer, id, volatile_btf_type,
                         as_type_definition);
   }
 
   case btfparse::BTFKind::Const: {
     const auto &const_btf_type = getTypeAs<ConstBTFType>(btf_type);
-    return generateType(context, buffer, id, const_btf_type,
+    return generateType(context, state, buffer, id, const_btf_type,
                         as_type_definition);
   }
 
   case btfparse::BTFKind::Restrict: {
     const auto &restrict_btf_type = getTypeAs<RestrictBTFType>(btf_type);
-    return generateType(context, buffer, id, restrict_btf_type,
+    return generateType(context, state, buffer, id, restrict_btf_type,
                         as_type_definition);
   }
 
   case btfparse::BTFKind::Fwd: {
     const auto &fwd_btf_type = getTypeAs<FwdBTFType>(btf_type);
-    return generateType(context, buffer, id, fwd_btf_type, as_type_definition);
+    return generateType(context, state, buffer, id, fwd_btf_type,
+                        as_type_definition);
   }
 
   case btfparse::BTFKind::Func:
@@ -1877,43 +1916,44 @@ bool BTFHeaderGenerator::generateType(Context &context,
   return true;
 }
 
-bool BTFHeaderGenerator::generateVoidType(Context &context,
+bool BTFHeaderGenerator::generateVoidType(const Context &context,
+                                          EmissionState &state,
                                           std::stringstream &buffer) {
 
-  generateTypeHeader(context, buffer, 0);
-  generateIndent(context, buffer);
+  generateTypeHeader(state, buffer, 0);
+  generateIndent(state, buffer);
 
-  if (!generateLeftModifiers(context, buffer)) {
+  if (!generateLeftModifiers(context, state, buffer)) {
     return false;
   }
 
   buffer << "void";
 
-  if (!generateMiddleModifiers(context, buffer)) {
+  if (!generateMiddleModifiers(context, state, buffer)) {
     return false;
   }
 
-  auto opt_name = BTFHeaderGenerator::takeVariableName(context);
+  auto opt_name = BTFHeaderGenerator::takeVariableName(state);
   if (!opt_name.has_value()) {
-    opt_name = BTFHeaderGenerator::takeTypedefName(context);
+    opt_name = BTFHeaderGenerator::takeTypedefName(state);
   }
 
   if (opt_name.has_value()) {
     buffer << " " << opt_name.value();
   }
 
-  if (!generateRightModifiers(context, buffer)) {
+  if (!generateRightModifiers(context, state, buffer)) {
     return false;
   }
 
   return true;
 }
 
-bool BTFHeaderGenerator::generateTypeHeader(const Context &context,
+bool BTFHeaderGenerator::generateTypeHeader(const EmissionState &state,
                                             std::stringstream &buffer,
                                             std::uint32_t id) {
 
-  generateIndent(context, buffer);
+  generateIndent(state, buffer);
 
   buffer << "/* "
          << "BTF Type #" << id << " */\n";
@@ -1921,28 +1961,29 @@ bool BTFHeaderGenerator::generateTypeHeader(const Context &context,
   return true;
 }
 
-void BTFHeaderGenerator::pushModifierList(Context &context) {
-  context.modifier_list_stack.push_back(std::move(context.modifier_list));
-  context.modifier_list.clear();
+void BTFHeaderGenerator::pushModifierList(EmissionState &state) {
+  state.modifier_list_stack.push_back(std::move(state.modifier_list));
+  state.modifier_list.clear();
 }
 
-void BTFHeaderGenerator::popModifierList(Context &context) {
-  if (context.modifier_list_stack.empty()) {
-    context.modifier_list.clear();
+void BTFHeaderGenerator::popModifierList(EmissionState &state) {
+  if (state.modifier_list_stack.empty()) {
+    state.modifier_list.clear();
 
   } else {
-    context.modifier_list = std::move(context.modifier_list_stack.back());
-    context.modifier_list_stack.pop_back();
+    state.modifier_list = std::move(state.modifier_list_stack.back());
+    state.modifier_list_stack.pop_back();
   }
 }
 
-void BTFHeaderGenerator::pushModifier(Context &context, std::uint32_t id) {
-  context.modifier_list.push_back(id);
+void BTFHeaderGenerator::pushModifier(EmissionState &state, std::uint32_t id) {
+  state.modifier_list.push_back(id);
 }
 
-void BTFHeaderGenerator::filterFuncProtoModifiers(Context &context) {
-  for (auto modifier_it = context.modifier_list.begin();
-       modifier_it != context.modifier_list.end();) {
+void BTFHeaderGenerator::filterFuncProtoModifiers(const Context &context,
+                                                  EmissionState &state) {
+  for (auto modifier_it = state.modifier_list.begin();
+       modifier_it != state.modifier_list.end();) {
 
     const auto &modifier = *modifier_it;
 
@@ -1954,20 +1995,21 @@ void BTFHeaderGenerator::filterFuncProtoModifiers(Context &context) {
 
     auto btf_kind = IBTF::getBTFTypeKind(btf_type);
     if (btf_kind == BTFKind::Volatile) {
-      modifier_it = context.modifier_list.erase(modifier_it);
+      modifier_it = state.modifier_list.erase(modifier_it);
     } else {
       ++modifier_it;
     }
   }
 }
 
-bool BTFHeaderGenerator::generateLeftModifiers(Context &context,
+bool BTFHeaderGenerator::generateLeftModifiers(const Context &context,
+                                               EmissionState &state,
                                                std::stringstream &buffer) {
 
   std::vector<const char *> string_list;
 
-  for (auto modifier_it = context.modifier_list.rbegin();
-       modifier_it != context.modifier_list.rend(); ++modifier_it) {
+  for (auto modifier_it = state.modifier_list.rbegin();
+       modifier_it != state.modifier_list.rend(); ++modifier_it) {
 
     const auto &id = *modifier_it;
     const auto &btf_type = context.btf_type_map.at(id);
@@ -1988,8 +2030,8 @@ bool BTFHeaderGenerator::generateLeftModifiers(Context &context,
   }
 
   auto count = static_cast<int>(string_list.size());
-  auto start_it = std::prev(context.modifier_list.end(), count);
-  context.modifier_list.erase(start_it, context.modifier_list.end());
+  auto start_it = std::prev(state.modifier_list.end(), count);
+  state.modifier_list.erase(start_it, state.modifier_list.end());
 
   if (!string_list.empty()) {
     buffer << " ";
@@ -2005,12 +2047,13 @@ bool BTFHeaderGenerator::generateLeftModifiers(Context &context,
   return true;
 }
 
-bool BTFHeaderGenerator::generateMiddleModifiers(Context &context,
+bool BTFHeaderGenerator::generateMiddleModifiers(const Context &context,
+                                                 EmissionState &state,
                                                  std::stringstream &buffer) {
   std::vector<const char *> string_list;
 
-  for (auto modifier_it = context.modifier_list.rbegin();
-       modifier_it != context.modifier_list.rend(); ++modifier_it) {
+  for (auto modifier_it = state.modifier_list.rbegin();
+       modifier_it != state.modifier_list.rend(); ++modifier_it) {
 
     const auto &id = *modifier_it;
     const auto &btf_type = context.btf_type_map.at(id);
@@ -2028,8 +2071,8 @@ bool BTFHeaderGenerator::generateMiddleModifiers(Context &context,
   }
 
   auto count = static_cast<int>(string_list.size());
-  auto start_it = std::prev(context.modifier_list.end(), count);
-  context.modifier_list.erase(start_it, context.modifier_list.end());
+  auto start_it = std::prev(state.modifier_list.end(), count);
+  state.modifier_list.erase(start_it, state.modifier_list.end());
 
   if (!string_list.empty()) {
     buffer << " ";
@@ -2049,14 +2092,15 @@ bool BTFHeaderGenerator::generateMiddleModifiers(Context &context,
   return true;
 }
 
-bool BTFHeaderGenerator::generateRightModifiers(Context &context,
+bool BTFHeaderGenerator::generateRightModifiers(const Context &context,
+                                                EmissionState &state,
                                                 std::stringstream &buffer) {
 
   std::size_t consumed_modifier_count{0};
   bool is_array{false};
 
-  for (auto modifier_it = context.modifier_list.rbegin();
-       modifier_it != context.modifier_list.rend(); ++modifier_it) {
+  for (auto modifier_it = state.modifier_list.rbegin();
+       modifier_it != state.modifier_list.rend(); ++modifier_it) {
 
     const auto &id = *modifier_it;
     const auto &btf_type = context.btf_type_map.at(id);
@@ -2085,55 +2129,192 @@ bool BTFHeaderGenerator::generateRightModifiers(Context &context,
   }
 
   auto count = static_cast<int>(consumed_modifier_count);
-  auto start_it = std::prev(context.modifier_list.end(), count);
-  context.modifier_list.erase(start_it, context.modifier_list.end());
+  auto start_it = std::prev(state.modifier_list.end(), count);
+  state.modifier_list.erase(start_it, state.modifier_list.end());
 
-  if (!context.modifier_list.empty()) {
+  if (!state.modifier_list.empty()) {
     buffer << " /* Unused modifiers: ";
 
-    for (auto modifier_it = context.modifier_list.begin();
-         modifier_it != context.modifier_list.end(); ++modifier_it) {
+    for (auto modifier_it = state.modifier_list.begin();
+         modifier_it != state.modifier_list.end(); ++modifier_it) {
       buffer << static_cast<int>(*modifier_it);
 
-      if (std::next(modifier_it, 1) != context.modifier_list.end()) {
+      if (std::next(modifier_it, 1) != state.modifier_list.end()) {
         buffer << ", ";
       }
     }
 
     buffer << " */ ";
 
-    context.modifier_list.clear();
+    state.modifier_list.clear();
     return true;
   }
 
   return true;
 }
 
-bool BTFHeaderGenerator::generateHeader(Context &context,
-                                        std::stringstream &buffer) {
+bool BTFHeaderGenerator::generateDeclaration(const Context &context,
+                                             EmissionState &state,
+                                             std::stringstream &buffer,
+                                             std::uint32_t id) {
+  resetState(state);
+
+  buffer.str({});
+  if (!generateType(context, state, buffer, id, true)) {
+    return false;
+  }
 
-  buffer << "#pragma pack(push, 1)\n";
+  buffer << ";\n\n";
+  return true;
+}
 
-  for (const auto &id : context.type_queue) {
-    resetState(context);
+bool BTFHeaderGenerator::generateHeader(
+    const Context &context, const BTFHeaderGeneratorOptions &options,
+    const OutputCallback &callback) {
 
-    {
-      auto opt_name = getTypeName(context, id);
+  std::vector<std::uint32_t> id_list;
+  id_list.reserve(context.type_queue.size());
 
-      const auto &name = opt_name.value();
-      if (name.find("__builtin_") == 0) {
-        continue;
-      }
+  for (const auto &id : context.type_queue) {
+    auto opt_name = getTypeName(context, id);
+
+    const auto &name = opt_name.value();
+    if (name.find("__builtin_") != 0) {
+      id_list.push_back(id);
     }
+  }
 
-    if (!generateType(context, buffer, id, true)) {
+  if (!callback("#pragma pack(push, 1)\n")) {
+    return false;
+  }
+
+  BTFOptions task_options;
+  task_options.thread_count = options.thread_count;
+  task_options.executor = options.executor;
+
+  auto task_count = BTF::getThreadCount(task_options);
+  task_count = std::min(task_count, id_list.size() / kMinTaskDeclarationCount);
+
+  if (task_count > 1) {
+    if (!generateDeclarationsInParallel(context, id_list, task_count,
+                                        task_options, callback)) {
       return false;
     }
 
-    buffer << ";\n\n";
+  } else {
+    // Only a single declaration is buffered at any given time
+    EmissionState state;
+    std::stringstream buffer;
+
+    // Rendering errors are reported as a failure, like the parallel
+    // tasks do, while exceptions from the callback are let through on
+    // both paths
+    std::string declaration;
+
+    for (const auto &id : id_list) {
+      try {
+        if (!generateDeclaration(context, state, buffer, id)) {
+          return false;
+        }
+
+        declaration = buffer.str();
+
+      } catch (const std::exception &) {
+        return false;
+      }
+
+      if (!callback(declaration)) {
+        return false;
+      }
+    }
+  }
+
+  return callback("#pragma pack(pop)\n");
+}
+
+bool BTFHeaderGenerator::generateDeclarationsInParallel(
+    const Context &context, const std::vector<std::uint32_t> &id_list,
+    std::size_t task_count, const BTFOptions &task_options,
+    const OutputCallback &callback) {
+
+  // Each task renders a contiguous range of the queue into its own
+  // buffer. The queue is processed in batches, so that only a bounded
+  // number of declarations is kept in memory before being passed to the
+  // callback in order
+  struct Task final {
+    std::size_t start{};
+    std::size_t end{};
+
+    std::string output;
+    std::vector<std::size_t> declaration_end_list;
+    bool succeeded{false};
+  };
+
+  std::vector<Task> task_list(task_count);
+
+  BTFOptions::TaskList task_function_list;
+  for (auto &task : task_list) {
+    task_function_list.push_back([&context, &id_list, &task]() {
+      task.output.clear();
+      task.declaration_end_list.clear();
+      task.succeeded = false;
+
+      try {
+        EmissionState state;
+        std::stringstream buffer;
+
+        for (auto i = task.start; i < task.end; ++i) {
+          if (!generateDeclaration(context, state, buffer, id_list[i])) {
+            return;
+          }
+
+          task.output.append(buffer.str());
+          task.declaration_end_list.push_back(task.output.size());
+        }
+
+        task.succeeded = true;
+
+      } catch (const std::exception &) {
+      }
+    });
   }
 
-  buffer << "#pragma pack(pop)\n";
+  auto batch_size = task_count * kTaskDeclarationCount;
+
+  for (std::size_t batch_start = 0; batch_start < id_list.size();
+       batch_start += batch_size) {
+
+    auto batch_end = std::min(batch_start + batch_size, id_list.size());
+    auto task_size = (batch_end - batch_start + task_count - 1) / task_count;
+
+    for (std::size_t i = 0; i < task_count; ++i) {
+      auto &task = task_list[i];
+      task.start = std::min(batch_start + i * task_size, batch_end);
+      task.end = std::min(task.start + task_size, batch_end);
+    }
+
+    BTF::runTasks(task_function_list, task_options);
+
+    for (const auto &task : task_list) {
+      // A failed task still passes on the declarations that precede the
+      // failure, so the output matches the one of the serial path
+      std::size_t declaration_start{0};
+      for (const auto &declaration_end : task.declaration_end_list) {
+        std::string_view declaration(task.output.data() + declaration_start,
+                                     declaration_end - declaration_start);
+
+        if (!callback(declaration)) {
+          return false;
+        }
+
+        declaration_start = declaration_end;
+      }
+
+      if (!task.succeeded) {
+        return false;
+      }
+    }
+  }
 
   return true;
 }
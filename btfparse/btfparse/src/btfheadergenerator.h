@@ -8,11 +8,13 @@
 
 #pragma once
 
+#include "btftypegraph.h"
+
 #include <sstream>
 #include <unordered_map>
-#include <unordered_set>
 
 #include <btfparse/ibtfheadergenerator.h>
+#include <btfparse/ibtflayout.h>
 
 namespace btfparse {
 
@@ -20,8 +22,11 @@ class BTFHeaderGenerator final : public IBTFHeaderGenerator {
 public:
   virtual ~BTFHeaderGenerator() override;
 
-  virtual bool generate(std::string &header,
-                        const IBTF::Ptr &btf) const override;
+  using IBTFHeaderGenerator::generate;
+
+  virtual bool
+  generate(const OutputCallback &callback, const IBTF::Ptr &btf,
+           const BTFHeaderGeneratorOptions &options) const override;
 
 private:
   BTFHeaderGenerator();
@@ -29,7 +34,11 @@ private:
 public:
   struct Context final {
     BTFTypeMap btf_type_map;
-    std::unordered_set<std::uint32_t> top_level_type_list;
+
+    // Sizes of the original types, used to materialize the padding
+    IBTFLayout::Ptr layout;
+
+    BTFTypeIDSet top_level_type_list;
     std::unordered_map<std::string, std::uint32_t> fwd_type_map;
 
     std::uint32_t padding_byte_id{0};
@@ -37,21 +46,42 @@ public:
     std::uint32_t highest_btf_type_id{0};
     std::uint32_t btf_type_id_generator{0};
 
+    // Only set when generating a subset of the types
+    std::optional<std::vector<std::uint32_t>> opt_root_type_list;
+
     std::vector<std::uint32_t> type_queue;
 
-    std::unordered_set<std::uint32_t> visited_type_list;
+    BTFTypeIDSet visited_type_list;
+
+    BTFTypeGraph type_tree;
+    BTFTypeGraph inverse_type_tree;
 
-    std::unordered_map<std::uint32_t, std::unordered_map<std::uint32_t, bool>>
-        type_tree;
+    // Work lists of createTypeTreeHelper and createTypeQueueHelper; they
+    // live here so that every call reuses their storage
+    struct TypeTreeNode final {
+      std::uint32_t parent{};
+      std::uint32_t id{};
+      bool inside_pointer{false};
+    };
 
-    std::unordered_map<std::uint32_t, std::unordered_set<std::uint32_t>>
-        inverse_type_tree;
+    struct TypeQueueNode final {
+      std::uint32_t id{};
+      std::size_t next_edge{};
+    };
 
+    std::vector<TypeTreeNode> type_tree_work_list;
+    std::vector<TypeQueueNode> type_queue_work_list;
+
+    BTFTypeIDSet generated_type_list;
+  };
+
+  // The state that generateType pushes and pops while it renders a single
+  // declaration. The Context is only read during the emission, so each
+  // thread rendering declarations in parallel owns one of these
+  struct EmissionState final {
     std::vector<std::vector<std::uint32_t>> modifier_list_stack;
     std::vector<std::uint32_t> modifier_list;
 
-    std::unordered_set<std::uint32_t> generated_type_list;
-
     std::vector<std::optional<std::string>> typedef_name_stack;
     std::optional<std::string> opt_typedef_name;
 
@@ -71,16 +101,13 @@ public:
 
   static bool isBitfield(const StructBTFType::Member &member);
 
-  static std::optional<std::uint32_t> getBTFTypeSize(const Context &context,
-                                                     const BTFType &type);
-
-  static std::optional<std::uint32_t> getBTFTypeSize(const Context &context,
-                                                     std::uint32_t type);
-
   static bool isValidTypeId(const Context &context, std::uint32_t id);
   static bool isRenameableType(const Context &context, std::uint32_t id);
   static void scanTypes(Context &context);
 
+  static bool resolveRootTypes(Context &context,
+                               const BTFHeaderGeneratorOptions &options);
+
   static bool getTypeDependencies(const Context &context,
                                   std::vector<std::uint32_t> &dependency_list,
                                   std::uint32_t id);
@@ -91,10 +118,11 @@ public:
   static bool setTypeName(Context &context, std::uint32_t id,
                           const std::string &name);
 
-  static void resetIndent(Context &context);
-  static void increaseIndent(Context &context);
-  static void decreaseIndent(Context &context);
-  static void generateIndent(const Context &context, std::stringstream &buffer);
+  static void resetIndent(EmissionState &state);
+  static void increaseIndent(EmissionState &state);
+  static void decreaseIndent(EmissionState &state);
+  static void generateIndent(const EmissionState &state,
+                             std::stringstream &buffer);
 
   static bool createTypeTree(Context &context);
   static bool createTypeTreeHelper(BTFHeaderGenerator::Context &context,
@@ -110,103 +138,122 @@ public:
   static bool isTopLevelTypeDeclaration(const Context &context,
                                         std::uint32_t id);
 
-  static void setVariableName(Context &context, const std::string &name);
-  static std::optional<std::string> takeVariableName(Context &context);
-  static void pushVariableName(Context &context);
-  static void popVariableName(Context &context);
+  static void setVariableName(EmissionState &state, const std::string &name);
+  static std::optional<std::string> takeVariableName(EmissionState &state);
+  static void pushVariableName(EmissionState &state);
+  static void popVariableName(EmissionState &state);
 
-  static void setTypedefName(Context &context, const std::string &name);
-  static std::optional<std::string> takeTypedefName(Context &context);
-  static void pushTypedefName(Context &context);
-  static void popTypedefName(Context &context);
+  static void setTypedefName(EmissionState &state, const std::string &name);
+  static std::optional<std::string> takeTypedefName(EmissionState &state);
+  static void pushTypedefName(EmissionState &state);
+  static void popTypedefName(EmissionState &state);
 
-  static void pushState(Context &context);
-  static void popState(Context &context);
-  static void resetState(Context &context);
+  static void pushState(EmissionState &state);
+  static void popState(EmissionState &state);
+  static void resetState(EmissionState &state);
 
   static std::uint32_t getOrCreateFwdType(Context &context, bool is_union,
                                           const std::string &name);
 
-  static bool generateType(Context &context, std::stringstream &buffer,
-                           std::uint32_t id,
+  static bool generateType(const Context &context, EmissionState &state,
+                           std::stringstream &buffer, std::uint32_t id,
                            const StructBTFType &struct_btf_type, bool as_type);
 
-  static bool generateType(Context &context, std::stringstream &buffer,
-                           std::uint32_t id, const UnionBTFType &union_btf_type,
-                           bool as_type);
+  static bool generateType(const Context &context, EmissionState &state,
+                           std::stringstream &buffer, std::uint32_t id,
+                           const UnionBTFType &union_btf_type, bool as_type);
 
-  static bool generateType(Context &context, std::stringstream &buffer,
-                           std::uint32_t id, const EnumBTFType &enum_btf_type,
-                           bool as_type);
+  static bool generateType(const Context &context, EmissionState &state,
+                           std::stringstream &buffer, std::uint32_t id,
+                           const EnumBTFType &enum_btf_type, bool as_type);
 
-  static bool generateType(Context &context, std::stringstream &buffer,
-                           std::uint32_t id,
+  static bool generateType(const Context &context, EmissionState &state,
+                           std::stringstream &buffer, std::uint32_t id,
                            const TypedefBTFType &typedef_btf_type,
                            bool as_type);
 
-  static bool generateType(Context &context, std::stringstream &buffer,
-                           std::uint32_t id, const IntBTFType &int_btf_type,
-                           bool as_type);
+  static bool generateType(const Context &context, EmissionState &state,
+                           std::stringstream &buffer, std::uint32_t id,
+                           const IntBTFType &int_btf_type, bool as_type);
 
-  static bool generateType(Context &context, std::stringstream &buffer,
-                           std::uint32_t id,
+  static bool generateType(const Context &context, EmissionState &state,
+                           std::stringstream &buffer, std::uint32_t id,
                            const FuncProtoBTFType &func_proto_btf_type,
                            bool as_type);
 
-  static bool generateType(Context &context, std::stringstream &buffer,
-                           std::uint32_t id, const FloatBTFType &float_btf_type,
-                           bool as_type);
+  static bool generateType(const Context &context, EmissionState &state,
+                           std::stringstream &buffer, std::uint32_t id,
+                           const FloatBTFType &float_btf_type, bool as_type);
 
-  static bool generateType(Context &context, std::stringstream &buffer,
-                           std::uint32_t id, const PtrBTFType &ptr_btf_type,
-                           bool as_type);
+  static bool generateType(const Context &context, EmissionState &state,
+                           std::stringstream &buffer, std::uint32_t id,
+                           const PtrBTFType &ptr_btf_type, bool as_type);
 
-  static bool generateType(Context &context, std::stringstream &buffer,
-                           std::uint32_t id, const ArrayBTFType &array_btf_type,
-                           bool as_type);
+  static bool generateType(const Context &context, EmissionState &state,
+                           std::stringstream &buffer, std::uint32_t id,
+                           const ArrayBTFType &array_btf_type, bool as_type);
 
-  static bool generateType(Context &context, std::stringstream &buffer,
-                           std::uint32_t id,
+  static bool generateType(const Context &context, EmissionState &state,
+                           std::stringstream &buffer, std::uint32_t id,
                            const VolatileBTFType &volatile_btf_type,
                            bool as_type);
 
-  static bool generateType(Context &context, std::stringstream &buffer,
-                           std::uint32_t id, const ConstBTFType &const_btf_type,
-                           bool as_type);
+  static bool generateType(const Context &context, EmissionState &state,
+                           std::stringstream &buffer, std::uint32_t id,
+                           const ConstBTFType &const_btf_type, bool as_type);
 
-  static bool generateType(Context &context, std::stringstream &buffer,
-                           std::uint32_t id,
+  static bool generateType(const Context &context, EmissionState &state,
+                           std::stringstream &buffer, std::uint32_t id,
                            const RestrictBTFType &restrict_btf_type,
                            bool as_type);
 
-  static bool generateType(Context &context, std::stringstream &buffer,
-                           std::uint32_t id, const FwdBTFType &fwd_btf_type,
-                           bool as_type);
+  static bool generateType(const Context &context, EmissionState &state,
+                           std::stringstream &buffer, std::uint32_t id,
+                           const FwdBTFType &fwd_btf_type, bool as_type);
 
-  static bool generateType(Context &context, std::stringstream &buffer,
-                           std::uint32_t id, bool as_type);
+  static bool generateType(const Context &context, EmissionState &state,
+                           std::stringstream &buffer, std::uint32_t id,
+                           bool as_type);
 
-  static bool generateVoidType(Context &context, std::stringstream &buffer);
+  static bool generateVoidType(const Context &context, EmissionState &state,
+                               std::stringstream &buffer);
 
-  static bool generateTypeHeader(const Context &context,
+  static bool generateTypeHeader(const EmissionState &state,
                                  std::stringstream &buffer, std::uint32_t id);
 
-  static void pushModifierList(Context &context);
-  static void popModifierList(Context &context);
-  static void pushModifier(Context &context, std::uint32_t id);
+  static void pushModifierList(EmissionState &state);
+  static void popModifierList(EmissionState &state);
+  static void pushModifier(EmissionState &state, std::uint32_t id);
 
-  static void filterFuncProtoModifiers(Context &context);
+  static void filterFuncProtoModifiers(const Context &context,
+                                       EmissionState &state);
 
-  static bool generateLeftModifiers(Context &context,
+  static bool generateLeftModifiers(const Context &context,
+                                    EmissionState &state,
                                     std::stringstream &buffer);
 
-  static bool generateMiddleModifiers(Context &context,
+  static bool generateMiddleModifiers(const Context &context,
+                                      EmissionState &state,
                                       std::stringstream &buffer);
 
-  static bool generateRightModifiers(Context &context,
+  static bool generateRightModifiers(const Context &context,
+                                     EmissionState &state,
                                      std::stringstream &buffer);
 
-  static bool generateHeader(Context &context, std::stringstream &buffer);
+  static bool generateDeclaration(const Context &context,
+                                  EmissionState &state,
+                                  std::stringstream &buffer, std::uint32_t id);
+
+  static bool generateHeader(const Context &context,
+                             const BTFHeaderGeneratorOptions &options,
+                             const OutputCallback &callback);
+
+  static bool
+  generateDeclarationsInParallel(const Context &context,
+                                 const std::vector<std::uint32_t> &id_list,
+                                 std::size_t task_count,
+                                 const BTFOptions &task_options,
+                                 const OutputCallback &callback);
 
   friend class IBTFHeaderGenerator;
 };
@@ -0,0 +1,836 @@
+//
+// Copyright (c) 2021-present, Trail of Bits, Inc.
+// All rights reserved.
+//
+// This source code is licensed in accordance with the terms specified in
+// the LICENSE file found in the root directory of this source tree.
+//
+
+#include "btflayout.h"
+
+#include <algorithm>
+#include <limits>
+#include <mutex>
+
+namespace btfparse {
+
+namespace {
+
+const std::uint32_t kUnresolvedTypeID{
+    std::numeric_limits<std::uint32_t>::max()};
+
+const std::uint64_t kPointerSize{sizeof(void *)};
+
+BTFLayoutError createError(BTFLayoutErrorInformation::Code code,
+                           std::uint32_t id) {
+  return BTFLayoutError(BTFLayoutErrorInformation{code, id});
+}
+
+void setError(BTFLayout::TypeInfo &type_info,
+              BTFLayoutErrorInformation::Code code, std::uint32_t id) {
+  type_info.state = BTFLayout::TypeInfo::State::Failed;
+  type_info.error_information = BTFLayoutErrorInformation{code, id};
+}
+
+// Copies the error of the given dependency, if it could not be resolved
+bool propagateError(BTFLayout::TypeInfo &type_info,
+                    const BTFLayout::TypeInfo &dependency_info) {
+  if (dependency_info.state != BTFLayout::TypeInfo::State::Failed) {
+    return false;
+  }
+
+  type_info.state = BTFLayout::TypeInfo::State::Failed;
+  type_info.error_information = dependency_info.error_information;
+
+  return true;
+}
+
+void setScalarLayout(BTFLayout::TypeInfo &type_info, std::uint64_t size) {
+  type_info.state = BTFLayout::TypeInfo::State::Resolved;
+  type_info.size = size;
+  type_info.alignment =
+      std::max<std::uint64_t>(std::min(size, kPointerSize), 1);
+}
+
+std::optional<std::uint32_t> getModifierTarget(const BTFType &btf_type) {
+  switch (IBTF::getBTFTypeKind(btf_type)) {
+  case BTFKind::Typedef:
+    return std::get<TypedefBTFType>(btf_type).type;
+
+  case BTFKind::Const:
+    return std::get<ConstBTFType>(btf_type).type;
+
+  case BTFKind::Volatile:
+    return std::get<VolatileBTFType>(btf_type).type;
+
+  case BTFKind::Restrict:
+    return std::get<RestrictBTFType>(btf_type).type;
+
+  default:
+    return std::nullopt;
+  }
+}
+
+template <typename AggregateType>
+void computeAggregateLayout(
+    BTFLayout::TypeInfo &type_info,
+    const std::vector<BTFLayout::TypeInfo> &type_info_list,
+    const AggregateType &btf_type) {
+
+  std::uint64_t alignment{1};
+  bool packed{false};
+
+  for (const auto &member : btf_type.member_list) {
+    // The size is known anyway, so a member that can not be laid out
+    // only forces the most conservative alignment
+    if (member.type >= type_info_list.size() ||
+        type_info_list[member.type].state !=
+            BTFLayout::TypeInfo::State::Resolved) {
+      packed = true;
+      continue;
+    }
+
+    const auto &member_info = type_info_list[member.type];
+    alignment = std::max(alignment, member_info.alignment);
+
+    // Members that are not placed on their natural alignment can only
+    // appear in packed types. Bitfields are exempt
+    auto is_bitfield = member.opt_bitfield_size.has_value() &&
+                       member.opt_bitfield_size.value() != 0;
+
+    if (!is_bitfield && (member.offset % (member_info.alignment * 8)) != 0) {
+      packed = true;
+    }
+  }
+
+  if ((btf_type.size % alignment) != 0) {
+    packed = true;
+  }
+
+  type_info.state = BTFLayout::TypeInfo::State::Resolved;
+  type_info.size = btf_type.size;
+  type_info.alignment = packed ? 1 : alignment;
+}
+
+} // namespace
+
+struct BTFLayout::PrivateData final {
+  PrivateData(const IBTF &btf_ref) : btf(btf_ref) {}
+
+  const IBTF &btf;
+
+  std::mutex mutex;
+
+  // Both are indexed by type ID
+  std::vector<TypeInfo> type_info_list;
+  std::vector<std::uint32_t> resolved_type_list;
+
+  std::unordered_map<std::uint32_t, MemberMap> member_map_cache;
+
+  // Work lists used by resolveTypeInfo and resolveTypeLocked
+  struct WorkItem final {
+    std::uint32_t id{};
+    bool expanded{false};
+  };
+
+  std::vector<WorkItem> work_list;
+  std::vector<std::uint32_t> dependency_list;
+  std::vector<std::uint32_t> type_chain;
+};
+
+Result<IBTFLayout::Ptr, BTFLayoutError>
+BTFLayout::create(const IBTF &btf) noexcept {
+  try {
+    return Ptr(new BTFLayout(btf));
+
+  } catch (const std::bad_alloc &) {
+    return BTFLayoutError(BTFLayoutErrorInformation{
+        BTFLayoutErrorInformation::Code::MemoryAllocationFailure,
+    });
+  }
+}
+
+BTFLayout::~BTFLayout() {}
+
+Result<std::uint64_t, BTFLayoutError>
+BTFLayout::getSize(std::uint32_t id) const noexcept {
+  std::lock_guard<std::mutex> lock(d->mutex);
+
+  if (id >= d->type_info_list.size()) {
+    return createError(BTFLayoutErrorInformation::Code::InvalidTypeID, id);
+  }
+
+  try {
+    const auto &type_info = getTypeInfo(id);
+    if (type_info.state == TypeInfo::State::Failed) {
+      return BTFLayoutError(type_info.error_information);
+    }
+
+    return type_info.size;
+
+  } catch (const std::bad_alloc &) {
+    return BTFLayoutError(BTFLayoutErrorInformation{
+        BTFLayoutErrorInformation::Code::MemoryAllocationFailure,
+    });
+  }
+}
+
+Result<std::uint64_t, BTFLayoutError>
+BTFLayout::getAlignment(std::uint32_t id) const noexcept {
+  std::lock_guard<std::mutex> lock(d->mutex);
+
+  if (id >= d->type_info_list.size()) {
+    return createError(BTFLayoutErrorInformation::Code::InvalidTypeID, id);
+  }
+
+  try {
+    const auto &type_info = getTypeInfo(id);
+    if (type_info.state == TypeInfo::State::Failed) {
+      return BTFLayoutError(type_info.error_information);
+    }
+
+    return type_info.alignment;
+
+  } catch (const std::bad_alloc &) {
+    return BTFLayoutError(BTFLayoutErrorInformation{
+        BTFLayoutErrorInformation::Code::MemoryAllocationFailure,
+    });
+  }
+}
+
+Result<std::uint32_t, BTFLayoutError>
+BTFLayout::resolveType(std::uint32_t id) const noexcept {
+  std::lock_guard<std::mutex> lock(d->mutex);
+
+  try {
+    return resolveTypeLocked(id);
+
+  } catch (const std::bad_alloc &) {
+    return BTFLayoutError(BTFLayoutErrorInformation{
+        BTFLayoutErrorInformation::Code::MemoryAllocationFailure,
+    });
+  }
+}
+
+Result<BTFMemberLocation, BTFLayoutError>
+BTFLayout::resolveMemberPath(std::uint32_t id,
+                             std::string_view path) const noexcept {
+  std::lock_guard<std::mutex> lock(d->mutex);
+
+  try {
+    return resolveMemberPathLocked(id, path);
+
+  } catch (const std::bad_alloc &) {
+    return BTFLayoutError(BTFLayoutErrorInformation{
+        BTFLayoutErrorInformation::Code::MemoryAllocationFailure,
+    });
+  }
+}
+
+Result<BTFMemberLocation, BTFLayoutError>
+BTFLayout::resolveMemberPath(std::string_view path) const noexcept {
+  auto root_type_name = getMemberName(path);
+  if (root_type_name.empty()) {
+    return BTFLayoutError(BTFLayoutErrorInformation{
+        BTFLayoutErrorInformation::Code::InvalidMemberPath,
+    });
+  }
+
+  std::optional<std::uint32_t> opt_root_type_id;
+  for (auto kind : {BTFKind::Struct, BTFKind::Union, BTFKind::Typedef}) {
+    auto id_range = d->btf.findByName(root_type_name, kind);
+    if (!id_range.empty()) {
+      opt_root_type_id = id_range[0];
+      break;
+    }
+  }
+
+  if (!opt_root_type_id.has_value()) {
+    return BTFLayoutError(BTFLayoutErrorInformation{
+        BTFLayoutErrorInformation::Code::TypeNotFound,
+    });
+  }
+
+  // The root type name consumed all the identifier characters, so the
+  // rest of the path starts with an operator
+  return resolveMemberPath(opt_root_type_id.value(), path);
+}
+
+BTFLayout::BTFLayout(const IBTF &btf) : d(new PrivateData(btf)) {
+  auto type_count = static_cast<std::size_t>(btf.count()) + 1U;
+
+  d->type_info_list.resize(type_count);
+  d->resolved_type_list.assign(type_count, kUnresolvedTypeID);
+}
+
+const BTFLayout::TypeInfo &BTFLayout::getTypeInfo(std::uint32_t id) const {
+  const auto &type_info = d->type_info_list[id];
+  if (type_info.state != TypeInfo::State::Resolved &&
+      type_info.state != TypeInfo::State::Failed) {
+    resolveTypeInfo(id);
+  }
+
+  return type_info;
+}
+
+void BTFLayout::resolveTypeInfo(std::uint32_t id) const {
+  // Walk the value dependencies depth first, without recursion. Pointers
+  // do not depend on their target, so the only loops that can be found
+  // here come from malformed data
+  auto &work_list = d->work_list;
+  auto &dependency_list = d->dependency_list;
+
+  work_list.clear();
+  work_list.push_back({id, false});
+
+  while (!work_list.empty()) {
+    auto work_item = work_list.back();
+    auto &type_info = d->type_info_list[work_item.id];
+
+    if (type_info.state == TypeInfo::State::Resolved ||
+        type_info.state == TypeInfo::State::Failed) {
+      work_list.pop_back();
+      continue;
+    }
+
+    if (work_item.expanded) {
+      // All the dependencies have been resolved
+      computeTypeInfo(type_info, work_item.id);
+      work_list.pop_back();
+      continue;
+    }
+
+    work_list.back().expanded = true;
+    type_info.state = TypeInfo::State::Expanding;
+
+    // Structs and unions never fail because of their members, which
+    // are instead checked by computeAggregateLayout
+    auto has_own_size = getDependencyList(dependency_list, work_item.id);
+
+    for (const auto &dependency : dependency_list) {
+      if (has_own_size) {
+        break;
+      }
+
+      if (dependency >= d->type_info_list.size()) {
+        setError(type_info, BTFLayoutErrorInformation::Code::InvalidTypeID,
+                 dependency);
+
+        break;
+      }
+
+      // Only the types that are currently being expanded are in this
+      // state, and all of them are ancestors of this one
+      if (d->type_info_list[dependency].state == TypeInfo::State::Expanding) {
+        setError(type_info, BTFLayoutErrorInformation::Code::TypeLoop,
+                 work_item.id);
+
+        break;
+      }
+    }
+
+    if (type_info.state == TypeInfo::State::Failed) {
+      continue;
+    }
+
+    for (const auto &dependency : dependency_list) {
+      if (dependency < d->type_info_list.size() &&
+          d->type_info_list[dependency].state == TypeInfo::State::Unvisited) {
+        work_list.push_back({dependency, false});
+      }
+    }
+  }
+}
+
+bool BTFLayout::getDependencyList(std::vector<std::uint32_t> &dependency_list,
+                                  std::uint32_t id) const {
+  dependency_list.clear();
+
+  const auto *btf_type = d->btf.getTypeRef(id);
+  if (btf_type == nullptr) {
+    return false;
+  }
+
+  auto opt_modifier_target = getModifierTarget(*btf_type);
+  if (opt_modifier_target.has_value()) {
+    dependency_list.push_back(opt_modifier_target.value());
+    return false;
+  }
+
+  switch (IBTF::getBTFTypeKind(*btf_type)) {
+  case BTFKind::Array:
+    dependency_list.push_back(std::get<ArrayBTFType>(*btf_type).type);
+    return false;
+
+  case BTFKind::Struct:
+    for (const auto &member : std::get<StructBTFType>(*btf_type).member_list) {
+      dependency_list.push_back(member.type);
+    }
+
+    return true;
+
+  case BTFKind::Union:
+    for (const auto &member : std::get<UnionBTFType>(*btf_type).member_list) {
+      dependency_list.push_back(member.type);
+    }
+
+    return true;
+
+  default:
+    return false;
+  }
+}
+
+void BTFLayout::computeTypeInfo(TypeInfo &type_info, std::uint32_t id) const {
+  const auto *btf_type = d->btf.getTypeRef(id);
+  if (btf_type == nullptr) {
+    auto error_code = (id == 0)
+                          ? BTFLayoutErrorInformation::Code::IncompleteType
+                          : BTFLayoutErrorInformation::Code::InvalidTypeID;
+
+    setError(type_info, error_code, id);
+    return;
+  }
+
+  auto opt_modifier_target = getModifierTarget(*btf_type);
+  if (opt_modifier_target.has_value()) {
+    const auto &target_info =
+        d->type_info_list[opt_modifier_target.value()];
+
+    if (!propagateError(type_info, target_info)) {
+      type_info.state = TypeInfo::State::Resolved;
+      type_info.size = target_info.size;
+      type_info.alignment = target_info.alignment;
+    }
+
+    return;
+  }
+
+  switch (IBTF::getBTFTypeKind(*btf_type)) {
+  case BTFKind::Int:
+    setScalarLayout(type_info, std::get<IntBTFType>(*btf_type).size);
+    break;
+
+  case BTFKind::Enum:
+    setScalarLayout(type_info, std::get<EnumBTFType>(*btf_type).size);
+    break;
+
+  case BTFKind::Float:
+    setScalarLayout(type_info, std::get<FloatBTFType>(*btf_type).size);
+    break;
+
+  case BTFKind::Ptr:
+    setScalarLayout(type_info, kPointerSize);
+    break;
+
+  case BTFKind::Array: {
+    const auto &array_btf_type = std::get<ArrayBTFType>(*btf_type);
+
+    const auto &element_info = d->type_info_list[array_btf_type.type];
+    if (propagateError(type_info, element_info)) {
+      break;
+    }
+
+    std::uint64_t size{};
+    if (__builtin_mul_overflow(element_info.size, array_btf_type.nelems,
+                               &size)) {
+      setError(type_info, BTFLayoutErrorInformation::Code::SizeOverflow, id);
+      break;
+    }
+
+    type_info.state = TypeInfo::State::Resolved;
+    type_info.size = size;
+    type_info.alignment = element_info.alignment;
+
+    break;
+  }
+
+  case BTFKind::Struct:
+    computeAggregateLayout(type_info, d->type_info_list,
+                           std::get<StructBTFType>(*btf_type));
+    break;
+
+  case BTFKind::Union:
+    computeAggregateLayout(type_info, d->type_info_list,
+                           std::get<UnionBTFType>(*btf_type));
+    break;
+
+  default:
+    // Forward declarations, functions, variables and data sections
+    setError(type_info, BTFLayoutErrorInformation::Code::IncompleteType, id);
+    break;
+  }
+}
+
+Result<std::uint32_t, BTFLayoutError>
+BTFLayout::resolveTypeLocked(std::uint32_t id) const {
+  auto &resolved_type_list = d->resolved_type_list;
+  if (id >= resolved_type_list.size()) {
+    return createError(BTFLayoutErrorInformation::Code::InvalidTypeID, id);
+  }
+
+  // Follow the chain until a type that is not a modifier, or one that has
+  // already been resolved, is found. All the types that were traversed
+  // resolve to the same one
+  auto &type_chain = d->type_chain;
+  type_chain.clear();
+
+  auto current_id = id;
+  std::uint32_t resolved_id{};
+
+  while (true) {
+    if (resolved_type_list[current_id] != kUnresolvedTypeID) {
+      resolved_id = resolved_type_list[current_id];
+      break;
+    }
+
+    if (type_chain.size() >= resolved_type_list.size()) {
+      return createError(BTFLayoutErrorInformation::Code::TypeLoop, id);
+    }
+
+    type_chain.push_back(current_id);
+
+    if (current_id == 0) {
+      resolved_id = current_id;
+      break;
+    }
+
+    const auto *btf_type = d->btf.getTypeRef(current_id);
+    if (btf_type == nullptr) {
+      return createError(BTFLayoutErrorInformation::Code::InvalidTypeID,
+                         current_id);
+    }
+
+    auto opt_modifier_target = getModifierTarget(*btf_type);
+    if (!opt_modifier_target.has_value()) {
+      resolved_id = current_id;
+      break;
+    }
+
+    current_id = opt_modifier_target.value();
+    if (current_id >= resolved_type_list.size()) {
+      return createError(BTFLayoutErrorInformation::Code::InvalidTypeID,
+                         current_id);
+    }
+  }
+
+  for (const auto &chain_id : type_chain) {
+    resolved_type_list[chain_id] = resolved_id;
+  }
+
+  return resolved_id;
+}
+
+Result<std::uint32_t, BTFLayoutError>
+BTFLayout::resolveAggregateType(std::uint32_t id) const {
+  auto resolved_id_res = resolveTypeLocked(id);
+  if (resolved_id_res.failed()) {
+    return resolved_id_res.takeError();
+  }
+
+  auto resolved_id = resolved_id_res.takeValue();
+
+  auto opt_kind = d->btf.getKind(resolved_id);
+  if (opt_kind == BTFKind::Struct || opt_kind == BTFKind::Union) {
+    return resolved_id;
+  }
+
+  if (opt_kind != BTFKind::Fwd) {
+    return createError(BTFLayoutErrorInformation::Code::NotAStructOrUnion,
+                       resolved_id);
+  }
+
+  // Pointers to forward declarations are common in split BTF data: use
+  // the definition, if there is one
+  const auto &fwd_btf_type =
+      std::get<FwdBTFType>(*d->btf.getTypeRef(resolved_id));
+
+  auto id_range = d->btf.findByName(
+      fwd_btf_type.name, fwd_btf_type.is_union ? BTFKind::Union
+                                               : BTFKind::Struct);
+
+  if (id_range.empty()) {
+    return createError(BTFLayoutErrorInformation::Code::IncompleteType,
+                       resolved_id);
+  }
+
+  return id_range[0];
+}
+
+Result<const BTFLayout::MemberMap *, BTFLayoutError>
+BTFLayout::getMemberMap(std::uint32_t id) const {
+  auto member_map_it = d->member_map_cache.find(id);
+  if (member_map_it != d->member_map_cache.end()) {
+    return &member_map_it->second;
+  }
+
+  // Anonymous members are only expanded when the layout of the type is
+  // valid, which guarantees that they do not contain themselves
+  const auto &type_info = getTypeInfo(id);
+  if (type_info.state == TypeInfo::State::Failed) {
+    return BTFLayoutError(type_info.error_information);
+  }
+
+  struct PendingType final {
+    std::uint32_t id{};
+    std::uint64_t bit_offset{};
+  };
+
+  MemberMap member_map;
+  std::vector<PendingType> pending_type_list{{id, 0}};
+
+  auto add_member_list = [&](const auto &member_list,
+                             std::uint64_t base_bit_offset) {
+    for (const auto &member : member_list) {
+      auto bit_offset = base_bit_offset + member.offset;
+
+      if (member.opt_name.has_value() && !member.opt_name.value().empty()) {
+        Member layout_member;
+        layout_member.type = member.type;
+        layout_member.bit_offset = bit_offset;
+
+        if (member.opt_bitfield_size.has_value() &&
+            member.opt_bitfield_size.value() != 0) {
+          layout_member.opt_bitfield_size = member.opt_bitfield_size;
+        }
+
+        member_map.insert({member.opt_name.value(), layout_member});
+        continue;
+      }
+
+      auto resolved_id_res = resolveTypeLocked(member.type);
+      if (resolved_id_res.failed()) {
+        continue;
+      }
+
+      auto resolved_id = resolved_id_res.takeValue();
+
+      auto opt_kind = d->btf.getKind(resolved_id);
+      if (opt_kind == BTFKind::Struct || opt_kind == BTFKind::Union) {
+        pending_type_list.push_back({resolved_id, bit_offset});
+      }
+    }
+  };
+
+  while (!pending_type_list.empty()) {
+    auto pending_type = pending_type_list.back();
+    pending_type_list.pop_back();
+
+    const auto &btf_type = *d->btf.getTypeRef(pending_type.id);
+    if (IBTF::getBTFTypeKind(btf_type) == BTFKind::Struct) {
+      add_member_list(std::get<StructBTFType>(btf_type).member_list,
+                      pending_type.bit_offset);
+
+    } else {
+      add_member_list(std::get<UnionBTFType>(btf_type).member_list,
+                      pending_type.bit_offset);
+    }
+  }
+
+  auto insert_status = d->member_map_cache.insert({id, std::move(member_map)});
+  return &insert_status.first->second;
+}
+
+Result<BTFMemberLocation, BTFLayoutError>
+BTFLayout::resolveMemberPathLocked(std::uint32_t id,
+                                   std::string_view path) const {
+  if (id >= d->type_info_list.size()) {
+    return createError(BTFLayoutErrorInformation::Code::InvalidTypeID, id);
+  }
+
+  BTFMemberLocation location;
+  location.type = id;
+
+  for (bool first_component{true}; !path.empty(); first_component = false) {
+    if (path.front() == '[') {
+      path.remove_prefix(1);
+
+      std::uint64_t index{};
+      if (!getArrayIndex(index, path)) {
+        return createError(BTFLayoutErrorInformation::Code::InvalidMemberPath,
+                           location.type);
+      }
+
+      auto resolved_id_res = resolveTypeLocked(location.type);
+      if (resolved_id_res.failed()) {
+        return resolved_id_res.takeError();
+      }
+
+      auto resolved_id = resolved_id_res.takeValue();
+      if (location.opt_bitfield_size.has_value() ||
+          d->btf.getKind(resolved_id) != BTFKind::Array) {
+        return createError(BTFLayoutErrorInformation::Code::NotAnArray,
+                           resolved_id);
+      }
+
+      const auto &array_btf_type =
+          std::get<ArrayBTFType>(*d->btf.getTypeRef(resolved_id));
+
+      // Zero-sized arrays are flexible array members
+      if (array_btf_type.nelems != 0 && index >= array_btf_type.nelems) {
+        return createError(
+            BTFLayoutErrorInformation::Code::ArrayIndexOutOfRange,
+            resolved_id);
+      }
+
+      const auto &type_info = getTypeInfo(resolved_id);
+      if (type_info.state == TypeInfo::State::Failed) {
+        return BTFLayoutError(type_info.error_information);
+      }
+
+      // The layout of the array is valid, so the element one is as well
+      auto element_bit_size = d->type_info_list[array_btf_type.type].size * 8;
+
+      std::uint64_t element_bit_offset{};
+      if (__builtin_mul_overflow(index, element_bit_size,
+                                 &element_bit_offset) ||
+          __builtin_add_overflow(location.bit_offset, element_bit_offset,
+                                 &location.bit_offset)) {
+        return createError(BTFLayoutErrorInformation::Code::SizeOverflow,
+                           resolved_id);
+      }
+
+      location.type = array_btf_type.type;
+      continue;
+    }
+
+    bool dereference{false};
+    if (path.front() == '.') {
+      path.remove_prefix(1);
+
+    } else if (path.substr(0, 2) == "->") {
+      path.remove_prefix(2);
+      dereference = true;
+
+    } else if (!first_component) {
+      return createError(BTFLayoutErrorInformation::Code::InvalidMemberPath,
+                         location.type);
+    }
+
+    if (dereference) {
+      auto resolved_id_res = resolveTypeLocked(location.type);
+      if (resolved_id_res.failed()) {
+        return resolved_id_res.takeError();
+      }
+
+      auto resolved_id = resolved_id_res.takeValue();
+      if (location.opt_bitfield_size.has_value() ||
+          d->btf.getKind(resolved_id) != BTFKind::Ptr) {
+        return createError(BTFLayoutErrorInformation::Code::NotAPointer,
+                           resolved_id);
+      }
+
+      if ((location.bit_offset % 8) != 0) {
+        return createError(BTFLayoutErrorInformation::Code::UnalignedPointer,
+                           resolved_id);
+      }
+
+      location.pointer_offset_list.push_back(location.bit_offset / 8);
+      location.bit_offset = 0;
+      const auto &ptr_btf_type =
+          std::get<PtrBTFType>(*d->btf.getTypeRef(resolved_id));
+
+      location.type = ptr_btf_type.type;
+    }
+
+    auto member_name = getMemberName(path);
+    if (member_name.empty()) {
+      return createError(BTFLayoutErrorInformation::Code::InvalidMemberPath,
+                         location.type);
+    }
+
+    if (location.opt_bitfield_size.has_value()) {
+      return createError(BTFLayoutErrorInformation::Code::NotAStructOrUnion,
+                         location.type);
+    }
+
+    auto aggregate_id_res = resolveAggregateType(location.type);
+    if (aggregate_id_res.failed()) {
+      return aggregate_id_res.takeError();
+    }
+
+    auto aggregate_id = aggregate_id_res.takeValue();
+
+    auto member_map_res = getMemberMap(aggregate_id);
+    if (member_map_res.failed()) {
+      return member_map_res.takeError();
+    }
+
+    const auto &member_map = *member_map_res.takeValue();
+
+    auto member_it = member_map.find(member_name);
+    if (member_it == member_map.end()) {
+      return createError(BTFLayoutErrorInformation::Code::MemberNotFound,
+                         aggregate_id);
+    }
+
+    const auto &member = member_it->second;
+    location.type = member.type;
+    location.bit_offset += member.bit_offset;
+    location.opt_bitfield_size = member.opt_bitfield_size;
+  }
+
+  if (location.opt_bitfield_size.has_value()) {
+    location.bit_size = location.opt_bitfield_size.value();
+    return location;
+  }
+
+  if (location.type >= d->type_info_list.size()) {
+    return createError(BTFLayoutErrorInformation::Code::InvalidTypeID,
+                       location.type);
+  }
+
+  const auto &type_info = getTypeInfo(location.type);
+  if (type_info.state == TypeInfo::State::Failed) {
+    return BTFLayoutError(type_info.error_information);
+  }
+
+  location.bit_size = type_info.size * 8;
+  return location;
+}
+
+std::string_view BTFLayout::getMemberName(std::string_view &path) noexcept {
+  std::size_t name_length{0};
+  while (name_length < path.size()) {
+    auto c = path[name_length];
+    if ((c < 'a' || c > 'z') && (c < 'A' || c > 'Z') && (c < '0' || c > '9') &&
+        c != '_') {
+      break;
+    }
+
+    ++name_length;
+  }
+
+  auto name = path.substr(0, name_length);
+  path.remove_prefix(name_length);
+
+  return name;
+}
+
+bool BTFLayout::getArrayIndex(std::uint64_t &index,
+                              std::string_view &path) noexcept {
+  index = 0;
+
+  std::size_t digit_count{0};
+  while (digit_count < path.size() && path[digit_count] >= '0' &&
+         path[digit_count] <= '9') {
+
+    auto digit = static_cast<std::uint64_t>(path[digit_count] - '0');
+    if (__builtin_mul_overflow(index, 10U, &index) ||
+        __builtin_add_overflow(index, digit, &index)) {
+      return false;
+    }
+
+    ++digit_count;
+  }
+
+  if (digit_count == 0 || digit_count >= path.size() ||
+      path[digit_count] != ']') {
+    return false;
+  }
+
+  path.remove_prefix(digit_count + 1);
+  return true;
+}
+
+} // namespace btfparse
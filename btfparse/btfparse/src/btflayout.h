@@ -0,0 +1,104 @@
+//
+// Copyright (c) 2021-present, Trail of Bits, Inc.
+// All rights reserved.
+//
+// This source code is licensed in accordance with the terms specified in
+// the LICENSE file found in the root directory of this source tree.
+//
+
+#pragma once
+
+#include <btfparse/ibtflayout.h>
+
+#include <unordered_map>
+
+namespace btfparse {
+
+class BTFLayout final : public IBTFLayout {
+public:
+  static Result<IBTFLayout::Ptr, BTFLayoutError>
+  create(const IBTF &btf) noexcept;
+
+  virtual ~BTFLayout() override;
+
+  virtual Result<std::uint64_t, BTFLayoutError>
+  getSize(std::uint32_t id) const noexcept override;
+
+  virtual Result<std::uint64_t, BTFLayoutError>
+  getAlignment(std::uint32_t id) const noexcept override;
+
+  virtual Result<std::uint32_t, BTFLayoutError>
+  resolveType(std::uint32_t id) const noexcept override;
+
+  virtual Result<BTFMemberLocation, BTFLayoutError>
+  resolveMemberPath(std::uint32_t id,
+                    std::string_view path) const noexcept override;
+
+  virtual Result<BTFMemberLocation, BTFLayoutError>
+  resolveMemberPath(std::string_view path) const noexcept override;
+
+private:
+  struct PrivateData;
+  std::unique_ptr<PrivateData> d;
+
+  BTFLayout(const IBTF &btf);
+
+public:
+  // Memoized layout of a single type
+  struct TypeInfo final {
+    enum class State : std::uint8_t {
+      Unvisited,
+      Expanding,
+      Resolved,
+      Failed,
+    };
+
+    State state{State::Unvisited};
+
+    std::uint64_t size{};
+    std::uint64_t alignment{};
+
+    // Only valid when the state is Failed
+    BTFLayoutErrorInformation error_information;
+  };
+
+  // A member of a struct or union, including the ones that are reached
+  // through anonymous members. The offset is relative to the outermost
+  // type
+  struct Member final {
+    std::uint32_t type{};
+    std::uint64_t bit_offset{};
+    std::optional<std::uint8_t> opt_bitfield_size;
+  };
+
+  using MemberMap = std::unordered_map<std::string_view, Member>;
+
+  // The methods below must be called with the mutex held
+
+  const TypeInfo &getTypeInfo(std::uint32_t id) const;
+  void resolveTypeInfo(std::uint32_t id) const;
+  // Returns true if the type can be laid out even when some of its
+  // dependencies can not, as structs and unions record their own size
+  bool getDependencyList(std::vector<std::uint32_t> &dependency_list,
+                         std::uint32_t id) const;
+
+  void computeTypeInfo(TypeInfo &type_info, std::uint32_t id) const;
+
+  Result<std::uint32_t, BTFLayoutError>
+  resolveTypeLocked(std::uint32_t id) const;
+
+  Result<std::uint32_t, BTFLayoutError>
+  resolveAggregateType(std::uint32_t id) const;
+
+  Result<const MemberMap *, BTFLayoutError>
+  getMemberMap(std::uint32_t id) const;
+
+  Result<BTFMemberLocation, BTFLayoutError>
+  resolveMemberPathLocked(std::uint32_t id, std::string_view path) const;
+
+  static std::string_view getMemberName(std::string_view &path) noexcept;
+  static bool getArrayIndex(std::uint64_t &index,
+                            std::string_view &path) noexcept;
+};
+
+} // namespace btfparse
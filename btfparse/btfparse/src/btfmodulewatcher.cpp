@@ -0,0 +1,317 @@
+//
+// Copyright (c) 2021-present, Trail of Bits, Inc.
+// All rights reserved.
+//
+// This source code is licensed in accordance with the terms specified in
+// the LICENSE file found in the root directory of this source tree.
+//
+
+#include "btfmodulewatcher.h"
+
+#include <cerrno>
+#include <climits>
+#include <cstring>
+#include <mutex>
+
+#include <poll.h>
+#include <sys/inotify.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace btfparse {
+
+namespace {
+
+const std::string kBaseBTFFileName{"vmlinux"};
+
+const std::uint32_t kInotifyEventMask{IN_CREATE | IN_DELETE | IN_MOVED_FROM |
+                                      IN_MOVED_TO | IN_CLOSE_WRITE};
+
+// Used to tell a module that has been reloaded (or rewritten) apart
+// from the one that was parsed before
+struct FileIdentity final {
+  dev_t device{};
+  ino_t inode{};
+  off_t size{};
+  std::int64_t modification_time{};
+
+  bool operator==(const FileIdentity &other) const {
+    return device == other.device && inode == other.inode &&
+           size == other.size && modification_time == other.modification_time;
+  }
+
+  bool operator!=(const FileIdentity &other) const {
+    return !(*this == other);
+  }
+};
+
+using FileIdentityMap = std::map<std::string, FileIdentity>;
+
+std::optional<FileIdentity> getFileIdentity(const std::filesystem::path &path) {
+  struct stat file_stats {};
+  if (stat(path.c_str(), &file_stats) != 0 || !S_ISREG(file_stats.st_mode)) {
+    return std::nullopt;
+  }
+
+  FileIdentity file_identity;
+  file_identity.device = file_stats.st_dev;
+  file_identity.inode = file_stats.st_ino;
+  file_identity.size = file_stats.st_size;
+  file_identity.modification_time =
+      static_cast<std::int64_t>(file_stats.st_mtim.tv_sec) * 1000000000LL +
+      static_cast<std::int64_t>(file_stats.st_mtim.tv_nsec);
+
+  return file_identity;
+}
+
+BTFModuleWatcherError createIOError(const std::string &message) {
+  return BTFModuleWatcherError(BTFModuleWatcherErrorInformation{
+      BTFModuleWatcherErrorInformation::Code::IOError,
+      message + ": " + std::strerror(errno),
+  });
+}
+
+} // namespace
+
+struct BTFModuleWatcher::PrivateData final {
+  ~PrivateData() {
+    if (inotify_fd != -1) {
+      close(inotify_fd);
+    }
+  }
+
+  std::filesystem::path btf_directory;
+  BTFOptions options;
+  int inotify_fd{-1};
+
+  // Serializes the updates; readers never take it
+  std::mutex update_mutex;
+
+  // Guards the module set pointer. It is only held while the pointer is
+  // copied or replaced, never while an update is parsing modules
+  std::mutex module_set_mutex;
+
+  // The files that the current module set was created from. Modules
+  // that failed to parse are not listed, so that they are retried
+  FileIdentityMap file_identity_map;
+
+  // Only accessed while holding module_set_mutex
+  BTFModuleSet::Ptr module_set;
+};
+
+Result<IBTFModuleWatcher::Ptr, BTFModuleWatcherError>
+BTFModuleWatcher::create(const std::filesystem::path &btf_directory,
+                         const BTFOptions &options) noexcept {
+  try {
+    std::error_code error;
+    if (!std::filesystem::is_directory(btf_directory, error)) {
+      return BTFModuleWatcherError(BTFModuleWatcherErrorInformation{
+          BTFModuleWatcherErrorInformation::Code::FileNotFound,
+          btf_directory.string(),
+      });
+    }
+
+    auto base_btf_res =
+        IBTF::createFromPath(btf_directory / kBaseBTFFileName, options);
+
+    if (base_btf_res.failed()) {
+      return convertBTFError(kBaseBTFFileName, base_btf_res.takeError());
+    }
+
+    auto module_set = std::make_shared<BTFModuleSet>();
+    module_set->base_btf = base_btf_res.takeValue();
+
+    std::unique_ptr<BTFModuleWatcher> watcher(
+        new BTFModuleWatcher(btf_directory, options));
+
+    auto &watcher_data = *watcher->d;
+    watcher_data.module_set = std::move(module_set);
+
+    // Watch the directory before the first scan, so that no change can
+    // fall in between
+    watcher_data.inotify_fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (watcher_data.inotify_fd == -1) {
+      return createIOError("Failed to create the inotify instance");
+    }
+
+    if (inotify_add_watch(watcher_data.inotify_fd, btf_directory.c_str(),
+                          kInotifyEventMask) == -1) {
+      return createIOError("Failed to watch " + btf_directory.string());
+    }
+
+    // The modules that fail to parse here are reported by the next
+    // update, which tries them again
+    static_cast<void>(watcher->update());
+
+    return Ptr(std::move(watcher));
+
+  } catch (const std::bad_alloc &) {
+    return BTFModuleWatcherError(BTFModuleWatcherErrorInformation{
+        BTFModuleWatcherErrorInformation::Code::MemoryAllocationFailure,
+    });
+  }
+}
+
+BTFModuleWatcher::~BTFModuleWatcher() {}
+
+BTFModuleSet::Ptr BTFModuleWatcher::getModuleSet() const noexcept {
+  std::lock_guard<std::mutex> lock(d->module_set_mutex);
+  return d->module_set;
+}
+
+std::optional<BTFModuleWatcherError> BTFModuleWatcher::update() {
+  try {
+    std::lock_guard<std::mutex> lock(d->update_mutex);
+
+    FileIdentityMap file_identity_map;
+
+    std::error_code error;
+    std::filesystem::directory_iterator directory_it(d->btf_directory, error);
+    if (error) {
+      return BTFModuleWatcherError(BTFModuleWatcherErrorInformation{
+          BTFModuleWatcherErrorInformation::Code::IOError,
+          "Failed to list " + d->btf_directory.string(),
+      });
+    }
+
+    for (; directory_it != std::filesystem::directory_iterator();
+         directory_it.increment(error)) {
+
+      const auto &path = directory_it->path();
+
+      auto name = path.filename().string();
+      if (name == kBaseBTFFileName || name.front() == '.') {
+        continue;
+      }
+
+      auto opt_file_identity = getFileIdentity(path);
+      if (opt_file_identity.has_value()) {
+        file_identity_map.insert({name, opt_file_identity.value()});
+      }
+    }
+
+    if (error) {
+      return BTFModuleWatcherError(BTFModuleWatcherErrorInformation{
+          BTFModuleWatcherErrorInformation::Code::IOError,
+          "Failed to list " + d->btf_directory.string(),
+      });
+    }
+
+    auto current_module_set = getModuleSet();
+    auto module_set = std::make_shared<BTFModuleSet>(*current_module_set);
+
+    auto changed{false};
+    for (auto module_it = module_set->module_map.begin();
+         module_it != module_set->module_map.end();) {
+
+      auto file_identity_it = file_identity_map.find(module_it->first);
+      auto current_file_identity_it =
+          d->file_identity_map.find(module_it->first);
+
+      if (file_identity_it != file_identity_map.end() &&
+          current_file_identity_it != d->file_identity_map.end() &&
+          file_identity_it->second == current_file_identity_it->second) {
+
+        ++module_it;
+        continue;
+      }
+
+      d->file_identity_map.erase(module_it->first);
+      module_it = module_set->module_map.erase(module_it);
+      changed = true;
+    }
+
+    std::optional<BTFModuleWatcherError> opt_error;
+    for (const auto &[name, file_identity] : file_identity_map) {
+      if (module_set->module_map.count(name) > 0) {
+        continue;
+      }
+
+      auto module_btf_res = IBTF::createSplitFromPath(
+          module_set->base_btf, d->btf_directory / name, d->options);
+
+      if (module_btf_res.failed()) {
+        auto module_error = module_btf_res.takeError();
+        if (!opt_error.has_value()) {
+          opt_error = convertBTFError(name, module_error);
+        }
+
+        continue;
+      }
+
+      module_set->module_map.insert({name, module_btf_res.takeValue()});
+      d->file_identity_map.insert({name, file_identity});
+      changed = true;
+    }
+
+    if (changed) {
+      BTFModuleSet::Ptr published_module_set = std::move(module_set);
+
+      // The previous set is released outside of the lock, since
+      // destroying its modules may take a while
+      {
+        std::lock_guard<std::mutex> module_set_lock(d->module_set_mutex);
+        d->module_set.swap(published_module_set);
+      }
+    }
+
+    return opt_error;
+
+  } catch (const std::bad_alloc &) {
+    return BTFModuleWatcherError(BTFModuleWatcherErrorInformation{
+        BTFModuleWatcherErrorInformation::Code::MemoryAllocationFailure,
+    });
+  }
+}
+
+std::optional<BTFModuleWatcherError>
+BTFModuleWatcher::update(std::chrono::milliseconds timeout) {
+  auto timeout_ms = std::min<std::chrono::milliseconds::rep>(
+      std::max<std::chrono::milliseconds::rep>(timeout.count(), 0), INT_MAX);
+
+  struct pollfd poll_fd {};
+  poll_fd.fd = d->inotify_fd;
+  poll_fd.events = POLLIN;
+
+  if (poll(&poll_fd, 1, static_cast<int>(timeout_ms)) == -1 &&
+      errno != EINTR) {
+    return createIOError("Failed to wait for inotify events");
+  }
+
+  // The events only tell us that something has changed; the directory
+  // is compared with the module set again in any case
+  alignas(struct inotify_event) char event_buffer[4096];
+  while (read(d->inotify_fd, event_buffer, sizeof(event_buffer)) > 0) {
+  }
+
+  return update();
+}
+
+BTFModuleWatcher::BTFModuleWatcher(const std::filesystem::path &btf_directory,
+                                   const BTFOptions &options)
+    : d(new PrivateData) {
+  d->btf_directory = btf_directory;
+  d->options = options;
+}
+
+BTFModuleWatcherError BTFModuleWatcher::convertBTFError(const std::string &name,
+                                                        const BTFError &error) {
+  auto code = BTFModuleWatcherErrorInformation::Code::InvalidBTF;
+  if (error.get().code == BTFErrorInformation::Code::FileNotFound) {
+    code = BTFModuleWatcherErrorInformation::Code::FileNotFound;
+
+  } else if (error.get().code == BTFErrorInformation::Code::IOError) {
+    code = BTFModuleWatcherErrorInformation::Code::IOError;
+
+  } else if (error.get().code ==
+             BTFErrorInformation::Code::MemoryAllocationFailure) {
+    code = BTFModuleWatcherErrorInformation::Code::MemoryAllocationFailure;
+  }
+
+  return BTFModuleWatcherError(BTFModuleWatcherErrorInformation{
+      code,
+      name + ": " + error.toString(),
+  });
+}
+
+} // namespace btfparse
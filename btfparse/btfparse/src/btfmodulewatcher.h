@@ -0,0 +1,41 @@
+//
+// Copyright (c) 2021-present, Trail of Bits, Inc.
+// All rights reserved.
+//
+// This source code is licensed in accordance with the terms specified in
+// the LICENSE file found in the root directory of this source tree.
+//
+
+#pragma once
+
+#include <btfparse/ibtfmodulewatcher.h>
+
+namespace btfparse {
+
+class BTFModuleWatcher final : public IBTFModuleWatcher {
+public:
+  static Result<IBTFModuleWatcher::Ptr, BTFModuleWatcherError>
+  create(const std::filesystem::path &btf_directory,
+         const BTFOptions &options) noexcept;
+
+  virtual ~BTFModuleWatcher() override;
+
+  virtual BTFModuleSet::Ptr getModuleSet() const noexcept override;
+  virtual std::optional<BTFModuleWatcherError> update() override;
+
+  virtual std::optional<BTFModuleWatcherError>
+  update(std::chrono::milliseconds timeout) override;
+
+private:
+  struct PrivateData;
+  std::unique_ptr<PrivateData> d;
+
+  BTFModuleWatcher(const std::filesystem::path &btf_directory,
+                   const BTFOptions &options);
+
+public:
+  static BTFModuleWatcherError convertBTFError(const std::string &name,
+                                               const BTFError &error);
+};
+
+} // namespace btfparse
@@ -0,0 +1,209 @@
+//
+// Copyright (c) 2021-present, Trail of Bits, Inc.
+// All rights reserved.
+//
+// This source code is licensed in accordance with the terms specified in
+// the LICENSE file found in the root directory of this source tree.
+//
+
+#include "btfnameindex.h"
+
+#include <algorithm>
+
+namespace btfparse {
+
+namespace {
+
+const std::size_t kBTFKindCount{static_cast<std::size_t>(BTFKind::Float) + 1U};
+
+template <typename String>
+std::string_view getOptionalName(const std::optional<String> &opt_name) {
+  if (!opt_name.has_value()) {
+    return {};
+  }
+
+  return opt_name.value();
+}
+
+} // namespace
+
+void BTFNameIndex::build(const EntryList &entry_list) {
+  kind_id_list.clear();
+  kind_offset_list.assign(kBTFKindCount + 1U, 0);
+
+  name_range_map.clear();
+  name_id_list.clear();
+  name_kind_list.clear();
+
+  // Sort the entries by kind with a counting sort, which keeps them in ID
+  // order within each kind
+  for (const auto &entry : entry_list) {
+    ++kind_offset_list[static_cast<std::size_t>(entry.kind) + 1U];
+  }
+
+  for (std::size_t i = 1; i < kind_offset_list.size(); ++i) {
+    kind_offset_list[i] += kind_offset_list[i - 1];
+  }
+
+  std::vector<std::size_t> sorted_entry_list(entry_list.size());
+  auto next_offset_list = kind_offset_list;
+
+  for (std::size_t i = 0; i < entry_list.size(); ++i) {
+    auto &next_offset =
+        next_offset_list[static_cast<std::size_t>(entry_list[i].kind)];
+
+    sorted_entry_list[next_offset] = i;
+    ++next_offset;
+  }
+
+  kind_id_list.reserve(entry_list.size());
+  for (const auto &entry_index : sorted_entry_list) {
+    kind_id_list.push_back(entry_list[entry_index].id);
+  }
+
+  // Then group the named entries by name, going through them in the same
+  // order: each name range is sorted by kind, and then by ID. The first
+  // pass counts the entries of each name, and the second one places them
+  std::size_t named_entry_count{0};
+  for (const auto &entry_index : sorted_entry_list) {
+    const auto &entry = entry_list[entry_index];
+    if (entry.name.empty()) {
+      continue;
+    }
+
+    ++name_range_map[entry.name].end;
+    ++named_entry_count;
+  }
+
+  std::size_t next_start{0};
+  for (auto &name_range_map_p : name_range_map) {
+    auto &name_range = name_range_map_p.second;
+
+    auto entry_count = name_range.end;
+    name_range.start = next_start;
+    name_range.end = next_start;
+
+    next_start += entry_count;
+  }
+
+  name_id_list.resize(named_entry_count);
+  name_kind_list.resize(named_entry_count);
+
+  for (const auto &entry_index : sorted_entry_list) {
+    const auto &entry = entry_list[entry_index];
+    if (entry.name.empty()) {
+      continue;
+    }
+
+    auto &name_range = name_range_map.at(entry.name);
+    name_id_list[name_range.end] = entry.id;
+    name_kind_list[name_range.end] = entry.kind;
+
+    ++name_range.end;
+  }
+}
+
+BTFTypeIDRange BTFNameIndex::findByName(std::string_view name) const noexcept {
+  auto name_range_map_it = name_range_map.find(name);
+  if (name_range_map_it == name_range_map.end()) {
+    return {};
+  }
+
+  const auto &name_range = name_range_map_it->second;
+  return createRange(name_id_list, name_range.start, name_range.end);
+}
+
+BTFTypeIDRange BTFNameIndex::findByName(std::string_view name,
+                                        BTFKind kind) const noexcept {
+  auto name_range_map_it = name_range_map.find(name);
+  if (name_range_map_it == name_range_map.end()) {
+    return {};
+  }
+
+  const auto &name_range = name_range_map_it->second;
+
+  auto kind_begin = name_kind_list.begin();
+  auto kind_range = std::equal_range(
+      kind_begin + static_cast<std::ptrdiff_t>(name_range.start),
+      kind_begin + static_cast<std::ptrdiff_t>(name_range.end), kind);
+
+  return createRange(
+      name_id_list, static_cast<std::size_t>(kind_range.first - kind_begin),
+      static_cast<std::size_t>(kind_range.second - kind_begin));
+}
+
+BTFTypeIDRange BTFNameIndex::findByKind(BTFKind kind) const noexcept {
+  auto kind_index = static_cast<std::size_t>(kind);
+  if (kind_index + 1U >= kind_offset_list.size()) {
+    return {};
+  }
+
+  return createRange(kind_id_list, kind_offset_list[kind_index],
+                     kind_offset_list[kind_index + 1U]);
+}
+
+std::string_view
+BTFNameIndex::getTypeName(const BTFType &btf_type) noexcept {
+  return std::visit(
+      [](const auto &type) -> std::string_view {
+        using Type = std::decay_t<decltype(type)>;
+
+        if constexpr (std::is_same_v<Type, StructBTFType> ||
+                      std::is_same_v<Type, UnionBTFType> ||
+                      std::is_same_v<Type, EnumBTFType>) {
+          return getOptionalName(type.opt_name);
+
+        } else if constexpr (std::is_same_v<Type, IntBTFType> ||
+                             std::is_same_v<Type, TypedefBTFType> ||
+                             std::is_same_v<Type, FwdBTFType> ||
+                             std::is_same_v<Type, FuncBTFType> ||
+                             std::is_same_v<Type, FloatBTFType> ||
+                             std::is_same_v<Type, VarBTFType> ||
+                             std::is_same_v<Type, DataSecBTFType>) {
+          return type.name;
+
+        } else {
+          return {};
+        }
+      },
+      btf_type);
+}
+
+std::string_view
+BTFNameIndex::getTypeName(const BTFTypeView &btf_type_view) noexcept {
+  return std::visit(
+      [](const auto &type) -> std::string_view {
+        using Type = std::decay_t<decltype(type)>;
+
+        if constexpr (std::is_same_v<Type, StructBTFTypeView> ||
+                      std::is_same_v<Type, UnionBTFTypeView> ||
+                      std::is_same_v<Type, EnumBTFTypeView>) {
+          return getOptionalName(type.opt_name);
+
+        } else if constexpr (std::is_same_v<Type, IntBTFTypeView> ||
+                             std::is_same_v<Type, TypedefBTFTypeView> ||
+                             std::is_same_v<Type, FwdBTFTypeView> ||
+                             std::is_same_v<Type, FuncBTFTypeView> ||
+                             std::is_same_v<Type, FloatBTFTypeView> ||
+                             std::is_same_v<Type, VarBTFTypeView> ||
+                             std::is_same_v<Type, DataSecBTFTypeView>) {
+          return type.name;
+
+        } else {
+          return {};
+        }
+      },
+      btf_type_view);
+}
+
+BTFTypeIDRange
+BTFNameIndex::createRange(const std::vector<std::uint32_t> &id_list,
+                          std::size_t start, std::size_t end) const noexcept {
+  if (start == end) {
+    return {};
+  }
+
+  return BTFTypeIDRange(id_list.data() + start, id_list.data() + end);
+}
+
+} // namespace btfparse
@@ -0,0 +1,70 @@
+//
+// Copyright (c) 2021-present, Trail of Bits, Inc.
+// All rights reserved.
+//
+// This source code is licensed in accordance with the terms specified in
+// the LICENSE file found in the root directory of this source tree.
+//
+
+#pragma once
+
+#include <btfparse/ibtf.h>
+
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace btfparse {
+
+// Lookup tables from type names and kinds to type IDs. Both are stored as
+// ranges over sorted ID lists, so that lookups return borrowed ranges
+// instead of copies
+class BTFNameIndex final {
+public:
+  struct Entry final {
+    std::uint32_t id{};
+    BTFKind kind{BTFKind::Void};
+
+    // Empty for anonymous types
+    std::string_view name;
+  };
+
+  using EntryList = std::vector<Entry>;
+
+  // The entries must be in ID order. The names are not copied, and must
+  // outlive the index
+  void build(const EntryList &entry_list);
+
+  BTFTypeIDRange findByName(std::string_view name) const noexcept;
+  BTFTypeIDRange findByName(std::string_view name,
+                            BTFKind kind) const noexcept;
+
+  BTFTypeIDRange findByKind(BTFKind kind) const noexcept;
+
+  // Returns the name of the given type, or an empty string if the type
+  // is anonymous. The view points inside the given object
+  static std::string_view getTypeName(const BTFType &btf_type) noexcept;
+
+  // Same as the other overload, for type views
+  static std::string_view
+  getTypeName(const BTFTypeView &btf_type_view) noexcept;
+
+private:
+  struct NameRange final {
+    std::size_t start{};
+    std::size_t end{};
+  };
+
+  std::vector<std::uint32_t> kind_id_list;
+  std::vector<std::size_t> kind_offset_list;
+
+  std::unordered_map<std::string_view, NameRange> name_range_map;
+  std::vector<std::uint32_t> name_id_list;
+  std::vector<BTFKind> name_kind_list;
+
+  BTFTypeIDRange createRange(const std::vector<std::uint32_t> &id_list,
+                             std::size_t start,
+                             std::size_t end) const noexcept;
+};
+
+} // namespace btfparse
@@ -0,0 +1,1042 @@
+//
+// Copyright (c) 2021-present, Trail of Bits, Inc.
+// All rights reserved.
+//
+// This source code is licensed in accordance with the terms specified in
+// the LICENSE file found in the root directory of this source tree.
+//
+
+#include "btfsnapshot.h"
+#include "btfhash.h"
+
+#include <array>
+#include <atomic>
+#include <limits>
+#include <mutex>
+#include <unordered_map>
+
+namespace btfparse {
+
+namespace {
+
+const std::uint32_t kSnapshotMagic{0x53465442};
+const std::uint32_t kSnapshotVersion{1U};
+
+const std::size_t kSnapshotHeaderSize{32U};
+const std::size_t kSnapshotChecksumEnd{16U};
+const std::size_t kTypeRecordSize{32U};
+const std::size_t kItemRecordSize{16U};
+
+const std::uint32_t kBitfieldSizePresent{0x100U};
+
+const std::size_t kLazyTypeBlockSize{1024U};
+
+std::uint32_t readU32(const std::uint8_t *data) {
+  return static_cast<std::uint32_t>(data[0]) |
+         (static_cast<std::uint32_t>(data[1]) << 8) |
+         (static_cast<std::uint32_t>(data[2]) << 16) |
+         (static_cast<std::uint32_t>(data[3]) << 24);
+}
+
+std::uint64_t readU64(const std::uint8_t *data) {
+  return static_cast<std::uint64_t>(readU32(data)) |
+         (static_cast<std::uint64_t>(readU32(data + 4)) << 32);
+}
+
+void writeU32(std::uint8_t *data, std::uint32_t value) {
+  for (std::size_t i = 0; i < 4; ++i) {
+    data[i] = static_cast<std::uint8_t>(value >> (i * 8U));
+  }
+}
+
+void writeU64(std::uint8_t *data, std::uint64_t value) {
+  writeU32(data, static_cast<std::uint32_t>(value));
+  writeU32(data + 4, static_cast<std::uint32_t>(value >> 32));
+}
+
+BTFError createInvalidSnapshotError() {
+  return BTFError(BTFErrorInformation{
+      BTFErrorInformation::Code::InvalidSnapshot,
+  });
+}
+
+// Collects the records and strings of a snapshot while it is being
+// serialized
+class SnapshotWriter final {
+public:
+  SnapshotWriter(std::uint32_t type_count)
+      : type_record_buffer(type_count * kTypeRecordSize, 0) {}
+
+  void addType(std::uint32_t id, const BTFType &btf_type) {
+    if (id == 0 || id > type_record_buffer.size() / kTypeRecordSize) {
+      throw createInvalidSnapshotError();
+    }
+
+    auto record = encodeType(btf_type);
+
+    auto data = type_record_buffer.data() + (id - 1) * kTypeRecordSize;
+    writeU32(data, record.kind);
+    writeU32(data + 4, record.name);
+    writeU32(data + 8, record.field0);
+    writeU32(data + 12, record.field1);
+    writeU32(data + 16, record.field2);
+    writeU32(data + 20, record.first_item);
+    writeU32(data + 24, record.item_count);
+  }
+
+  std::vector<std::uint8_t> finalize() const {
+    auto item_count = item_record_buffer.size() / kItemRecordSize;
+
+    if (item_count > std::numeric_limits<std::uint32_t>::max() ||
+        string_pool.size() > std::numeric_limits<std::uint32_t>::max()) {
+      throw createInvalidSnapshotError();
+    }
+
+    std::vector<std::uint8_t> buffer(kSnapshotHeaderSize, 0);
+    buffer.reserve(kSnapshotHeaderSize + type_record_buffer.size() +
+                   item_record_buffer.size() + string_pool.size());
+
+    auto type_count = type_record_buffer.size() / kTypeRecordSize;
+
+    writeU32(buffer.data(), kSnapshotMagic);
+    writeU32(buffer.data() + 4, kSnapshotVersion);
+    writeU32(buffer.data() + 16, static_cast<std::uint32_t>(type_count));
+    writeU32(buffer.data() + 20, static_cast<std::uint32_t>(item_count));
+    writeU32(buffer.data() + 24,
+             static_cast<std::uint32_t>(string_pool.size()));
+
+    buffer.insert(buffer.end(), type_record_buffer.begin(),
+                  type_record_buffer.end());
+
+    buffer.insert(buffer.end(), item_record_buffer.begin(),
+                  item_record_buffer.end());
+
+    buffer.insert(buffer.end(), string_pool.begin(), string_pool.end());
+
+    auto checksum =
+        BTFSnapshot::computeChecksum(buffer.data() + kSnapshotChecksumEnd,
+                                     buffer.size() - kSnapshotChecksumEnd);
+
+    writeU64(buffer.data() + 8, checksum);
+    return buffer;
+  }
+
+private:
+  std::vector<std::uint8_t> type_record_buffer;
+  std::vector<std::uint8_t> item_record_buffer;
+  std::string string_pool;
+  std::unordered_map<std::string, std::uint32_t> string_map;
+
+  std::uint32_t addString(const std::string &str) {
+    auto string_map_it = string_map.find(str);
+    if (string_map_it != string_map.end()) {
+      return string_map_it->second;
+    }
+
+    if (string_pool.size() >= std::numeric_limits<std::uint32_t>::max()) {
+      throw createInvalidSnapshotError();
+    }
+
+    auto name = static_cast<std::uint32_t>(string_pool.size()) + 1;
+    string_pool.append(str);
+    string_pool.push_back('\0');
+
+    string_map.insert({str, name});
+    return name;
+  }
+
+  std::uint32_t addOptionalString(const std::optional<std::string> &opt_str) {
+    return opt_str.has_value() ? addString(opt_str.value()) : 0U;
+  }
+
+  std::uint32_t nextItem() const {
+    return static_cast<std::uint32_t>(item_record_buffer.size() /
+                                      kItemRecordSize);
+  }
+
+  void addItem(const BTFSnapshot::ItemRecord &item) {
+    auto offset = item_record_buffer.size();
+    item_record_buffer.resize(offset + kItemRecordSize);
+
+    auto data = item_record_buffer.data() + offset;
+    writeU32(data, item.name);
+    writeU32(data + 4, item.field0);
+    writeU32(data + 8, item.field1);
+    writeU32(data + 12, item.field2);
+  }
+
+  template <typename Type>
+  void encodeStructOrUnion(BTFSnapshot::TypeRecord &record,
+                           const Type &btf_type) {
+    record.name = addOptionalString(btf_type.opt_name);
+    record.field0 = btf_type.size;
+    record.first_item = nextItem();
+    record.item_count = static_cast<std::uint32_t>(btf_type.member_list.size());
+
+    for (const auto &member : btf_type.member_list) {
+      BTFSnapshot::ItemRecord item;
+      item.name = addOptionalString(member.opt_name);
+      item.field0 = member.type;
+      item.field1 = member.offset;
+
+      if (member.opt_bitfield_size.has_value()) {
+        item.field2 = kBitfieldSizePresent | member.opt_bitfield_size.value();
+      }
+
+      addItem(item);
+    }
+  }
+
+  BTFSnapshot::TypeRecord encodeType(const BTFType &btf_type) {
+    BTFSnapshot::TypeRecord record;
+
+    auto btf_kind = IBTF::getBTFTypeKind(btf_type);
+    record.kind = static_cast<std::uint32_t>(btf_kind);
+
+    switch (btf_kind) {
+    case BTFKind::Void:
+      break;
+
+    case BTFKind::Int: {
+      const auto &int_type = std::get<IntBTFType>(btf_type);
+      record.name = addString(int_type.name);
+      record.field0 = int_type.size;
+      record.field1 = static_cast<std::uint32_t>(int_type.encoding);
+      record.field2 = static_cast<std::uint32_t>(int_type.offset) |
+                      (static_cast<std::uint32_t>(int_type.bits) << 8);
+
+      break;
+    }
+
+    case BTFKind::Ptr:
+      record.field0 = std::get<PtrBTFType>(btf_type).type;
+      break;
+
+    case BTFKind::Const:
+      record.field0 = std::get<ConstBTFType>(btf_type).type;
+      break;
+
+    case BTFKind::Volatile:
+      record.field0 = std::get<VolatileBTFType>(btf_type).type;
+      break;
+
+    case BTFKind::Restrict:
+      record.field0 = std::get<RestrictBTFType>(btf_type).type;
+      break;
+
+    case BTFKind::Array: {
+      const auto &array_type = std::get<ArrayBTFType>(btf_type);
+      record.field0 = array_type.type;
+      record.field1 = array_type.index_type;
+      record.field2 = array_type.nelems;
+
+      break;
+    }
+
+    case BTFKind::Typedef: {
+      const auto &typedef_type = std::get<TypedefBTFType>(btf_type);
+      record.name = addString(typedef_type.name);
+      record.field0 = typedef_type.type;
+
+      break;
+    }
+
+    case BTFKind::Enum: {
+      const auto &enum_type = std::get<EnumBTFType>(btf_type);
+      record.name = addOptionalString(enum_type.opt_name);
+      record.field0 = enum_type.size;
+      record.first_item = nextItem();
+      record.item_count =
+          static_cast<std::uint32_t>(enum_type.value_list.size());
+
+      for (const auto &value : enum_type.value_list) {
+        BTFSnapshot::ItemRecord item;
+        item.name = addString(value.name);
+        item.field0 = static_cast<std::uint32_t>(value.val);
+
+        addItem(item);
+      }
+
+      break;
+    }
+
+    case BTFKind::FuncProto: {
+      const auto &func_proto_type = std::get<FuncProtoBTFType>(btf_type);
+      record.field0 = func_proto_type.return_type;
+      record.field1 = func_proto_type.is_variadic ? 1U : 0U;
+      record.first_item = nextItem();
+      record.item_count =
+          static_cast<std::uint32_t>(func_proto_type.param_list.size());
+
+      for (const auto &param : func_proto_type.param_list) {
+        BTFSnapshot::ItemRecord item;
+        item.name = addOptionalString(param.opt_name);
+        item.field0 = param.type;
+
+        addItem(item);
+      }
+
+      break;
+    }
+
+    case BTFKind::Struct:
+      encodeStructOrUnion(record, std::get<StructBTFType>(btf_type));
+      break;
+
+    case BTFKind::Union:
+      encodeStructOrUnion(record, std::get<UnionBTFType>(btf_type));
+      break;
+
+    case BTFKind::Fwd: {
+      const auto &fwd_type = std::get<FwdBTFType>(btf_type);
+      record.name = addString(fwd_type.name);
+      record.field0 = fwd_type.is_union ? 1U : 0U;
+
+      break;
+    }
+
+    case BTFKind::Func: {
+      const auto &func_type = std::get<FuncBTFType>(btf_type);
+      record.name = addString(func_type.name);
+      record.field0 = func_type.type;
+      record.field1 = static_cast<std::uint32_t>(func_type.linkage);
+
+      break;
+    }
+
+    case BTFKind::Float: {
+      const auto &float_type = std::get<FloatBTFType>(btf_type);
+      record.name = addString(float_type.name);
+      record.field0 = float_type.size;
+
+      break;
+    }
+
+    case BTFKind::Var: {
+      const auto &var_type = std::get<VarBTFType>(btf_type);
+      record.name = addString(var_type.name);
+      record.field0 = var_type.type;
+      record.field1 = var_type.linkage;
+
+      break;
+    }
+
+    case BTFKind::DataSec: {
+      const auto &data_sec_type = std::get<DataSecBTFType>(btf_type);
+      record.name = addString(data_sec_type.name);
+      record.field0 = data_sec_type.size;
+      record.first_item = nextItem();
+      record.item_count =
+          static_cast<std::uint32_t>(data_sec_type.variable_list.size());
+
+      for (const auto &variable : data_sec_type.variable_list) {
+        BTFSnapshot::ItemRecord item;
+        item.field0 = variable.type;
+        item.field1 = variable.offset;
+        item.field2 = variable.size;
+
+        addItem(item);
+      }
+
+      break;
+    }
+    }
+
+    return record;
+  }
+};
+
+// Decodes the records of a validated image. Every offset and index is
+// still checked, since the checksum does not protect against crafted files
+class SnapshotReader final {
+public:
+  SnapshotReader(const BTFSnapshot::Image &snapshot_image)
+      : image(snapshot_image) {}
+
+  Result<BTFType, BTFError> decodeType(std::uint32_t index) const {
+    auto record = BTFSnapshot::readTypeRecord(image, index);
+
+    if (static_cast<std::uint64_t>(record.first_item) + record.item_count >
+        image.item_count) {
+      return createInvalidSnapshotError();
+    }
+
+    switch (static_cast<BTFKind>(record.kind)) {
+    case BTFKind::Void:
+      return BTFType{};
+
+    case BTFKind::Int: {
+      if (record.field1 > static_cast<std::uint32_t>(
+                              IntBTFType::Encoding::Bool)) {
+        return createInvalidSnapshotError();
+      }
+
+      IntBTFType int_type;
+      if (!readString(int_type.name, record.name)) {
+        return createInvalidSnapshotError();
+      }
+
+      int_type.size = record.field0;
+      int_type.encoding = static_cast<IntBTFType::Encoding>(record.field1);
+      int_type.offset = static_cast<std::uint8_t>(record.field2);
+      int_type.bits = static_cast<std::uint8_t>(record.field2 >> 8);
+
+      return BTFType{std::move(int_type)};
+    }
+
+    case BTFKind::Ptr:
+      return BTFType{PtrBTFType{record.field0}};
+
+    case BTFKind::Const:
+      return BTFType{ConstBTFType{record.field0}};
+
+    case BTFKind::Volatile:
+      return BTFType{VolatileBTFType{record.field0}};
+
+    case BTFKind::Restrict:
+      return BTFType{RestrictBTFType{record.field0}};
+
+    case BTFKind::Array:
+      return BTFType{ArrayBTFType{record.field0, record.field1, record.field2}};
+
+    case BTFKind::Typedef: {
+      TypedefBTFType typedef_type;
+      if (!readString(typedef_type.name, record.name)) {
+        return createInvalidSnapshotError();
+      }
+
+      typedef_type.type = record.field0;
+      return BTFType{std::move(typedef_type)};
+    }
+
+    case BTFKind::Enum: {
+      EnumBTFType enum_type;
+      if (!readOptionalString(enum_type.opt_name, record.name)) {
+        return createInvalidSnapshotError();
+      }
+
+      enum_type.size = record.field0;
+      enum_type.value_list.reserve(record.item_count);
+
+      for (std::uint32_t i = 0; i < record.item_count; ++i) {
+        auto item = readItemRecord(record.first_item + i);
+
+        EnumBTFType::Value value;
+        if (!readString(value.name, item.name)) {
+          return createInvalidSnapshotError();
+        }
+
+        value.val = static_cast<std::int32_t>(item.field0);
+        enum_type.value_list.push_back(std::move(value));
+      }
+
+      return BTFType{std::move(enum_type)};
+    }
+
+    case BTFKind::FuncProto: {
+      FuncProtoBTFType func_proto_type;
+      func_proto_type.return_type = record.field0;
+      func_proto_type.is_variadic = record.field1 != 0;
+      func_proto_type.param_list.reserve(record.item_count);
+
+      for (std::uint32_t i = 0; i < record.item_count; ++i) {
+        auto item = readItemRecord(record.first_item + i);
+
+        FuncProtoBTFType::Param param;
+        if (!readOptionalString(param.opt_name, item.name)) {
+          return createInvalidSnapshotError();
+        }
+
+        param.type = item.field0;
+        func_proto_type.param_list.push_back(std::move(param));
+      }
+
+      return BTFType{std::move(func_proto_type)};
+    }
+
+    case BTFKind::Struct:
+      return decodeStructOrUnion<StructBTFType>(record);
+
+    case BTFKind::Union:
+      return decodeStructOrUnion<UnionBTFType>(record);
+
+    case BTFKind::Fwd: {
+      FwdBTFType fwd_type;
+      if (!readString(fwd_type.name, record.name)) {
+        return createInvalidSnapshotError();
+      }
+
+      fwd_type.is_union = record.field0 != 0;
+      return BTFType{std::move(fwd_type)};
+    }
+
+    case BTFKind::Func: {
+      if (record.field1 >
+          static_cast<std::uint32_t>(FuncBTFType::Linkage::Extern)) {
+        return createInvalidSnapshotError();
+      }
+
+      FuncBTFType func_type;
+      if (!readString(func_type.name, record.name)) {
+        return createInvalidSnapshotError();
+      }
+
+      func_type.type = record.field0;
+      func_type.linkage = static_cast<FuncBTFType::Linkage>(record.field1);
+
+      return BTFType{std::move(func_type)};
+    }
+
+    case BTFKind::Float: {
+      FloatBTFType float_type;
+      if (!readString(float_type.name, record.name)) {
+        return createInvalidSnapshotError();
+      }
+
+      float_type.size = record.field0;
+      return BTFType{std::move(float_type)};
+    }
+
+    case BTFKind::Var: {
+      VarBTFType var_type;
+      if (!readString(var_type.name, record.name)) {
+        return createInvalidSnapshotError();
+      }
+
+      var_type.type = record.field0;
+      var_type.linkage = record.field1;
+
+      return BTFType{std::move(var_type)};
+    }
+
+    case BTFKind::DataSec: {
+      DataSecBTFType data_sec_type;
+      if (!readString(data_sec_type.name, record.name)) {
+        return createInvalidSnapshotError();
+      }
+
+      data_sec_type.size = record.field0;
+      data_sec_type.variable_list.reserve(record.item_count);
+
+      for (std::uint32_t i = 0; i < record.item_count; ++i) {
+        auto item = readItemRecord(record.first_item + i);
+        data_sec_type.variable_list.push_back(
+            DataSecBTFType::Variable{item.field0, item.field1, item.field2});
+      }
+
+      return BTFType{std::move(data_sec_type)};
+    }
+    }
+
+    return createInvalidSnapshotError();
+  }
+
+private:
+  const BTFSnapshot::Image &image;
+
+  BTFSnapshot::ItemRecord readItemRecord(std::uint32_t index) const {
+    auto data = image.item_records + index * kItemRecordSize;
+
+    BTFSnapshot::ItemRecord item;
+    item.name = readU32(data);
+    item.field0 = readU32(data + 4);
+    item.field1 = readU32(data + 8);
+    item.field2 = readU32(data + 12);
+
+    return item;
+  }
+
+  // The image validation guarantees that the string pool ends with a NUL
+  // character, so any offset inside of it is terminated
+  bool readString(std::string &output, std::uint32_t name) const {
+    if (name == 0) {
+      output.clear();
+      return true;
+    }
+
+    if (name > image.string_pool_size) {
+      return false;
+    }
+
+    output = std::string(image.string_pool + (name - 1));
+    return true;
+  }
+
+  bool readOptionalString(std::optional<std::string> &opt_output,
+                          std::uint32_t name) const {
+    if (name == 0) {
+      opt_output = std::nullopt;
+      return true;
+    }
+
+    std::string output;
+    if (!readString(output, name)) {
+      return false;
+    }
+
+    opt_output = std::move(output);
+    return true;
+  }
+
+  template <typename Type>
+  Result<BTFType, BTFError>
+  decodeStructOrUnion(const BTFSnapshot::TypeRecord &record) const {
+    static_assert(std::is_same<Type, StructBTFType>::value ||
+                      std::is_same<Type, UnionBTFType>::value,
+                  "Type must be either StructBTFType or UnionBTFType");
+
+    Type output;
+    if (!readOptionalString(output.opt_name, record.name)) {
+      return createInvalidSnapshotError();
+    }
+
+    output.size = record.field0;
+    output.member_list.reserve(record.item_count);
+
+    for (std::uint32_t i = 0; i < record.item_count; ++i) {
+      auto item = readItemRecord(record.first_item + i);
+
+      typename Type::Member member;
+      if (!readOptionalString(member.opt_name, item.name)) {
+        return createInvalidSnapshotError();
+      }
+
+      member.type = item.field0;
+      member.offset = item.field1;
+
+      if ((item.field2 & kBitfieldSizePresent) != 0) {
+        member.opt_bitfield_size = static_cast<std::uint8_t>(item.field2);
+      }
+
+      output.member_list.push_back(std::move(member));
+    }
+
+    return BTFType{std::move(output)};
+  }
+};
+
+} // namespace
+
+struct BTFSnapshot::PrivateData final {
+  struct LazyType final {
+    std::atomic_bool decoded{false};
+    BTFType btf_type;
+  };
+
+  using LazyTypeBlock = std::array<LazyType, kLazyTypeBlockSize>;
+
+  // Owns the memory the image points to
+  IFileReader::Ptr file_reader;
+  Image image;
+
+  // The decoded types are stored in blocks that are only allocated when
+  // one of their types is first requested, so that opening a snapshot
+  // does not depend on the number of types it contains
+  std::unique_ptr<std::atomic<LazyTypeBlock *>[]> lazy_type_block_list;
+  std::vector<std::unique_ptr<LazyTypeBlock>> lazy_type_block_storage;
+  std::mutex lazy_type_list_mutex;
+
+  // Built by the first findByName/findByKind call
+  std::once_flag name_index_once_flag;
+  BTFNameIndex name_index;
+
+  // Built by the first getTypeView call
+  std::once_flag type_view_table_once_flag;
+  BTFTypeViewTable type_view_table;
+};
+
+Result<IBTF::Ptr, BTFError>
+BTFSnapshot::create(IFileReader::Ptr file_reader) noexcept {
+  try {
+    return Ptr(new BTFSnapshot(std::move(file_reader)));
+
+  } catch (const std::bad_alloc &) {
+    return BTFError(BTFErrorInformation{
+        BTFErrorInformation::Code::MemoryAllocationFailure,
+    });
+
+  } catch (const BTFError &e) {
+    return e;
+  }
+}
+
+Result<std::vector<std::uint8_t>, BTFError>
+BTFSnapshot::serialize(const IBTF &btf) noexcept {
+  try {
+    SnapshotWriter writer(btf.count());
+
+    btf.forEach([&writer](std::uint32_t id, const BTFType &btf_type) {
+      writer.addType(id, btf_type);
+      return true;
+    });
+
+    return writer.finalize();
+
+  } catch (const std::bad_alloc &) {
+    return BTFError(BTFErrorInformation{
+        BTFErrorInformation::Code::MemoryAllocationFailure,
+    });
+
+  } catch (const BTFError &e) {
+    return e;
+  }
+}
+
+BTFSnapshot::~BTFSnapshot() {}
+
+std::optional<BTFType> BTFSnapshot::getType(std::uint32_t id) const noexcept {
+  const auto *btf_type = getTypeRef(id);
+  if (btf_type == nullptr) {
+    return std::nullopt;
+  }
+
+  return *btf_type;
+}
+
+std::optional<BTFKind> BTFSnapshot::getKind(std::uint32_t id) const noexcept {
+  if (id == 0 || id > d->image.type_count) {
+    return std::nullopt;
+  }
+
+  // The kind is read straight from the record, without decoding the type
+  auto record = readTypeRecord(d->image, id - 1);
+  if (record.kind == static_cast<std::uint32_t>(BTFKind::Void) ||
+      record.kind > static_cast<std::uint32_t>(BTFKind::Float)) {
+    return std::nullopt;
+  }
+
+  return static_cast<BTFKind>(record.kind);
+}
+
+const BTFType *BTFSnapshot::getTypeRef(std::uint32_t id) const noexcept {
+  if (id == 0 || id > d->image.type_count) {
+    return nullptr;
+  }
+
+  auto index = id - 1;
+
+  auto &lazy_type_block = d->lazy_type_block_list[index / kLazyTypeBlockSize];
+  auto lazy_type_block_ptr = lazy_type_block.load(std::memory_order_acquire);
+
+  if (lazy_type_block_ptr == nullptr ||
+      !(*lazy_type_block_ptr)[index % kLazyTypeBlockSize].decoded.load(
+          std::memory_order_acquire)) {
+
+    std::lock_guard<std::mutex> lock(d->lazy_type_list_mutex);
+
+    lazy_type_block_ptr = lazy_type_block.load(std::memory_order_relaxed);
+    if (lazy_type_block_ptr == nullptr) {
+      try {
+        d->lazy_type_block_storage.push_back(
+            std::make_unique<PrivateData::LazyTypeBlock>());
+
+      } catch (const std::bad_alloc &) {
+        return nullptr;
+      }
+
+      lazy_type_block_ptr = d->lazy_type_block_storage.back().get();
+      lazy_type_block.store(lazy_type_block_ptr, std::memory_order_release);
+    }
+
+    auto &lazy_type = (*lazy_type_block_ptr)[index % kLazyTypeBlockSize];
+    if (!lazy_type.decoded.load(std::memory_order_relaxed)) {
+      auto btf_type_res = decodeType(d->image, index);
+
+      // Like in the lazy BTF decoding, invalid types are reported as missing
+      if (!btf_type_res.failed()) {
+        lazy_type.btf_type = btf_type_res.takeValue();
+      }
+
+      lazy_type.decoded.store(true, std::memory_order_release);
+    }
+  }
+
+  const auto &lazy_type = (*lazy_type_block_ptr)[index % kLazyTypeBlockSize];
+  if (std::holds_alternative<std::monostate>(lazy_type.btf_type)) {
+    return nullptr;
+  }
+
+  return &lazy_type.btf_type;
+}
+
+std::optional<BTFTypeView>
+BTFSnapshot::getTypeView(std::uint32_t id) const noexcept {
+  if (id == 0 || id > d->image.type_count) {
+    return std::nullopt;
+  }
+
+  try {
+    std::call_once(d->type_view_table_once_flag, [this]() {
+      d->type_view_table.build(*this, 1, d->image.type_count);
+    });
+
+  } catch (const std::exception &) {
+    return std::nullopt;
+  }
+
+  const auto &btf_type_view = d->type_view_table[id - 1];
+  if (std::holds_alternative<std::monostate>(btf_type_view)) {
+    return std::nullopt;
+  }
+
+  return btf_type_view;
+}
+
+std::uint32_t BTFSnapshot::count() const noexcept {
+  return d->image.type_count;
+}
+
+BTFTypeMap BTFSnapshot::getAll() const noexcept {
+  BTFTypeMap btf_type_map;
+  btf_type_map.reserve(count());
+
+  forEach([&btf_type_map](std::uint32_t id, const BTFType &btf_type) {
+    btf_type_map.insert({id, btf_type});
+    return true;
+  });
+
+  return btf_type_map;
+}
+
+std::optional<std::uint32_t>
+BTFSnapshot::getCanonicalID(std::uint32_t original_id) const noexcept {
+  if (original_id > count()) {
+    return std::nullopt;
+  }
+
+  return original_id;
+}
+
+BTFTypeIDRange BTFSnapshot::findByName(std::string_view name) const noexcept {
+  const auto *name_index = getNameIndex();
+  if (name_index == nullptr) {
+    return {};
+  }
+
+  return name_index->findByName(name);
+}
+
+BTFTypeIDRange BTFSnapshot::findByName(std::string_view name,
+                                       BTFKind kind) const noexcept {
+  const auto *name_index = getNameIndex();
+  if (name_index == nullptr) {
+    return {};
+  }
+
+  return name_index->findByName(name, kind);
+}
+
+BTFTypeIDRange BTFSnapshot::findByKind(BTFKind kind) const noexcept {
+  const auto *name_index = getNameIndex();
+  if (name_index == nullptr) {
+    return {};
+  }
+
+  return name_index->findByKind(kind);
+}
+
+bool BTFSnapshot::forEach(const ForEachCallback &callback) const {
+  for (std::uint32_t id = 1; id <= d->image.type_count; ++id) {
+    const auto *btf_type = getTypeRef(id);
+    if (btf_type != nullptr && !callback(id, *btf_type)) {
+      return false;
+    }
+  }
+
+  return true;
+}
+
+const BTFNameIndex *BTFSnapshot::getNameIndex() const noexcept {
+  try {
+    std::call_once(d->name_index_once_flag, [this]() {
+      const auto &image = d->image;
+
+      // Like getKind, this only reads the type records. The names point
+      // straight into the string pool, which is already deduplicated
+      BTFNameIndex::EntryList entry_list;
+      entry_list.reserve(image.type_count);
+
+      for (std::uint32_t index = 0; index < image.type_count; ++index) {
+        auto record = readTypeRecord(image, index);
+        if (record.kind == static_cast<std::uint32_t>(BTFKind::Void) ||
+            record.kind > static_cast<std::uint32_t>(BTFKind::Float)) {
+          continue;
+        }
+
+        BTFNameIndex::Entry entry;
+        entry.id = index + 1;
+        entry.kind = static_cast<BTFKind>(record.kind);
+
+        if (record.name != 0 && record.name <= image.string_pool_size) {
+          entry.name = image.string_pool + (record.name - 1);
+        }
+
+        entry_list.push_back(entry);
+      }
+
+      d->name_index.build(entry_list);
+    });
+
+    return &d->name_index;
+
+  } catch (const std::exception &) {
+    return nullptr;
+  }
+}
+
+BTFSnapshot::BTFSnapshot(IFileReader::Ptr file_reader) : d(new PrivateData) {
+  auto opt_buffer = file_reader->buffer();
+  if (!opt_buffer.has_value()) {
+    throw BTFError(BTFErrorInformation{
+        BTFErrorInformation::Code::IOError,
+    });
+  }
+
+  const auto &buffer = opt_buffer.value();
+
+  auto image_res = validateImage(buffer.data, buffer.size);
+  if (image_res.failed()) {
+    throw image_res.takeError();
+  }
+
+  d->file_reader = std::move(file_reader);
+  d->image = image_res.takeValue();
+  auto lazy_type_block_count =
+      (d->image.type_count + kLazyTypeBlockSize - 1) / kLazyTypeBlockSize;
+
+  d->lazy_type_block_list.reset(
+      new std::atomic<PrivateData::LazyTypeBlock *>[lazy_type_block_count]);
+
+  for (std::size_t i = 0; i < lazy_type_block_count; ++i) {
+    d->lazy_type_block_list[i].store(nullptr, std::memory_order_relaxed);
+  }
+}
+
+Result<BTFSnapshot::Image, BTFError>
+BTFSnapshot::validateImage(const std::uint8_t *data,
+                           std::size_t size) noexcept {
+  if (size < kSnapshotHeaderSize) {
+    return createInvalidSnapshotError();
+  }
+
+  Header header;
+  header.magic = readU32(data);
+  header.version = readU32(data + 4);
+  header.checksum = readU64(data + 8);
+  header.type_count = readU32(data + 16);
+  header.item_count = readU32(data + 20);
+  header.string_pool_size = readU32(data + 24);
+
+  if (header.magic != kSnapshotMagic) {
+    return createInvalidSnapshotError();
+  }
+
+  if (header.version != kSnapshotVersion) {
+    return BTFError(BTFErrorInformation{
+        BTFErrorInformation::Code::UnsupportedSnapshotVersion,
+    });
+  }
+
+  auto expected_size = static_cast<std::uint64_t>(kSnapshotHeaderSize) +
+                       header.type_count * std::uint64_t{kTypeRecordSize} +
+                       header.item_count * std::uint64_t{kItemRecordSize} +
+                       header.string_pool_size;
+
+  if (expected_size != size) {
+    return createInvalidSnapshotError();
+  }
+
+  auto checksum = computeChecksum(data + kSnapshotChecksumEnd,
+                                  size - kSnapshotChecksumEnd);
+
+  if (checksum != header.checksum) {
+    return BTFError(BTFErrorInformation{
+        BTFErrorInformation::Code::SnapshotChecksumMismatch,
+    });
+  }
+
+  Image image;
+  image.type_records = data + kSnapshotHeaderSize;
+  image.item_records =
+      image.type_records + header.type_count * kTypeRecordSize;
+
+  image.string_pool = reinterpret_cast<const char *>(
+      image.item_records + header.item_count * kItemRecordSize);
+
+  image.type_count = header.type_count;
+  image.item_count = header.item_count;
+  image.string_pool_size = header.string_pool_size;
+
+  if (image.string_pool_size != 0 &&
+      image.string_pool[image.string_pool_size - 1] != '\0') {
+    return createInvalidSnapshotError();
+  }
+
+  return image;
+}
+
+std::uint64_t BTFSnapshot::computeChecksum(const std::uint8_t *data,
+                                           std::size_t size) noexcept {
+  // FNV-1a over 64-bit words, using independent lanes so that large
+  // snapshots can be verified every time they are opened
+  std::array<std::uint64_t, 4> lane_list;
+  for (std::size_t lane = 0; lane < lane_list.size(); ++lane) {
+    lane_list[lane] = kFNVOffsetBasis + lane;
+  }
+
+  const std::size_t kStride{lane_list.size() * 8U};
+
+  std::size_t i{};
+  for (; i + kStride <= size; i += kStride) {
+    for (std::size_t lane = 0; lane < lane_list.size(); ++lane) {
+      auto &checksum = lane_list[lane];
+      checksum ^= readU64(data + i + lane * 8U);
+      checksum *= kFNVPrime;
+      checksum ^= checksum >> 32;
+    }
+  }
+
+  auto checksum = kFNVOffsetBasis;
+  for (const auto &lane : lane_list) {
+    checksum ^= lane;
+    checksum *= kFNVPrime;
+  }
+
+  for (; i < size; ++i) {
+    checksum ^= data[i];
+    checksum *= kFNVPrime;
+  }
+
+  checksum ^= static_cast<std::uint64_t>(size);
+  return checksum;
+}
+
+BTFSnapshot::TypeRecord
+BTFSnapshot::readTypeRecord(const Image &image, std::uint32_t index) noexcept {
+  auto data = image.type_records + index * kTypeRecordSize;
+
+  TypeRecord record;
+  record.kind = readU32(data);
+  record.name = readU32(data + 4);
+  record.field0 = readU32(data + 8);
+  record.field1 = readU32(data + 12);
+  record.field2 = readU32(data + 16);
+  record.first_item = readU32(data + 20);
+  record.item_count = readU32(data + 24);
+
+  return record;
+}
+
+Result<BTFType, BTFError>
+BTFSnapshot::decodeType(const Image &image, std::uint32_t index) noexcept {
+  try {
+    return SnapshotReader(image).decodeType(index);
+
+  } catch (const std::bad_alloc &) {
+    return BTFError(BTFErrorInformation{
+        BTFErrorInformation::Code::MemoryAllocationFailure,
+    });
+  }
+}
+
+} // namespace btfparse
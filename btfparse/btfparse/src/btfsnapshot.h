@@ -0,0 +1,129 @@
+//
+// Copyright (c) 2021-present, Trail of Bits, Inc.
+// All rights reserved.
+//
+// This source code is licensed in accordance with the terms specified in
+// the LICENSE file found in the root directory of this source tree.
+//
+
+#pragma once
+
+#include "btfnameindex.h"
+#include "btftypeviewtable.h"
+
+#include <btfparse/ibtf.h>
+#include <btfparse/ifilereader.h>
+
+#include <vector>
+
+namespace btfparse {
+
+// Snapshot layout (all the integers are little endian):
+//
+//  Header      magic, version, checksum, type count, item count and
+//              string pool size
+//  Types       one fixed-width record per type ID, starting from 1.
+//              Holes have the Void kind
+//  Items       fixed-width records for the members, enum values,
+//              parameters and variables, referenced by the types
+//  Strings     NUL-terminated, deduplicated strings. Names are stored
+//              as (offset + 1), and 0 means that there is no name
+//
+// The checksum covers everything that follows it
+class BTFSnapshot final : public IBTF {
+public:
+  // The file reader must be memory resident
+  static Result<IBTF::Ptr, BTFError>
+  create(IFileReader::Ptr file_reader) noexcept;
+
+  static Result<std::vector<std::uint8_t>, BTFError>
+  serialize(const IBTF &btf) noexcept;
+
+  virtual ~BTFSnapshot() override;
+
+  virtual std::optional<BTFType>
+  getType(std::uint32_t id) const noexcept override;
+
+  virtual std::optional<BTFKind>
+  getKind(std::uint32_t id) const noexcept override;
+
+  virtual const BTFType *getTypeRef(std::uint32_t id) const noexcept override;
+
+  virtual std::optional<BTFTypeView>
+  getTypeView(std::uint32_t id) const noexcept override;
+
+  virtual std::uint32_t count() const noexcept override;
+  virtual BTFTypeMap getAll() const noexcept override;
+
+  virtual std::optional<std::uint32_t>
+  getCanonicalID(std::uint32_t original_id) const noexcept override;
+
+  virtual BTFTypeIDRange
+  findByName(std::string_view name) const noexcept override;
+
+  virtual BTFTypeIDRange findByName(std::string_view name,
+                                    BTFKind kind) const noexcept override;
+
+  virtual BTFTypeIDRange findByKind(BTFKind kind) const noexcept override;
+
+  virtual bool forEach(const ForEachCallback &callback) const override;
+
+private:
+  struct PrivateData;
+  std::unique_ptr<PrivateData> d;
+
+  BTFSnapshot(IFileReader::Ptr file_reader);
+
+  const BTFNameIndex *getNameIndex() const noexcept;
+
+public:
+  struct Header final {
+    std::uint32_t magic{};
+    std::uint32_t version{};
+    std::uint64_t checksum{};
+    std::uint32_t type_count{};
+    std::uint32_t item_count{};
+    std::uint32_t string_pool_size{};
+  };
+
+  struct TypeRecord final {
+    std::uint32_t kind{};
+    std::uint32_t name{};
+    std::uint32_t field0{};
+    std::uint32_t field1{};
+    std::uint32_t field2{};
+    std::uint32_t first_item{};
+    std::uint32_t item_count{};
+  };
+
+  struct ItemRecord final {
+    std::uint32_t name{};
+    std::uint32_t field0{};
+    std::uint32_t field1{};
+    std::uint32_t field2{};
+  };
+
+  struct Image final {
+    const std::uint8_t *type_records{nullptr};
+    const std::uint8_t *item_records{nullptr};
+    const char *string_pool{nullptr};
+
+    std::uint32_t type_count{};
+    std::uint32_t item_count{};
+    std::uint32_t string_pool_size{};
+  };
+
+  static Result<Image, BTFError> validateImage(const std::uint8_t *data,
+                                               std::size_t size) noexcept;
+
+  static std::uint64_t computeChecksum(const std::uint8_t *data,
+                                       std::size_t size) noexcept;
+
+  static TypeRecord readTypeRecord(const Image &image,
+                                   std::uint32_t index) noexcept;
+
+  static Result<BTFType, BTFError> decodeType(const Image &image,
+                                              std::uint32_t index) noexcept;
+};
+
+} // namespace btfparse
@@ -0,0 +1,145 @@
+//
+// Copyright (c) 2021-present, Trail of Bits, Inc.
+// All rights reserved.
+//
+// This source code is licensed in accordance with the terms specified in
+// the LICENSE file found in the root directory of this source tree.
+//
+
+#include "btfstringtable.h"
+#include "btf.h"
+
+#include <algorithm>
+
+namespace btfparse {
+
+Result<BTFStringTable, BTFError>
+BTFStringTable::create(const BTFFileList &btf_file_list) noexcept {
+  return create(btf_file_list, nullptr);
+}
+
+Result<BTFStringTable, BTFError>
+BTFStringTable::create(const BTFFileList &btf_file_list,
+                       const BTFStringTable &base_string_table) noexcept {
+  return create(btf_file_list, &base_string_table);
+}
+
+Result<BTFStringTable, BTFError>
+BTFStringTable::create(const BTFFileList &btf_file_list,
+                       const BTFStringTable *base_string_table) noexcept {
+  try {
+    BTFStringTable string_table;
+    string_table.base_string_table = base_string_table;
+
+    std::uint64_t base_offset{};
+    if (base_string_table != nullptr) {
+      base_offset = base_string_table->size();
+    }
+
+    for (const auto &btf_file : btf_file_list) {
+      const auto &btf_header = btf_file.btf_header;
+      auto &file_reader = *btf_file.file_reader.get();
+
+      auto section_offset =
+          static_cast<std::uint64_t>(btf_header.hdr_len) + btf_header.str_off;
+
+      Section section;
+      section.base_offset = base_offset;
+
+      if (btf_header.str_len != 0) {
+        auto opt_buffer = file_reader.buffer();
+        if (opt_buffer.has_value()) {
+          const auto &buffer = opt_buffer.value();
+          if (section_offset + btf_header.str_len > buffer.size) {
+            return BTFError{
+                BTFErrorInformation{
+                    BTFErrorInformation::Code::IOError,
+                    BTFErrorInformation::FileRange{section_offset,
+                                                   btf_header.str_len},
+                },
+            };
+          }
+
+          section.data =
+              reinterpret_cast<const char *>(&buffer.data[section_offset]);
+
+        } else {
+          std::vector<char> section_buffer(btf_header.str_len);
+
+          file_reader.seek(section_offset);
+          file_reader.read(
+              reinterpret_cast<std::uint8_t *>(section_buffer.data()),
+              section_buffer.size());
+
+          section.data = section_buffer.data();
+          string_table.section_buffer_list.push_back(
+              std::move(section_buffer));
+        }
+
+        // Only keep the part of the section that is terminated, so that
+        // lookups never have to check for the section boundaries
+        std::string_view section_view(section.data, btf_header.str_len);
+        auto last_terminator = section_view.rfind('\0');
+
+        if (last_terminator != std::string_view::npos) {
+          section.size = last_terminator + 1;
+        }
+      }
+
+      string_table.section_list.push_back(section);
+      base_offset += btf_header.str_len;
+    }
+
+    string_table.end_offset = base_offset;
+    return string_table;
+
+  } catch (const std::bad_alloc &) {
+    return BTFError{
+        BTFErrorInformation{
+            BTFErrorInformation::Code::MemoryAllocationFailure,
+        },
+    };
+
+  } catch (const FileReaderError &error) {
+    return BTF::convertFileReaderError(error);
+  }
+}
+
+Result<std::string_view, BTFError>
+BTFStringTable::get(std::uint64_t offset) const noexcept {
+  lookup_counter.increment();
+
+  if (base_string_table != nullptr && offset < base_string_table->size()) {
+    return base_string_table->get(offset);
+  }
+
+  auto section_it = std::upper_bound(
+      section_list.begin(), section_list.end(), offset,
+      [](std::uint64_t value, const Section &section) -> bool {
+        return value < section.base_offset;
+      });
+
+  if (section_it != section_list.begin()) {
+    const auto &section = *std::prev(section_it);
+
+    auto relative_offset = offset - section.base_offset;
+    if (relative_offset < section.size) {
+      return std::string_view(&section.data[relative_offset]);
+    }
+  }
+
+  return BTFError{
+      BTFErrorInformation{
+          BTFErrorInformation::Code::InvalidStringOffset,
+          BTFErrorInformation::FileRange{offset, 0},
+      },
+  };
+}
+
+std::uint64_t BTFStringTable::size() const noexcept { return end_offset; }
+
+std::uint64_t BTFStringTable::lookupCount() const noexcept {
+  return lookup_counter.value();
+}
+
+} // namespace btfparse
@@ -0,0 +1,66 @@
+//
+// Copyright (c) 2021-present, Trail of Bits, Inc.
+// All rights reserved.
+//
+// This source code is licensed in accordance with the terms specified in
+// the LICENSE file found in the root directory of this source tree.
+//
+
+#pragma once
+
+#include "btf_types.h"
+#include "btftelemetry.h"
+
+#include <btfparse/ibtf.h>
+
+#include <string_view>
+#include <vector>
+
+namespace btfparse {
+
+// Resolves string offsets against the string sections of a BTFFileList.
+// Sections of memory-resident files are referenced in place, while the
+// others are read once. Each file covers the offset range that starts
+// where the string section of the previous file ends
+class BTFStringTable final {
+public:
+  static Result<BTFStringTable, BTFError>
+  create(const BTFFileList &btf_file_list) noexcept;
+
+  // Offsets below base_string_table.size() are resolved by the base
+  // table, which must outlive the returned object
+  static Result<BTFStringTable, BTFError>
+  create(const BTFFileList &btf_file_list,
+         const BTFStringTable &base_string_table) noexcept;
+
+  BTFStringTable() = default;
+
+  Result<std::string_view, BTFError> get(std::uint64_t offset) const noexcept;
+
+  std::uint64_t size() const noexcept;
+
+  // Number of get() calls, including the ones that were forwarded to the
+  // base table. Always 0 unless telemetry is enabled
+  std::uint64_t lookupCount() const noexcept;
+
+private:
+  struct Section final {
+    std::uint64_t base_offset{};
+    const char *data{nullptr};
+    std::size_t size{};
+  };
+
+  const BTFStringTable *base_string_table{nullptr};
+  std::uint64_t end_offset{};
+
+  std::vector<Section> section_list;
+  std::vector<std::vector<char>> section_buffer_list;
+
+  BTFTelemetryCounter lookup_counter;
+
+  static Result<BTFStringTable, BTFError>
+  create(const BTFFileList &btf_file_list,
+         const BTFStringTable *base_string_table) noexcept;
+};
+
+} // namespace btfparse
@@ -0,0 +1,178 @@
+//
+// Copyright (c) 2021-present, Trail of Bits, Inc.
+// All rights reserved.
+//
+// This source code is licensed in accordance with the terms specified in
+// the LICENSE file found in the root directory of this source tree.
+//
+
+#pragma once
+
+#include <btfparse/ibtf.h>
+
+#include <atomic>
+#include <chrono>
+
+// All the helpers below compile to nothing unless btfparse is built with
+// BTFPARSE_ENABLE_TELEMETRY, and the code that only fills in the stats is
+// guarded by kTelemetryEnabled so that it is removed as well
+
+namespace btfparse {
+
+#ifdef BTFPARSE_ENABLE_TELEMETRY
+const bool kTelemetryEnabled{true};
+#else
+const bool kTelemetryEnabled{false};
+#endif
+
+// A relaxed atomic counter that can be copied and moved along with the
+// object that owns it
+class BTFTelemetryCounter final {
+public:
+  BTFTelemetryCounter() = default;
+
+  BTFTelemetryCounter(const BTFTelemetryCounter &other) noexcept {
+    *this = other;
+  }
+
+  BTFTelemetryCounter &operator=(const BTFTelemetryCounter &other) noexcept {
+#ifdef BTFPARSE_ENABLE_TELEMETRY
+    counter.store(other.value(), std::memory_order_relaxed);
+#else
+    static_cast<void>(other);
+#endif
+
+    return *this;
+  }
+
+  void increment() const noexcept {
+#ifdef BTFPARSE_ENABLE_TELEMETRY
+    counter.fetch_add(1, std::memory_order_relaxed);
+#endif
+  }
+
+  std::uint64_t value() const noexcept {
+#ifdef BTFPARSE_ENABLE_TELEMETRY
+    return counter.load(std::memory_order_relaxed);
+#else
+    return 0;
+#endif
+  }
+
+private:
+#ifdef BTFPARSE_ENABLE_TELEMETRY
+  mutable std::atomic_uint64_t counter{0};
+#endif
+};
+
+// Measures one phase. When stopped (or destroyed), the duration is
+// passed to the trace callback, if set, and added to the output, if not
+// null
+class BTFPhaseTimer final {
+public:
+  BTFPhaseTimer(const BTFTraceCallback &trace_callback, std::string_view phase,
+                std::chrono::nanoseconds *output) noexcept
+#ifdef BTFPARSE_ENABLE_TELEMETRY
+      : callback(trace_callback), phase_name(phase),
+        duration_output(output), start_time(std::chrono::steady_clock::now())
+#endif
+  {
+#ifndef BTFPARSE_ENABLE_TELEMETRY
+    static_cast<void>(trace_callback);
+    static_cast<void>(phase);
+    static_cast<void>(output);
+#endif
+  }
+
+  ~BTFPhaseTimer() { stop(); }
+
+  void stop() noexcept {
+#ifdef BTFPARSE_ENABLE_TELEMETRY
+    if (stopped) {
+      return;
+    }
+
+    stopped = true;
+
+    auto duration = std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now() - start_time);
+
+    if (duration_output != nullptr) {
+      *duration_output += duration;
+    }
+
+    if (callback) {
+      callback(phase_name, duration);
+    }
+#endif
+  }
+
+  BTFPhaseTimer(const BTFPhaseTimer &) = delete;
+  BTFPhaseTimer &operator=(const BTFPhaseTimer &) = delete;
+
+private:
+#ifdef BTFPARSE_ENABLE_TELEMETRY
+  const BTFTraceCallback &callback;
+  std::string_view phase_name;
+  std::chrono::nanoseconds *duration_output{nullptr};
+  std::chrono::steady_clock::time_point start_time;
+  bool stopped{false};
+#endif
+};
+
+// Counts the types of each kind that a decoding loop goes through, and
+// the time spent on them. Nothing is recorded when the list is null
+class BTFKindStatsRecorder final {
+public:
+  explicit BTFKindStatsRecorder(
+      BTFParseStats::KindStatsList *kind_stats_list) noexcept
+#ifdef BTFPARSE_ENABLE_TELEMETRY
+      : stats_list(kind_stats_list)
+#endif
+  {
+#ifndef BTFPARSE_ENABLE_TELEMETRY
+    static_cast<void>(kind_stats_list);
+#endif
+  }
+
+  void start() noexcept {
+#ifdef BTFPARSE_ENABLE_TELEMETRY
+    if (stats_list != nullptr) {
+      start_time = std::chrono::steady_clock::now();
+    }
+#endif
+  }
+
+  void stop(BTFKind kind) noexcept {
+#ifdef BTFPARSE_ENABLE_TELEMETRY
+    if (stats_list == nullptr) {
+      return;
+    }
+
+    auto &kind_stats = (*stats_list)[static_cast<std::size_t>(kind)];
+    ++kind_stats.type_count;
+    kind_stats.decode_time +=
+        std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now() - start_time);
+#else
+    static_cast<void>(kind);
+#endif
+  }
+
+private:
+#ifdef BTFPARSE_ENABLE_TELEMETRY
+  BTFParseStats::KindStatsList *stats_list{nullptr};
+  std::chrono::steady_clock::time_point start_time;
+#endif
+};
+
+// Adds the counters of the source list to the destination list
+inline void addKindStats(BTFParseStats::KindStatsList &destination,
+                         const BTFParseStats::KindStatsList &source) noexcept {
+  for (std::size_t i = 0; i < destination.size(); ++i) {
+    destination[i].type_count += source[i].type_count;
+    destination[i].decode_time += source[i].decode_time;
+  }
+}
+
+} // namespace btfparse
@@ -0,0 +1,422 @@
+//
+// Copyright (c) 2021-present, Trail of Bits, Inc.
+// All rights reserved.
+//
+// This source code is licensed in accordance with the terms specified in
+// the LICENSE file found in the root directory of this source tree.
+//
+
+#include "btftypededup.h"
+#include "btfhash.h"
+
+#include <string>
+
+namespace btfparse {
+
+namespace {
+
+// Label of the nodes without a type (i.e. void, or the references past
+// the last type). It is followed by the node, so each of them is unique
+const std::uint32_t kMissingTypeLabel{0xFFFFFFFFU};
+
+const std::uint32_t kNoCanonicalNode{0xFFFFFFFFU};
+const std::uint32_t kEmptySlot{0xFFFFFFFFU};
+
+// Assigns consecutive indexes to distinct keys. Keys are built at the end
+// of a single buffer and then interned, which avoids an allocation for
+// each of them
+class KeyInterner final {
+public:
+  // At most key_count keys can be interned until the next reset
+  void reset(std::size_t key_count) {
+    std::size_t slot_count{16U};
+    while (slot_count < key_count * 2U) {
+      slot_count *= 2U;
+    }
+
+    buffer.clear();
+    key_offset_list.assign(1U, 0U);
+    slot_list.assign(slot_count, kEmptySlot);
+  }
+
+  // The key that is being built follows the interned ones
+  std::string &keyBuffer() noexcept { return buffer; }
+
+  // Returns the index of the key appended since the previous call
+  std::uint32_t intern() {
+    auto key_offset = key_offset_list.back();
+    std::string_view key(buffer.data() + key_offset,
+                         buffer.size() - key_offset);
+
+    FNV1aHash hash;
+    hash.update(reinterpret_cast<const std::uint8_t *>(key.data()),
+                key.size());
+
+    auto slot_mask = slot_list.size() - 1U;
+    for (auto slot = static_cast<std::size_t>(hash.value()) & slot_mask;;
+         slot = (slot + 1U) & slot_mask) {
+
+      auto index = slot_list[slot];
+      if (index == kEmptySlot) {
+        index = static_cast<std::uint32_t>(key_offset_list.size() - 1U);
+
+        slot_list[slot] = index;
+        key_offset_list.push_back(buffer.size());
+
+        return index;
+      }
+
+      std::string_view existing_key(buffer.data() + key_offset_list[index],
+                                    key_offset_list[index + 1U] -
+                                        key_offset_list[index]);
+
+      if (existing_key == key) {
+        buffer.resize(key_offset);
+        return index;
+      }
+    }
+  }
+
+  std::size_t size() const noexcept { return key_offset_list.size() - 1U; }
+
+private:
+  std::string buffer;
+  std::vector<std::size_t> key_offset_list;
+  std::vector<std::uint32_t> slot_list;
+};
+
+void appendU32(std::string &buffer, std::uint32_t value) {
+  for (std::size_t i = 0; i < 4; ++i) {
+    buffer.push_back(static_cast<char>(value >> (i * 8U)));
+  }
+}
+
+void appendName(std::string &buffer, std::string_view name) {
+  appendU32(buffer, static_cast<std::uint32_t>(name.size()));
+  buffer.append(name);
+}
+
+void appendOptionalName(std::string &buffer,
+                        const std::optional<std::string> &opt_name) {
+  appendU32(buffer, opt_name.has_value() ? 1U : 0U);
+  if (opt_name.has_value()) {
+    appendName(buffer, opt_name.value());
+  }
+}
+
+template <typename MemberList>
+void appendMemberList(std::string &buffer, const MemberList &member_list) {
+  appendU32(buffer, static_cast<std::uint32_t>(member_list.size()));
+
+  for (const auto &member : member_list) {
+    appendOptionalName(buffer, member.opt_name);
+    appendU32(buffer, member.offset);
+    appendU32(buffer, member.opt_bitfield_size.has_value()
+                          ? member.opt_bitfield_size.value() + 1U
+                          : 0U);
+  }
+}
+
+// Appends all the fields of the type, except for the types it references
+void appendLabel(std::string &label, const BTFType &btf_type) {
+  appendU32(label, static_cast<std::uint32_t>(IBTF::getBTFTypeKind(btf_type)));
+
+  std::visit(
+      [&label](const auto &type) {
+        using Type = std::decay_t<decltype(type)>;
+
+        if constexpr (std::is_same_v<Type, IntBTFType>) {
+          appendName(label, type.name);
+          appendU32(label, type.size);
+          appendU32(label, static_cast<std::uint32_t>(type.encoding));
+          appendU32(label, type.offset);
+          appendU32(label, type.bits);
+
+        } else if constexpr (std::is_same_v<Type, ArrayBTFType>) {
+          appendU32(label, type.nelems);
+
+        } else if constexpr (std::is_same_v<Type, TypedefBTFType>) {
+          appendName(label, type.name);
+
+        } else if constexpr (std::is_same_v<Type, EnumBTFType>) {
+          appendOptionalName(label, type.opt_name);
+          appendU32(label, type.size);
+
+          appendU32(label, static_cast<std::uint32_t>(type.value_list.size()));
+          for (const auto &value : type.value_list) {
+            appendName(label, value.name);
+            appendU32(label, static_cast<std::uint32_t>(value.val));
+          }
+
+        } else if constexpr (std::is_same_v<Type, FuncProtoBTFType>) {
+          appendU32(label, type.is_variadic ? 1U : 0U);
+
+          appendU32(label, static_cast<std::uint32_t>(type.param_list.size()));
+          for (const auto &param : type.param_list) {
+            appendOptionalName(label, param.opt_name);
+          }
+
+        } else if constexpr (std::is_same_v<Type, StructBTFType> ||
+                             std::is_same_v<Type, UnionBTFType>) {
+          appendOptionalName(label, type.opt_name);
+          appendU32(label, type.size);
+          appendMemberList(label, type.member_list);
+
+        } else if constexpr (std::is_same_v<Type, FwdBTFType>) {
+          appendName(label, type.name);
+          appendU32(label, type.is_union ? 1U : 0U);
+
+        } else if constexpr (std::is_same_v<Type, FuncBTFType>) {
+          appendName(label, type.name);
+          appendU32(label, static_cast<std::uint32_t>(type.linkage));
+
+        } else if constexpr (std::is_same_v<Type, FloatBTFType>) {
+          appendName(label, type.name);
+          appendU32(label, type.size);
+
+        } else if constexpr (std::is_same_v<Type, VarBTFType>) {
+          appendName(label, type.name);
+          appendU32(label, type.linkage);
+
+        } else if constexpr (std::is_same_v<Type, DataSecBTFType>) {
+          appendName(label, type.name);
+          appendU32(label, type.size);
+
+          appendU32(label,
+                    static_cast<std::uint32_t>(type.variable_list.size()));
+
+          for (const auto &variable : type.variable_list) {
+            appendU32(label, variable.offset);
+            appendU32(label, variable.size);
+          }
+        }
+      },
+      btf_type);
+}
+
+// Calls the callback with each of the type IDs referenced by the given
+// type, in order. They can be updated in place when the type is mutable
+template <typename BTFTypeReference, typename Callback>
+void visitReferences(BTFTypeReference &btf_type, Callback callback) {
+  std::visit(
+      [&callback](auto &type) {
+        using Type = std::decay_t<decltype(type)>;
+
+        if constexpr (std::is_same_v<Type, PtrBTFType> ||
+                      std::is_same_v<Type, ConstBTFType> ||
+                      std::is_same_v<Type, VolatileBTFType> ||
+                      std::is_same_v<Type, RestrictBTFType> ||
+                      std::is_same_v<Type, TypedefBTFType> ||
+                      std::is_same_v<Type, FuncBTFType> ||
+                      std::is_same_v<Type, VarBTFType>) {
+          callback(type.type);
+
+        } else if constexpr (std::is_same_v<Type, ArrayBTFType>) {
+          callback(type.type);
+          callback(type.index_type);
+
+        } else if constexpr (std::is_same_v<Type, FuncProtoBTFType>) {
+          callback(type.return_type);
+          for (auto &param : type.param_list) {
+            callback(param.type);
+          }
+
+        } else if constexpr (std::is_same_v<Type, StructBTFType> ||
+                             std::is_same_v<Type, UnionBTFType>) {
+          for (auto &member : type.member_list) {
+            callback(member.type);
+          }
+
+        } else if constexpr (std::is_same_v<Type, DataSecBTFType>) {
+          for (auto &variable : type.variable_list) {
+            callback(variable.type);
+          }
+        }
+      },
+      btf_type);
+}
+
+} // namespace
+
+BTFTypeDedup::RemapTable BTFTypeDedup::deduplicate(BTFTypeMap &btf_type_map,
+                                                   const IBTF *base_btf) {
+  auto first_type_id = base_btf != nullptr ? base_btf->count() + 1U : 1U;
+  auto last_type_id =
+      first_type_id - 1U + static_cast<std::uint32_t>(btf_type_map.size());
+
+  // Each type ID is a node of the graph. The last node stands for all the
+  // references past the last type
+  const auto invalid_node = last_type_id + 1U;
+  const auto node_count = static_cast<std::size_t>(invalid_node) + 1U;
+
+  auto get_type = [&](std::uint32_t id) -> const BTFType * {
+    if (id < first_type_id) {
+      return base_btf != nullptr ? base_btf->getTypeRef(id) : nullptr;
+    }
+
+    auto btf_type_map_it = btf_type_map.find(id);
+    if (btf_type_map_it == btf_type_map.end()) {
+      return nullptr;
+    }
+
+    return &btf_type_map_it->second;
+  };
+
+  // The children of each node are stored as compressed sparse rows. The
+  // nodes start out partitioned by label
+  std::vector<std::size_t> child_offset_list(node_count + 1U);
+  std::vector<std::uint32_t> child_list;
+  std::vector<std::uint32_t> class_list(node_count);
+  std::size_t class_count{};
+
+  KeyInterner key_interner;
+  auto &key_buffer = key_interner.keyBuffer();
+
+  {
+    key_interner.reset(node_count);
+
+    for (std::uint32_t node = 0; node < node_count; ++node) {
+      child_offset_list[node] = child_list.size();
+
+      const auto *btf_type = node != invalid_node ? get_type(node) : nullptr;
+      if (btf_type == nullptr) {
+        appendU32(key_buffer, kMissingTypeLabel);
+        appendU32(key_buffer, node);
+
+      } else {
+        appendLabel(key_buffer, *btf_type);
+
+        visitReferences(*btf_type, [&](std::uint32_t id) {
+          child_list.push_back(id > last_type_id ? invalid_node : id);
+        });
+      }
+
+      class_list[node] = key_interner.intern();
+    }
+
+    child_offset_list[node_count] = child_list.size();
+    class_count = key_interner.size();
+  }
+
+  // Splits the classes until all of their nodes reference the same
+  // classes (Moore's partition refinement). The nodes that are alone in
+  // their class, or that have no children, can not be split anymore and
+  // are left out of the following rounds
+  std::vector<std::uint32_t> active_node_list;
+  for (std::uint32_t node = 0; node < node_count; ++node) {
+    if (child_offset_list[node] != child_offset_list[node + 1U]) {
+      active_node_list.push_back(node);
+    }
+  }
+
+  std::vector<std::uint32_t> class_size_list;
+  std::size_t active_class_count{};
+
+  auto update_active_node_list = [&]() {
+    class_size_list.assign(class_count, 0U);
+
+    active_class_count = 0U;
+    for (auto node : active_node_list) {
+      if (class_size_list[class_list[node]]++ == 0U) {
+        ++active_class_count;
+      }
+    }
+
+    std::size_t kept_node_count{};
+    for (auto node : active_node_list) {
+      if (class_size_list[class_list[node]] > 1U) {
+        active_node_list[kept_node_count++] = node;
+      } else {
+        --active_class_count;
+      }
+    }
+
+    active_node_list.resize(kept_node_count);
+  };
+
+  update_active_node_list();
+
+  std::vector<std::uint32_t> next_class_list;
+
+  while (!active_node_list.empty()) {
+    key_interner.reset(active_node_list.size());
+    next_class_list.resize(active_node_list.size());
+
+    for (std::size_t i = 0; i < active_node_list.size(); ++i) {
+      auto node = active_node_list[i];
+      appendU32(key_buffer, class_list[node]);
+
+      for (auto child_index = child_offset_list[node];
+           child_index < child_offset_list[node + 1U]; ++child_index) {
+        appendU32(key_buffer, class_list[child_list[child_index]]);
+      }
+
+      next_class_list[i] =
+          static_cast<std::uint32_t>(class_count) + key_interner.intern();
+    }
+
+    // The signatures start with the class, so they can only split them
+    if (key_interner.size() == active_class_count) {
+      break;
+    }
+
+    for (std::size_t i = 0; i < active_node_list.size(); ++i) {
+      class_list[active_node_list[i]] = next_class_list[i];
+    }
+
+    class_count += key_interner.size();
+    update_active_node_list();
+  }
+
+  // The first node of each class is its canonical type. The base types
+  // always keep their IDs
+  std::vector<std::uint32_t> canonical_node_list(class_count,
+                                                 kNoCanonicalNode);
+
+  std::vector<std::uint32_t> node_remap_list(node_count);
+  auto next_type_id = first_type_id;
+
+  for (std::uint32_t node = 0; node < invalid_node; ++node) {
+    auto &canonical_node = canonical_node_list[class_list[node]];
+
+    if (canonical_node == kNoCanonicalNode) {
+      canonical_node = node;
+      node_remap_list[node] = node < first_type_id ? node : next_type_id++;
+
+    } else if (node < first_type_id) {
+      node_remap_list[node] = node;
+
+    } else {
+      node_remap_list[node] = node_remap_list[canonical_node];
+    }
+  }
+
+  node_remap_list[invalid_node] = next_type_id;
+
+  RemapTable remap_table(btf_type_map.size());
+
+  BTFTypeMap deduplicated_type_map;
+  deduplicated_type_map.reserve(next_type_id - first_type_id);
+
+  for (auto &btf_type_map_p : btf_type_map) {
+    auto id = btf_type_map_p.first;
+    remap_table[id - first_type_id] = node_remap_list[id];
+
+    if (canonical_node_list[class_list[id]] != id) {
+      continue;
+    }
+
+    auto &btf_type = btf_type_map_p.second;
+    visitReferences(btf_type, [&](std::uint32_t &reference) {
+      reference = node_remap_list[reference > last_type_id ? invalid_node
+                                                           : reference];
+    });
+
+    deduplicated_type_map.insert({node_remap_list[id], std::move(btf_type)});
+  }
+
+  btf_type_map = std::move(deduplicated_type_map);
+  return remap_table;
+}
+
+} // namespace btfparse
@@ -0,0 +1,38 @@
+//
+// Copyright (c) 2021-present, Trail of Bits, Inc.
+// All rights reserved.
+//
+// This source code is licensed in accordance with the terms specified in
+// the LICENSE file found in the root directory of this source tree.
+//
+
+#pragma once
+
+#include <btfparse/ibtf.h>
+
+#include <vector>
+
+namespace btfparse {
+
+// Merges the structurally equivalent types of a type map. Two types are
+// equivalent when all of their fields, names included, are the same and
+// the types they reference are equivalent as well; cycles are followed,
+// so that two copies of a self-referencing struct are merged together.
+// Forward declarations are kept apart from the types they declare
+class BTFTypeDedup final {
+public:
+  // Maps each type of the original map (at index id - first ID) to the
+  // ID of its canonical type
+  using RemapTable = std::vector<std::uint32_t>;
+
+  // The types below the first ID of the map belong to the base, if any.
+  // They keep their IDs, and the types of the map that are equivalent to
+  // one of them are remapped to it. The remaining canonical types are
+  // renumbered in ID order, starting from the first ID of the map, and
+  // the other ones are dropped. References to IDs past the last type are
+  // rewritten to the first ID past the last canonical type
+  static RemapTable deduplicate(BTFTypeMap &btf_type_map,
+                                const IBTF *base_btf);
+};
+
+} // namespace btfparse
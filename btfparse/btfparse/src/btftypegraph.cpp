@@ -0,0 +1,217 @@
+//
+// Copyright (c) 2021-present, Trail of Bits, Inc.
+// All rights reserved.
+//
+// This source code is licensed in accordance with the terms specified in
+// the LICENSE file found in the root directory of this source tree.
+//
+
+#include "btftypegraph.h"
+
+#include <algorithm>
+
+namespace btfparse {
+
+BTFTypeIDSet::BTFTypeIDSet(
+    std::initializer_list<std::uint32_t> initial_id_list) {
+  for (const auto &id : initial_id_list) {
+    insert(id);
+  }
+}
+
+bool BTFTypeIDSet::insert(std::uint32_t id) {
+  if (id >= bitset.size()) {
+    bitset.resize(std::max<std::size_t>(static_cast<std::size_t>(id) + 1U,
+                                        bitset.size() * 2U));
+  }
+
+  if (bitset[id]) {
+    return false;
+  }
+
+  bitset[id] = true;
+  id_list.push_back(id);
+
+  return true;
+}
+
+std::size_t BTFTypeIDSet::count(std::uint32_t id) const noexcept {
+  return (id < bitset.size() && bitset[id]) ? 1U : 0U;
+}
+
+void BTFTypeIDSet::clear() noexcept {
+  for (const auto &id : id_list) {
+    bitset[id] = false;
+  }
+
+  id_list.clear();
+}
+
+void BTFTypeIDSet::reserve(std::size_t id_count) {
+  if (id_count > bitset.size()) {
+    bitset.resize(id_count);
+  }
+
+  id_list.reserve(id_count);
+}
+
+std::size_t BTFTypeIDSet::size() const noexcept { return id_list.size(); }
+
+bool BTFTypeIDSet::empty() const noexcept { return id_list.empty(); }
+
+BTFTypeIDSet::const_iterator BTFTypeIDSet::begin() const noexcept {
+  return id_list.begin();
+}
+
+BTFTypeIDSet::const_iterator BTFTypeIDSet::end() const noexcept {
+  return id_list.end();
+}
+
+BTFTypeGraph::Edge::Edge(std::uint32_t id, bool weak) noexcept
+    : value((id << 1U) | (weak ? 1U : 0U)) {}
+
+std::uint32_t BTFTypeGraph::Edge::id() const noexcept { return value >> 1U; }
+
+bool BTFTypeGraph::Edge::weak() const noexcept { return (value & 1U) != 0; }
+
+void BTFTypeGraph::addEdge(std::uint32_t parent, std::uint32_t child,
+                           bool weak) {
+  pending_edge_list.emplace_back(parent, Edge(child, weak));
+}
+
+void BTFTypeGraph::finalize() {
+  if (pending_edge_list.empty()) {
+    return;
+  }
+
+  // The rows are rebuilt with a counting sort on the parent ID, which
+  // keeps the existing edges ahead of the pending ones
+  std::uint32_t row_count{};
+  if (!row_offset_list.empty()) {
+    row_count = static_cast<std::uint32_t>(row_offset_list.size() - 1U);
+  }
+
+  std::uint32_t highest_child_id{};
+  for (const auto &edge : edge_list) {
+    highest_child_id = std::max(highest_child_id, edge.id());
+  }
+
+  for (const auto &p : pending_edge_list) {
+    row_count = std::max(row_count, p.first + 1U);
+    highest_child_id = std::max(highest_child_id, p.second.id());
+  }
+
+  std::vector<std::uint32_t> new_row_offset_list(row_count + 1U, 0U);
+  for (std::uint32_t parent = 0; parent + 1U < row_offset_list.size();
+       ++parent) {
+    new_row_offset_list[parent + 1U] =
+        row_offset_list[parent + 1U] - row_offset_list[parent];
+  }
+
+  for (const auto &p : pending_edge_list) {
+    ++new_row_offset_list[p.first + 1U];
+  }
+
+  for (std::size_t i = 1; i < new_row_offset_list.size(); ++i) {
+    new_row_offset_list[i] += new_row_offset_list[i - 1U];
+  }
+
+  std::vector<std::uint32_t> insert_offset_list(new_row_offset_list.begin(),
+                                                new_row_offset_list.end() - 1);
+
+  std::vector<Edge> new_edge_list(new_row_offset_list.back(), Edge(0, false));
+
+  for (std::uint32_t parent = 0; parent + 1U < row_offset_list.size();
+       ++parent) {
+    for (auto i = row_offset_list[parent]; i < row_offset_list[parent + 1U];
+         ++i) {
+      new_edge_list[insert_offset_list[parent]++] = edge_list[i];
+    }
+  }
+
+  for (const auto &p : pending_edge_list) {
+    new_edge_list[insert_offset_list[p.first]++] = p.second;
+  }
+
+  pending_edge_list.clear();
+
+  // Merge the duplicated edges. The slot list remembers where each child
+  // was last written, and the row list which row wrote it
+  std::vector<std::uint32_t> last_row_list(highest_child_id + 1U, 0U);
+  std::vector<std::uint32_t> slot_list(highest_child_id + 1U, 0U);
+
+  std::uint32_t output_index{};
+  for (std::uint32_t parent = 0; parent < row_count; ++parent) {
+    auto row_begin = new_row_offset_list[parent];
+    auto row_end = new_row_offset_list[parent + 1U];
+    new_row_offset_list[parent] = output_index;
+
+    for (auto i = row_begin; i < row_end; ++i) {
+      auto edge = new_edge_list[i];
+      auto child = edge.id();
+
+      if (last_row_list[child] == parent + 1U) {
+        auto &merged_edge = new_edge_list[slot_list[child]];
+        merged_edge = Edge(child, merged_edge.weak() && edge.weak());
+        continue;
+      }
+
+      last_row_list[child] = parent + 1U;
+      slot_list[child] = output_index;
+      new_edge_list[output_index++] = edge;
+    }
+  }
+
+  new_row_offset_list[row_count] = output_index;
+  new_edge_list.resize(output_index, Edge(0, false));
+
+  row_offset_list = std::move(new_row_offset_list);
+  edge_list = std::move(new_edge_list);
+}
+
+BTFTypeGraph::EdgeRange<BTFTypeGraph::Edge *>
+BTFTypeGraph::edges(std::uint32_t parent) noexcept {
+  if (static_cast<std::size_t>(parent) + 1U >= row_offset_list.size()) {
+    return {nullptr, nullptr};
+  }
+
+  auto row_begin = edge_list.data() + row_offset_list[parent];
+  auto row_end = edge_list.data() + row_offset_list[parent + 1U];
+
+  return {row_begin, row_end};
+}
+
+BTFTypeGraph::EdgeRange<const BTFTypeGraph::Edge *>
+BTFTypeGraph::edges(std::uint32_t parent) const noexcept {
+  if (static_cast<std::size_t>(parent) + 1U >= row_offset_list.size()) {
+    return {nullptr, nullptr};
+  }
+
+  auto row_begin = edge_list.data() + row_offset_list[parent];
+  auto row_end = edge_list.data() + row_offset_list[parent + 1U];
+
+  return {row_begin, row_end};
+}
+
+BTFTypeGraph BTFTypeGraph::createInverse() const {
+  BTFTypeGraph inverse_graph;
+  inverse_graph.pending_edge_list.reserve(edge_list.size());
+
+  for (std::uint32_t parent = 0; parent + 1U < row_offset_list.size();
+       ++parent) {
+    for (const auto &edge : edges(parent)) {
+      inverse_graph.addEdge(edge.id(), parent, false);
+    }
+  }
+
+  inverse_graph.finalize();
+  return inverse_graph;
+}
+
+void BTFTypeGraph::clear() noexcept {
+  row_offset_list.clear();
+  edge_list.clear();
+  pending_edge_list.clear();
+}
+
+} // namespace btfparse
@@ -0,0 +1,105 @@
+//
+// Copyright (c) 2021-present, Trail of Bits, Inc.
+// All rights reserved.
+//
+// This source code is licensed in accordance with the terms specified in
+// the LICENSE file found in the root directory of this source tree.
+//
+
+#pragma once
+
+#include <cstdint>
+#include <initializer_list>
+#include <utility>
+#include <vector>
+
+namespace btfparse {
+
+// Set of type IDs backed by a dense bitset. Elements are visited in
+// insertion order
+class BTFTypeIDSet final {
+public:
+  using const_iterator = std::vector<std::uint32_t>::const_iterator;
+
+  BTFTypeIDSet() = default;
+  BTFTypeIDSet(std::initializer_list<std::uint32_t> initial_id_list);
+
+  // Returns false if the ID was already part of the set
+  bool insert(std::uint32_t id);
+
+  std::size_t count(std::uint32_t id) const noexcept;
+
+  void clear() noexcept;
+
+  // Preallocates the storage for the IDs below id_count
+  void reserve(std::size_t id_count);
+
+  std::size_t size() const noexcept;
+  bool empty() const noexcept;
+
+  const_iterator begin() const noexcept;
+  const_iterator end() const noexcept;
+
+private:
+  std::vector<bool> bitset;
+  std::vector<std::uint32_t> id_list;
+};
+
+// Dependency graph between type IDs, stored as compressed sparse rows.
+// New edges are queued by addEdge and merged into the rows by finalize
+class BTFTypeGraph final {
+public:
+  // Packs the child ID together with a flag that is set when the child
+  // is only referenced through a pointer
+  class Edge final {
+  public:
+    Edge(std::uint32_t id, bool weak) noexcept;
+
+    std::uint32_t id() const noexcept;
+    bool weak() const noexcept;
+
+  private:
+    std::uint32_t value{};
+  };
+
+  template <typename Pointer> class EdgeRange final {
+  public:
+    EdgeRange(Pointer begin_ptr, Pointer end_ptr) noexcept
+        : range_begin(begin_ptr), range_end(end_ptr) {}
+
+    Pointer begin() const noexcept { return range_begin; }
+    Pointer end() const noexcept { return range_end; }
+
+    bool empty() const noexcept { return range_begin == range_end; }
+
+  private:
+    Pointer range_begin;
+    Pointer range_end;
+  };
+
+  BTFTypeGraph() = default;
+
+  void addEdge(std::uint32_t parent, std::uint32_t child, bool weak);
+
+  // Duplicated edges are merged, keeping the position of the first one.
+  // The merged edge is weak only if all the duplicates were weak
+  void finalize();
+
+  // Edges can be updated in place, but not added or removed
+  EdgeRange<Edge *> edges(std::uint32_t parent) noexcept;
+  EdgeRange<const Edge *> edges(std::uint32_t parent) const noexcept;
+
+  // Returns a finalized graph where every edge is reversed. The weak
+  // flags are not preserved
+  BTFTypeGraph createInverse() const;
+
+  void clear() noexcept;
+
+private:
+  std::vector<std::uint32_t> row_offset_list;
+  std::vector<Edge> edge_list;
+
+  std::vector<std::pair<std::uint32_t, Edge>> pending_edge_list;
+};
+
+} // namespace btfparse
@@ -0,0 +1,762 @@
+//
+// Copyright (c) 2021-present, Trail of Bits, Inc.
+// All rights reserved.
+//
+// This source code is licensed in accordance with the terms specified in
+// the LICENSE file found in the root directory of this source tree.
+//
+
+#include "btftypehasher.h"
+#include "btfhash.h"
+
+#include <algorithm>
+#include <map>
+#include <mutex>
+#include <unordered_map>
+
+namespace btfparse {
+
+namespace {
+
+// Hashed in place of the types that can not be reached. Kinds are hashed
+// as their BTF values, so none of these collides with them
+const std::uint64_t kInvalidTypeMarker{0x100};
+const std::uint64_t kCycleMarker{0x101};
+const std::uint64_t kNamedReferenceMarker{0x102};
+
+using NamedTypeKey = std::pair<BTFKind, std::string_view>;
+
+struct NamedTypeIDList final {
+  std::vector<std::uint32_t> old_id_list;
+  std::vector<std::uint32_t> new_id_list;
+};
+
+using NamedTypeMap = std::map<NamedTypeKey, NamedTypeIDList>;
+
+BTFTypeHasherError getInvalidTypeIDError(std::uint32_t id) {
+  return BTFTypeHasherError(BTFTypeHasherErrorInformation{
+      BTFTypeHasherErrorInformation::Code::InvalidTypeID,
+      id,
+  });
+}
+
+const std::optional<std::string> *getTypeName(const BTFType &btf_type) {
+  switch (IBTF::getBTFTypeKind(btf_type)) {
+  case BTFKind::Struct:
+    return &std::get<StructBTFType>(btf_type).opt_name;
+
+  case BTFKind::Union:
+    return &std::get<UnionBTFType>(btf_type).opt_name;
+
+  case BTFKind::Enum:
+    return &std::get<EnumBTFType>(btf_type).opt_name;
+
+  default:
+    return nullptr;
+  }
+}
+
+// Named structs, unions and enums are referenced by name. Forward
+// declarations are referenced like the type they declare
+bool getNamedReference(BTFKind &kind, std::string_view &name,
+                       const BTFType &btf_type) {
+  if (IBTF::getBTFTypeKind(btf_type) == BTFKind::Fwd) {
+    const auto &fwd_type = std::get<FwdBTFType>(btf_type);
+    kind = fwd_type.is_union ? BTFKind::Union : BTFKind::Struct;
+    name = fwd_type.name;
+
+    return true;
+  }
+
+  const auto *opt_name = getTypeName(btf_type);
+  if (opt_name == nullptr || !opt_name->has_value()) {
+    return false;
+  }
+
+  kind = IBTF::getBTFTypeKind(btf_type);
+  name = opt_name->value();
+
+  return true;
+}
+
+// Pointers, qualifiers and the other types that have no identity of
+// their own keep referencing their children by name, so that following
+// a pointer never leads back into the type that contains it
+bool isReferenceTransparent(BTFKind kind) {
+  switch (kind) {
+  case BTFKind::Ptr:
+  case BTFKind::Typedef:
+  case BTFKind::Const:
+  case BTFKind::Volatile:
+  case BTFKind::Restrict:
+  case BTFKind::Array:
+  case BTFKind::FuncProto:
+  case BTFKind::Func:
+    return true;
+
+  default:
+    return false;
+  }
+}
+
+void updateName(FNV1aHash &hash, const std::optional<std::string> &opt_name) {
+  hash.update(static_cast<std::uint64_t>(opt_name.has_value()));
+  if (opt_name.has_value()) {
+    hash.update(opt_name.value());
+  }
+}
+
+void collectNamedTypes(NamedTypeMap &named_type_map, const IBTF &btf,
+                       bool old_btf) {
+  for (auto kind : {BTFKind::Struct, BTFKind::Union, BTFKind::Enum}) {
+    for (auto id : btf.findByKind(kind)) {
+      const auto *btf_type = btf.getTypeRef(id);
+      if (btf_type == nullptr) {
+        continue;
+      }
+
+      const auto &opt_name = *getTypeName(*btf_type);
+      if (!opt_name.has_value()) {
+        continue;
+      }
+
+      auto &id_list_pair = named_type_map[{kind, opt_name.value()}];
+      auto &id_list =
+          old_btf ? id_list_pair.old_id_list : id_list_pair.new_id_list;
+
+      id_list.push_back(id);
+    }
+  }
+}
+
+std::uint32_t getTypeSize(const BTFType &btf_type) {
+  switch (IBTF::getBTFTypeKind(btf_type)) {
+  case BTFKind::Struct:
+    return std::get<StructBTFType>(btf_type).size;
+
+  case BTFKind::Union:
+    return std::get<UnionBTFType>(btf_type).size;
+
+  case BTFKind::Enum:
+    return std::get<EnumBTFType>(btf_type).size;
+
+  default:
+    return 0;
+  }
+}
+
+// Pairs the members by name. Anonymous members are paired in the order
+// in which they appear
+template <typename AggregateType>
+std::optional<BTFTypeHasherError>
+diffMembers(std::vector<BTFMemberDiff> &member_diff_list,
+            const IBTFTypeHasher &old_hasher, const AggregateType &old_type,
+            const IBTFTypeHasher &new_hasher, const AggregateType &new_type) {
+
+  std::unordered_map<std::string_view, std::size_t> new_member_map;
+  std::vector<std::size_t> new_anonymous_member_list;
+
+  for (std::size_t i = 0; i < new_type.member_list.size(); ++i) {
+    const auto &opt_name = new_type.member_list[i].opt_name;
+    if (opt_name.has_value()) {
+      new_member_map.insert({opt_name.value(), i});
+    } else {
+      new_anonymous_member_list.push_back(i);
+    }
+  }
+
+  std::vector<bool> matched_new_member_list(new_type.member_list.size());
+  std::size_t anonymous_member_index{};
+
+  for (const auto &old_member : old_type.member_list) {
+    std::optional<std::size_t> opt_new_member_index;
+    if (old_member.opt_name.has_value()) {
+      auto new_member_it = new_member_map.find(old_member.opt_name.value());
+      if (new_member_it != new_member_map.end()) {
+        opt_new_member_index = new_member_it->second;
+      }
+
+    } else if (anonymous_member_index < new_anonymous_member_list.size()) {
+      opt_new_member_index =
+          new_anonymous_member_list[anonymous_member_index++];
+    }
+
+    BTFMemberDiff member_diff;
+    member_diff.name = old_member.opt_name.value_or("");
+    member_diff.opt_old_type = old_member.type;
+    member_diff.opt_old_offset = old_member.offset;
+
+    if (!opt_new_member_index.has_value()) {
+      member_diff.change = BTFDiffChange::Removed;
+      member_diff_list.push_back(std::move(member_diff));
+      continue;
+    }
+
+    matched_new_member_list[opt_new_member_index.value()] = true;
+    const auto &new_member = new_type.member_list[opt_new_member_index.value()];
+
+    auto old_hash_res = old_hasher.getHash(old_member.type);
+    if (old_hash_res.failed()) {
+      return old_hash_res.takeError();
+    }
+
+    auto new_hash_res = new_hasher.getHash(new_member.type);
+    if (new_hash_res.failed()) {
+      return new_hash_res.takeError();
+    }
+
+    member_diff.type_changed =
+        old_hash_res.takeValue() != new_hash_res.takeValue() ||
+        old_member.opt_bitfield_size != new_member.opt_bitfield_size;
+
+    if (!member_diff.type_changed && old_member.offset == new_member.offset) {
+      continue;
+    }
+
+    member_diff.opt_new_type = new_member.type;
+    member_diff.opt_new_offset = new_member.offset;
+    member_diff_list.push_back(std::move(member_diff));
+  }
+
+  for (std::size_t i = 0; i < new_type.member_list.size(); ++i) {
+    if (matched_new_member_list[i]) {
+      continue;
+    }
+
+    const auto &new_member = new_type.member_list[i];
+
+    BTFMemberDiff member_diff;
+    member_diff.change = BTFDiffChange::Added;
+    member_diff.name = new_member.opt_name.value_or("");
+    member_diff.opt_new_type = new_member.type;
+    member_diff.opt_new_offset = new_member.offset;
+
+    member_diff_list.push_back(std::move(member_diff));
+  }
+
+  return std::nullopt;
+}
+
+void diffEnumValues(std::vector<BTFMemberDiff> &member_diff_list,
+                    const EnumBTFType &old_type, const EnumBTFType &new_type) {
+
+  std::unordered_map<std::string_view, std::size_t> new_value_map;
+  for (std::size_t i = 0; i < new_type.value_list.size(); ++i) {
+    new_value_map.insert({new_type.value_list[i].name, i});
+  }
+
+  std::vector<bool> matched_new_value_list(new_type.value_list.size());
+
+  for (const auto &old_value : old_type.value_list) {
+    BTFMemberDiff member_diff;
+    member_diff.name = old_value.name;
+    member_diff.opt_old_value = old_value.val;
+
+    auto new_value_it = new_value_map.find(old_value.name);
+    if (new_value_it == new_value_map.end()) {
+      member_diff.change = BTFDiffChange::Removed;
+      member_diff_list.push_back(std::move(member_diff));
+      continue;
+    }
+
+    matched_new_value_list[new_value_it->second] = true;
+
+    const auto &new_value = new_type.value_list[new_value_it->second];
+    if (new_value.val == old_value.val) {
+      continue;
+    }
+
+    member_diff.opt_new_value = new_value.val;
+    member_diff_list.push_back(std::move(member_diff));
+  }
+
+  for (std::size_t i = 0; i < new_type.value_list.size(); ++i) {
+    if (matched_new_value_list[i]) {
+      continue;
+    }
+
+    BTFMemberDiff member_diff;
+    member_diff.change = BTFDiffChange::Added;
+    member_diff.name = new_type.value_list[i].name;
+    member_diff.opt_new_value = new_type.value_list[i].val;
+
+    member_diff_list.push_back(std::move(member_diff));
+  }
+}
+
+std::optional<BTFTypeHasherError>
+diffTypes(BTFTypeDiff &type_diff, const IBTFTypeHasher &old_hasher,
+          const BTFType &old_type, const IBTFTypeHasher &new_hasher,
+          const BTFType &new_type) {
+
+  switch (type_diff.kind) {
+  case BTFKind::Struct:
+    return diffMembers(type_diff.member_diff_list, old_hasher,
+                       std::get<StructBTFType>(old_type), new_hasher,
+                       std::get<StructBTFType>(new_type));
+
+  case BTFKind::Union:
+    return diffMembers(type_diff.member_diff_list, old_hasher,
+                       std::get<UnionBTFType>(old_type), new_hasher,
+                       std::get<UnionBTFType>(new_type));
+
+  case BTFKind::Enum:
+    diffEnumValues(type_diff.member_diff_list,
+                   std::get<EnumBTFType>(old_type),
+                   std::get<EnumBTFType>(new_type));
+    break;
+
+  default:
+    break;
+  }
+
+  return std::nullopt;
+}
+
+// Types that are structurally the same are dropped first. When a name
+// is used by more than one type, the rest are then paired in ID order
+std::optional<BTFTypeHasherError>
+diffNamedTypes(BTFDiff &btf_diff, const NamedTypeKey &named_type_key,
+               const IBTFTypeHasher &old_hasher,
+               std::vector<std::uint32_t> old_id_list,
+               const IBTFTypeHasher &new_hasher,
+               std::vector<std::uint32_t> new_id_list) {
+
+  std::vector<std::uint64_t> new_hash_list;
+  for (auto new_id : new_id_list) {
+    auto hash_res = new_hasher.getHash(new_id);
+    if (hash_res.failed()) {
+      return hash_res.takeError();
+    }
+
+    new_hash_list.push_back(hash_res.takeValue());
+  }
+
+  std::vector<std::uint32_t> changed_old_id_list;
+  for (auto old_id : old_id_list) {
+    auto hash_res = old_hasher.getHash(old_id);
+    if (hash_res.failed()) {
+      return hash_res.takeError();
+    }
+
+    auto hash = hash_res.takeValue();
+
+    auto new_hash_it =
+        std::find(new_hash_list.begin(), new_hash_list.end(), hash);
+
+    if (new_hash_it == new_hash_list.end()) {
+      changed_old_id_list.push_back(old_id);
+      continue;
+    }
+
+    auto new_index =
+        static_cast<std::size_t>(new_hash_it - new_hash_list.begin());
+
+    new_hash_list.erase(new_hash_it);
+    new_id_list.erase(new_id_list.begin() +
+                      static_cast<std::ptrdiff_t>(new_index));
+  }
+
+  old_id_list = std::move(changed_old_id_list);
+
+  auto list_size = std::max(old_id_list.size(), new_id_list.size());
+  for (std::size_t i = 0; i < list_size; ++i) {
+    BTFTypeDiff type_diff;
+    type_diff.kind = named_type_key.first;
+    type_diff.name = named_type_key.second;
+
+    const BTFType *old_type{nullptr};
+    if (i < old_id_list.size()) {
+      type_diff.opt_old_id = old_id_list[i];
+
+      old_type = old_hasher.btf().getTypeRef(old_id_list[i]);
+      type_diff.opt_old_size = getTypeSize(*old_type);
+    }
+
+    const BTFType *new_type{nullptr};
+    if (i < new_id_list.size()) {
+      type_diff.opt_new_id = new_id_list[i];
+
+      new_type = new_hasher.btf().getTypeRef(new_id_list[i]);
+      type_diff.opt_new_size = getTypeSize(*new_type);
+    }
+
+    if (old_type == nullptr) {
+      type_diff.change = BTFDiffChange::Added;
+
+    } else if (new_type == nullptr) {
+      type_diff.change = BTFDiffChange::Removed;
+
+    } else {
+      auto opt_error =
+          diffTypes(type_diff, old_hasher, *old_type, new_hasher, *new_type);
+
+      if (opt_error.has_value()) {
+        return opt_error;
+      }
+    }
+
+    btf_diff.push_back(std::move(type_diff));
+  }
+
+  return std::nullopt;
+}
+
+} // namespace
+
+struct BTFTypeHasher::PrivateData final {
+  PrivateData(const IBTF &btf_ref) : btf(btf_ref) {}
+
+  const IBTF &btf;
+
+  std::mutex mutex;
+
+  // Indexed by type ID and then by hash mode
+  std::vector<NodeInfo> node_info_list;
+
+  // Work lists used by getNodeHash
+  struct WorkItem final {
+    Node node;
+    bool expanded{false};
+  };
+
+  std::vector<WorkItem> work_list;
+  std::vector<Node> dependency_list;
+};
+
+Result<IBTFTypeHasher::Ptr, BTFTypeHasherError>
+BTFTypeHasher::create(const IBTF &btf) noexcept {
+  try {
+    return Ptr(new BTFTypeHasher(btf));
+
+  } catch (const std::bad_alloc &) {
+    return BTFTypeHasherError(BTFTypeHasherErrorInformation{
+        BTFTypeHasherErrorInformation::Code::MemoryAllocationFailure,
+    });
+  }
+}
+
+Result<BTFDiff, BTFTypeHasherError>
+BTFTypeHasher::diff(const IBTFTypeHasher &old_hasher,
+                    const IBTFTypeHasher &new_hasher) noexcept {
+  try {
+    NamedTypeMap named_type_map;
+    collectNamedTypes(named_type_map, old_hasher.btf(), true);
+    collectNamedTypes(named_type_map, new_hasher.btf(), false);
+
+    BTFDiff btf_diff;
+    for (const auto &[named_type_key, id_list_pair] : named_type_map) {
+      auto opt_error =
+          diffNamedTypes(btf_diff, named_type_key, old_hasher,
+                         id_list_pair.old_id_list, new_hasher,
+                         id_list_pair.new_id_list);
+
+      if (opt_error.has_value()) {
+        return opt_error.value();
+      }
+    }
+
+    return btf_diff;
+
+  } catch (const std::bad_alloc &) {
+    return BTFTypeHasherError(BTFTypeHasherErrorInformation{
+        BTFTypeHasherErrorInformation::Code::MemoryAllocationFailure,
+    });
+  }
+}
+
+BTFTypeHasher::~BTFTypeHasher() {}
+
+Result<std::uint64_t, BTFTypeHasherError>
+BTFTypeHasher::getHash(std::uint32_t id) const noexcept {
+  std::lock_guard<std::mutex> lock(d->mutex);
+
+  if (static_cast<std::size_t>(id) * 2 >= d->node_info_list.size()) {
+    return getInvalidTypeIDError(id);
+  }
+
+  try {
+    return getNodeHash(Node{id, HashMode::Value});
+
+  } catch (const std::bad_alloc &) {
+    return BTFTypeHasherError(BTFTypeHasherErrorInformation{
+        BTFTypeHasherErrorInformation::Code::MemoryAllocationFailure,
+    });
+  }
+}
+
+const IBTF &BTFTypeHasher::btf() const noexcept { return d->btf; }
+
+BTFTypeHasher::BTFTypeHasher(const IBTF &btf) : d(new PrivateData(btf)) {
+  auto type_count = static_cast<std::size_t>(btf.count()) + 1U;
+  d->node_info_list.resize(type_count * 2);
+}
+
+BTFTypeHasher::NodeInfo &BTFTypeHasher::getNodeInfo(const Node &node) const {
+  return d->node_info_list[static_cast<std::size_t>(node.id) * 2 +
+                           static_cast<std::size_t>(node.mode)];
+}
+
+std::uint64_t BTFTypeHasher::getNodeHash(const Node &node) const {
+  const auto &root_node_info = getNodeInfo(node);
+  if (root_node_info.state == NodeInfo::State::Hashed) {
+    return root_node_info.hash;
+  }
+
+  // Children are always hashed before their parents. The ones that are
+  // still being expanded when they are reached again form a cycle
+  auto &work_list = d->work_list;
+  work_list.clear();
+  work_list.push_back({node, false});
+
+  while (!work_list.empty()) {
+    auto work_item = work_list.back();
+
+    auto &node_info = getNodeInfo(work_item.node);
+    if (node_info.state == NodeInfo::State::Hashed) {
+      work_list.pop_back();
+      continue;
+    }
+
+    if (!work_item.expanded) {
+      work_list.back().expanded = true;
+      node_info.state = NodeInfo::State::Expanding;
+
+      d->dependency_list.clear();
+      getDependencyList(d->dependency_list, work_item.node);
+
+      for (const auto &dependency : d->dependency_list) {
+        if (getNodeInfo(dependency).state == NodeInfo::State::Unvisited) {
+          work_list.push_back({dependency, false});
+        }
+      }
+
+      continue;
+    }
+
+    work_list.pop_back();
+
+    node_info.hash = computeNodeHash(work_item.node);
+    node_info.state = NodeInfo::State::Hashed;
+  }
+
+  return root_node_info.hash;
+}
+
+void BTFTypeHasher::getDependencyList(std::vector<Node> &dependency_list,
+                                      const Node &node) const {
+  const auto *btf_type = d->btf.getTypeRef(node.id);
+  if (btf_type == nullptr) {
+    return;
+  }
+
+  auto kind = IBTF::getBTFTypeKind(*btf_type);
+
+  if (node.mode == HashMode::Reference) {
+    BTFKind named_kind;
+    std::string_view name;
+    if (getNamedReference(named_kind, name, *btf_type)) {
+      return;
+    }
+
+    if (!isReferenceTransparent(kind)) {
+      dependency_list.push_back({node.id, HashMode::Value});
+      return;
+    }
+  }
+
+  auto child_mode = (node.mode == HashMode::Reference || kind == BTFKind::Ptr)
+                        ? HashMode::Reference
+                        : HashMode::Value;
+
+  auto add_child = [&](std::uint32_t child_id) {
+    if (static_cast<std::size_t>(child_id) * 2 < d->node_info_list.size()) {
+      dependency_list.push_back({child_id, child_mode});
+    }
+  };
+
+  std::visit(
+      [&](const auto &type) {
+        using Type = std::decay_t<decltype(type)>;
+
+        if constexpr (std::is_same_v<Type, PtrBTFType> ||
+                      std::is_same_v<Type, ConstBTFType> ||
+                      std::is_same_v<Type, VolatileBTFType> ||
+                      std::is_same_v<Type, RestrictBTFType> ||
+                      std::is_same_v<Type, TypedefBTFType> ||
+                      std::is_same_v<Type, FuncBTFType> ||
+                      std::is_same_v<Type, VarBTFType>) {
+          add_child(type.type);
+
+        } else if constexpr (std::is_same_v<Type, ArrayBTFType>) {
+          add_child(type.type);
+          add_child(type.index_type);
+
+        } else if constexpr (std::is_same_v<Type, StructBTFType> ||
+                             std::is_same_v<Type, UnionBTFType>) {
+          for (const auto &member : type.member_list) {
+            add_child(member.type);
+          }
+
+        } else if constexpr (std::is_same_v<Type, FuncProtoBTFType>) {
+          add_child(type.return_type);
+          for (const auto &param : type.param_list) {
+            add_child(param.type);
+          }
+
+        } else if constexpr (std::is_same_v<Type, DataSecBTFType>) {
+          for (const auto &variable : type.variable_list) {
+            add_child(variable.type);
+          }
+        }
+      },
+      *btf_type);
+}
+
+std::uint64_t BTFTypeHasher::computeNodeHash(const Node &node) const {
+  FNV1aHash hash;
+
+  const auto *btf_type = d->btf.getTypeRef(node.id);
+  if (btf_type == nullptr) {
+    hash.update(static_cast<std::uint64_t>(BTFKind::Void));
+    return hash.value();
+  }
+
+  auto kind = IBTF::getBTFTypeKind(*btf_type);
+
+  if (node.mode == HashMode::Reference) {
+    BTFKind named_kind;
+    std::string_view name;
+    if (getNamedReference(named_kind, name, *btf_type)) {
+      hash.update(kNamedReferenceMarker);
+      hash.update(static_cast<std::uint64_t>(named_kind));
+      hash.update(name);
+
+      return hash.value();
+    }
+
+    if (!isReferenceTransparent(kind)) {
+      return getDependencyHash({node.id, HashMode::Value});
+    }
+  }
+
+  auto child_mode = (node.mode == HashMode::Reference || kind == BTFKind::Ptr)
+                        ? HashMode::Reference
+                        : HashMode::Value;
+
+  auto update_child = [&](std::uint32_t child_id) {
+    hash.update(getDependencyHash({child_id, child_mode}));
+  };
+
+  hash.update(static_cast<std::uint64_t>(kind));
+
+  std::visit(
+      [&](const auto &type) {
+        using Type = std::decay_t<decltype(type)>;
+
+        if constexpr (std::is_same_v<Type, IntBTFType>) {
+          hash.update(type.name);
+          hash.update(type.size);
+          hash.update(static_cast<std::uint64_t>(type.encoding));
+          hash.update(type.offset);
+          hash.update(type.bits);
+
+        } else if constexpr (std::is_same_v<Type, PtrBTFType> ||
+                             std::is_same_v<Type, ConstBTFType> ||
+                             std::is_same_v<Type, VolatileBTFType> ||
+                             std::is_same_v<Type, RestrictBTFType>) {
+          update_child(type.type);
+
+        } else if constexpr (std::is_same_v<Type, ArrayBTFType>) {
+          hash.update(type.nelems);
+          update_child(type.type);
+          update_child(type.index_type);
+
+        } else if constexpr (std::is_same_v<Type, TypedefBTFType>) {
+          hash.update(type.name);
+          update_child(type.type);
+
+        } else if constexpr (std::is_same_v<Type, EnumBTFType>) {
+          updateName(hash, type.opt_name);
+          hash.update(type.size);
+
+          hash.update(static_cast<std::uint64_t>(type.value_list.size()));
+          for (const auto &value : type.value_list) {
+            hash.update(value.name);
+            hash.update(static_cast<std::uint64_t>(value.val));
+          }
+
+        } else if constexpr (std::is_same_v<Type, StructBTFType> ||
+                             std::is_same_v<Type, UnionBTFType>) {
+          updateName(hash, type.opt_name);
+          hash.update(type.size);
+
+          hash.update(static_cast<std::uint64_t>(type.member_list.size()));
+          for (const auto &member : type.member_list) {
+            updateName(hash, member.opt_name);
+            hash.update(member.offset);
+            hash.update(member.opt_bitfield_size.has_value()
+                            ? member.opt_bitfield_size.value() + 1U
+                            : 0U);
+
+            update_child(member.type);
+          }
+
+        } else if constexpr (std::is_same_v<Type, FuncProtoBTFType>) {
+          update_child(type.return_type);
+          hash.update(static_cast<std::uint64_t>(type.is_variadic));
+
+          hash.update(static_cast<std::uint64_t>(type.param_list.size()));
+          for (const auto &param : type.param_list) {
+            update_child(param.type);
+          }
+
+        } else if constexpr (std::is_same_v<Type, FwdBTFType>) {
+          hash.update(type.name);
+          hash.update(static_cast<std::uint64_t>(type.is_union));
+
+        } else if constexpr (std::is_same_v<Type, FuncBTFType>) {
+          hash.update(type.name);
+          hash.update(static_cast<std::uint64_t>(type.linkage));
+          update_child(type.type);
+
+        } else if constexpr (std::is_same_v<Type, FloatBTFType>) {
+          hash.update(type.name);
+          hash.update(type.size);
+
+        } else if constexpr (std::is_same_v<Type, VarBTFType>) {
+          hash.update(type.name);
+          hash.update(type.linkage);
+          update_child(type.type);
+
+        } else if constexpr (std::is_same_v<Type, DataSecBTFType>) {
+          hash.update(type.name);
+          hash.update(type.size);
+
+          hash.update(static_cast<std::uint64_t>(type.variable_list.size()));
+          for (const auto &variable : type.variable_list) {
+            hash.update(variable.offset);
+            hash.update(variable.size);
+            update_child(variable.type);
+          }
+        }
+      },
+      *btf_type);
+
+  return hash.value();
+}
+
+std::uint64_t BTFTypeHasher::getDependencyHash(const Node &node) const {
+  if (static_cast<std::size_t>(node.id) * 2 >= d->node_info_list.size()) {
+    return kInvalidTypeMarker;
+  }
+
+  const auto &node_info = getNodeInfo(node);
+  if (node_info.state != NodeInfo::State::Hashed) {
+    return kCycleMarker;
+  }
+
+  return node_info.hash;
+}
+
+} // namespace btfparse
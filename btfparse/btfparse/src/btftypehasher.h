@@ -0,0 +1,73 @@
+//
+// Copyright (c) 2021-present, Trail of Bits, Inc.
+// All rights reserved.
+//
+// This source code is licensed in accordance with the terms specified in
+// the LICENSE file found in the root directory of this source tree.
+//
+
+#pragma once
+
+#include <btfparse/ibtftypehasher.h>
+
+namespace btfparse {
+
+class BTFTypeHasher final : public IBTFTypeHasher {
+public:
+  static Result<IBTFTypeHasher::Ptr, BTFTypeHasherError>
+  create(const IBTF &btf) noexcept;
+
+  static Result<BTFDiff, BTFTypeHasherError>
+  diff(const IBTFTypeHasher &old_hasher,
+       const IBTFTypeHasher &new_hasher) noexcept;
+
+  virtual ~BTFTypeHasher() override;
+
+  virtual Result<std::uint64_t, BTFTypeHasherError>
+  getHash(std::uint32_t id) const noexcept override;
+
+  virtual const IBTF &btf() const noexcept override;
+
+private:
+  struct PrivateData;
+  std::unique_ptr<PrivateData> d;
+
+  BTFTypeHasher(const IBTF &btf);
+
+public:
+  // Each type is hashed twice: by value, and as seen through a pointer.
+  // The latter stops at the named structs, unions and enums
+  enum class HashMode : std::uint8_t {
+    Value,
+    Reference,
+  };
+
+  struct Node final {
+    std::uint32_t id{};
+    HashMode mode{HashMode::Value};
+  };
+
+  struct NodeInfo final {
+    enum class State : std::uint8_t {
+      Unvisited,
+      Expanding,
+      Hashed,
+    };
+
+    State state{State::Unvisited};
+    std::uint64_t hash{};
+  };
+
+  // The methods below must be called with the mutex held
+
+  NodeInfo &getNodeInfo(const Node &node) const;
+  std::uint64_t getNodeHash(const Node &node) const;
+
+  void getDependencyList(std::vector<Node> &dependency_list,
+                         const Node &node) const;
+
+  std::uint64_t computeNodeHash(const Node &node) const;
+  std::uint64_t getDependencyHash(const Node &node) const;
+};
+
+} // namespace btfparse
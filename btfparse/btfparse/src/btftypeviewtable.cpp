@@ -0,0 +1,438 @@
+//
+// Copyright (c) 2021-present, Trail of Bits, Inc.
+// All rights reserved.
+//
+// This source code is licensed in accordance with the terms specified in
+// the LICENSE file found in the root directory of this source tree.
+//
+
+#include "btftypeviewtable.h"
+
+namespace btfparse {
+
+namespace {
+
+template <typename Element>
+void appendElement(std::vector<Element> &block, BTFViewList<Element> &list,
+                   const Element &element) {
+  // The capacity has been reserved by reset(), so this never reallocates
+  block.push_back(element);
+
+  const auto *list_data = list.empty() ? &block.back() : list.begin();
+  list = BTFViewList<Element>(list_data, list.size() + 1);
+}
+
+std::optional<std::string_view>
+createOptionalNameView(const std::optional<std::string> &opt_name) {
+  if (!opt_name.has_value()) {
+    return std::nullopt;
+  }
+
+  return std::string_view(opt_name.value());
+}
+
+std::optional<std::string>
+createOptionalName(const std::optional<std::string_view> &opt_name) {
+  if (!opt_name.has_value()) {
+    return std::nullopt;
+  }
+
+  return std::string(opt_name.value());
+}
+
+template <typename ViewType, typename Type>
+ViewType createAggregateView(BTFTypeViewTable &table, const Type &btf_type) {
+  ViewType output;
+  output.opt_name = createOptionalNameView(btf_type.opt_name);
+  output.size = btf_type.size;
+
+  for (const auto &member : btf_type.member_list) {
+    StructBTFTypeView::Member member_view;
+    member_view.opt_name = createOptionalNameView(member.opt_name);
+    member_view.type = member.type;
+    member_view.offset = member.offset;
+    member_view.opt_bitfield_size = member.opt_bitfield_size;
+
+    table.append(output.member_list, member_view);
+  }
+
+  return output;
+}
+
+template <typename Type, typename ViewType>
+Type createAggregate(const ViewType &btf_type_view) {
+  Type output;
+  output.opt_name = createOptionalName(btf_type_view.opt_name);
+  output.size = btf_type_view.size;
+  output.member_list.reserve(btf_type_view.member_list.size());
+
+  for (const auto &member_view : btf_type_view.member_list) {
+    typename Type::Member member;
+    member.opt_name = createOptionalName(member_view.opt_name);
+    member.type = member_view.type;
+    member.offset = member_view.offset;
+    member.opt_bitfield_size = member_view.opt_bitfield_size;
+
+    output.member_list.push_back(std::move(member));
+  }
+
+  return output;
+}
+
+} // namespace
+
+void BTFTypeViewTable::addTypeCapacity(Capacity &capacity, BTFKind kind,
+                                       std::size_t vlen) noexcept {
+  ++capacity.type_count;
+
+  switch (kind) {
+  case BTFKind::Struct:
+  case BTFKind::Union:
+    capacity.member_count += vlen;
+    break;
+
+  case BTFKind::Enum:
+    capacity.enum_value_count += vlen;
+    break;
+
+  case BTFKind::FuncProto:
+    capacity.param_count += vlen;
+    break;
+
+  case BTFKind::DataSec:
+    capacity.variable_count += vlen;
+    break;
+
+  default:
+    break;
+  }
+}
+
+void BTFTypeViewTable::reset(const Capacity &capacity) {
+  view_list.clear();
+  member_block.clear();
+  enum_value_block.clear();
+  param_block.clear();
+  variable_block.clear();
+
+  view_list.reserve(capacity.type_count);
+  member_block.reserve(capacity.member_count);
+  enum_value_block.reserve(capacity.enum_value_count);
+  param_block.reserve(capacity.param_count);
+  variable_block.reserve(capacity.variable_count);
+}
+
+void BTFTypeViewTable::push(const BTFTypeView &btf_type_view) {
+  view_list.push_back(btf_type_view);
+}
+
+void BTFTypeViewTable::append(StructBTFTypeView::MemberList &list,
+                              const StructBTFTypeView::Member &member) {
+  appendElement(member_block, list, member);
+}
+
+void BTFTypeViewTable::append(EnumBTFTypeView::ValueList &list,
+                              const EnumBTFTypeView::Value &value) {
+  appendElement(enum_value_block, list, value);
+}
+
+void BTFTypeViewTable::append(FuncProtoBTFTypeView::ParamList &list,
+                              const FuncProtoBTFTypeView::Param &param) {
+  appendElement(param_block, list, param);
+}
+
+void BTFTypeViewTable::append(DataSecBTFTypeView::VariableList &list,
+                              const DataSecBTFTypeView::Variable &variable) {
+  appendElement(variable_block, list, variable);
+}
+
+void BTFTypeViewTable::popBack(
+    FuncProtoBTFTypeView::ParamList &list) noexcept {
+  param_block.pop_back();
+  list = FuncProtoBTFTypeView::ParamList(list.begin(), list.size() - 1);
+}
+
+std::size_t BTFTypeViewTable::size() const noexcept {
+  return view_list.size();
+}
+
+const BTFTypeView &
+BTFTypeViewTable::operator[](std::size_t index) const noexcept {
+  return view_list[index];
+}
+
+BTFTypeView BTFTypeViewTable::createView(const BTFType &btf_type) {
+  switch (IBTF::getBTFTypeKind(btf_type)) {
+  case BTFKind::Void:
+    return std::monostate{};
+
+  case BTFKind::Int: {
+    const auto &int_btf_type = std::get<IntBTFType>(btf_type);
+
+    IntBTFTypeView output;
+    output.name = int_btf_type.name;
+    output.size = int_btf_type.size;
+    output.encoding = int_btf_type.encoding;
+    output.offset = int_btf_type.offset;
+    output.bits = int_btf_type.bits;
+
+    return output;
+  }
+
+  case BTFKind::Ptr:
+    return std::get<PtrBTFType>(btf_type);
+
+  case BTFKind::Array:
+    return std::get<ArrayBTFType>(btf_type);
+
+  case BTFKind::Struct:
+    return createAggregateView<StructBTFTypeView>(
+        *this, std::get<StructBTFType>(btf_type));
+
+  case BTFKind::Union:
+    return createAggregateView<UnionBTFTypeView>(
+        *this, std::get<UnionBTFType>(btf_type));
+
+  case BTFKind::Enum: {
+    const auto &enum_btf_type = std::get<EnumBTFType>(btf_type);
+
+    EnumBTFTypeView output;
+    output.opt_name = createOptionalNameView(enum_btf_type.opt_name);
+    output.size = enum_btf_type.size;
+
+    for (const auto &value : enum_btf_type.value_list) {
+      append(output.value_list, {value.name, value.val});
+    }
+
+    return output;
+  }
+
+  case BTFKind::Fwd: {
+    const auto &fwd_btf_type = std::get<FwdBTFType>(btf_type);
+    return FwdBTFTypeView{fwd_btf_type.name, fwd_btf_type.is_union};
+  }
+
+  case BTFKind::Typedef: {
+    const auto &typedef_btf_type = std::get<TypedefBTFType>(btf_type);
+    return TypedefBTFTypeView{typedef_btf_type.name, typedef_btf_type.type};
+  }
+
+  case BTFKind::Volatile:
+    return std::get<VolatileBTFType>(btf_type);
+
+  case BTFKind::Const:
+    return std::get<ConstBTFType>(btf_type);
+
+  case BTFKind::Restrict:
+    return std::get<RestrictBTFType>(btf_type);
+
+  case BTFKind::Func: {
+    const auto &func_btf_type = std::get<FuncBTFType>(btf_type);
+    return FuncBTFTypeView{func_btf_type.name, func_btf_type.type,
+                           func_btf_type.linkage};
+  }
+
+  case BTFKind::FuncProto: {
+    const auto &func_proto_btf_type = std::get<FuncProtoBTFType>(btf_type);
+
+    FuncProtoBTFTypeView output;
+    output.return_type = func_proto_btf_type.return_type;
+    output.is_variadic = func_proto_btf_type.is_variadic;
+
+    for (const auto &param : func_proto_btf_type.param_list) {
+      append(output.param_list,
+             {createOptionalNameView(param.opt_name), param.type});
+    }
+
+    return output;
+  }
+
+  case BTFKind::Var: {
+    const auto &var_btf_type = std::get<VarBTFType>(btf_type);
+    return VarBTFTypeView{var_btf_type.name, var_btf_type.type,
+                          var_btf_type.linkage};
+  }
+
+  case BTFKind::DataSec: {
+    const auto &data_sec_btf_type = std::get<DataSecBTFType>(btf_type);
+
+    DataSecBTFTypeView output;
+    output.name = data_sec_btf_type.name;
+    output.size = data_sec_btf_type.size;
+
+    for (const auto &variable : data_sec_btf_type.variable_list) {
+      append(output.variable_list, variable);
+    }
+
+    return output;
+  }
+
+  case BTFKind::Float: {
+    const auto &float_btf_type = std::get<FloatBTFType>(btf_type);
+    return FloatBTFTypeView{float_btf_type.name, float_btf_type.size};
+  }
+  }
+
+  return std::monostate{};
+}
+
+BTFType BTFTypeViewTable::createType(const BTFTypeView &btf_type_view) {
+  switch (IBTF::getBTFTypeKind(btf_type_view)) {
+  case BTFKind::Void:
+    return std::monostate{};
+
+  case BTFKind::Int: {
+    const auto &int_view = std::get<IntBTFTypeView>(btf_type_view);
+
+    IntBTFType output;
+    output.name = int_view.name;
+    output.size = int_view.size;
+    output.encoding = int_view.encoding;
+    output.offset = int_view.offset;
+    output.bits = int_view.bits;
+
+    return output;
+  }
+
+  case BTFKind::Ptr:
+    return std::get<PtrBTFType>(btf_type_view);
+
+  case BTFKind::Array:
+    return std::get<ArrayBTFType>(btf_type_view);
+
+  case BTFKind::Struct:
+    return createAggregate<StructBTFType>(
+        std::get<StructBTFTypeView>(btf_type_view));
+
+  case BTFKind::Union:
+    return createAggregate<UnionBTFType>(
+        std::get<UnionBTFTypeView>(btf_type_view));
+
+  case BTFKind::Enum: {
+    const auto &enum_view = std::get<EnumBTFTypeView>(btf_type_view);
+
+    EnumBTFType output;
+    output.opt_name = createOptionalName(enum_view.opt_name);
+    output.size = enum_view.size;
+    output.value_list.reserve(enum_view.value_list.size());
+
+    for (const auto &value : enum_view.value_list) {
+      output.value_list.push_back({std::string(value.name), value.val});
+    }
+
+    return output;
+  }
+
+  case BTFKind::Fwd: {
+    const auto &fwd_view = std::get<FwdBTFTypeView>(btf_type_view);
+    return FwdBTFType{std::string(fwd_view.name), fwd_view.is_union};
+  }
+
+  case BTFKind::Typedef: {
+    const auto &typedef_view = std::get<TypedefBTFTypeView>(btf_type_view);
+    return TypedefBTFType{std::string(typedef_view.name), typedef_view.type};
+  }
+
+  case BTFKind::Volatile:
+    return std::get<VolatileBTFType>(btf_type_view);
+
+  case BTFKind::Const:
+    return std::get<ConstBTFType>(btf_type_view);
+
+  case BTFKind::Restrict:
+    return std::get<RestrictBTFType>(btf_type_view);
+
+  case BTFKind::Func: {
+    const auto &func_view = std::get<FuncBTFTypeView>(btf_type_view);
+    return FuncBTFType{std::string(func_view.name), func_view.type,
+                       func_view.linkage};
+  }
+
+  case BTFKind::FuncProto: {
+    const auto &func_proto_view =
+        std::get<FuncProtoBTFTypeView>(btf_type_view);
+
+    FuncProtoBTFType output;
+    output.return_type = func_proto_view.return_type;
+    output.is_variadic = func_proto_view.is_variadic;
+    output.param_list.reserve(func_proto_view.param_list.size());
+
+    for (const auto &param : func_proto_view.param_list) {
+      output.param_list.push_back(
+          {createOptionalName(param.opt_name), param.type});
+    }
+
+    return output;
+  }
+
+  case BTFKind::Var: {
+    const auto &var_view = std::get<VarBTFTypeView>(btf_type_view);
+    return VarBTFType{std::string(var_view.name), var_view.type,
+                      var_view.linkage};
+  }
+
+  case BTFKind::DataSec: {
+    const auto &data_sec_view = std::get<DataSecBTFTypeView>(btf_type_view);
+
+    DataSecBTFType output;
+    output.name = data_sec_view.name;
+    output.size = data_sec_view.size;
+    output.variable_list.assign(data_sec_view.variable_list.begin(),
+                                data_sec_view.variable_list.end());
+
+    return output;
+  }
+
+  case BTFKind::Float: {
+    const auto &float_view = std::get<FloatBTFTypeView>(btf_type_view);
+    return FloatBTFType{std::string(float_view.name), float_view.size};
+  }
+  }
+
+  return std::monostate{};
+}
+
+void BTFTypeViewTable::build(const IBTF &btf, std::uint32_t first_id,
+                             std::uint32_t last_id) {
+  Capacity capacity;
+
+  for (auto id = first_id; id <= last_id; ++id) {
+    const auto *btf_type = btf.getTypeRef(id);
+    if (btf_type == nullptr) {
+      ++capacity.type_count;
+      continue;
+    }
+
+    std::size_t element_count{};
+    std::visit(
+        [&element_count](const auto &concrete_type) {
+          using Type = std::decay_t<decltype(concrete_type)>;
+
+          if constexpr (std::is_same_v<Type, StructBTFType> ||
+                        std::is_same_v<Type, UnionBTFType>) {
+            element_count = concrete_type.member_list.size();
+
+          } else if constexpr (std::is_same_v<Type, EnumBTFType>) {
+            element_count = concrete_type.value_list.size();
+
+          } else if constexpr (std::is_same_v<Type, FuncProtoBTFType>) {
+            element_count = concrete_type.param_list.size();
+
+          } else if constexpr (std::is_same_v<Type, DataSecBTFType>) {
+            element_count = concrete_type.variable_list.size();
+          }
+        },
+        *btf_type);
+
+    addTypeCapacity(capacity, IBTF::getBTFTypeKind(*btf_type), element_count);
+  }
+
+  reset(capacity);
+
+  for (auto id = first_id; id <= last_id; ++id) {
+    const auto *btf_type = btf.getTypeRef(id);
+    push(btf_type != nullptr ? createView(*btf_type) : std::monostate{});
+  }
+}
+
+} // namespace btfparse
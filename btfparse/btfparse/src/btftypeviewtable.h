@@ -0,0 +1,80 @@
+//
+// Copyright (c) 2021-present, Trail of Bits, Inc.
+// All rights reserved.
+//
+// This source code is licensed in accordance with the terms specified in
+// the LICENSE file found in the root directory of this source tree.
+//
+
+#pragma once
+
+#include <btfparse/ibtf.h>
+
+#include <vector>
+
+namespace btfparse {
+
+// Storage for BTFTypeView objects. The lists of all the views are appended
+// to one block per element type. The blocks are sized when the table is
+// reset and never reallocated, so the lists that point inside them remain
+// valid as long as the table is alive and not reset again
+class BTFTypeViewTable final {
+public:
+  struct Capacity final {
+    std::size_t type_count{};
+    std::size_t member_count{};
+    std::size_t enum_value_count{};
+    std::size_t param_count{};
+    std::size_t variable_count{};
+  };
+
+  // Adds the storage needed by a type with the given kind and vlen
+  static void addTypeCapacity(Capacity &capacity, BTFKind kind,
+                              std::size_t vlen) noexcept;
+
+  // Removes all the views, and reserves the given capacity. The views
+  // and elements added afterwards must fit in it
+  void reset(const Capacity &capacity);
+
+  void push(const BTFTypeView &btf_type_view);
+
+  void append(StructBTFTypeView::MemberList &list,
+              const StructBTFTypeView::Member &member);
+
+  void append(EnumBTFTypeView::ValueList &list,
+              const EnumBTFTypeView::Value &value);
+
+  void append(FuncProtoBTFTypeView::ParamList &list,
+              const FuncProtoBTFTypeView::Param &param);
+
+  void append(DataSecBTFTypeView::VariableList &list,
+              const DataSecBTFTypeView::Variable &variable);
+
+  // Removes the last element of the list, which must be the last one that
+  // was appended to the table
+  void popBack(FuncProtoBTFTypeView::ParamList &list) noexcept;
+
+  std::size_t size() const noexcept;
+  const BTFTypeView &operator[](std::size_t index) const noexcept;
+
+  // Creates the view of an owned type, which must outlive the view. The
+  // lists are appended to the table, but the view is not pushed
+  BTFTypeView createView(const BTFType &btf_type);
+
+  // Creates an owned copy of the given view
+  static BTFType createType(const BTFTypeView &btf_type_view);
+
+  // Creates the views of the given IDs. Invalid types are stored as
+  // std::monostate
+  void build(const IBTF &btf, std::uint32_t first_id, std::uint32_t last_id);
+
+private:
+  std::vector<BTFTypeView> view_list;
+
+  std::vector<StructBTFTypeView::Member> member_block;
+  std::vector<EnumBTFTypeView::Value> enum_value_block;
+  std::vector<FuncProtoBTFTypeView::Param> param_block;
+  std::vector<DataSecBTFTypeView::Variable> variable_block;
+};
+
+} // namespace btfparse
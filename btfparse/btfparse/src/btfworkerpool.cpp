@@ -0,0 +1,248 @@
+//
+// Copyright (c) 2021-present, Trail of Bits, Inc.
+// All rights reserved.
+//
+// This source code is licensed in accordance with the terms specified in
+// the LICENSE file found in the root directory of this source tree.
+//
+
+#include "btfworkerpool.h"
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <system_error>
+#include <thread>
+
+namespace btfparse {
+
+namespace {
+
+// Set on the worker threads, so that nested run() calls queue their
+// tasks on the worker that made them
+thread_local const BTFWorkerPool *current_worker_pool{nullptr};
+thread_local std::size_t current_worker_index{};
+
+} // namespace
+
+// The tasks of a single run() call. It lives on the stack of the caller,
+// which only returns once pending_task_count has been decremented to 0
+// with the mutex held
+struct BTFWorkerPool::Batch final {
+  std::atomic_size_t pending_task_count{};
+
+  std::mutex mutex;
+  std::condition_variable completed;
+};
+
+struct BTFWorkerPool::QueuedTask final {
+  const std::function<void()> *task{nullptr};
+  Batch *batch{nullptr};
+};
+
+struct BTFWorkerPool::PrivateData final {
+  struct WorkerQueue final {
+    std::mutex mutex;
+    std::deque<QueuedTask> task_queue;
+  };
+
+  // One queue for each worker. Tasks queued from other threads are
+  // spread over all of them
+  std::vector<std::unique_ptr<WorkerQueue>> worker_queue_list;
+  std::atomic_size_t next_queue_index{};
+
+  std::vector<std::thread> thread_list;
+
+  // Incremented before the tasks are queued, so that a worker that finds
+  // it at 0 can safely go to sleep
+  std::atomic_size_t queued_task_count{};
+
+  std::mutex wakeup_mutex;
+  std::condition_variable wakeup;
+  bool stopping{false};
+};
+
+BTFWorkerPool::~BTFWorkerPool() {
+  {
+    std::lock_guard<std::mutex> lock(d->wakeup_mutex);
+    d->stopping = true;
+  }
+
+  d->wakeup.notify_all();
+
+  for (auto &thread : d->thread_list) {
+    thread.join();
+  }
+}
+
+std::size_t BTFWorkerPool::threadCount() const noexcept {
+  return d->thread_list.size();
+}
+
+void BTFWorkerPool::run(const BTFOptions::TaskList &task_list) {
+  if (task_list.empty()) {
+    return;
+  }
+
+  if (d->thread_list.empty()) {
+    for (const auto &task : task_list) {
+      task();
+    }
+
+    return;
+  }
+
+  Batch batch;
+  batch.pending_task_count = task_list.size();
+
+  auto opt_worker_index = getCurrentWorkerIndex();
+  d->queued_task_count += task_list.size();
+
+  if (opt_worker_index.has_value()) {
+    auto &worker_queue = *d->worker_queue_list[opt_worker_index.value()];
+
+    std::lock_guard<std::mutex> lock(worker_queue.mutex);
+    for (const auto &task : task_list) {
+      worker_queue.task_queue.push_back(QueuedTask{&task, &batch});
+    }
+
+  } else {
+    for (const auto &task : task_list) {
+      auto queue_index =
+          d->next_queue_index++ % d->worker_queue_list.size();
+
+      auto &worker_queue = *d->worker_queue_list[queue_index];
+
+      std::lock_guard<std::mutex> lock(worker_queue.mutex);
+      worker_queue.task_queue.push_back(QueuedTask{&task, &batch});
+    }
+  }
+
+  {
+    std::lock_guard<std::mutex> lock(d->wakeup_mutex);
+  }
+
+  d->wakeup.notify_all();
+
+  // Help until there is nothing left to take; the remaining tasks of
+  // this batch are then already running on other threads
+  QueuedTask queued_task;
+  while (batch.pending_task_count > 0 &&
+         tryTakeTask(queued_task, opt_worker_index)) {
+    runTask(queued_task);
+  }
+
+  std::unique_lock<std::mutex> lock(batch.mutex);
+  batch.completed.wait(lock,
+                       [&batch]() { return batch.pending_task_count == 0; });
+}
+
+BTFWorkerPool::BTFWorkerPool(std::size_t thread_count)
+    : d(new PrivateData) {
+  if (thread_count == 0) {
+    thread_count = std::max(std::thread::hardware_concurrency(), 1U);
+  }
+
+  for (std::size_t i = 0; i < thread_count; ++i) {
+    d->worker_queue_list.push_back(
+        std::make_unique<PrivateData::WorkerQueue>());
+  }
+
+  // The queues of the workers that could not be started are kept: the
+  // other workers steal from them
+  for (std::size_t i = 0; i < thread_count; ++i) {
+    try {
+      d->thread_list.emplace_back(&BTFWorkerPool::workerLoop, this, i);
+
+    } catch (const std::system_error &) {
+      break;
+    }
+  }
+}
+
+void BTFWorkerPool::workerLoop(std::size_t worker_index) {
+  current_worker_pool = this;
+  current_worker_index = worker_index;
+
+  QueuedTask queued_task;
+
+  for (;;) {
+    if (tryTakeTask(queued_task, worker_index)) {
+      runTask(queued_task);
+      continue;
+    }
+
+    std::unique_lock<std::mutex> lock(d->wakeup_mutex);
+    d->wakeup.wait(lock, [this]() {
+      return d->stopping || d->queued_task_count > 0;
+    });
+
+    if (d->stopping && d->queued_task_count == 0) {
+      break;
+    }
+  }
+}
+
+std::optional<std::size_t> BTFWorkerPool::getCurrentWorkerIndex() const {
+  if (current_worker_pool != this) {
+    return std::nullopt;
+  }
+
+  return current_worker_index;
+}
+
+bool BTFWorkerPool::tryTakeTask(
+    QueuedTask &queued_task,
+    const std::optional<std::size_t> &opt_worker_index) {
+
+  if (d->queued_task_count == 0) {
+    return false;
+  }
+
+  auto queue_count = d->worker_queue_list.size();
+  auto first_queue_index = opt_worker_index.value_or(0);
+
+  // The newest task of our own queue is the most likely one to still be
+  // in the cache. Other queues are stolen from the front, which holds the
+  // oldest and usually largest tasks
+  for (std::size_t i = 0; i < queue_count; ++i) {
+    auto queue_index = (first_queue_index + i) % queue_count;
+    auto own_queue = opt_worker_index.has_value() && i == 0;
+
+    auto &worker_queue = *d->worker_queue_list[queue_index];
+
+    std::lock_guard<std::mutex> lock(worker_queue.mutex);
+    if (worker_queue.task_queue.empty()) {
+      continue;
+    }
+
+    if (own_queue) {
+      queued_task = worker_queue.task_queue.back();
+      worker_queue.task_queue.pop_back();
+
+    } else {
+      queued_task = worker_queue.task_queue.front();
+      worker_queue.task_queue.pop_front();
+    }
+
+    --d->queued_task_count;
+    return true;
+  }
+
+  return false;
+}
+
+void BTFWorkerPool::runTask(const QueuedTask &queued_task) {
+  (*queued_task.task)();
+
+  auto &batch = *queued_task.batch;
+
+  std::lock_guard<std::mutex> lock(batch.mutex);
+  if (--batch.pending_task_count == 0) {
+    batch.completed.notify_all();
+  }
+}
+
+} // namespace btfparse
@@ -0,0 +1,45 @@
+//
+// Copyright (c) 2021-present, Trail of Bits, Inc.
+// All rights reserved.
+//
+// This source code is licensed in accordance with the terms specified in
+// the LICENSE file found in the root directory of this source tree.
+//
+
+#pragma once
+
+#include <btfparse/ibtfworkerpool.h>
+
+#include <optional>
+
+namespace btfparse {
+
+class BTFWorkerPool final : public IBTFWorkerPool {
+public:
+  virtual ~BTFWorkerPool() override;
+
+  virtual std::size_t threadCount() const noexcept override;
+  virtual void run(const BTFOptions::TaskList &task_list) override;
+
+private:
+  struct PrivateData;
+  std::unique_ptr<PrivateData> d;
+
+  BTFWorkerPool(std::size_t thread_count);
+
+  struct Batch;
+  struct QueuedTask;
+
+  void workerLoop(std::size_t worker_index);
+
+  std::optional<std::size_t> getCurrentWorkerIndex() const;
+
+  bool tryTakeTask(QueuedTask &queued_task,
+                   const std::optional<std::size_t> &opt_worker_index);
+
+  static void runTask(const QueuedTask &queued_task);
+
+  friend class IBTFWorkerPool;
+};
+
+} // namespace btfparse
@@ -7,33 +7,512 @@
 //
 
 #include "btf.h"
+#include "btfsnapshot.h"
+#include "btftelemetry.h"
 
 #include <btfparse/ibtf.h>
 
+#include <atomic>
+#include <fstream>
+#include <stdexcept>
+
+#include <unistd.h>
+
 namespace btfparse {
 
+namespace {
+
+using FileReaderList = std::vector<IFileReader::Ptr>;
+
+std::atomic_uint64_t temporary_snapshot_counter{0};
+
+#ifdef BTFPARSE_ENABLE_TELEMETRY
+struct StreamCallCounters final {
+  std::uint64_t read_count{};
+  std::uint64_t seek_count{};
+};
+
+// Forwards all the calls to the wrapped stream, counting the reads and
+// the seeks
+class CountedStream final : public IStream {
+public:
+  CountedStream(IStream::Ptr stream,
+                std::shared_ptr<StreamCallCounters> counters)
+      : wrapped_stream(std::move(stream)), call_counters(std::move(counters)) {}
+
+  virtual ~CountedStream() override = default;
+
+  virtual bool seek(std::uint64_t offset) override {
+    ++call_counters->seek_count;
+    return wrapped_stream->seek(offset);
+  }
+
+  virtual std::uint64_t offset() const override {
+    return wrapped_stream->offset();
+  }
+
+  virtual bool read(std::uint8_t *buffer, std::size_t size) override {
+    ++call_counters->read_count;
+    return wrapped_stream->read(buffer, size);
+  }
+
+  virtual OptionalBuffer buffer() const override {
+    return wrapped_stream->buffer();
+  }
+
+private:
+  IStream::Ptr wrapped_stream;
+  std::shared_ptr<StreamCallCounters> call_counters;
+};
+#endif
+
+Result<IBTF::Ptr, BTFError>
+createBTF(Result<FileReaderList, FileReaderError> file_reader_list_res,
+          const BTFOptions &options, IBTF::SharedPtr base_btf) noexcept {
+  if (file_reader_list_res.failed()) {
+    return BTF::convertFileReaderError(file_reader_list_res.takeError());
+  }
+
+  return BTF::create(file_reader_list_res.takeValue(), options,
+                     std::move(base_btf));
+}
+
+std::optional<BTFError>
+parseBTF(Result<FileReaderList, FileReaderError> file_reader_list_res,
+         const IBTF::ParseCallback &callback) {
+  if (file_reader_list_res.failed()) {
+    return BTF::convertFileReaderError(file_reader_list_res.takeError());
+  }
+
+  return BTF::parseTypes(file_reader_list_res.takeValue(), callback);
+}
+
+Result<FileReaderList, FileReaderError>
+toFileReaderList(Result<IFileReader::Ptr, FileReaderError> file_reader_res) {
+  if (file_reader_res.failed()) {
+    return file_reader_res.takeError();
+  }
+
+  try {
+    FileReaderList file_reader_list;
+    file_reader_list.push_back(file_reader_res.takeValue());
+
+    return file_reader_list;
+
+  } catch (const std::bad_alloc &) {
+    return FileReaderError(FileReaderErrorInformation{
+        FileReaderErrorInformation::Code::MemoryAllocationFailure,
+    });
+  }
+}
+
+Result<FileReaderList, FileReaderError>
+openPathList(const PathList &path_list) noexcept {
+  try {
+    FileReaderList file_reader_list;
+
+    for (const auto &path : path_list) {
+      auto file_reader_res = IFileReader::open(path);
+      if (file_reader_res.failed()) {
+        return file_reader_res.takeError();
+      }
+
+      file_reader_list.push_back(file_reader_res.takeValue());
+    }
+
+    return file_reader_list;
+
+  } catch (const std::bad_alloc &) {
+    return FileReaderError(FileReaderErrorInformation{
+        FileReaderErrorInformation::Code::MemoryAllocationFailure,
+    });
+  }
+}
+
+BTFError createInvalidBaseBTFError() {
+  return BTFError(BTFErrorInformation{
+      BTFErrorInformation::Code::InvalidBaseBTF,
+  });
+}
+
+const std::string_view kBTFSectionName{".BTF"};
+
+} // namespace
+
 Result<IBTF::Ptr, BTFError>
 IBTF::createFromPath(const std::filesystem::path &path) noexcept {
-  return IBTF::createFromPathList({path});
+  return IBTF::createFromPath(path, BTFOptions{});
+}
+
+Result<IBTF::Ptr, BTFError>
+IBTF::createFromPath(const std::filesystem::path &path,
+                     const BTFOptions &options) noexcept {
+  return createBTF(toFileReaderList(IFileReader::open(path)), options,
+                   nullptr);
 }
 
 Result<IBTF::Ptr, BTFError>
 IBTF::createFromPathList(const PathList &path_list) noexcept {
+  return IBTF::createFromPathList(path_list, BTFOptions{});
+}
+
+Result<IBTF::Ptr, BTFError>
+IBTF::createFromPathList(const PathList &path_list,
+                         const BTFOptions &options) noexcept {
+  return createBTF(openPathList(path_list), options, nullptr);
+}
+
+Result<IBTF::Ptr, BTFError>
+IBTF::createFromBuffer(const std::uint8_t *data, std::size_t size) noexcept {
+  return IBTF::createFromBuffer(data, size, BTFOptions{});
+}
+
+Result<IBTF::Ptr, BTFError>
+IBTF::createFromBuffer(const std::uint8_t *data, std::size_t size,
+                       const BTFOptions &options) noexcept {
+  return createBTF(toFileReaderList(IFileReader::createFromBuffer(data, size)),
+                   options, nullptr);
+}
+
+Result<IBTF::Ptr, BTFError>
+IBTF::createFromStream(IStream::Ptr stream) noexcept {
+  return IBTF::createFromStream(std::move(stream), BTFOptions{});
+}
+
+Result<IBTF::Ptr, BTFError>
+IBTF::createFromStream(IStream::Ptr stream,
+                       const BTFOptions &options) noexcept {
+#ifdef BTFPARSE_ENABLE_TELEMETRY
+  if (options.stats_callback) {
+    try {
+      auto counters = std::make_shared<StreamCallCounters>();
+      stream = std::make_unique<CountedStream>(std::move(stream), counters);
+
+      auto counted_options = options;
+      counted_options.stats_callback = [&options,
+                                        counters](const BTFParseStats &stats) {
+        auto stream_stats = stats;
+        stream_stats.stream_read_count = counters->read_count;
+        stream_stats.stream_seek_count = counters->seek_count;
+
+        options.stats_callback(stream_stats);
+      };
+
+      return createBTF(
+          toFileReaderList(IFileReader::createFromStream(std::move(stream))),
+          counted_options, nullptr);
+
+    } catch (const std::bad_alloc &) {
+      return BTFError(BTFErrorInformation{
+          BTFErrorInformation::Code::MemoryAllocationFailure,
+      });
+    }
+  }
+#endif
+
+  return createBTF(
+      toFileReaderList(IFileReader::createFromStream(std::move(stream))),
+      options, nullptr);
+}
+
+Result<IBTF::Ptr, BTFError>
+IBTF::createFromELF(const std::filesystem::path &path) noexcept {
+  return IBTF::createFromELF(path, BTFOptions{});
+}
+
+Result<IBTF::Ptr, BTFError>
+IBTF::createFromELF(const std::filesystem::path &path,
+                    const BTFOptions &options) noexcept {
+  return createBTF(
+      toFileReaderList(IFileReader::openELFSection(path, kBTFSectionName)),
+      options, nullptr);
+}
+
+Result<IBTF::Ptr, BTFError>
+IBTF::createFromELFBuffer(const std::uint8_t *data, std::size_t size) noexcept {
+  return IBTF::createFromELFBuffer(data, size, BTFOptions{});
+}
+
+Result<IBTF::Ptr, BTFError>
+IBTF::createFromELFBuffer(const std::uint8_t *data, std::size_t size,
+                          const BTFOptions &options) noexcept {
+  return createBTF(toFileReaderList(IFileReader::createFromELFSection(
+                       data, size, kBTFSectionName)),
+                   options, nullptr);
+}
+
+std::optional<BTFError>
+IBTF::parseFromPath(const std::filesystem::path &path,
+                    const ParseCallback &callback) {
+  return parseBTF(toFileReaderList(IFileReader::open(path)), callback);
+}
+
+std::optional<BTFError>
+IBTF::parseFromPathList(const PathList &path_list,
+                        const ParseCallback &callback) {
+  return parseBTF(openPathList(path_list), callback);
+}
+
+std::optional<BTFError> IBTF::parseFromBuffer(const std::uint8_t *data,
+                                              std::size_t size,
+                                              const ParseCallback &callback) {
+  return parseBTF(toFileReaderList(IFileReader::createFromBuffer(data, size)),
+                  callback);
+}
+
+Result<IBTF::Ptr, BTFError>
+IBTF::createSplitFromPath(SharedPtr base_btf,
+                          const std::filesystem::path &path) noexcept {
+  return IBTF::createSplitFromPath(std::move(base_btf), path, BTFOptions{});
+}
+
+Result<IBTF::Ptr, BTFError>
+IBTF::createSplitFromPath(SharedPtr base_btf, const std::filesystem::path &path,
+                          const BTFOptions &options) noexcept {
+  if (!base_btf) {
+    return createInvalidBaseBTFError();
+  }
+
+  return createBTF(toFileReaderList(IFileReader::open(path)), options,
+                   std::move(base_btf));
+}
+
+Result<IBTF::Ptr, BTFError>
+IBTF::createSplitFromELF(SharedPtr base_btf,
+                         const std::filesystem::path &path) noexcept {
+  return IBTF::createSplitFromELF(std::move(base_btf), path, BTFOptions{});
+}
+
+Result<IBTF::Ptr, BTFError>
+IBTF::createSplitFromELF(SharedPtr base_btf, const std::filesystem::path &path,
+                         const BTFOptions &options) noexcept {
+  if (!base_btf) {
+    return createInvalidBaseBTFError();
+  }
+
+  return createBTF(
+      toFileReaderList(IFileReader::openELFSection(path, kBTFSectionName)),
+      options, std::move(base_btf));
+}
+
+Result<IBTF::Ptr, BTFError>
+IBTF::createFromSnapshot(const std::filesystem::path &path) noexcept {
+  auto file_reader_res = IFileReader::open(path);
+  if (file_reader_res.failed()) {
+    return BTF::convertFileReaderError(file_reader_res.takeError());
+  }
+
+  return BTFSnapshot::create(file_reader_res.takeValue());
+}
+
+Result<IBTF::Ptr, BTFError>
+IBTF::createFromSnapshotBuffer(const std::uint8_t *data,
+                               std::size_t size) noexcept {
+  auto file_reader_res = IFileReader::createFromBuffer(data, size);
+  if (file_reader_res.failed()) {
+    return BTF::convertFileReaderError(file_reader_res.takeError());
+  }
+
+  return BTFSnapshot::create(file_reader_res.takeValue());
+}
+
+std::optional<BTFError>
+IBTF::saveSnapshot(const IBTF &btf,
+                   const std::filesystem::path &path) noexcept {
+  auto buffer_res = BTFSnapshot::serialize(btf);
+  if (buffer_res.failed()) {
+    return buffer_res.takeError();
+  }
+
+  auto buffer = buffer_res.takeValue();
+
   try {
-    return Ptr(new BTF(path_list));
+    // Snapshots are mapped by their readers, so an existing file is never
+    // rewritten in place: the new one is renamed over it once complete
+    auto temporary_file_path = path;
+    temporary_file_path += ".tmp." + std::to_string(getpid()) + "." +
+                           std::to_string(temporary_snapshot_counter++);
+
+    std::ofstream snapshot_file(temporary_file_path,
+                                std::ios::binary | std::ios::trunc);
+
+    snapshot_file.write(reinterpret_cast<const char *>(buffer.data()),
+                        static_cast<std::streamsize>(buffer.size()));
+
+    snapshot_file.close();
+
+    std::error_code error;
+    if (snapshot_file) {
+      std::filesystem::rename(temporary_file_path, path, error);
+    }
+
+    if (!snapshot_file || error) {
+      std::filesystem::remove(temporary_file_path, error);
+
+      return BTFError(BTFErrorInformation{
+          BTFErrorInformation::Code::IOError,
+      });
+    }
+
+    return std::nullopt;
 
   } catch (const std::bad_alloc &) {
     return BTFError(BTFErrorInformation{
         BTFErrorInformation::Code::MemoryAllocationFailure,
     });
+  }
+}
+
+Result<std::vector<std::uint8_t>, BTFError>
+IBTF::createSnapshotBuffer(const IBTF &btf) noexcept {
+  return BTFSnapshot::serialize(btf);
+}
 
-  } catch (const BTFError &e) {
-    return e;
+BTFTypeMap &BTFTypeMap::operator=(const BTFTypeMap &other) {
+  // The stored pairs have a const key and can't be assigned to, so
+  // rebuild the storage instead of doing an element-wise copy
+  if (this != &other) {
+    auto copy = other;
+    *this = std::move(copy);
   }
+
+  return *this;
+}
+
+BTFTypeMap::iterator BTFTypeMap::find(key_type id) noexcept {
+  auto opt_index = getIndex(id);
+  if (!opt_index.has_value()) {
+    return end();
+  }
+
+  auto storage_it = std::next(storage.begin(),
+                              static_cast<std::ptrdiff_t>(opt_index.value()));
+
+  return iterator(storage_it, storage.end());
+}
+
+BTFTypeMap::const_iterator BTFTypeMap::find(key_type id) const noexcept {
+  auto opt_index = getIndex(id);
+  if (!opt_index.has_value()) {
+    return end();
+  }
+
+  auto storage_it = std::next(storage.begin(),
+                              static_cast<std::ptrdiff_t>(opt_index.value()));
+
+  return const_iterator(storage_it, storage.end());
+}
+
+BTFTypeMap::mapped_type &BTFTypeMap::at(key_type id) {
+  auto opt_index = getIndex(id);
+  if (!opt_index.has_value()) {
+    throw std::out_of_range("Invalid BTF type id");
+  }
+
+  return storage[opt_index.value()].second;
+}
+
+const BTFTypeMap::mapped_type &BTFTypeMap::at(key_type id) const {
+  auto opt_index = getIndex(id);
+  if (!opt_index.has_value()) {
+    throw std::out_of_range("Invalid BTF type id");
+  }
+
+  return storage[opt_index.value()].second;
+}
+
+BTFTypeMap::size_type BTFTypeMap::count(key_type id) const noexcept {
+  return getIndex(id).has_value() ? 1U : 0U;
+}
+
+std::pair<BTFTypeMap::iterator, bool> BTFTypeMap::insert(value_type value) {
+  auto id = value.first;
+
+  // The void type (and any other empty value) is never stored
+  if (std::holds_alternative<std::monostate>(value.second)) {
+    return {end(), false};
+  }
+
+  if (storage.empty()) {
+    first_id = id;
+
+  } else if (id < first_id) {
+    // IDs are normally inserted in ascending order; when they are not,
+    // move the existing types to make room for the new ones at the front
+    Storage new_storage;
+    new_storage.reserve(storage.size() + (first_id - id));
+
+    for (auto hole_id = id; hole_id < first_id; ++hole_id) {
+      new_storage.emplace_back(hole_id, std::monostate{});
+    }
+
+    for (auto &p : storage) {
+      new_storage.emplace_back(p.first, std::move(p.second));
+    }
+
+    storage = std::move(new_storage);
+    first_id = id;
+  }
+
+  auto index = static_cast<size_type>(id - first_id);
+
+  if (index < storage.size()) {
+    auto &slot = storage[index];
+    auto storage_it =
+        std::next(storage.begin(), static_cast<std::ptrdiff_t>(index));
+
+    if (!std::holds_alternative<std::monostate>(slot.second)) {
+      return {iterator(storage_it, storage.end()), false};
+    }
+
+    slot.second = std::move(value.second);
+    ++type_count;
+
+    return {iterator(storage_it, storage.end()), true};
+  }
+
+  for (auto hole_id = first_id + static_cast<key_type>(storage.size());
+       hole_id < id; ++hole_id) {
+    storage.emplace_back(hole_id, std::monostate{});
+  }
+
+  storage.push_back(std::move(value));
+  ++type_count;
+
+  return {iterator(std::prev(storage.end()), storage.end()), true};
+}
+
+void BTFTypeMap::reserve(size_type capacity) { storage.reserve(capacity); }
+
+void BTFTypeMap::clear() noexcept {
+  storage.clear();
+  first_id = 1U;
+  type_count = 0U;
+}
+
+std::optional<BTFTypeMap::size_type>
+BTFTypeMap::getIndex(key_type id) const noexcept {
+  if (id < first_id) {
+    return std::nullopt;
+  }
+
+  auto index = static_cast<size_type>(id - first_id);
+  if (index >= storage.size() ||
+      std::holds_alternative<std::monostate>(storage[index].second)) {
+    return std::nullopt;
+  }
+
+  return index;
 }
 
 BTFKind IBTF::getBTFTypeKind(const BTFType &btf_type) noexcept {
   return static_cast<BTFKind>(btf_type.index());
 }
 
+BTFKind IBTF::getBTFTypeKind(const BTFTypeView &btf_type_view) noexcept {
+  return static_cast<BTFKind>(btf_type_view.index());
+}
+
+bool IBTF::isTelemetryEnabled() noexcept { return kTelemetryEnabled; }
+
 } // namespace btfparse
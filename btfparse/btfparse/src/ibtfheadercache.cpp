@@ -0,0 +1,26 @@
+//
+// Copyright (c) 2021-present, Trail of Bits, Inc.
+// All rights reserved.
+//
+// This source code is licensed in accordance with the terms specified in
+// the LICENSE file found in the root directory of this source tree.
+//
+
+#include "btfheadercache.h"
+
+#include <btfparse/ibtfheadercache.h>
+
+namespace btfparse {
+
+Result<IBTFHeaderCache::Ptr, BTFHeaderCacheError>
+IBTFHeaderCache::create(const std::filesystem::path &cache_directory) noexcept {
+  return BTFHeaderCache::create(cache_directory);
+}
+
+std::optional<BTFHeaderCacheError>
+IBTFHeaderCache::generate(std::ostream &stream,
+                          const PathList &path_list) const {
+  return generate(stream, path_list, BTFHeaderGeneratorOptions{});
+}
+
+} // namespace btfparse
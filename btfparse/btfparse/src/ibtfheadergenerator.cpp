@@ -21,4 +21,51 @@ IBTFHeaderGenerator::Ptr IBTFHeaderGenerator::create() {
   }
 }
 
+bool IBTFHeaderGenerator::generate(std::string &header,
+                                   const IBTF::Ptr &btf) const {
+  return generate(header, btf, BTFHeaderGeneratorOptions{});
+}
+
+bool IBTFHeaderGenerator::generate(
+    std::string &header, const IBTF::Ptr &btf,
+    const BTFHeaderGeneratorOptions &options) const {
+
+  header.clear();
+
+  auto succeeded = generate(
+      [&header](std::string_view chunk) -> bool {
+        header.append(chunk);
+        return true;
+      },
+      btf, options);
+
+  if (!succeeded) {
+    header.clear();
+  }
+
+  return succeeded;
+}
+
+bool IBTFHeaderGenerator::generate(std::ostream &stream,
+                                   const IBTF::Ptr &btf) const {
+  return generate(stream, btf, BTFHeaderGeneratorOptions{});
+}
+
+bool IBTFHeaderGenerator::generate(
+    std::ostream &stream, const IBTF::Ptr &btf,
+    const BTFHeaderGeneratorOptions &options) const {
+
+  return generate(
+      [&stream](std::string_view chunk) -> bool {
+        stream.write(chunk.data(), static_cast<std::streamsize>(chunk.size()));
+        return stream.good();
+      },
+      btf, options);
+}
+
+bool IBTFHeaderGenerator::generate(const OutputCallback &callback,
+                                   const IBTF::Ptr &btf) const {
+  return generate(callback, btf, BTFHeaderGeneratorOptions{});
+}
+
 } // namespace btfparse
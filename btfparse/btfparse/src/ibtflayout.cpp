@@ -0,0 +1,20 @@
+//
+// Copyright (c) 2021-present, Trail of Bits, Inc.
+// All rights reserved.
+//
+// This source code is licensed in accordance with the terms specified in
+// the LICENSE file found in the root directory of this source tree.
+//
+
+#include "btflayout.h"
+
+#include <btfparse/ibtflayout.h>
+
+namespace btfparse {
+
+Result<IBTFLayout::Ptr, BTFLayoutError>
+IBTFLayout::create(const IBTF &btf) noexcept {
+  return BTFLayout::create(btf);
+}
+
+} // namespace btfparse
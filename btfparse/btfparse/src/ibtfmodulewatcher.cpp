@@ -0,0 +1,35 @@
+//
+// Copyright (c) 2021-present, Trail of Bits, Inc.
+// All rights reserved.
+//
+// This source code is licensed in accordance with the terms specified in
+// the LICENSE file found in the root directory of this source tree.
+//
+
+#include "btfmodulewatcher.h"
+
+namespace btfparse {
+
+namespace {
+
+const std::filesystem::path kDefaultBTFDirectory{"/sys/kernel/btf"};
+
+} // namespace
+
+Result<IBTFModuleWatcher::Ptr, BTFModuleWatcherError>
+IBTFModuleWatcher::create() noexcept {
+  return create(kDefaultBTFDirectory, BTFOptions{});
+}
+
+Result<IBTFModuleWatcher::Ptr, BTFModuleWatcherError>
+IBTFModuleWatcher::create(const std::filesystem::path &btf_directory) noexcept {
+  return create(btf_directory, BTFOptions{});
+}
+
+Result<IBTFModuleWatcher::Ptr, BTFModuleWatcherError>
+IBTFModuleWatcher::create(const std::filesystem::path &btf_directory,
+                          const BTFOptions &options) noexcept {
+  return BTFModuleWatcher::create(btf_directory, options);
+}
+
+} // namespace btfparse
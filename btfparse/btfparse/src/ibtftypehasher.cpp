@@ -0,0 +1,42 @@
+//
+// Copyright (c) 2021-present, Trail of Bits, Inc.
+// All rights reserved.
+//
+// This source code is licensed in accordance with the terms specified in
+// the LICENSE file found in the root directory of this source tree.
+//
+
+#include "btftypehasher.h"
+
+namespace btfparse {
+
+Result<IBTFTypeHasher::Ptr, BTFTypeHasherError>
+IBTFTypeHasher::create(const IBTF &btf) noexcept {
+  return BTFTypeHasher::create(btf);
+}
+
+Result<BTFDiff, BTFTypeHasherError>
+IBTFTypeHasher::diff(const IBTF &old_btf, const IBTF &new_btf) noexcept {
+  auto old_hasher_res = BTFTypeHasher::create(old_btf);
+  if (old_hasher_res.failed()) {
+    return old_hasher_res.takeError();
+  }
+
+  auto new_hasher_res = BTFTypeHasher::create(new_btf);
+  if (new_hasher_res.failed()) {
+    return new_hasher_res.takeError();
+  }
+
+  auto old_hasher = old_hasher_res.takeValue();
+  auto new_hasher = new_hasher_res.takeValue();
+
+  return BTFTypeHasher::diff(*old_hasher, *new_hasher);
+}
+
+Result<BTFDiff, BTFTypeHasherError>
+IBTFTypeHasher::diff(const IBTFTypeHasher &old_hasher,
+                     const IBTFTypeHasher &new_hasher) noexcept {
+  return BTFTypeHasher::diff(old_hasher, new_hasher);
+}
+
+} // namespace btfparse
@@ -0,0 +1,24 @@
+//
+// Copyright (c) 2021-present, Trail of Bits, Inc.
+// All rights reserved.
+//
+// This source code is licensed in accordance with the terms specified in
+// the LICENSE file found in the root directory of this source tree.
+//
+
+#include "btfworkerpool.h"
+
+namespace btfparse {
+
+IBTFWorkerPool::Ptr IBTFWorkerPool::create() { return create(0); }
+
+IBTFWorkerPool::Ptr IBTFWorkerPool::create(std::size_t thread_count) {
+  try {
+    return Ptr(new BTFWorkerPool(thread_count));
+
+  } catch (const std::bad_alloc &) {
+    return nullptr;
+  }
+}
+
+} // namespace btfparse
@@ -0,0 +1,831 @@
+//
+// Copyright (c) 2021-present, Trail of Bits, Inc.
+// All rights reserved.
+//
+// This source code is licensed in accordance with the terms specified in
+// the LICENSE file found in the root directory of this source tree.
+//
+
+#include "btfbuilder.h"
+
+#include <doctest/doctest.h>
+
+#include <btfparse/ibtf.h>
+
+#include <algorithm>
+#include <thread>
+#include <type_traits>
+
+namespace btfparse {
+
+namespace {
+
+BTFBuilder createTestBuilder() {
+  BTFBuilder builder;
+  auto int_id = builder.addInt("int", 4);
+  builder.addPtr(int_id);
+  builder.addStruct("pair", 8, {{"first", int_id, 0}, {"second", int_id, 32}});
+
+  return builder;
+}
+
+Result<IBTF::Ptr, BTFError> createBTF(const BTFBuilder &builder,
+                                      const BTFOptions &options) {
+  auto path = builder.save("btf");
+  auto btf_res = IBTF::createFromPath(path, options);
+  std::filesystem::remove(path);
+
+  return btf_res;
+}
+
+IBTF::Ptr createTestBTF(const BTFOptions &options = {}) {
+  auto btf_res = createBTF(createTestBuilder(), options);
+  REQUIRE(!btf_res.failed());
+
+  return btf_res.takeValue();
+}
+
+BTFOptions lazyOptions() {
+  BTFOptions options;
+  options.decoding_mode = BTFOptions::DecodingMode::Lazy;
+
+  return options;
+}
+
+BTFBuilder createLargeTestBuilder() {
+  BTFBuilder builder;
+  auto int_id = builder.addInt("int", 4);
+  for (std::uint32_t i = 0; i < 256; ++i) {
+    builder.addStruct("s" + std::to_string(i), 4, {{"value", int_id, 0}});
+  }
+
+  return builder;
+}
+
+// Moves the string section in front of the type section and drops the last
+// bytes of the type data, so that the final type is cut short by the end
+// of the buffer instead of running into the strings
+std::vector<std::uint8_t> buildTruncatedBuffer(const BTFBuilder &builder,
+                                               std::size_t dropped_size) {
+  auto buffer = builder.build();
+
+  auto readU32 = [&buffer](std::size_t offset) {
+    std::uint32_t value{};
+    for (std::size_t i = 0; i < 4; ++i) {
+      value |= static_cast<std::uint32_t>(buffer[offset + i]) << (i * 8U);
+    }
+
+    return value;
+  };
+
+  auto type_len = readU32(12);
+  auto str_len = readU32(20);
+
+  std::vector<std::uint8_t> output(buffer.begin(), buffer.begin() + 8);
+
+  auto truncated_type_len = static_cast<std::uint32_t>(type_len - dropped_size);
+  for (auto value : {str_len, truncated_type_len, 0U, str_len}) {
+    for (std::size_t i = 0; i < 4; ++i) {
+      output.push_back(static_cast<std::uint8_t>(value >> (i * 8U)));
+    }
+  }
+
+  output.insert(output.end(), buffer.begin() + 24 + type_len, buffer.end());
+  output.insert(output.end(), buffer.begin() + 24,
+                buffer.begin() + 24 + truncated_type_len);
+
+  return output;
+}
+
+// Covers every decoder that reads more than the type header: bitfields,
+// enum values, function parameters and data section variables
+BTFBuilder createByteOrderTestBuilder() {
+  const std::uint32_t kKindFlag{0x80000000U};
+
+  BTFBuilder builder;
+  auto int_id = builder.addInt("int", 4);
+  auto ptr_id = builder.addPtr(int_id);
+
+  builder.addType({}, BTFKind::Array, 0, 0, {int_id, int_id, 16});
+
+  builder.addType("bits", BTFKind::Struct, 2 | kKindFlag, 4,
+                  {builder.addString("low"), int_id, (3U << 24) | 0U,
+                   builder.addString("high"), int_id, (5U << 24) | 3U});
+
+  builder.addType("color", BTFKind::Enum, 2, 4,
+                  {builder.addString("RED"), 0, builder.addString("NONE"),
+                   static_cast<std::uint32_t>(-1)});
+
+  auto func_proto_id = builder.addType(
+      {}, BTFKind::FuncProto, 2, int_id,
+      {builder.addString("format"), ptr_id, 0, 0});
+
+  builder.addType("printk", BTFKind::Func, 1, func_proto_id);
+
+  auto var_id = builder.addType("counter", BTFKind::Var, 0, int_id, {1});
+  builder.addType(".data", BTFKind::DataSec, 2, 8,
+                  {var_id, 0, 4, var_id, 4, 4});
+
+  return builder;
+}
+
+std::vector<std::string> getStructNameList(const IBTF &btf) {
+  std::vector<std::string> name_list;
+
+  btf.forEach([&name_list](std::uint32_t, const BTFType &btf_type) {
+    if (IBTF::getBTFTypeKind(btf_type) == BTFKind::Struct) {
+      const auto &struct_type = std::get<StructBTFType>(btf_type);
+      name_list.push_back(struct_type.opt_name.value() + "." +
+                          struct_type.member_list.at(0).opt_name.value());
+    }
+
+    return true;
+  });
+
+  return name_list;
+}
+
+} // namespace
+
+TEST_CASE("IBTF::getTypeRef()") {
+  auto btf = createTestBTF();
+  REQUIRE(btf->count() == 3);
+
+  CHECK(btf->getTypeRef(0) == nullptr);
+  CHECK(btf->getTypeRef(4) == nullptr);
+
+  const auto *btf_type = btf->getTypeRef(3);
+  REQUIRE(btf_type != nullptr);
+  CHECK(btf_type == btf->getTypeRef(3));
+  CHECK(IBTF::getBTFTypeKind(*btf_type) == BTFKind::Struct);
+
+  const auto &struct_type = std::get<StructBTFType>(*btf_type);
+  REQUIRE(struct_type.member_list.size() == 2);
+  CHECK(struct_type.opt_name.value() == "pair");
+  CHECK(struct_type.member_list[1].opt_name.value() == "second");
+  CHECK(struct_type.member_list[1].offset == 32);
+}
+
+TEST_CASE("IBTF::forEach()") {
+  auto btf = createTestBTF();
+
+  std::vector<std::uint32_t> id_list;
+  CHECK(btf->forEach([&](std::uint32_t id, const BTFType &btf_type) {
+    CHECK(&btf_type == btf->getTypeRef(id));
+    id_list.push_back(id);
+    return true;
+  }));
+
+  CHECK(id_list == std::vector<std::uint32_t>{1, 2, 3});
+
+  id_list.clear();
+  CHECK(!btf->forEach([&](std::uint32_t id, const BTFType &) {
+    id_list.push_back(id);
+    return id < 2;
+  }));
+
+  CHECK(id_list == std::vector<std::uint32_t>{1, 2});
+}
+
+TEST_CASE("IBTF::visit()") {
+  auto btf = createTestBTF();
+
+  std::uint32_t pointee_type{};
+  CHECK(btf->visit(2, [&](const auto &btf_type) {
+    using Type = std::decay_t<decltype(btf_type)>;
+    if constexpr (std::is_same_v<Type, PtrBTFType>) {
+      pointee_type = btf_type.type;
+    }
+  }));
+
+  CHECK(pointee_type == 1);
+  CHECK(!btf->visit(10, [](const auto &) {}));
+}
+
+TEST_CASE("BTFOptions::DecodingMode::Lazy") {
+  auto btf = createTestBTF(lazyOptions());
+  REQUIRE(btf->count() == 3);
+
+  CHECK(btf->getKind(1) == BTFKind::Int);
+  CHECK(btf->getKind(2) == BTFKind::Ptr);
+  CHECK(btf->getKind(3) == BTFKind::Struct);
+  CHECK(!btf->getKind(4).has_value());
+
+  const auto *btf_type = btf->getTypeRef(3);
+  REQUIRE(btf_type != nullptr);
+  CHECK(btf_type == btf->getTypeRef(3));
+
+  const auto &struct_type = std::get<StructBTFType>(*btf_type);
+  REQUIRE(struct_type.member_list.size() == 2);
+  CHECK(struct_type.member_list[0].opt_name.value() == "first");
+  CHECK(struct_type.member_list[1].offset == 32);
+
+  auto opt_ptr_type = btf->getType(2);
+  REQUIRE(opt_ptr_type.has_value());
+  CHECK(std::get<PtrBTFType>(opt_ptr_type.value()).type == 1);
+
+  CHECK(btf->getAll().size() == 3);
+}
+
+TEST_CASE("BTFOptions::DecodingMode::Lazy decoding errors") {
+  auto builder = createTestBuilder();
+  builder.addRawType(0xFFFFFF, static_cast<std::uint32_t>(BTFKind::Typedef), 0,
+                     1);
+
+  CHECK(createBTF(builder, BTFOptions{}).failed());
+
+  auto btf_res = createBTF(builder, lazyOptions());
+  REQUIRE(!btf_res.failed());
+
+  auto btf = btf_res.takeValue();
+  CHECK(btf->count() == 4);
+  CHECK(btf->getKind(4) == BTFKind::Typedef);
+  CHECK(btf->getTypeRef(4) == nullptr);
+  CHECK(btf->getTypeRef(3) != nullptr);
+
+  // Index errors are still reported when the object is created
+  builder.addRawType(0, 31, 0, 0);
+  CHECK(createBTF(builder, lazyOptions()).failed());
+}
+
+TEST_CASE("BTFOptions::DecodingMode::Lazy concurrent lookups") {
+  auto btf_res = createBTF(createLargeTestBuilder(), lazyOptions());
+  REQUIRE(!btf_res.failed());
+
+  auto btf = btf_res.takeValue();
+  REQUIRE(btf->count() == 257);
+
+  std::vector<std::vector<const BTFType *>> type_ref_list_list(4);
+
+  std::vector<std::thread> thread_list;
+  for (auto &type_ref_list : type_ref_list_list) {
+    thread_list.emplace_back([&btf, &type_ref_list]() {
+      for (std::uint32_t id = 1; id <= btf->count(); ++id) {
+        type_ref_list.push_back(btf->getTypeRef(id));
+      }
+    });
+  }
+
+  for (auto &thread : thread_list) {
+    thread.join();
+  }
+
+  for (const auto &type_ref_list : type_ref_list_list) {
+    CHECK(type_ref_list == type_ref_list_list.front());
+  }
+
+  const auto *btf_type = btf->getTypeRef(257);
+  REQUIRE(btf_type != nullptr);
+  CHECK(std::get<StructBTFType>(*btf_type).opt_name.value() == "s255");
+}
+
+TEST_CASE("BTFOptions::thread_count") {
+  auto builder = createLargeTestBuilder();
+
+  auto sequential_btf_res = createBTF(builder, BTFOptions{});
+  REQUIRE(!sequential_btf_res.failed());
+
+  auto sequential_btf = sequential_btf_res.takeValue();
+  auto expected_name_list = getStructNameList(*sequential_btf);
+  REQUIRE(expected_name_list.size() == 256);
+
+  for (std::size_t thread_count : {0U, 2U, 3U, 64U, 1024U}) {
+    BTFOptions options;
+    options.thread_count = thread_count;
+
+    auto btf_res = createBTF(builder, options);
+    REQUIRE(!btf_res.failed());
+
+    auto btf = btf_res.takeValue();
+    CHECK(btf->count() == sequential_btf->count());
+    CHECK(getStructNameList(*btf) == expected_name_list);
+  }
+}
+
+TEST_CASE("BTFOptions::executor") {
+  auto builder = createLargeTestBuilder();
+
+  // Two decoding errors, that will end up in different tasks
+  auto typedef_kind = static_cast<std::uint32_t>(BTFKind::Typedef);
+  builder.addRawType(0xFFFF00, typedef_kind, 0, 1);
+  builder.addInt("long", 8);
+  builder.addRawType(0xFFFF01, typedef_kind, 0, 1);
+
+  for (std::uint32_t i = 0; i < 256; ++i) {
+    builder.addInt("int" + std::to_string(i), 4);
+  }
+
+  auto sequential_btf_res = createBTF(builder, BTFOptions{});
+  REQUIRE(sequential_btf_res.failed());
+
+  const auto &expected_error = sequential_btf_res.error().get();
+  REQUIRE(expected_error.opt_file_range.has_value());
+  CHECK(expected_error.opt_file_range->offset == 0xFFFF00);
+
+  // Run the tasks backwards, so that the last error is found first
+  std::size_t executed_task_count{};
+
+  BTFOptions options;
+  options.thread_count = 4;
+  options.executor = [&](const BTFOptions::TaskList &task_list) {
+    for (auto it = task_list.rbegin(); it != task_list.rend(); ++it) {
+      (*it)();
+      ++executed_task_count;
+    }
+  };
+
+  auto btf_res = createBTF(builder, options);
+  REQUIRE(btf_res.failed());
+  CHECK(executed_task_count == 4);
+
+  const auto &error = btf_res.error().get();
+  CHECK(error.code == expected_error.code);
+  REQUIRE(error.opt_file_range.has_value());
+  CHECK(error.opt_file_range->offset == 0xFFFF00);
+
+  // Index errors are reported after the decoding errors that precede them
+  builder = createLargeTestBuilder();
+  builder.addRawType(0, 31, 0, 0);
+
+  executed_task_count = 0;
+  btf_res = createBTF(builder, options);
+  REQUIRE(btf_res.failed());
+  CHECK(executed_task_count == 4);
+  CHECK(btf_res.error().get().code ==
+        BTFErrorInformation::Code::InvalidBTFKind);
+}
+
+TEST_CASE("IBTF::createSplitFromPath()") {
+  BTFBuilder base_builder;
+  auto int_id = base_builder.addInt("int", 4);
+  auto base_struct_id =
+      base_builder.addStruct("base_struct", 4, {{"value", int_id, 0}});
+
+  auto split_builder = BTFBuilder::createSplit(base_builder);
+  split_builder.addPtr(base_struct_id);
+  split_builder.addStruct("split_struct", 4,
+                          {{"base_member", base_struct_id, 0}});
+
+  // Split types can reference the strings of the base
+  split_builder.addRawType(1, static_cast<std::uint32_t>(BTFKind::Typedef), 0,
+                           int_id);
+
+  auto base_path = base_builder.save("base");
+  auto split_path = split_builder.save("split");
+
+  auto base_btf_res = IBTF::createFromPath(base_path);
+  REQUIRE(!base_btf_res.failed());
+
+  IBTF::SharedPtr base_btf = base_btf_res.takeValue();
+
+  for (auto decoding_mode :
+       {BTFOptions::DecodingMode::Eager, BTFOptions::DecodingMode::Lazy,
+        BTFOptions::DecodingMode::Compact}) {
+
+    BTFOptions options;
+    options.decoding_mode = decoding_mode;
+
+    auto split_btf_res =
+        IBTF::createSplitFromPath(base_btf, split_path, options);
+
+    REQUIRE(!split_btf_res.failed());
+
+    auto split_btf = split_btf_res.takeValue();
+    REQUIRE(split_btf->count() == 5);
+
+    // The base types are shared, not decoded again
+    CHECK(split_btf->getTypeRef(1) == base_btf->getTypeRef(1));
+    CHECK(split_btf->getTypeRef(2) == base_btf->getTypeRef(2));
+    CHECK(split_btf->getKind(2) == BTFKind::Struct);
+    CHECK(split_btf->getKind(3) == BTFKind::Ptr);
+    CHECK(!split_btf->getKind(6).has_value());
+
+    auto opt_ptr_type = split_btf->getType(3);
+    REQUIRE(opt_ptr_type.has_value());
+    CHECK(std::get<PtrBTFType>(opt_ptr_type.value()).type == base_struct_id);
+
+    const auto *typedef_type = split_btf->getTypeRef(5);
+    REQUIRE(typedef_type != nullptr);
+    CHECK(std::get<TypedefBTFType>(*typedef_type).name == "int");
+
+    CHECK(getStructNameList(*split_btf) ==
+          std::vector<std::string>{"base_struct.value",
+                                   "split_struct.base_member"});
+
+    std::vector<std::uint32_t> id_list;
+    split_btf->forEach([&id_list](std::uint32_t id, const BTFType &) {
+      id_list.push_back(id);
+      return true;
+    });
+
+    CHECK(id_list == std::vector<std::uint32_t>{1, 2, 3, 4, 5});
+    CHECK(split_btf->getAll().size() == 5);
+  }
+
+  // The result matches parsing both files as a single list
+  auto btf_res = IBTF::createFromPathList({base_path, split_path});
+  REQUIRE(!btf_res.failed());
+  CHECK(getStructNameList(*btf_res.takeValue()) ==
+        std::vector<std::string>{"base_struct.value",
+                                 "split_struct.base_member"});
+
+  auto invalid_split_btf_res = IBTF::createSplitFromPath(nullptr, split_path);
+  REQUIRE(invalid_split_btf_res.failed());
+  CHECK(invalid_split_btf_res.error().get().code ==
+        BTFErrorInformation::Code::InvalidBaseBTF);
+
+  std::filesystem::remove(base_path);
+  std::filesystem::remove(split_path);
+}
+
+TEST_CASE("IBTF::createFromBuffer()") {
+  auto buffer = createTestBuilder().build();
+
+  auto btf_res = IBTF::createFromBuffer(buffer.data(), buffer.size());
+  REQUIRE(!btf_res.failed());
+
+  auto btf = btf_res.takeValue();
+  CHECK(btf->count() == 3);
+  CHECK(getStructNameList(*btf) == std::vector<std::string>{"pair.first"});
+
+  btf_res = IBTF::createFromBuffer(buffer.data(), 8);
+  CHECK(btf_res.failed());
+}
+
+TEST_CASE("IBTF::createFromBuffer() (truncated data)") {
+  auto buffer = createTestBuilder().build();
+
+  // Every read past the end of the buffer is reported as an error
+  for (std::size_t size = 0; size < buffer.size(); ++size) {
+    auto btf_res = IBTF::createFromBuffer(buffer.data(), size);
+    CHECK(btf_res.failed());
+  }
+}
+
+TEST_CASE("IBTF::createFromBuffer() (truncated records)") {
+  for (auto kind : {BTFKind::Struct, BTFKind::DataSec}) {
+    auto builder = createTestBuilder();
+
+    std::uint32_t truncated_id{};
+    if (kind == BTFKind::Struct) {
+      truncated_id =
+          builder.addStruct("truncated", 8, {{"a", 1, 0}, {"b", 1, 32}});
+
+    } else {
+      auto var_id = builder.addType("counter", BTFKind::Var, 0, 1, {1});
+      truncated_id = builder.addType(".data", BTFKind::DataSec, 2, 8,
+                                     {var_id, 0, 4, var_id, 4, 4});
+    }
+
+    // The last record is cut in half
+    auto buffer = buildTruncatedBuffer(builder, 4);
+
+    auto intact_buffer = buildTruncatedBuffer(builder, 0);
+    REQUIRE(!IBTF::createFromBuffer(intact_buffer.data(), intact_buffer.size())
+                 .failed());
+
+    for (auto decoding_mode : {BTFOptions::DecodingMode::Eager,
+                               BTFOptions::DecodingMode::Compact}) {
+      BTFOptions options;
+      options.decoding_mode = decoding_mode;
+
+      CHECK(IBTF::createFromBuffer(buffer.data(), buffer.size(), options)
+                .failed());
+    }
+
+    auto btf_res =
+        IBTF::createFromBuffer(buffer.data(), buffer.size(), lazyOptions());
+    REQUIRE(!btf_res.failed());
+
+    auto btf = btf_res.takeValue();
+    CHECK(btf->getKind(truncated_id) == kind);
+    CHECK(btf->getTypeRef(truncated_id) == nullptr);
+    CHECK(btf->getTypeRef(3) != nullptr);
+
+    std::vector<std::uint32_t> id_list;
+    auto opt_error = IBTF::parseFromBuffer(
+        buffer.data(), buffer.size(),
+        [&](std::uint32_t id, const BTFTypeView &) {
+          id_list.push_back(id);
+          return true;
+        });
+
+    CHECK(opt_error.has_value());
+    CHECK(std::find(id_list.begin(), id_list.end(), truncated_id) ==
+          id_list.end());
+  }
+}
+
+TEST_CASE("IBTF::createFromBuffer() (big endian)") {
+  auto builder = createByteOrderTestBuilder();
+  auto little_endian_buffer = builder.build();
+  auto big_endian_buffer = builder.buildBigEndian();
+
+  auto little_endian_btf_res = IBTF::createFromBuffer(
+      little_endian_buffer.data(), little_endian_buffer.size());
+
+  REQUIRE(!little_endian_btf_res.failed());
+
+  // Snapshots encode every field, so the types are the same if the
+  // snapshots are
+  auto expected_snapshot =
+      createSnapshotBuffer(*little_endian_btf_res.takeValue());
+
+  for (auto decoding_mode :
+       {BTFOptions::DecodingMode::Eager, BTFOptions::DecodingMode::Lazy,
+        BTFOptions::DecodingMode::Compact}) {
+
+    BTFOptions options;
+    options.decoding_mode = decoding_mode;
+
+    auto btf_res = IBTF::createFromBuffer(big_endian_buffer.data(),
+                                          big_endian_buffer.size(), options);
+
+    REQUIRE(!btf_res.failed());
+
+    auto btf = btf_res.takeValue();
+    REQUIRE(btf->count() == 9);
+    CHECK(createSnapshotBuffer(*btf) == expected_snapshot);
+
+    const auto &bits = std::get<StructBTFType>(*btf->getTypeRef(4));
+    REQUIRE(bits.member_list.size() == 2);
+    CHECK(bits.member_list[1].offset == 3);
+    CHECK(bits.member_list[1].opt_bitfield_size.value() == 5);
+
+    const auto &color = std::get<EnumBTFType>(*btf->getTypeRef(5));
+    REQUIRE(color.value_list.size() == 2);
+    CHECK(color.value_list[1].val == -1);
+
+    const auto &data_sec = std::get<DataSecBTFType>(*btf->getTypeRef(9));
+    REQUIRE(data_sec.variable_list.size() == 2);
+    CHECK(data_sec.variable_list[1].offset == 4);
+  }
+
+  // The streaming decoder uses the same specializations
+  std::vector<BTFKind> kind_list;
+  auto opt_error = IBTF::parseFromBuffer(
+      big_endian_buffer.data(), big_endian_buffer.size(),
+      [&](std::uint32_t, const BTFTypeView &btf_type_view) {
+        kind_list.push_back(IBTF::getBTFTypeKind(btf_type_view));
+        return true;
+      });
+
+  CHECK(!opt_error.has_value());
+  CHECK(kind_list.size() == 9);
+}
+
+TEST_CASE("IBTF::parseFromBuffer()") {
+  auto buffer = createTestBuilder().build();
+
+  std::vector<std::uint32_t> id_list;
+  std::vector<BTFKind> kind_list;
+
+  auto opt_error = IBTF::parseFromBuffer(
+      buffer.data(), buffer.size(),
+      [&](std::uint32_t id, const BTFTypeView &btf_type_view) {
+        id_list.push_back(id);
+        kind_list.push_back(IBTF::getBTFTypeKind(btf_type_view));
+
+        if (id == 3) {
+          const auto &pair = std::get<StructBTFTypeView>(btf_type_view);
+          CHECK(pair.opt_name.value() == "pair");
+          REQUIRE(pair.member_list.size() == 2);
+          CHECK(pair.member_list[1].opt_name.value() == "second");
+          CHECK(pair.member_list[1].offset == 32);
+        }
+
+        return true;
+      });
+
+  CHECK(!opt_error.has_value());
+  CHECK(id_list == std::vector<std::uint32_t>{1, 2, 3});
+  CHECK(kind_list ==
+        std::vector<BTFKind>{BTFKind::Int, BTFKind::Ptr, BTFKind::Struct});
+
+  // Stopping early is not an error
+  id_list.clear();
+  opt_error = IBTF::parseFromBuffer(
+      buffer.data(), buffer.size(), [&](std::uint32_t id, const BTFTypeView &) {
+        id_list.push_back(id);
+        return id < 2;
+      });
+
+  CHECK(!opt_error.has_value());
+  CHECK(id_list == std::vector<std::uint32_t>{1, 2});
+
+  auto accept_all = [](std::uint32_t, const BTFTypeView &) { return true; };
+  opt_error = IBTF::parseFromBuffer(buffer.data(), 8, accept_all);
+
+  CHECK(opt_error.has_value());
+}
+
+TEST_CASE("IBTF::parseFromBuffer() (decoding errors)") {
+  auto builder = createTestBuilder();
+  builder.addRawType(0xFFFFFF, static_cast<std::uint32_t>(BTFKind::Typedef), 0,
+                     1);
+
+  builder.addInt("long", 8);
+  auto buffer = builder.build();
+
+  // The types that precede the error have already been received
+  std::vector<std::uint32_t> id_list;
+  auto opt_error = IBTF::parseFromBuffer(
+      buffer.data(), buffer.size(), [&](std::uint32_t id, const BTFTypeView &) {
+        id_list.push_back(id);
+        return true;
+      });
+
+  auto btf_res = IBTF::createFromBuffer(buffer.data(), buffer.size());
+  REQUIRE(btf_res.failed());
+
+  REQUIRE(opt_error.has_value());
+  CHECK(opt_error->get().code == btf_res.takeError().get().code);
+
+  CHECK(id_list == std::vector<std::uint32_t>{1, 2, 3});
+}
+
+TEST_CASE("IBTF::parseFromPath()") {
+  auto path = createTestBuilder().save("btf");
+
+  std::vector<std::string> name_list;
+  auto opt_error = IBTF::parseFromPath(
+      path, [&](std::uint32_t, const BTFTypeView &btf_type_view) {
+        if (std::holds_alternative<IntBTFTypeView>(btf_type_view)) {
+          name_list.emplace_back(std::get<IntBTFTypeView>(btf_type_view).name);
+        }
+
+        return true;
+      });
+
+  std::filesystem::remove(path);
+
+  CHECK(!opt_error.has_value());
+  CHECK(name_list == std::vector<std::string>{"int"});
+
+  opt_error = IBTF::parseFromPath(
+      path, [](std::uint32_t, const BTFTypeView &) { return true; });
+
+  REQUIRE(opt_error.has_value());
+  CHECK(opt_error->get().code == BTFErrorInformation::Code::FileNotFound);
+}
+
+TEST_CASE("BTFOptions::stats_callback") {
+  std::optional<BTFParseStats> opt_stats;
+  std::vector<std::string> phase_list;
+
+  BTFOptions options;
+  options.stats_callback = [&opt_stats](const BTFParseStats &stats) {
+    opt_stats = stats;
+  };
+
+  options.trace_callback = [&phase_list](std::string_view phase,
+                                         std::chrono::nanoseconds) {
+    phase_list.emplace_back(phase);
+  };
+
+  auto btf = createTestBTF(options);
+
+  // Without telemetry, the callbacks are never called
+  if (!IBTF::isTelemetryEnabled()) {
+    CHECK(!opt_stats.has_value());
+    CHECK(phase_list.empty());
+    return;
+  }
+
+  REQUIRE(opt_stats.has_value());
+  CHECK(opt_stats->bytes_read == createTestBuilder().build().size());
+  CHECK(opt_stats->stream_read_count == 0);
+  CHECK(opt_stats->string_lookup_count >= 4);
+
+  const auto &kind_stats_list = opt_stats->kind_stats_list;
+  CHECK(kind_stats_list[static_cast<std::size_t>(BTFKind::Int)].type_count ==
+        1);
+
+  CHECK(kind_stats_list[static_cast<std::size_t>(BTFKind::Ptr)].type_count ==
+        1);
+
+  CHECK(
+      kind_stats_list[static_cast<std::size_t>(BTFKind::Struct)].type_count ==
+      1);
+
+  CHECK(phase_list ==
+        std::vector<std::string>{"openBTFFileList", "createStringTable",
+                                 "parseTypeSections", "parse"});
+
+  // Failed parses are reported as well
+  opt_stats.reset();
+
+  auto builder = createTestBuilder();
+  builder.addRawType(0xFFFFFF, static_cast<std::uint32_t>(BTFKind::Typedef), 0,
+                     1);
+
+  CHECK(createBTF(builder, options).failed());
+
+  REQUIRE(opt_stats.has_value());
+  CHECK(opt_stats->kind_stats_list[static_cast<std::size_t>(BTFKind::Struct)]
+            .type_count == 1);
+}
+
+TEST_CASE("IBTF::createFromStream()") {
+  class TestStream final : public IStream {
+  public:
+    TestStream(std::vector<std::uint8_t> buffer)
+        : stream_buffer(std::move(buffer)) {}
+
+    virtual ~TestStream() override = default;
+
+    virtual bool seek(std::uint64_t offset) override {
+      if (offset >= stream_buffer.size()) {
+        return false;
+      }
+
+      stream_pos = static_cast<std::size_t>(offset);
+      return true;
+    }
+
+    virtual std::uint64_t offset() const override { return stream_pos; }
+
+    virtual bool read(std::uint8_t *buffer, std::size_t size) override {
+      if (size > stream_buffer.size() - stream_pos) {
+        return false;
+      }
+
+      auto source_it =
+          stream_buffer.begin() + static_cast<std::ptrdiff_t>(stream_pos);
+
+      std::copy_n(source_it, size, buffer);
+
+      stream_pos += size;
+      return true;
+    }
+
+  private:
+    std::vector<std::uint8_t> stream_buffer;
+    std::size_t stream_pos{};
+  };
+
+  auto btf_res = IBTF::createFromStream(
+      std::make_unique<TestStream>(createTestBuilder().build()));
+
+  REQUIRE(!btf_res.failed());
+
+  auto btf = btf_res.takeValue();
+  CHECK(btf->count() == 3);
+  CHECK(getStructNameList(*btf) == std::vector<std::string>{"pair.first"});
+
+  std::optional<BTFParseStats> opt_stats;
+
+  BTFOptions options;
+  options.stats_callback = [&opt_stats](const BTFParseStats &stats) {
+    opt_stats = stats;
+  };
+
+  btf_res = IBTF::createFromStream(
+      std::make_unique<TestStream>(createTestBuilder().build()), options);
+
+  REQUIRE(!btf_res.failed());
+  CHECK(opt_stats.has_value() == IBTF::isTelemetryEnabled());
+
+  if (opt_stats.has_value()) {
+    CHECK(opt_stats->stream_read_count > 0);
+    CHECK(opt_stats->stream_seek_count > 0);
+  }
+}
+
+TEST_CASE("IBTF::createFromELF()") {
+  auto builder = createTestBuilder();
+
+  auto image = builder.buildELF();
+  auto btf_res = IBTF::createFromELFBuffer(image.data(), image.size());
+  REQUIRE(!btf_res.failed());
+  CHECK(btf_res.takeValue()->count() == 3);
+
+  auto path = builder.saveELF("elf");
+  btf_res = IBTF::createFromELF(path);
+  REQUIRE(!btf_res.failed());
+
+  IBTF::SharedPtr base_btf = btf_res.takeValue();
+  CHECK(getStructNameList(*base_btf) ==
+        std::vector<std::string>{"pair.first"});
+
+  auto split_builder = BTFBuilder::createSplit(builder);
+  split_builder.addPtr(3);
+
+  auto split_path = split_builder.saveELF("split-elf");
+  btf_res = IBTF::createSplitFromELF(base_btf, split_path);
+  REQUIRE(!btf_res.failed());
+  CHECK(btf_res.takeValue()->getKind(4) == BTFKind::Ptr);
+
+  // Raw BTF blobs are not ELF files
+  auto raw_path = builder.save("raw");
+  btf_res = IBTF::createFromELF(raw_path);
+  REQUIRE(btf_res.failed());
+  CHECK(btf_res.error().get().code ==
+        BTFErrorInformation::Code::InvalidELFFile);
+
+  std::filesystem::remove(path);
+  std::filesystem::remove(split_path);
+  std::filesystem::remove(raw_path);
+}
+
+} // namespace btfparse
@@ -0,0 +1,263 @@
+//
+// Copyright (c) 2021-present, Trail of Bits, Inc.
+// All rights reserved.
+//
+// This source code is licensed in accordance with the terms specified in
+// the LICENSE file found in the root directory of this source tree.
+//
+
+#pragma once
+
+#include <doctest/doctest.h>
+
+#include <btfparse/ibtf.h>
+
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <unistd.h>
+
+namespace btfparse {
+
+/// Builds small BTF blobs for the tests, in either byte order
+class BTFBuilder final {
+public:
+  struct Member final {
+    std::string name;
+    std::uint32_t type{};
+    std::uint32_t offset{};
+  };
+
+  BTFBuilder() : string_section(1, '\0') {}
+
+  // Split BTF blobs continue the string offsets of their base
+  static BTFBuilder createSplit(const BTFBuilder &base_builder) {
+    BTFBuilder builder;
+    builder.string_offset_base = base_builder.stringOffsetEnd();
+
+    return builder;
+  }
+
+  std::uint32_t stringOffsetEnd() const {
+    return string_offset_base +
+           static_cast<std::uint32_t>(string_section.size());
+  }
+
+  // ID that the next type added to the builder will receive
+  std::uint32_t nextTypeID() const { return type_count + 1; }
+
+  std::uint32_t addString(const std::string &str) {
+    if (str.empty()) {
+      return 0;
+    }
+
+    auto offset = stringOffsetEnd();
+    string_section.insert(string_section.end(), str.begin(), str.end());
+    string_section.push_back('\0');
+
+    return offset;
+  }
+
+  std::uint32_t addType(const std::string &name, BTFKind kind,
+                        std::uint32_t vlen, std::uint32_t size_or_type,
+                        const std::vector<std::uint32_t> &payload = {}) {
+    return addRawType(addString(name), static_cast<std::uint32_t>(kind), vlen,
+                      size_or_type, payload);
+  }
+
+  std::uint32_t addRawType(std::uint32_t name_off, std::uint32_t kind,
+                           std::uint32_t vlen, std::uint32_t size_or_type,
+                           const std::vector<std::uint32_t> &payload = {}) {
+    appendU32(name_off);
+    appendU32((kind << 24) | vlen);
+    appendU32(size_or_type);
+
+    for (const auto &value : payload) {
+      appendU32(value);
+    }
+
+    return ++type_count;
+  }
+
+  std::uint32_t addInt(const std::string &name, std::uint32_t size) {
+    return addType(name, BTFKind::Int, 0, size, {size * 8U});
+  }
+
+  std::uint32_t addPtr(std::uint32_t type) {
+    return addType({}, BTFKind::Ptr, 0, type);
+  }
+
+  std::uint32_t addStruct(const std::string &name, std::uint32_t size,
+                          const std::vector<Member> &member_list) {
+    std::vector<std::uint32_t> payload;
+    for (const auto &member : member_list) {
+      payload.push_back(addString(member.name));
+      payload.push_back(member.type);
+      payload.push_back(member.offset);
+    }
+
+    return addType(name, BTFKind::Struct,
+                   static_cast<std::uint32_t>(member_list.size()), size,
+                   payload);
+  }
+
+  std::vector<std::uint8_t> build() const {
+    std::vector<std::uint8_t> buffer{0x9F, 0xEB, 0x01, 0x00};
+
+    auto type_len = static_cast<std::uint32_t>(type_section.size());
+    auto str_len = static_cast<std::uint32_t>(string_section.size());
+
+    for (auto value : {24U, 0U, type_len, type_len, str_len}) {
+      for (std::size_t i = 0; i < 4; ++i) {
+        buffer.push_back(static_cast<std::uint8_t>(value >> (i * 8U)));
+      }
+    }
+
+    buffer.insert(buffer.end(), type_section.begin(), type_section.end());
+    buffer.insert(buffer.end(), string_section.begin(), string_section.end());
+
+    return buffer;
+  }
+
+  // The type section only contains 32-bit words, so swapping every word
+  // of the header and of the type data is enough
+  std::vector<std::uint8_t> buildBigEndian() const {
+    auto buffer = build();
+    std::swap(buffer[0], buffer[1]);
+
+    auto type_section_end = 24 + type_section.size();
+    for (std::size_t offset = 4; offset < type_section_end; offset += 4) {
+      std::swap(buffer[offset], buffer[offset + 3]);
+      std::swap(buffer[offset + 1], buffer[offset + 2]);
+    }
+
+    return buffer;
+  }
+
+  // Wraps the BTF blob in the .BTF section of a little endian ELF64 image
+  std::vector<std::uint8_t> buildELF() const {
+    const std::string kStringTable{"\0.BTF\0.shstrtab\0", 16};
+    const std::size_t kHeaderSize{0x40};
+
+    auto btf_section = build();
+    auto string_table_offset = kHeaderSize + btf_section.size();
+    auto section_header_table_offset =
+        string_table_offset + kStringTable.size();
+
+    std::vector<std::uint8_t> image{0x7F, 'E', 'L', 'F', 2, 1, 1};
+    image.resize(kHeaderSize);
+    image.insert(image.end(), btf_section.begin(), btf_section.end());
+    image.insert(image.end(), kStringTable.begin(), kStringTable.end());
+
+    // e_shoff, followed by e_shentsize, e_shnum and e_shstrndx
+    writeU64(image, 0x28, section_header_table_offset);
+    writeU64(image, 0x3A, 0x40 | (3U << 16) | (2ULL << 32), 6);
+
+    // The null section, .BTF and .shstrtab
+    std::vector<std::vector<std::uint64_t>> section_header_list{
+        {0, 0, 0, 0},
+        {1, 1, kHeaderSize, btf_section.size()},
+        {6, 3, string_table_offset, kStringTable.size()},
+    };
+
+    for (const auto &section_header : section_header_list) {
+      auto offset = image.size();
+      image.resize(offset + 0x40);
+
+      writeU64(image, offset, section_header[0] | (section_header[1] << 32));
+      writeU64(image, offset + 0x18, section_header[2]);
+      writeU64(image, offset + 0x20, section_header[3]);
+    }
+
+    return image;
+  }
+
+  std::filesystem::path save(const std::string &name) const {
+    return save(name, build());
+  }
+
+  std::filesystem::path saveELF(const std::string &name) const {
+    return save(name, buildELF());
+  }
+
+private:
+  std::vector<std::uint8_t> type_section;
+  std::vector<char> string_section;
+  std::uint32_t type_count{};
+  std::uint32_t string_offset_base{};
+
+  std::filesystem::path save(const std::string &name,
+                             const std::vector<std::uint8_t> &buffer) const {
+    auto path = std::filesystem::temp_directory_path() /
+                ("btfparse-tests-" + name + "-" + std::to_string(getpid()));
+
+    std::ofstream output_file(path, std::ios::binary | std::ios::trunc);
+    output_file.write(reinterpret_cast<const char *>(buffer.data()),
+                      static_cast<std::streamsize>(buffer.size()));
+
+    return path;
+  }
+
+  static void writeU64(std::vector<std::uint8_t> &buffer, std::size_t offset,
+                       std::uint64_t value, std::size_t size = 8) {
+    for (std::size_t i = 0; i < size; ++i) {
+      buffer[offset + i] = static_cast<std::uint8_t>(value >> (i * 8U));
+    }
+  }
+
+  void appendU32(std::uint32_t value) {
+    for (std::size_t i = 0; i < 4; ++i) {
+      type_section.push_back(static_cast<std::uint8_t>(value >> (i * 8U)));
+    }
+  }
+};
+
+inline void writeFile(const std::filesystem::path &path,
+                      const std::vector<std::uint8_t> &buffer) {
+  std::ofstream output_file(path, std::ios::binary | std::ios::trunc);
+  output_file.write(reinterpret_cast<const char *>(buffer.data()),
+                    static_cast<std::streamsize>(buffer.size()));
+}
+
+// An empty temporary directory that holds the BTF file of a test
+struct TestEnvironment final {
+  std::filesystem::path directory;
+  BTFBuilder builder;
+};
+
+inline TestEnvironment createTestEnvironment(const std::string &name,
+                                             const std::string &btf_file_name,
+                                             BTFBuilder builder) {
+  TestEnvironment environment;
+  environment.directory =
+      std::filesystem::temp_directory_path() /
+      ("btfparse-tests-" + name + "-" + std::to_string(getpid()));
+
+  std::filesystem::remove_all(environment.directory);
+  std::filesystem::create_directories(environment.directory);
+
+  writeFile(environment.directory / btf_file_name, builder.build());
+  environment.builder = std::move(builder);
+
+  return environment;
+}
+
+inline std::vector<std::uint8_t> createSnapshotBuffer(const IBTF &btf) {
+  auto snapshot_res = IBTF::createSnapshotBuffer(btf);
+  REQUIRE(!snapshot_res.failed());
+
+  return snapshot_res.takeValue();
+}
+
+// Returns the error of an IBTF factory call, which must have failed
+inline BTFErrorInformation::Code
+getErrorCode(Result<IBTF::Ptr, BTFError> btf_res) {
+  REQUIRE(btf_res.failed());
+  return btf_res.takeError().get().code;
+}
+
+} // namespace btfparse
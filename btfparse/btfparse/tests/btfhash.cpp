@@ -0,0 +1,68 @@
+//
+// Copyright (c) 2021-present, Trail of Bits, Inc.
+// All rights reserved.
+//
+// This source code is licensed in accordance with the terms specified in
+// the LICENSE file found in the root directory of this source tree.
+//
+
+#include "btfhash.h"
+
+#include <doctest/doctest.h>
+
+#include <iomanip>
+#include <sstream>
+#include <string>
+
+namespace btfparse {
+
+namespace {
+
+std::string toHexString(const SHA256Hash::Digest &digest) {
+  std::stringstream buffer;
+  buffer << std::hex << std::setfill('0');
+  for (auto byte : digest) {
+    buffer << std::setw(2) << static_cast<unsigned int>(byte);
+  }
+
+  return buffer.str();
+}
+
+std::string getSHA256(const std::string &message) {
+  SHA256Hash hash;
+  hash.update(reinterpret_cast<const std::uint8_t *>(message.data()),
+              message.size());
+
+  return toHexString(hash.finalize());
+}
+
+} // namespace
+
+TEST_CASE("SHA256Hash") {
+  // FIPS 180-2 test vectors
+  CHECK(getSHA256("") ==
+        "e3b0c44298fc1c149afbf4c8996fb92427ae41e4649b934ca495991b7852b855");
+
+  CHECK(getSHA256("abc") ==
+        "ba7816bf8f01cfea414140de5dae2223b00361a396177a9cb410ff61f20015ad");
+
+  CHECK(getSHA256("abcdbcdecdefdefgefghfghighijhijkijkljklmklmnlmnomnopnopq") ==
+        "248d6a61d20638b8e5c026930c3e6039a33ce45964ff2167f6ecedd419db06c1");
+
+  CHECK(getSHA256(std::string(1000000, 'a')) ==
+        "cdc76e5c9914fb9281a1c7e284d73e67f1809a48a497200e046d39ccc7112cd0");
+
+  // Splitting the input does not change the digest
+  std::string message(200, 'x');
+
+  SHA256Hash hash;
+  for (std::size_t i = 0; i < message.size(); i += 7) {
+    auto size = std::min<std::size_t>(7, message.size() - i);
+    hash.update(reinterpret_cast<const std::uint8_t *>(message.data() + i),
+                size);
+  }
+
+  CHECK(toHexString(hash.finalize()) == getSHA256(message));
+}
+
+} // namespace btfparse
@@ -0,0 +1,175 @@
+//
+// Copyright (c) 2021-present, Trail of Bits, Inc.
+// All rights reserved.
+//
+// This source code is licensed in accordance with the terms specified in
+// the LICENSE file found in the root directory of this source tree.
+//
+
+#include "btfbuilder.h"
+#include "btfheadercache.h"
+
+#include <doctest/doctest.h>
+
+#include <fstream>
+#include <sstream>
+
+namespace btfparse {
+
+namespace {
+
+TestEnvironment createTestEnvironment(const std::string &name) {
+  BTFBuilder builder;
+  auto int_id = builder.addInt("int", 4);
+  auto node_id = builder.addStruct("node", 4, {{"value", int_id, 0}});
+  builder.addStruct("outer", 8, {{"node", node_id, 0}});
+
+  return createTestEnvironment("headercache-" + name, "test.btf",
+                               std::move(builder));
+}
+
+std::filesystem::path getBTFPath(const TestEnvironment &environment) {
+  return environment.directory / "test.btf";
+}
+
+std::filesystem::path getCacheDirectory(const TestEnvironment &environment) {
+  return environment.directory / "cache";
+}
+
+std::string generateDirectly(const std::filesystem::path &btf_path,
+                             const BTFHeaderGeneratorOptions &options) {
+  auto btf_res = IBTF::createFromPath(btf_path);
+  REQUIRE(!btf_res.failed());
+
+  auto btf = btf_res.takeValue();
+  auto header_generator = IBTFHeaderGenerator::create();
+  REQUIRE(header_generator != nullptr);
+
+  std::string header;
+  REQUIRE(header_generator->generate(header, btf, options));
+
+  return header;
+}
+
+std::vector<std::filesystem::path>
+listCacheEntries(const std::filesystem::path &cache_directory) {
+  std::vector<std::filesystem::path> cache_entry_list;
+  for (const auto &entry :
+       std::filesystem::directory_iterator(cache_directory)) {
+    cache_entry_list.push_back(entry.path());
+  }
+
+  return cache_entry_list;
+}
+
+} // namespace
+
+TEST_CASE("BTFHeaderCache::generate (cache miss)") {
+  auto environment = createTestEnvironment("miss");
+
+  auto header_cache_res =
+      IBTFHeaderCache::create(getCacheDirectory(environment));
+  REQUIRE(!header_cache_res.failed());
+
+  auto header_cache = header_cache_res.takeValue();
+
+  std::stringstream buffer;
+  auto opt_error = header_cache->generate(buffer, {getBTFPath(environment)});
+  REQUIRE(!opt_error.has_value());
+
+  auto expected_header =
+      generateDirectly(getBTFPath(environment), BTFHeaderGeneratorOptions{});
+  CHECK(buffer.str() == expected_header);
+
+  auto cache_entry_list = listCacheEntries(getCacheDirectory(environment));
+  REQUIRE(cache_entry_list.size() == 1);
+  CHECK(cache_entry_list[0].extension() == ".h");
+
+  std::ifstream cache_entry(cache_entry_list[0], std::ios::binary);
+  std::stringstream cache_entry_contents;
+  cache_entry_contents << cache_entry.rdbuf();
+  CHECK(cache_entry_contents.str() == expected_header);
+
+  std::filesystem::remove_all(environment.directory);
+}
+
+TEST_CASE("BTFHeaderCache::generate (cache hit)") {
+  auto environment = createTestEnvironment("hit");
+
+  auto header_cache_res =
+      IBTFHeaderCache::create(getCacheDirectory(environment));
+  REQUIRE(!header_cache_res.failed());
+
+  auto header_cache = header_cache_res.takeValue();
+
+  std::stringstream buffer;
+  REQUIRE(
+      !header_cache->generate(buffer, {getBTFPath(environment)}).has_value());
+
+  // Replace the entry, so that we can tell whether it was reused
+  auto cache_entry_list = listCacheEntries(getCacheDirectory(environment));
+  REQUIRE(cache_entry_list.size() == 1);
+
+  {
+    std::ofstream cache_entry(cache_entry_list[0],
+                              std::ios::binary | std::ios::trunc);
+    cache_entry << "// cached header\n";
+  }
+
+  buffer = std::stringstream();
+  REQUIRE(
+      !header_cache->generate(buffer, {getBTFPath(environment)}).has_value());
+  CHECK(buffer.str() == "// cached header\n");
+
+  std::filesystem::remove_all(environment.directory);
+}
+
+TEST_CASE("BTFHeaderCache::generate (options)") {
+  auto environment = createTestEnvironment("options");
+
+  auto header_cache_res =
+      IBTFHeaderCache::create(getCacheDirectory(environment));
+  REQUIRE(!header_cache_res.failed());
+
+  auto header_cache = header_cache_res.takeValue();
+
+  std::stringstream buffer;
+  REQUIRE(
+      !header_cache->generate(buffer, {getBTFPath(environment)}).has_value());
+
+  BTFHeaderGeneratorOptions options;
+  options.root_type_name_list.push_back("node");
+
+  buffer = std::stringstream();
+  REQUIRE(!header_cache->generate(buffer, {getBTFPath(environment)}, options)
+               .has_value());
+
+  CHECK(buffer.str() == generateDirectly(getBTFPath(environment), options));
+  CHECK(listCacheEntries(getCacheDirectory(environment)).size() == 2);
+
+  std::filesystem::remove_all(environment.directory);
+}
+
+TEST_CASE("BTFHeaderCache::generate (missing file)") {
+  auto environment = createTestEnvironment("missing");
+
+  auto header_cache_res =
+      IBTFHeaderCache::create(getCacheDirectory(environment));
+  REQUIRE(!header_cache_res.failed());
+
+  auto header_cache = header_cache_res.takeValue();
+
+  std::stringstream buffer;
+  auto opt_error = header_cache->generate(
+      buffer, {environment.directory / "missing.btf"});
+
+  REQUIRE(opt_error.has_value());
+  CHECK(opt_error->get().code ==
+        BTFHeaderCacheErrorInformation::Code::FileNotFound);
+
+  CHECK(listCacheEntries(getCacheDirectory(environment)).empty());
+
+  std::filesystem::remove_all(environment.directory);
+}
+
+} // namespace btfparse
@@ -0,0 +1,339 @@
+//
+// Copyright (c) 2021-present, Trail of Bits, Inc.
+// All rights reserved.
+//
+// This source code is licensed in accordance with the terms specified in
+// the LICENSE file found in the root directory of this source tree.
+//
+
+#include "btfbuilder.h"
+
+#include <doctest/doctest.h>
+
+#include <btfparse/ibtfheadergenerator.h>
+
+#include <sstream>
+
+namespace btfparse {
+
+namespace {
+
+struct TestTypeIDs final {
+  std::uint32_t outer{};
+  std::uint32_t inner{};
+};
+
+// struct outer embeds struct inner, which points to struct node. The
+// unrelated struct is not referenced by any other type
+BTFBuilder createTestBuilder(TestTypeIDs &type_ids) {
+  BTFBuilder builder;
+  auto int_id = builder.addInt("int", 4);
+
+  auto node_id = builder.addStruct("node", 4, {{"value", int_id, 0}});
+  auto node_ptr_id = builder.addPtr(node_id);
+
+  type_ids.inner = builder.addStruct(
+      "inner", 16, {{"value", int_id, 0}, {"node", node_ptr_id, 64}});
+
+  type_ids.outer =
+      builder.addStruct("outer", 16, {{"inner", type_ids.inner, 0}});
+
+  builder.addType("outer_t", BTFKind::Typedef, 0, type_ids.outer);
+  builder.addStruct("unrelated", 4, {{"value", int_id, 0}});
+
+  return builder;
+}
+
+IBTF::Ptr createTestBTF() {
+  TestTypeIDs type_ids;
+  auto buffer = createTestBuilder(type_ids).build();
+
+  auto btf_res = IBTF::createFromBuffer(buffer.data(), buffer.size());
+  REQUIRE(!btf_res.failed());
+
+  return btf_res.takeValue();
+}
+
+bool generateHeader(std::string &header,
+                    const BTFHeaderGeneratorOptions &options) {
+  auto btf = createTestBTF();
+  return IBTFHeaderGenerator::create()->generate(header, btf, options);
+}
+
+// Enough declarations to be split across multiple tasks and batches
+IBTF::Ptr createLargeTestBTF() {
+  const std::uint32_t kStructCount{6000U};
+
+  BTFBuilder builder;
+  auto int_id = builder.addInt("int", 4);
+
+  // Each struct embeds the previous one, followed by a pointer to it
+  std::uint32_t struct_size{8U};
+  auto type_id = builder.addStruct("s0", struct_size, {{"value", int_id, 0}});
+
+  for (std::uint32_t i = 1; i < kStructCount; ++i) {
+    auto ptr_id = builder.addPtr(type_id);
+    type_id = builder.addStruct(
+        "s" + std::to_string(i), struct_size + 8U,
+        {{"value", type_id, 0}, {"ptr", ptr_id, struct_size * 8U}});
+
+    struct_size += 8U;
+  }
+
+  auto buffer = builder.build();
+  auto btf_res = IBTF::createFromBuffer(buffer.data(), buffer.size());
+  REQUIRE(!btf_res.failed());
+
+  return btf_res.takeValue();
+}
+
+bool contains(const std::string &header, const std::string &str) {
+  return header.find(str) != std::string::npos;
+}
+
+} // namespace
+
+TEST_CASE("BTFHeaderGenerator::generate") {
+  std::string header;
+  REQUIRE(generateHeader(header, BTFHeaderGeneratorOptions{}));
+
+  CHECK(contains(header, "struct node {"));
+  CHECK(contains(header, "struct inner {"));
+  CHECK(contains(header, "struct outer {"));
+  CHECK(contains(header, "outer_t;"));
+  CHECK(contains(header, "struct unrelated {"));
+}
+
+TEST_CASE("BTFHeaderGenerator::generate (output stream)") {
+  auto btf = createTestBTF();
+  auto header_generator = IBTFHeaderGenerator::create();
+
+  std::string header;
+  REQUIRE(header_generator->generate(header, btf));
+
+  std::stringstream stream;
+  REQUIRE(header_generator->generate(stream, btf));
+  CHECK(stream.str() == header);
+}
+
+TEST_CASE("BTFHeaderGenerator::generate (output callback)") {
+  auto btf = createTestBTF();
+  auto header_generator = IBTFHeaderGenerator::create();
+
+  std::string header;
+  REQUIRE(header_generator->generate(header, btf));
+
+  // The header is emitted in multiple chunks, that add up to the
+  // same output
+  std::vector<std::string> chunk_list;
+  REQUIRE(header_generator->generate(
+      [&chunk_list](std::string_view chunk) -> bool {
+        chunk_list.emplace_back(chunk);
+        return true;
+      },
+      btf));
+
+  CHECK(chunk_list.size() > 2);
+
+  std::string joined_chunks;
+  for (const auto &chunk : chunk_list) {
+    joined_chunks += chunk;
+  }
+
+  CHECK(joined_chunks == header);
+
+  // Stopping the output makes the generation fail
+  std::size_t chunk_count{};
+  CHECK_FALSE(header_generator->generate(
+      [&chunk_count](std::string_view) -> bool {
+        ++chunk_count;
+        return chunk_count < 2;
+      },
+      btf));
+
+  CHECK(chunk_count == 2);
+}
+
+TEST_CASE("BTFHeaderGenerator::generate (stats)") {
+  std::optional<BTFHeaderGeneratorStats> opt_stats;
+  std::vector<std::string> trace_phase_list;
+
+  BTFHeaderGeneratorOptions options;
+  options.stats_callback =
+      [&opt_stats](const BTFHeaderGeneratorStats &stats) { opt_stats = stats; };
+
+  options.trace_callback = [&trace_phase_list](std::string_view phase,
+                                               std::chrono::nanoseconds) {
+    trace_phase_list.emplace_back(phase);
+  };
+
+  std::string header;
+  REQUIRE(generateHeader(header, options));
+
+  if (!IBTF::isTelemetryEnabled()) {
+    CHECK(!opt_stats.has_value());
+    CHECK(trace_phase_list.empty());
+    return;
+  }
+
+  REQUIRE(opt_stats.has_value());
+  CHECK(opt_stats->output_size == header.size());
+
+  std::vector<std::string> phase_list;
+  for (const auto &phase : opt_stats->phase_list) {
+    phase_list.push_back(phase.name);
+    CHECK(phase.duration <= opt_stats->generation_time);
+  }
+
+  CHECK(phase_list ==
+        std::vector<std::string>{
+            "saveBTFTypeMap", "adjustTypeNames", "scanTypes",
+            "resolveRootTypes", "materializePadding", "createTypeTree",
+            "adjustTypedefDependencyLoops", "createTypeQueue",
+            "generateHeader"});
+
+  phase_list.push_back("generate");
+  CHECK(trace_phase_list == phase_list);
+}
+
+TEST_CASE("BTFHeaderGenerator::generate (deep dependency chains)") {
+  // Each struct embeds the previous one, and is accessed through a long
+  // chain of const qualifiers
+  const std::uint32_t kChainLength{20000U};
+
+  BTFBuilder builder;
+  auto type_id = builder.addInt("int", 4);
+
+  for (std::uint32_t i = 0; i < kChainLength; ++i) {
+    type_id = builder.addType({}, BTFKind::Const, 0, type_id);
+  }
+
+  for (std::uint32_t i = 0; i < kChainLength; ++i) {
+    type_id = builder.addStruct("s" + std::to_string(i), 4,
+                                {{"value", type_id, 0}});
+  }
+
+  auto buffer = builder.build();
+  auto btf_res = IBTF::createFromBuffer(buffer.data(), buffer.size());
+  REQUIRE(!btf_res.failed());
+
+  auto btf = btf_res.takeValue();
+
+  BTFHeaderGeneratorOptions options;
+  options.root_type_name_list = {"s" + std::to_string(kChainLength - 1U)};
+
+  std::string header;
+  REQUIRE(IBTFHeaderGenerator::create()->generate(header, btf, options));
+
+  auto first_struct_pos = header.find("struct s0 {");
+  auto last_struct_pos =
+      header.find("struct s" + std::to_string(kChainLength - 1U) + " {");
+
+  REQUIRE(first_struct_pos != std::string::npos);
+  REQUIRE(last_struct_pos != std::string::npos);
+  CHECK(first_struct_pos < last_struct_pos);
+}
+
+TEST_CASE("BTFHeaderGenerator::generate (multiple threads)") {
+  auto btf = createLargeTestBTF();
+  auto generator = IBTFHeaderGenerator::create();
+
+  std::string expected_header;
+  REQUIRE(generator->generate(expected_header, btf));
+
+  BTFHeaderGeneratorOptions options;
+  options.thread_count = 4;
+
+  std::size_t call_count{0};
+  std::string header;
+
+  auto callback = [&](std::string_view chunk) -> bool {
+    ++call_count;
+    header.append(chunk);
+    return true;
+  };
+
+  REQUIRE(generator->generate(callback, btf, options));
+  CHECK(header == expected_header);
+
+  // The pragma directives, and then one call per declaration
+  CHECK(call_count > 6000U);
+}
+
+TEST_CASE("BTFHeaderGenerator::generate (custom executor)") {
+  auto btf = createLargeTestBTF();
+  auto generator = IBTFHeaderGenerator::create();
+
+  std::string expected_header;
+  REQUIRE(generator->generate(expected_header, btf));
+
+  std::size_t executor_call_count{0};
+
+  BTFHeaderGeneratorOptions options;
+  options.thread_count = 3;
+  options.executor = [&](const BTFOptions::TaskList &task_list) {
+    ++executor_call_count;
+    CHECK(task_list.size() == 3U);
+
+    for (auto it = task_list.rbegin(); it != task_list.rend(); ++it) {
+      (*it)();
+    }
+  };
+
+  std::string header;
+  REQUIRE(generator->generate(header, btf, options));
+
+  CHECK(executor_call_count > 1U);
+  CHECK(header == expected_header);
+}
+
+TEST_CASE("BTFHeaderGenerator::generate (root type names)") {
+  BTFHeaderGeneratorOptions options;
+  options.root_type_name_list = {"outer_t"};
+
+  std::string header;
+  REQUIRE(generateHeader(header, options));
+
+  // Types that are only reached through a pointer are forward declared
+  CHECK(contains(header, "struct node;"));
+  CHECK_FALSE(contains(header, "struct node {"));
+
+  CHECK(contains(header, "struct inner {"));
+  CHECK(contains(header, "struct outer {"));
+  CHECK(contains(header, "outer_t;"));
+  CHECK_FALSE(contains(header, "unrelated"));
+
+  // Dependencies must come before the types that use them
+  CHECK(header.find("struct inner {") < header.find("struct outer {"));
+}
+
+TEST_CASE("BTFHeaderGenerator::generate (root type IDs)") {
+  TestTypeIDs type_ids;
+  createTestBuilder(type_ids);
+
+  BTFHeaderGeneratorOptions options;
+  options.root_type_id_list = {type_ids.inner};
+
+  std::string header;
+  REQUIRE(generateHeader(header, options));
+
+  CHECK(contains(header, "struct node;"));
+  CHECK(contains(header, "struct inner {"));
+  CHECK_FALSE(contains(header, "outer"));
+  CHECK_FALSE(contains(header, "unrelated"));
+}
+
+TEST_CASE("BTFHeaderGenerator::generate (invalid root types)") {
+  std::string header;
+
+  BTFHeaderGeneratorOptions options;
+  options.root_type_name_list = {"missing"};
+  CHECK_FALSE(generateHeader(header, options));
+
+  // Pointers and integers are not top level types
+  options = {};
+  options.root_type_id_list = {1};
+  CHECK_FALSE(generateHeader(header, options));
+}
+
+} // namespace btfparse
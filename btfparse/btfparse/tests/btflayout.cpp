@@ -0,0 +1,314 @@
+//
+// Copyright (c) 2021-present, Trail of Bits, Inc.
+// All rights reserved.
+//
+// This source code is licensed in accordance with the terms specified in
+// the LICENSE file found in the root directory of this source tree.
+//
+
+#include "btfbuilder.h"
+
+#include <doctest/doctest.h>
+
+#include <btfparse/ibtflayout.h>
+
+namespace btfparse {
+
+namespace {
+
+using OffsetList = std::vector<std::uint64_t>;
+using ErrorCode = BTFLayoutErrorInformation::Code;
+
+const std::uint32_t kKindFlag{0x80};
+const std::uint32_t kTypeCount{21};
+
+BTFBuilder createTestBuilder() {
+  BTFBuilder builder;
+  auto int_id = builder.addInt("int", 4);
+  auto long_id = builder.addInt("long", 8);
+  auto char_id = builder.addInt("char", 1);
+
+  // The pointer is added before the struct it points to
+  auto signal_ptr_id = builder.addPtr(10);
+
+  auto long_t_id = builder.addType("long_t", BTFKind::Typedef, 0, long_id);
+  auto const_long_t_id = builder.addType({}, BTFKind::Const, 0, long_t_id);
+  auto values_id =
+      builder.addType({}, BTFKind::Array, 0, 0, {int_id, int_id, 4});
+
+  auto rlimit_id = builder.addStruct(
+      "rlimit", 16, {{"rlim_cur", long_id, 0}, {"rlim_max", long_t_id, 64}});
+
+  auto rlimit_array_id =
+      builder.addType({}, BTFKind::Array, 0, 0, {rlimit_id, int_id, 2});
+
+  builder.addStruct("signal", 40,
+                    {{"count", int_id, 0}, {"rlim", rlimit_array_id, 64}});
+
+  auto anon_union_id = builder.addType(
+      {}, BTFKind::Union, 2, 8,
+      {builder.addString("a"), long_id, 0, builder.addString("b"), int_id, 0});
+
+  builder.addStruct("task", 40,
+                    {{"id", const_long_t_id, 0},
+                     {{}, anon_union_id, 64},
+                     {"sig", signal_ptr_id, 128},
+                     {"values", values_id, 192}});
+
+  builder.addStruct("packed", 5, {{"c", char_id, 0}, {"v", int_id, 8}});
+
+  builder.addRawType(builder.addString("flags"),
+                     static_cast<std::uint32_t>(BTFKind::Struct) | kKindFlag,
+                     2, 4,
+                     {builder.addString("low"), int_id, (3U << 24) | 0U,
+                      builder.addString("high"), int_id, (5U << 24) | 3U});
+
+  auto loop_a_id = builder.nextTypeID();
+  builder.addType("loop_a", BTFKind::Typedef, 0, loop_a_id + 1);
+  builder.addType("loop_b", BTFKind::Typedef, 0, loop_a_id);
+
+  // Members that point to a forward declaration are resolved through the
+  // definition
+  auto signal_fwd_id = builder.addType("signal", BTFKind::Fwd, 0, 0);
+  builder.addStruct("holder", 8, {{"s", builder.addPtr(signal_fwd_id), 0}});
+
+  auto cyclic_id = builder.nextTypeID();
+  builder.addStruct("cyclic", 8, {{"self", cyclic_id + 1, 0}});
+  builder.addPtr(cyclic_id);
+
+  REQUIRE(builder.nextTypeID() == kTypeCount + 1);
+  return builder;
+}
+
+IBTF::Ptr createTestBTF(const std::vector<std::uint8_t> &buffer,
+                        BTFOptions::DecodingMode decoding_mode) {
+  BTFOptions options;
+  options.decoding_mode = decoding_mode;
+
+  auto btf_res = IBTF::createFromBuffer(buffer.data(), buffer.size(), options);
+  REQUIRE(!btf_res.failed());
+
+  return btf_res.takeValue();
+}
+
+IBTFLayout::Ptr createTestLayout(const IBTF &btf) {
+  auto layout_res = IBTFLayout::create(btf);
+  REQUIRE(!layout_res.failed());
+
+  return layout_res.takeValue();
+}
+
+template <typename Value>
+ErrorCode getErrorCode(Result<Value, BTFLayoutError> &result) {
+  REQUIRE(result.failed());
+  return result.takeError().get().code;
+}
+
+std::uint64_t getSize(const IBTFLayout &layout, std::uint32_t id) {
+  auto size_res = layout.getSize(id);
+  REQUIRE(!size_res.failed());
+
+  return size_res.takeValue();
+}
+
+std::uint64_t getAlignment(const IBTFLayout &layout, std::uint32_t id) {
+  auto alignment_res = layout.getAlignment(id);
+  REQUIRE(!alignment_res.failed());
+
+  return alignment_res.takeValue();
+}
+
+BTFMemberLocation resolveMemberPath(const IBTFLayout &layout,
+                                    std::string_view path) {
+  auto location_res = layout.resolveMemberPath(path);
+  REQUIRE(!location_res.failed());
+
+  return location_res.takeValue();
+}
+
+ErrorCode getMemberPathError(const IBTFLayout &layout,
+                             std::string_view path) {
+  auto location_res = layout.resolveMemberPath(path);
+  return getErrorCode(location_res);
+}
+
+} // namespace
+
+TEST_CASE("IBTFLayout::getSize(), IBTFLayout::getAlignment()") {
+  auto buffer = createTestBuilder().build();
+
+  for (auto decoding_mode :
+       {BTFOptions::DecodingMode::Eager, BTFOptions::DecodingMode::Lazy}) {
+
+    auto btf = createTestBTF(buffer, decoding_mode);
+    auto layout = createTestLayout(*btf);
+
+    CHECK(getSize(*layout, 1) == 4);
+    CHECK(getAlignment(*layout, 1) == 4);
+    CHECK(getSize(*layout, 4) == sizeof(void *));
+    CHECK(getAlignment(*layout, 4) == sizeof(void *));
+
+    // Typedefs, qualifiers and arrays
+    CHECK(getSize(*layout, 6) == 8);
+    CHECK(getSize(*layout, 7) == 16);
+    CHECK(getAlignment(*layout, 7) == 4);
+    CHECK(getSize(*layout, 9) == 32);
+
+    // Structs and unions
+    CHECK(getSize(*layout, 12) == 40);
+    CHECK(getAlignment(*layout, 12) == 8);
+    CHECK(getSize(*layout, 11) == 8);
+    CHECK(getAlignment(*layout, 14) == 4);
+    CHECK(getSize(*layout, 20) == 8);
+
+    // The int member is misaligned, so the struct must be packed
+    CHECK(getSize(*layout, 13) == 5);
+    CHECK(getAlignment(*layout, 13) == 1);
+
+    auto void_size_res = layout->getSize(0);
+    CHECK(getErrorCode(void_size_res) == ErrorCode::IncompleteType);
+
+    auto fwd_size_res = layout->getSize(17);
+    CHECK(getErrorCode(fwd_size_res) == ErrorCode::IncompleteType);
+
+    auto invalid_size_res = layout->getSize(kTypeCount + 1);
+    CHECK(getErrorCode(invalid_size_res) == ErrorCode::InvalidTypeID);
+  }
+}
+
+TEST_CASE("IBTFLayout::getSize() (unresolvable members)") {
+  BTFBuilder builder;
+  auto int_id = builder.addInt("int", 4);
+  auto fwd_id = builder.addType("opaque", BTFKind::Fwd, 0, 0);
+
+  auto struct_id = builder.addStruct(
+      "outer", 16, {{"value", int_id, 0}, {"opaque", fwd_id, 32}});
+
+  auto invalid_struct_id = builder.addStruct(
+      "invalid", 8, {{"value", int_id, 0}, {"missing", 1000, 32}});
+
+  auto self_id = builder.nextTypeID();
+  builder.addStruct("self", 8, {{"self", self_id, 0}});
+
+  auto buffer = builder.build();
+  auto btf = createTestBTF(buffer, BTFOptions::DecodingMode::Eager);
+  auto layout = createTestLayout(*btf);
+
+  // The size recorded by BTF is still used, with a packed alignment
+  CHECK(getAlignment(*layout, struct_id) == 1);
+  CHECK(getAlignment(*layout, invalid_struct_id) == 1);
+  CHECK(getAlignment(*layout, self_id) == 1);
+
+  CHECK(getSize(*layout, struct_id) == 16);
+  CHECK(getSize(*layout, invalid_struct_id) == 8);
+  CHECK(getSize(*layout, self_id) == 8);
+}
+
+TEST_CASE("IBTFLayout::resolveType()") {
+  auto buffer = createTestBuilder().build();
+  auto btf = createTestBTF(buffer, BTFOptions::DecodingMode::Eager);
+  auto layout = createTestLayout(*btf);
+
+  for (std::uint32_t id : {6U, 5U, 2U}) {
+    auto resolved_id_res = layout->resolveType(id);
+    REQUIRE(!resolved_id_res.failed());
+    CHECK(resolved_id_res.takeValue() == 2);
+  }
+
+  auto ptr_id_res = layout->resolveType(4);
+  REQUIRE(!ptr_id_res.failed());
+  CHECK(ptr_id_res.takeValue() == 4);
+
+  // Typedefs that refer to each other
+  auto loop_id_res = layout->resolveType(15);
+  CHECK(getErrorCode(loop_id_res) == ErrorCode::TypeLoop);
+
+  auto loop_size_res = layout->getSize(16);
+  CHECK(getErrorCode(loop_size_res) == ErrorCode::TypeLoop);
+
+  auto invalid_id_res = layout->resolveType(kTypeCount + 1);
+  CHECK(getErrorCode(invalid_id_res) == ErrorCode::InvalidTypeID);
+}
+
+TEST_CASE("IBTFLayout::resolveMemberPath()") {
+  auto buffer = createTestBuilder().build();
+  auto btf = createTestBTF(buffer, BTFOptions::DecodingMode::Lazy);
+  auto layout = createTestLayout(*btf);
+
+  auto location = resolveMemberPath(*layout, "task.id");
+  CHECK(location.type == 6);
+  CHECK(location.bit_offset == 0);
+  CHECK(location.bit_size == 64);
+  CHECK(location.pointer_offset_list.empty());
+  CHECK(!location.opt_bitfield_size.has_value());
+
+  // Members of anonymous unions
+  location = resolveMemberPath(*layout, "task.b");
+  CHECK(location.type == 1);
+  CHECK(location.bit_offset == 64);
+  CHECK(location.bit_size == 32);
+
+  location = resolveMemberPath(*layout, "task.sig->rlim[1].rlim_max");
+  CHECK(location.type == 5);
+  CHECK(location.pointer_offset_list == OffsetList{16});
+  CHECK(location.bit_offset == 64 + 128 + 64);
+  CHECK(location.bit_size == 64);
+
+  location = resolveMemberPath(*layout, "task.values[3]");
+  CHECK(location.type == 1);
+  CHECK(location.bit_offset == 192 + 96);
+  CHECK(location.bit_size == 32);
+
+  location = resolveMemberPath(*layout, "flags.high");
+  CHECK(location.bit_offset == 3);
+  CHECK(location.bit_size == 5);
+  CHECK(location.opt_bitfield_size == 5);
+
+  location = resolveMemberPath(*layout, "holder.s->count");
+  CHECK(location.type == 1);
+  CHECK(location.pointer_offset_list == OffsetList{0});
+
+  location = resolveMemberPath(*layout, "task");
+  CHECK(location.type == 12);
+  CHECK(location.bit_size == 320);
+
+  // Paths relative to a type ID
+  auto location_res = layout->resolveMemberPath(12, "sig->count");
+  REQUIRE(!location_res.failed());
+
+  location = location_res.takeValue();
+  CHECK(location.type == 1);
+  CHECK(location.pointer_offset_list == OffsetList{16});
+  CHECK(location.bit_offset == 0);
+}
+
+TEST_CASE("IBTFLayout::resolveMemberPath() (invalid paths)") {
+  auto buffer = createTestBuilder().build();
+  auto btf = createTestBTF(buffer, BTFOptions::DecodingMode::Eager);
+  auto layout = createTestLayout(*btf);
+
+  CHECK(getMemberPathError(*layout, "missing.id") == ErrorCode::TypeNotFound);
+  CHECK(getMemberPathError(*layout, "task.missing") ==
+        ErrorCode::MemberNotFound);
+
+  CHECK(getMemberPathError(*layout, "task.id->x") == ErrorCode::NotAPointer);
+  CHECK(getMemberPathError(*layout, "task.id[0]") == ErrorCode::NotAnArray);
+  CHECK(getMemberPathError(*layout, "task.values[4]") ==
+        ErrorCode::ArrayIndexOutOfRange);
+
+  CHECK(getMemberPathError(*layout, "task.id.x") ==
+        ErrorCode::NotAStructOrUnion);
+
+  CHECK(getMemberPathError(*layout, "flags.low.x") ==
+        ErrorCode::NotAStructOrUnion);
+
+  for (auto path : {"", "task..id", "task.values[", "task.values[x]",
+                    "task.sig-count", "task id"}) {
+    CHECK(getMemberPathError(*layout, path) == ErrorCode::InvalidMemberPath);
+  }
+
+  auto location_res = layout->resolveMemberPath(kTypeCount + 1, "id");
+  CHECK(getErrorCode(location_res) == ErrorCode::InvalidTypeID);
+}
+
+} // namespace btfparse
@@ -0,0 +1,197 @@
+//
+// Copyright (c) 2021-present, Trail of Bits, Inc.
+// All rights reserved.
+//
+// This source code is licensed in accordance with the terms specified in
+// the LICENSE file found in the root directory of this source tree.
+//
+
+#include "btfbuilder.h"
+
+#include <doctest/doctest.h>
+
+#include <btfparse/ibtfmodulewatcher.h>
+
+#include <thread>
+
+namespace btfparse {
+
+namespace {
+
+TestEnvironment createTestEnvironment(const std::string &name) {
+  BTFBuilder base_builder;
+  base_builder.addInt("int", 4);
+
+  return createTestEnvironment("modulewatcher-" + name, "vmlinux",
+                               std::move(base_builder));
+}
+
+void addModule(const TestEnvironment &environment, const std::string &name) {
+  auto builder = BTFBuilder::createSplit(environment.builder);
+  builder.addStruct(name + "_state", 4, {{"value", 1, 0}});
+
+  writeFile(environment.directory / name, builder.build());
+}
+
+IBTFModuleWatcher::Ptr createWatcher(const TestEnvironment &environment) {
+  auto watcher_res = IBTFModuleWatcher::create(environment.directory);
+  REQUIRE(!watcher_res.failed());
+
+  return watcher_res.takeValue();
+}
+
+std::vector<std::string> getModuleNameList(const BTFModuleSet &module_set) {
+  std::vector<std::string> module_name_list;
+  for (const auto &[name, module_btf] : module_set.module_map) {
+    module_name_list.push_back(name);
+  }
+
+  return module_name_list;
+}
+
+} // namespace
+
+TEST_CASE("IBTFModuleWatcher::create()") {
+  auto environment = createTestEnvironment("create");
+  addModule(environment, "mod_a");
+
+  auto watcher = createWatcher(environment);
+  auto module_set = watcher->getModuleSet();
+
+  REQUIRE(module_set != nullptr);
+  REQUIRE(module_set->base_btf != nullptr);
+  CHECK(module_set->base_btf->count() == 1);
+  CHECK(getModuleNameList(*module_set) == std::vector<std::string>{"mod_a"});
+
+  const auto &module_btf = module_set->module_map.at("mod_a");
+  CHECK(module_btf->count() == 2);
+  CHECK(module_btf->findByName("mod_a_state").size() == 1);
+
+  std::filesystem::remove(environment.directory / "vmlinux");
+
+  auto watcher_res = IBTFModuleWatcher::create(environment.directory);
+  REQUIRE(watcher_res.failed());
+  CHECK(watcher_res.takeError().get().code ==
+        BTFModuleWatcherErrorInformation::Code::FileNotFound);
+
+  std::filesystem::remove_all(environment.directory);
+
+  watcher_res = IBTFModuleWatcher::create(environment.directory);
+  REQUIRE(watcher_res.failed());
+  CHECK(watcher_res.takeError().get().code ==
+        BTFModuleWatcherErrorInformation::Code::FileNotFound);
+}
+
+TEST_CASE("IBTFModuleWatcher::update()") {
+  auto environment = createTestEnvironment("update");
+  addModule(environment, "mod_a");
+
+  auto watcher = createWatcher(environment);
+  auto initial_module_set = watcher->getModuleSet();
+
+  // Nothing has changed, so the same set is kept
+  CHECK(!watcher->update().has_value());
+  CHECK(watcher->getModuleSet() == initial_module_set);
+
+  addModule(environment, "mod_b");
+  CHECK(!watcher->update().has_value());
+
+  auto module_set = watcher->getModuleSet();
+  CHECK(getModuleNameList(*module_set) ==
+        std::vector<std::string>{"mod_a", "mod_b"});
+
+  // The module that was already loaded has not been parsed again, and
+  // the previous set has not been modified
+  CHECK(module_set->base_btf == initial_module_set->base_btf);
+  CHECK(module_set->module_map.at("mod_a") ==
+        initial_module_set->module_map.at("mod_a"));
+
+  CHECK(getModuleNameList(*initial_module_set) ==
+        std::vector<std::string>{"mod_a"});
+
+  std::filesystem::remove(environment.directory / "mod_a");
+  CHECK(!watcher->update().has_value());
+
+  module_set = watcher->getModuleSet();
+  CHECK(getModuleNameList(*module_set) == std::vector<std::string>{"mod_b"});
+
+  // A module that is replaced is parsed again
+  auto mod_b_btf = module_set->module_map.at("mod_b");
+
+  auto builder = BTFBuilder::createSplit(environment.builder);
+  builder.addPtr(1);
+  builder.addPtr(1);
+  writeFile(environment.directory / "mod_b", builder.build());
+
+  CHECK(!watcher->update().has_value());
+
+  module_set = watcher->getModuleSet();
+  REQUIRE(module_set->module_map.count("mod_b") == 1);
+  CHECK(module_set->module_map.at("mod_b") != mod_b_btf);
+  CHECK(module_set->module_map.at("mod_b")->count() == 3);
+
+  std::filesystem::remove_all(environment.directory);
+}
+
+TEST_CASE("IBTFModuleWatcher::update() (invalid modules)") {
+  auto environment = createTestEnvironment("invalid");
+  writeFile(environment.directory / "mod_bad", {0x00, 0x01, 0x02});
+
+  auto watcher = createWatcher(environment);
+  CHECK(watcher->getModuleSet()->module_map.empty());
+
+  // The other modules are still published, and the invalid one is tried
+  // again on each update
+  addModule(environment, "mod_a");
+
+  auto opt_error = watcher->update();
+  REQUIRE(opt_error.has_value());
+  CHECK(opt_error->get().code ==
+        BTFModuleWatcherErrorInformation::Code::InvalidBTF);
+
+  CHECK(getModuleNameList(*watcher->getModuleSet()) ==
+        std::vector<std::string>{"mod_a"});
+
+  CHECK(watcher->update().has_value());
+
+  addModule(environment, "mod_bad");
+  CHECK(!watcher->update().has_value());
+  CHECK(getModuleNameList(*watcher->getModuleSet()) ==
+        std::vector<std::string>{"mod_a", "mod_bad"});
+
+  std::filesystem::remove_all(environment.directory);
+}
+
+TEST_CASE("IBTFModuleWatcher::update() (timeout)") {
+  auto environment = createTestEnvironment("timeout");
+  auto watcher = createWatcher(environment);
+
+  auto initial_module_set = watcher->getModuleSet();
+  CHECK(!watcher->update(std::chrono::milliseconds(1)).has_value());
+  CHECK(watcher->getModuleSet() == initial_module_set);
+
+  // Hidden files are ignored, so the module is complete when it appears
+  std::thread writer_thread([&environment]() {
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+
+    addModule(environment, ".mod_a");
+    std::filesystem::rename(environment.directory / ".mod_a",
+                            environment.directory / "mod_a");
+  });
+
+  std::optional<BTFModuleWatcherError> opt_error;
+  while (watcher->getModuleSet()->module_map.empty() &&
+         !opt_error.has_value()) {
+    opt_error = watcher->update(std::chrono::seconds(5));
+  }
+
+  writer_thread.join();
+
+  CHECK(!opt_error.has_value());
+  CHECK(getModuleNameList(*watcher->getModuleSet()) ==
+        std::vector<std::string>{"mod_a"});
+
+  std::filesystem::remove_all(environment.directory);
+}
+
+} // namespace btfparse
@@ -0,0 +1,147 @@
+//
+// Copyright (c) 2021-present, Trail of Bits, Inc.
+// All rights reserved.
+//
+// This source code is licensed in accordance with the terms specified in
+// the LICENSE file found in the root directory of this source tree.
+//
+
+#include "btfbuilder.h"
+
+#include <doctest/doctest.h>
+
+#include <btfparse/ibtf.h>
+
+namespace btfparse {
+
+namespace {
+
+using IDList = std::vector<std::uint32_t>;
+
+// The struct is defined after a forward declaration and a typedef that
+// share its name
+BTFBuilder createTestBuilder() {
+  BTFBuilder builder;
+  auto int_id = builder.addInt("int", 4);
+
+  auto fwd_id = builder.addType("node", BTFKind::Fwd, 0, 0);
+  builder.addType("node", BTFKind::Typedef, 0, fwd_id);
+  builder.addPtr(fwd_id);
+
+  builder.addStruct("node", 4, {{"value", int_id, 0}});
+  builder.addStruct({}, 4, {{"value", int_id, 0}});
+  builder.addStruct("list", 4, {{"value", int_id, 0}});
+
+  return builder;
+}
+
+IBTF::Ptr createTestBTF(const std::vector<std::uint8_t> &buffer,
+                        BTFOptions::DecodingMode decoding_mode) {
+  BTFOptions options;
+  options.decoding_mode = decoding_mode;
+
+  auto btf_res = IBTF::createFromBuffer(buffer.data(), buffer.size(), options);
+  REQUIRE(!btf_res.failed());
+
+  return btf_res.takeValue();
+}
+
+IDList toIDList(const BTFTypeIDRange &range) {
+  return IDList(range.begin(), range.end());
+}
+
+void checkNameIndex(const IBTF &btf) {
+  // Sorted by kind (struct, fwd, typedef), and then by ID
+  CHECK(toIDList(btf.findByName("node")) == IDList{5, 2, 3});
+  CHECK(toIDList(btf.findByName("node", BTFKind::Struct)) == IDList{5});
+  CHECK(toIDList(btf.findByName("node", BTFKind::Fwd)) == IDList{2});
+  CHECK(btf.findByName("node", BTFKind::Union).empty());
+
+  CHECK(toIDList(btf.findByName("int")) == IDList{1});
+  CHECK(btf.findByName("missing").empty());
+  CHECK(btf.findByName("").empty());
+
+  CHECK(toIDList(btf.findByKind(BTFKind::Struct)) == IDList{5, 6, 7});
+  CHECK(toIDList(btf.findByKind(BTFKind::Ptr)) == IDList{4});
+  CHECK(btf.findByKind(BTFKind::Void).empty());
+  CHECK(btf.findByKind(BTFKind::Float).empty());
+
+  auto range = btf.findByName("list");
+  REQUIRE(range.size() == 1);
+  CHECK(range[0] == 7);
+}
+
+} // namespace
+
+TEST_CASE("IBTF::findByName(), IBTF::findByKind()") {
+  auto buffer = createTestBuilder().build();
+
+  for (auto decoding_mode :
+       {BTFOptions::DecodingMode::Eager, BTFOptions::DecodingMode::Lazy}) {
+
+    auto btf = createTestBTF(buffer, decoding_mode);
+    checkNameIndex(*btf);
+
+    // The second lookup uses the same index
+    CHECK(btf->findByName("node").begin() == btf->findByName("node").begin());
+  }
+}
+
+TEST_CASE("IBTF::findByName() (snapshots)") {
+  auto buffer = createTestBuilder().build();
+  auto btf = createTestBTF(buffer, BTFOptions::DecodingMode::Eager);
+
+  auto snapshot_res = IBTF::createSnapshotBuffer(*btf);
+  REQUIRE(!snapshot_res.failed());
+
+  auto snapshot = snapshot_res.takeValue();
+
+  auto snapshot_btf_res =
+      IBTF::createFromSnapshotBuffer(snapshot.data(), snapshot.size());
+
+  REQUIRE(!snapshot_btf_res.failed());
+  checkNameIndex(*snapshot_btf_res.takeValue());
+}
+
+TEST_CASE("IBTF::findByName() (split BTF)") {
+  auto base_builder = createTestBuilder();
+
+  auto split_builder = BTFBuilder::createSplit(base_builder);
+  split_builder.addStruct("node", 4, {{"value", 1, 0}});
+  split_builder.addPtr(5);
+
+  auto base_path = base_builder.save("name_index_base");
+  auto split_path = split_builder.save("name_index_split");
+
+  auto base_btf_res = IBTF::createFromPath(base_path);
+  REQUIRE(!base_btf_res.failed());
+
+  IBTF::SharedPtr base_btf = base_btf_res.takeValue();
+
+  for (auto decoding_mode :
+       {BTFOptions::DecodingMode::Eager, BTFOptions::DecodingMode::Lazy}) {
+
+    BTFOptions options;
+    options.decoding_mode = decoding_mode;
+
+    auto split_btf_res =
+        IBTF::createSplitFromPath(base_btf, split_path, options);
+
+    REQUIRE(!split_btf_res.failed());
+
+    auto split_btf = split_btf_res.takeValue();
+    CHECK(toIDList(split_btf->findByName("node", BTFKind::Struct)) ==
+          IDList{5, 8});
+
+    CHECK(toIDList(split_btf->findByKind(BTFKind::Ptr)) == IDList{4, 9});
+    CHECK(toIDList(split_btf->findByName("list")) == IDList{7});
+  }
+
+  // The base index does not include the split types
+  CHECK(toIDList(base_btf->findByName("node", BTFKind::Struct)) == IDList{5});
+
+  std::filesystem::remove(base_path);
+  std::filesystem::remove(split_path);
+}
+
+} // namespace btfparse
@@ -0,0 +1,267 @@
+//
+// Copyright (c) 2021-present, Trail of Bits, Inc.
+// All rights reserved.
+//
+// This source code is licensed in accordance with the terms specified in
+// the LICENSE file found in the root directory of this source tree.
+//
+
+#include "btfbuilder.h"
+
+#include <doctest/doctest.h>
+
+#include <btfparse/ibtf.h>
+
+#include <fstream>
+
+#include <unistd.h>
+
+namespace btfparse {
+
+namespace {
+
+const std::uint32_t kKindFlag{0x80000000U};
+
+// One type of each kind, including bitfields, a variadic function and
+// a negative enum value
+std::vector<std::uint8_t> createTestBTFBuffer() {
+  BTFBuilder builder;
+  auto int_id = builder.addInt("int", 4);
+  auto ptr_id = builder.addPtr(int_id);
+
+  builder.addType({}, BTFKind::Array, 0, 0, {int_id, int_id, 16});
+
+  builder.addType("bits", BTFKind::Struct, 2 | kKindFlag, 4,
+                  {builder.addString("low"), int_id, (3U << 24) | 0U,
+                   builder.addString("high"), int_id, (5U << 24) | 3U});
+
+  builder.addType({}, BTFKind::Union, 1, 8,
+                  {builder.addString("ptr"), ptr_id, 0});
+
+  builder.addType("color", BTFKind::Enum, 2, 4,
+                  {builder.addString("RED"), 0, builder.addString("NONE"),
+                   static_cast<std::uint32_t>(-1)});
+
+  builder.addType("fwd_union", BTFKind::Fwd, kKindFlag, 0);
+  builder.addType("int_t", BTFKind::Typedef, 0, int_id);
+  builder.addType({}, BTFKind::Volatile, 0, int_id);
+  builder.addType({}, BTFKind::Const, 0, int_id);
+  builder.addType({}, BTFKind::Restrict, 0, ptr_id);
+
+  auto func_proto_id = builder.addType(
+      {}, BTFKind::FuncProto, 2, int_id,
+      {builder.addString("format"), ptr_id, 0, 0});
+
+  builder.addType("printk", BTFKind::Func, 1, func_proto_id);
+
+  auto var_id = builder.addType("counter", BTFKind::Var, 0, int_id, {1});
+  builder.addType(".data", BTFKind::DataSec, 1, 4, {var_id, 0, 4});
+  builder.addType("double", BTFKind::Float, 0, 8);
+
+  return builder.build();
+}
+
+IBTF::Ptr createTestBTF(const std::vector<std::uint8_t> &buffer) {
+  auto btf_res = IBTF::createFromBuffer(buffer.data(), buffer.size());
+  REQUIRE(!btf_res.failed());
+
+  return btf_res.takeValue();
+}
+
+Result<IBTF::Ptr, BTFError>
+loadSnapshot(const std::vector<std::uint8_t> &snapshot) {
+  return IBTF::createFromSnapshotBuffer(snapshot.data(), snapshot.size());
+}
+
+} // namespace
+
+TEST_CASE("IBTF::createFromSnapshotBuffer") {
+  auto buffer = createTestBTFBuffer();
+  auto btf = createTestBTF(buffer);
+  auto snapshot = createSnapshotBuffer(*btf.get());
+
+  auto snapshot_btf_res =
+      IBTF::createFromSnapshotBuffer(snapshot.data(), snapshot.size());
+  REQUIRE(!snapshot_btf_res.failed());
+
+  auto snapshot_btf = snapshot_btf_res.takeValue();
+  REQUIRE(snapshot_btf->count() == btf->count());
+
+  for (std::uint32_t id = 1; id <= btf->count(); ++id) {
+    CHECK(snapshot_btf->getKind(id) == btf->getKind(id));
+  }
+
+  CHECK(!snapshot_btf->getKind(0).has_value());
+  CHECK(snapshot_btf->getTypeRef(btf->count() + 1) == nullptr);
+
+  // The snapshot encodes every field, so the round trip is exact if
+  // serializing the loaded snapshot produces the same image
+  CHECK(createSnapshotBuffer(*snapshot_btf.get()) == snapshot);
+
+  const auto &bits = std::get<StructBTFType>(*snapshot_btf->getTypeRef(4));
+  REQUIRE(bits.member_list.size() == 2);
+  CHECK(bits.opt_name.value() == "bits");
+  CHECK(bits.member_list[1].opt_name.value() == "high");
+  CHECK(bits.member_list[1].offset == 3);
+  CHECK(bits.member_list[1].opt_bitfield_size.value() == 5);
+
+  const auto &unnamed_union =
+      std::get<UnionBTFType>(*snapshot_btf->getTypeRef(5));
+  CHECK(!unnamed_union.opt_name.has_value());
+
+  const auto &color = std::get<EnumBTFType>(*snapshot_btf->getTypeRef(6));
+  REQUIRE(color.value_list.size() == 2);
+  CHECK(color.value_list[1].name == "NONE");
+  CHECK(color.value_list[1].val == -1);
+
+  CHECK(std::get<FwdBTFType>(*snapshot_btf->getTypeRef(7)).is_union);
+
+  const auto &func_proto =
+      std::get<FuncProtoBTFType>(*snapshot_btf->getTypeRef(12));
+  CHECK(func_proto.is_variadic);
+  REQUIRE(func_proto.param_list.size() == 1);
+  CHECK(func_proto.param_list[0].opt_name.value() == "format");
+
+  const auto &func = std::get<FuncBTFType>(*snapshot_btf->getTypeRef(13));
+  CHECK(func.linkage == FuncBTFType::Linkage::Global);
+
+  const auto &data_sec =
+      std::get<DataSecBTFType>(*snapshot_btf->getTypeRef(15));
+  REQUIRE(data_sec.variable_list.size() == 1);
+  CHECK(data_sec.variable_list[0].type == 14);
+  CHECK(data_sec.variable_list[0].size == 4);
+}
+
+TEST_CASE("IBTF::createFromSnapshotBuffer (split BTF)") {
+  BTFBuilder base_builder;
+  auto int_id = base_builder.addInt("int", 4);
+
+  auto split_builder = BTFBuilder::createSplit(base_builder);
+  split_builder.addStruct("split_struct", 4, {{"value", int_id, 0}});
+
+  auto base_path = base_builder.save("base");
+  auto split_path = split_builder.save("split");
+
+  auto base_btf_res = IBTF::createFromPath(base_path);
+  REQUIRE(!base_btf_res.failed());
+
+  IBTF::SharedPtr base_btf = base_btf_res.takeValue();
+
+  auto split_btf_res = IBTF::createSplitFromPath(base_btf, split_path);
+  REQUIRE(!split_btf_res.failed());
+
+  auto split_btf = split_btf_res.takeValue();
+
+  std::filesystem::remove(base_path);
+  std::filesystem::remove(split_path);
+
+  // Snapshots are self contained, and also include the base types
+  auto snapshot = createSnapshotBuffer(*split_btf.get());
+
+  auto snapshot_btf_res =
+      IBTF::createFromSnapshotBuffer(snapshot.data(), snapshot.size());
+  REQUIRE(!snapshot_btf_res.failed());
+
+  auto snapshot_btf = snapshot_btf_res.takeValue();
+  CHECK(snapshot_btf->count() == 2);
+  CHECK(snapshot_btf->getKind(int_id) == BTFKind::Int);
+
+  // Split type IDs continue after the ones of the base
+  const auto &split_struct =
+      std::get<StructBTFType>(*snapshot_btf->getTypeRef(int_id + 1));
+  CHECK(split_struct.opt_name.value() == "split_struct");
+  CHECK(split_struct.member_list.at(0).type == int_id);
+}
+
+TEST_CASE("IBTF::createFromSnapshotBuffer (invalid snapshots)") {
+  auto btf = createTestBTF(createTestBTFBuffer());
+  auto snapshot = createSnapshotBuffer(*btf.get());
+
+  auto truncated_snapshot = snapshot;
+  truncated_snapshot.pop_back();
+  CHECK(getErrorCode(loadSnapshot(truncated_snapshot)) ==
+        BTFErrorInformation::Code::InvalidSnapshot);
+
+  auto invalid_magic_snapshot = snapshot;
+  invalid_magic_snapshot[0] ^= 0xFF;
+  CHECK(getErrorCode(loadSnapshot(invalid_magic_snapshot)) ==
+        BTFErrorInformation::Code::InvalidSnapshot);
+
+  auto future_snapshot = snapshot;
+  future_snapshot[4] = 0xFF;
+  CHECK(getErrorCode(loadSnapshot(future_snapshot)) ==
+        BTFErrorInformation::Code::UnsupportedSnapshotVersion);
+
+  auto corrupted_snapshot = snapshot;
+  corrupted_snapshot.back() ^= 0x01;
+  CHECK(getErrorCode(loadSnapshot(corrupted_snapshot)) ==
+        BTFErrorInformation::Code::SnapshotChecksumMismatch);
+}
+
+TEST_CASE("IBTF::saveSnapshot") {
+  auto buffer = createTestBTFBuffer();
+  auto btf = createTestBTF(buffer);
+
+  auto path = std::filesystem::temp_directory_path() /
+              ("btfparse-snapshot-tests-" + std::to_string(getpid()));
+
+  REQUIRE(!IBTF::saveSnapshot(*btf.get(), path).has_value());
+
+  auto snapshot_btf_res = IBTF::createFromSnapshot(path);
+  REQUIRE(!snapshot_btf_res.failed());
+
+  auto snapshot_btf = snapshot_btf_res.takeValue();
+  CHECK(createSnapshotBuffer(*snapshot_btf.get()) ==
+        createSnapshotBuffer(*btf.get()));
+
+  std::filesystem::remove(path);
+
+  auto missing_btf_res = IBTF::createFromSnapshot(path);
+  REQUIRE(missing_btf_res.failed());
+  CHECK(missing_btf_res.takeError().get().code ==
+        BTFErrorInformation::Code::FileNotFound);
+}
+
+TEST_CASE("IBTF::saveSnapshot (overwriting a loaded snapshot)") {
+  auto btf = createTestBTF(createTestBTFBuffer());
+
+  BTFBuilder builder;
+  builder.addInt("int", 4);
+  auto other_btf = createTestBTF(builder.build());
+
+  auto path = std::filesystem::temp_directory_path() /
+              ("btfparse-snapshot-tests-overwrite-" + std::to_string(getpid()));
+
+  REQUIRE(!IBTF::saveSnapshot(*btf.get(), path).has_value());
+
+  auto snapshot_btf_res = IBTF::createFromSnapshot(path);
+  REQUIRE(!snapshot_btf_res.failed());
+
+  auto snapshot_btf = snapshot_btf_res.takeValue();
+
+  // The loaded snapshot keeps its own file, even though the new snapshot
+  // is smaller and no type has been decoded yet
+  REQUIRE(!IBTF::saveSnapshot(*other_btf.get(), path).has_value());
+
+  CHECK(createSnapshotBuffer(*snapshot_btf.get()) ==
+        createSnapshotBuffer(*btf.get()));
+
+  auto other_snapshot_btf_res = IBTF::createFromSnapshot(path);
+  REQUIRE(!other_snapshot_btf_res.failed());
+  CHECK(other_snapshot_btf_res.takeValue()->count() == 1);
+
+  // No temporary file is left behind
+  std::size_t file_count{0};
+  for (const auto &entry :
+       std::filesystem::directory_iterator(path.parent_path())) {
+    if (entry.path().filename().string().find(path.filename().string()) ==
+        0) {
+      ++file_count;
+    }
+  }
+
+  CHECK(file_count == 1);
+  std::filesystem::remove(path);
+}
+
+} // namespace btfparse
@@ -0,0 +1,166 @@
+//
+// Copyright (c) 2021-present, Trail of Bits, Inc.
+// All rights reserved.
+//
+// This source code is licensed in accordance with the terms specified in
+// the LICENSE file found in the root directory of this source tree.
+//
+
+#include "btfbuilder.h"
+
+#include <doctest/doctest.h>
+
+namespace btfparse {
+
+namespace {
+
+struct TestFiles final {
+  std::filesystem::path base_path;
+  std::filesystem::path split_path;
+
+  ~TestFiles() {
+    std::filesystem::remove(base_path);
+    std::filesystem::remove(split_path);
+  }
+};
+
+// The split file repeats the base types, with different IDs and in a
+// different order, next to a new structure and a different copy of the
+// list
+void createTestFiles(TestFiles &test_files) {
+  BTFBuilder base_builder;
+  auto int_id = base_builder.addInt("int", 4);
+  base_builder.addStruct("list", 16, {{"next", 3, 0}, {"value", int_id, 64}});
+  base_builder.addPtr(2);
+
+  auto split_builder = BTFBuilder::createSplit(base_builder);
+  split_builder.addInt("int", 4);
+  split_builder.addPtr(6);
+  split_builder.addStruct("list", 16, {{"next", 5, 0}, {"value", 4, 64}});
+  split_builder.addStruct("other", 16, {{"list", 6, 0}});
+  split_builder.addStruct("list", 16, {{"next", 9, 0}, {"value", 4, 96}});
+  split_builder.addPtr(8);
+  split_builder.addType("int_t", BTFKind::Typedef, 0, 4);
+
+  test_files.base_path = base_builder.save("dedup-base");
+  test_files.split_path = split_builder.save("dedup-split");
+}
+
+BTFOptions getDedupOptions() {
+  BTFOptions options;
+  options.deduplicate = true;
+
+  return options;
+}
+
+void checkDeduplicatedTypes(const IBTF &btf) {
+  REQUIRE(btf.count() == 7);
+
+  const std::vector<std::optional<std::uint32_t>> expected_id_list{
+      0, 1, 2, 3, 1, 3, 2, 4, 5, 6, 7, std::nullopt};
+
+  for (std::uint32_t id = 0; id < expected_id_list.size(); ++id) {
+    CHECK(btf.getCanonicalID(id) == expected_id_list[id]);
+  }
+
+  const auto *other_type = btf.getTypeRef(4);
+  REQUIRE(other_type != nullptr);
+
+  const auto &other_struct = std::get<StructBTFType>(*other_type);
+  CHECK(other_struct.opt_name == "other");
+  CHECK(other_struct.member_list.at(0).type == 2);
+
+  const auto *list_type = btf.getTypeRef(5);
+  REQUIRE(list_type != nullptr);
+
+  const auto &list_struct = std::get<StructBTFType>(*list_type);
+  CHECK(list_struct.member_list.at(0).type == 6);
+  CHECK(list_struct.member_list.at(1).type == 1);
+  CHECK(list_struct.member_list.at(1).offset == 96);
+
+  const auto *list_ptr_type = btf.getTypeRef(6);
+  REQUIRE(list_ptr_type != nullptr);
+  CHECK(std::get<PtrBTFType>(*list_ptr_type).type == 5);
+
+  const auto *typedef_type = btf.getTypeRef(7);
+  REQUIRE(typedef_type != nullptr);
+  CHECK(std::get<TypedefBTFType>(*typedef_type).type == 1);
+
+  auto list_id_range = btf.findByName("list", BTFKind::Struct);
+  CHECK(std::vector<std::uint32_t>(list_id_range.begin(),
+                                   list_id_range.end()) ==
+        std::vector<std::uint32_t>{2, 5});
+}
+
+} // namespace
+
+TEST_CASE("BTFOptions::deduplicate") {
+  TestFiles test_files;
+  createTestFiles(test_files);
+
+  auto btf_res = IBTF::createFromPathList(
+      {test_files.base_path, test_files.split_path}, getDedupOptions());
+
+  REQUIRE(!btf_res.failed());
+  checkDeduplicatedTypes(*btf_res.takeValue());
+
+  // Without deduplication, each type keeps its ID
+  btf_res =
+      IBTF::createFromPathList({test_files.base_path, test_files.split_path});
+
+  REQUIRE(!btf_res.failed());
+
+  auto btf = btf_res.takeValue();
+  CHECK(btf->count() == 10);
+  CHECK(btf->getCanonicalID(5) == 5U);
+  CHECK(!btf->getCanonicalID(11).has_value());
+}
+
+TEST_CASE("BTFOptions::deduplicate with split BTF") {
+  TestFiles test_files;
+  createTestFiles(test_files);
+
+  auto base_btf_res = IBTF::createFromPath(test_files.base_path);
+  REQUIRE(!base_btf_res.failed());
+
+  IBTF::SharedPtr base_btf = base_btf_res.takeValue();
+
+  auto split_btf_res = IBTF::createSplitFromPath(
+      base_btf, test_files.split_path, getDedupOptions());
+
+  REQUIRE(!split_btf_res.failed());
+
+  // The split types are merged into the base ones
+  auto split_btf = split_btf_res.takeValue();
+  checkDeduplicatedTypes(*split_btf);
+  CHECK(split_btf->getTypeRef(2) == base_btf->getTypeRef(2));
+}
+
+TEST_CASE("BTFOptions::deduplicate errors") {
+  TestFiles test_files;
+  createTestFiles(test_files);
+
+  auto options = getDedupOptions();
+  options.decoding_mode = BTFOptions::DecodingMode::Lazy;
+
+  auto btf_res = IBTF::createFromPath(test_files.base_path, options);
+  REQUIRE(btf_res.failed());
+  CHECK(btf_res.error().get().code ==
+        BTFErrorInformation::Code::UnsupportedOptions);
+
+  // Deduplicated objects renumber their types, so the split files can not
+  // reference them anymore
+  btf_res = IBTF::createFromPath(test_files.base_path, getDedupOptions());
+  REQUIRE(!btf_res.failed());
+
+  IBTF::SharedPtr base_btf = btf_res.takeValue();
+
+  auto split_btf_res =
+      IBTF::createSplitFromPath(base_btf, test_files.split_path);
+
+  REQUIRE(split_btf_res.failed());
+  CHECK(split_btf_res.error().get().code ==
+        BTFErrorInformation::Code::InvalidBaseBTF);
+}
+
+} // namespace btfparse
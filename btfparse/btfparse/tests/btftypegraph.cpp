@@ -0,0 +1,105 @@
+//
+// Copyright (c) 2021-present, Trail of Bits, Inc.
+// All rights reserved.
+//
+// This source code is licensed in accordance with the terms specified in
+// the LICENSE file found in the root directory of this source tree.
+//
+
+#include "btftypegraph.h"
+
+#include <doctest/doctest.h>
+
+#include <vector>
+
+namespace btfparse {
+
+namespace {
+
+std::vector<std::uint32_t> getIDList(const BTFTypeIDSet &type_id_set) {
+  return std::vector<std::uint32_t>(type_id_set.begin(), type_id_set.end());
+}
+
+std::vector<std::pair<std::uint32_t, bool>>
+getEdgeList(const BTFTypeGraph &type_graph, std::uint32_t parent) {
+  std::vector<std::pair<std::uint32_t, bool>> edge_list;
+  for (const auto &edge : type_graph.edges(parent)) {
+    edge_list.emplace_back(edge.id(), edge.weak());
+  }
+
+  return edge_list;
+}
+
+} // namespace
+
+TEST_CASE("BTFTypeIDSet") {
+  BTFTypeIDSet type_id_set{0};
+  CHECK(type_id_set.size() == 1);
+  CHECK(type_id_set.count(0) == 1);
+
+  CHECK(type_id_set.insert(100));
+  CHECK(type_id_set.insert(7));
+  CHECK_FALSE(type_id_set.insert(100));
+
+  CHECK(type_id_set.count(7) == 1);
+  CHECK(type_id_set.count(8) == 0);
+  CHECK(type_id_set.count(100000) == 0);
+
+  // Elements are visited in insertion order
+  CHECK(getIDList(type_id_set) == std::vector<std::uint32_t>{0, 100, 7});
+
+  type_id_set.clear();
+  CHECK(type_id_set.empty());
+  CHECK(type_id_set.count(100) == 0);
+  CHECK(type_id_set.insert(100));
+}
+
+TEST_CASE("BTFTypeGraph::finalize") {
+  BTFTypeGraph type_graph;
+  type_graph.addEdge(3, 10, true);
+  type_graph.addEdge(1, 5, false);
+  type_graph.addEdge(3, 4, true);
+  type_graph.addEdge(3, 10, false);
+  type_graph.addEdge(3, 4, true);
+
+  // Edges are not visible until the graph is finalized
+  CHECK(type_graph.edges(3).empty());
+  type_graph.finalize();
+
+  // Duplicates keep the first position, and become strong unless they
+  // were all weak
+  using EdgeList = std::vector<std::pair<std::uint32_t, bool>>;
+  CHECK(getEdgeList(type_graph, 3) == EdgeList{{10, false}, {4, true}});
+  CHECK(getEdgeList(type_graph, 1) == EdgeList{{5, false}});
+  CHECK(type_graph.edges(2).empty());
+  CHECK(type_graph.edges(1000).empty());
+
+  // Edges can be updated in place, and new ones are merged on the next
+  // finalize call
+  auto edge_list = type_graph.edges(3);
+  *edge_list.begin() = BTFTypeGraph::Edge(11, true);
+
+  type_graph.addEdge(3, 4, false);
+  type_graph.addEdge(20, 3, false);
+  type_graph.finalize();
+
+  CHECK(getEdgeList(type_graph, 3) == EdgeList{{11, true}, {4, false}});
+  CHECK(getEdgeList(type_graph, 20) == EdgeList{{3, false}});
+}
+
+TEST_CASE("BTFTypeGraph::createInverse") {
+  BTFTypeGraph type_graph;
+  type_graph.addEdge(1, 3, true);
+  type_graph.addEdge(2, 3, false);
+  type_graph.addEdge(2, 1, false);
+  type_graph.finalize();
+
+  using EdgeList = std::vector<std::pair<std::uint32_t, bool>>;
+
+  auto inverse_graph = type_graph.createInverse();
+  CHECK(getEdgeList(inverse_graph, 3) == EdgeList{{1, false}, {2, false}});
+  CHECK(getEdgeList(inverse_graph, 1) == EdgeList{{2, false}});
+  CHECK(inverse_graph.edges(2).empty());
+}
+
+} // namespace btfparse
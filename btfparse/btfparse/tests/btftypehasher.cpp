@@ -0,0 +1,260 @@
+//
+// Copyright (c) 2021-present, Trail of Bits, Inc.
+// All rights reserved.
+//
+// This source code is licensed in accordance with the terms specified in
+// the LICENSE file found in the root directory of this source tree.
+//
+
+#include "btfbuilder.h"
+
+#include <doctest/doctest.h>
+
+#include <btfparse/ibtftypehasher.h>
+
+namespace btfparse {
+
+namespace {
+
+IBTF::Ptr createTestBTF(const BTFBuilder &builder) {
+  auto buffer = builder.build();
+
+  auto btf_res = IBTF::createFromBuffer(buffer.data(), buffer.size());
+  REQUIRE(!btf_res.failed());
+
+  return btf_res.takeValue();
+}
+
+IBTFTypeHasher::Ptr createTestHasher(const IBTF &btf) {
+  auto hasher_res = IBTFTypeHasher::create(btf);
+  REQUIRE(!hasher_res.failed());
+
+  return hasher_res.takeValue();
+}
+
+std::uint64_t getHash(const IBTFTypeHasher &hasher, std::uint32_t id) {
+  auto hash_res = hasher.getHash(id);
+  REQUIRE(!hash_res.failed());
+
+  return hash_res.takeValue();
+}
+
+BTFDiff getDiff(const IBTF &old_btf, const IBTF &new_btf) {
+  auto diff_res = IBTFTypeHasher::diff(old_btf, new_btf);
+  REQUIRE(!diff_res.failed());
+
+  return diff_res.takeValue();
+}
+
+std::uint32_t addEnum(BTFBuilder &builder, const std::string &name,
+                      const std::vector<std::pair<std::string, int>> &values) {
+  std::vector<std::uint32_t> payload;
+  for (const auto &[value_name, value] : values) {
+    payload.push_back(builder.addString(value_name));
+    payload.push_back(static_cast<std::uint32_t>(value));
+  }
+
+  return builder.addType(name, BTFKind::Enum,
+                         static_cast<std::uint32_t>(values.size()), 4,
+                         payload);
+}
+
+// The same list structure, laid out with different type IDs
+BTFBuilder createListBuilder(bool shuffled) {
+  BTFBuilder builder;
+  if (shuffled) {
+    builder.addInt("char", 1);
+
+    auto list_ptr_id = builder.addPtr(builder.nextTypeID() + 2);
+    auto int_id = builder.addInt("int", 4);
+    builder.addStruct("list", 16,
+                      {{"next", list_ptr_id, 0}, {"value", int_id, 64}});
+
+  } else {
+    auto int_id = builder.addInt("int", 4);
+    auto list_id = builder.nextTypeID();
+    builder.addStruct("list", 16,
+                      {{"next", list_id + 1, 0}, {"value", int_id, 64}});
+
+    builder.addPtr(list_id);
+  }
+
+  return builder;
+}
+
+} // namespace
+
+TEST_CASE("IBTFTypeHasher::getHash() ignores type IDs") {
+  auto btf = createTestBTF(createListBuilder(false));
+  auto shuffled_btf = createTestBTF(createListBuilder(true));
+
+  auto hasher = createTestHasher(*btf);
+  auto shuffled_hasher = createTestHasher(*shuffled_btf);
+
+  auto list_id = btf->findByName("list", BTFKind::Struct)[0];
+  auto shuffled_list_id =
+      shuffled_btf->findByName("list", BTFKind::Struct)[0];
+
+  CHECK(list_id != shuffled_list_id);
+  CHECK(getHash(*hasher, list_id) ==
+        getHash(*shuffled_hasher, shuffled_list_id));
+
+  // Memoized hashes are returned as is
+  CHECK(getHash(*hasher, list_id) == getHash(*hasher, list_id));
+
+  auto int_id = btf->findByName("int", BTFKind::Int)[0];
+  CHECK(getHash(*hasher, int_id) != getHash(*hasher, list_id));
+}
+
+TEST_CASE("IBTFTypeHasher::getHash() detects layout changes") {
+  auto btf = createTestBTF(createListBuilder(false));
+
+  BTFBuilder builder;
+  auto int_id = builder.addInt("int", 4);
+  auto list_id = builder.nextTypeID();
+  builder.addStruct("list", 16,
+                    {{"next", list_id + 1, 0}, {"value", int_id, 96}});
+
+  builder.addPtr(list_id);
+
+  auto moved_btf = createTestBTF(builder);
+
+  auto hasher = createTestHasher(*btf);
+  auto moved_hasher = createTestHasher(*moved_btf);
+
+  CHECK(getHash(*hasher, 2) != getHash(*moved_hasher, 2));
+
+  // The pointer only references the structure by name
+  CHECK(getHash(*hasher, 3) == getHash(*moved_hasher, 3));
+}
+
+TEST_CASE("IBTFTypeHasher::getHash() handles cycles") {
+  BTFBuilder builder;
+  auto loop_id = builder.nextTypeID();
+  builder.addType("loop_a", BTFKind::Typedef, 0, loop_id + 1);
+  builder.addType("loop_b", BTFKind::Typedef, 0, loop_id);
+
+  // An anonymous structure that points to itself
+  auto anon_id = builder.nextTypeID();
+  builder.addStruct({}, 8, {{"self", anon_id + 1, 0}});
+  builder.addPtr(anon_id);
+
+  auto btf = createTestBTF(builder);
+  auto hasher = createTestHasher(*btf);
+
+  CHECK(getHash(*hasher, loop_id) != getHash(*hasher, loop_id + 1));
+  getHash(*hasher, anon_id);
+  getHash(*hasher, anon_id + 1);
+}
+
+TEST_CASE("IBTFTypeHasher::getHash() rejects invalid IDs") {
+  auto btf = createTestBTF(createListBuilder(false));
+  auto hasher = createTestHasher(*btf);
+
+  getHash(*hasher, 0);
+
+  auto hash_res = hasher->getHash(btf->count() + 1);
+  REQUIRE(hash_res.failed());
+
+  auto error = hash_res.takeError();
+  CHECK(error.get().code == BTFTypeHasherErrorInformation::Code::InvalidTypeID);
+  CHECK(error.get().opt_type_id == btf->count() + 1);
+}
+
+TEST_CASE("IBTFTypeHasher::diff()") {
+  BTFBuilder old_builder;
+  auto old_int_id = old_builder.addInt("int", 4);
+  auto old_long_id = old_builder.addInt("long", 8);
+
+  old_builder.addStruct("same", 4, {{"a", old_int_id, 0}});
+  old_builder.addStruct("removed", 4, {{"a", old_int_id, 0}});
+  old_builder.addStruct("task", 16,
+                        {{"id", old_int_id, 0},
+                         {"state", old_int_id, 32},
+                         {"flags", old_long_id, 64}});
+
+  addEnum(old_builder, "mode", {{"READ", 1}, {"WRITE", 2}, {"EXEC", 4}});
+
+  BTFBuilder new_builder;
+  auto new_long_id = new_builder.addInt("long", 8);
+  auto new_int_id = new_builder.addInt("int", 4);
+
+  new_builder.addStruct("task", 24,
+                        {{"id", new_long_id, 0},
+                         {"flags", new_long_id, 64},
+                         {"prio", new_int_id, 128}});
+
+  new_builder.addStruct("same", 4, {{"a", new_int_id, 0}});
+  new_builder.addStruct("added", 4, {{"a", new_int_id, 0}});
+  addEnum(new_builder, "mode", {{"READ", 1}, {"WRITE", 8}, {"APPEND", 16}});
+
+  auto old_btf = createTestBTF(old_builder);
+  auto new_btf = createTestBTF(new_builder);
+
+  auto btf_diff = getDiff(*old_btf, *new_btf);
+  REQUIRE(btf_diff.size() == 4);
+
+  const auto &added_diff = btf_diff[0];
+  CHECK(added_diff.change == BTFDiffChange::Added);
+  CHECK(added_diff.kind == BTFKind::Struct);
+  CHECK(added_diff.name == "added");
+  CHECK(!added_diff.opt_old_id.has_value());
+  CHECK(added_diff.opt_new_id == 5U);
+  CHECK(added_diff.opt_new_size == 4U);
+  CHECK(added_diff.member_diff_list.empty());
+
+  const auto &removed_diff = btf_diff[1];
+  CHECK(removed_diff.change == BTFDiffChange::Removed);
+  CHECK(removed_diff.name == "removed");
+  CHECK(removed_diff.opt_old_id == 4U);
+  CHECK(!removed_diff.opt_new_id.has_value());
+
+  const auto &task_diff = btf_diff[2];
+  CHECK(task_diff.change == BTFDiffChange::Changed);
+  CHECK(task_diff.name == "task");
+  CHECK(task_diff.opt_old_size == 16U);
+  CHECK(task_diff.opt_new_size == 24U);
+  REQUIRE(task_diff.member_diff_list.size() == 3);
+
+  const auto &id_diff = task_diff.member_diff_list[0];
+  CHECK(id_diff.change == BTFDiffChange::Changed);
+  CHECK(id_diff.name == "id");
+  CHECK(id_diff.type_changed);
+  CHECK(id_diff.opt_old_offset == 0U);
+  CHECK(id_diff.opt_new_offset == 0U);
+
+  const auto &state_diff = task_diff.member_diff_list[1];
+  CHECK(state_diff.change == BTFDiffChange::Removed);
+  CHECK(state_diff.name == "state");
+  CHECK(state_diff.opt_old_offset == 32U);
+  CHECK(!state_diff.opt_new_offset.has_value());
+
+  const auto &prio_diff = task_diff.member_diff_list[2];
+  CHECK(prio_diff.change == BTFDiffChange::Added);
+  CHECK(prio_diff.name == "prio");
+  CHECK(prio_diff.opt_new_type == new_int_id);
+  CHECK(prio_diff.opt_new_offset == 128U);
+
+  const auto &mode_diff = btf_diff[3];
+  CHECK(mode_diff.change == BTFDiffChange::Changed);
+  CHECK(mode_diff.kind == BTFKind::Enum);
+  CHECK(mode_diff.name == "mode");
+  REQUIRE(mode_diff.member_diff_list.size() == 3);
+
+  CHECK(mode_diff.member_diff_list[0].change == BTFDiffChange::Changed);
+  CHECK(mode_diff.member_diff_list[0].name == "WRITE");
+  CHECK(mode_diff.member_diff_list[0].opt_old_value == 2);
+  CHECK(mode_diff.member_diff_list[0].opt_new_value == 8);
+
+  CHECK(mode_diff.member_diff_list[1].change == BTFDiffChange::Removed);
+  CHECK(mode_diff.member_diff_list[1].name == "EXEC");
+
+  CHECK(mode_diff.member_diff_list[2].change == BTFDiffChange::Added);
+  CHECK(mode_diff.member_diff_list[2].name == "APPEND");
+  CHECK(mode_diff.member_diff_list[2].opt_new_value == 16);
+
+  // Comparing an object against itself reports no differences
+  CHECK(getDiff(*new_btf, *new_btf).empty());
+}
+
+} // namespace btfparse
@@ -0,0 +1,109 @@
+//
+// Copyright (c) 2021-present, Trail of Bits, Inc.
+// All rights reserved.
+//
+// This source code is licensed in accordance with the terms specified in
+// the LICENSE file found in the root directory of this source tree.
+//
+
+#include <doctest/doctest.h>
+
+#include <btfparse/ibtf.h>
+
+#include <stdexcept>
+#include <vector>
+
+namespace btfparse {
+
+namespace {
+
+BTFType createIntType(std::uint32_t size) {
+  IntBTFType int_type;
+  int_type.name = "int";
+  int_type.size = size;
+  int_type.encoding = IntBTFType::Encoding::Signed;
+  int_type.offset = 0;
+  int_type.bits = static_cast<std::uint8_t>(size * 8U);
+
+  return int_type;
+}
+
+std::vector<std::uint32_t> getIDList(const BTFTypeMap &btf_type_map) {
+  std::vector<std::uint32_t> id_list;
+  for (const auto &p : btf_type_map) {
+    id_list.push_back(p.first);
+  }
+
+  return id_list;
+}
+
+} // namespace
+
+TEST_CASE("BTFTypeMap") {
+  BTFTypeMap btf_type_map;
+  CHECK(btf_type_map.empty());
+  CHECK(btf_type_map.begin() == btf_type_map.end());
+  CHECK(btf_type_map.find(1) == btf_type_map.end());
+
+  for (std::uint32_t id = 1; id <= 4; ++id) {
+    auto insert_status = btf_type_map.insert({id, createIntType(id)});
+    CHECK(insert_status.second);
+    CHECK(insert_status.first->first == id);
+  }
+
+  CHECK(btf_type_map.size() == 4);
+  CHECK(btf_type_map.firstID() == 1);
+  CHECK(getIDList(btf_type_map) == std::vector<std::uint32_t>{1, 2, 3, 4});
+
+  auto type_it = btf_type_map.find(3);
+  REQUIRE(type_it != btf_type_map.end());
+  CHECK(std::get<IntBTFType>(type_it->second).size == 3);
+
+  CHECK(btf_type_map.count(0) == 0);
+  CHECK(btf_type_map.count(5) == 0);
+  CHECK_THROWS_AS(btf_type_map.at(5), std::out_of_range);
+
+  auto insert_status = btf_type_map.insert({2, createIntType(8)});
+  CHECK(!insert_status.second);
+  CHECK(std::get<IntBTFType>(btf_type_map.at(2)).size == 2);
+}
+
+TEST_CASE("BTFTypeMap holes") {
+  BTFTypeMap btf_type_map;
+  CHECK(btf_type_map.insert({10, createIntType(1)}).second);
+  CHECK(btf_type_map.firstID() == 10);
+
+  CHECK(btf_type_map.insert({13, createIntType(2)}).second);
+  CHECK(btf_type_map.insert({7, createIntType(4)}).second);
+  CHECK(btf_type_map.insert({11, createIntType(8)}).second);
+
+  CHECK(btf_type_map.size() == 4);
+  CHECK(btf_type_map.firstID() == 7);
+  CHECK(getIDList(btf_type_map) == std::vector<std::uint32_t>{7, 10, 11, 13});
+
+  CHECK(btf_type_map.count(8) == 0);
+  CHECK(btf_type_map.count(12) == 0);
+  CHECK(std::get<IntBTFType>(btf_type_map.at(13)).size == 2);
+
+  CHECK(!btf_type_map.insert({12, BTFType{}}).second);
+  CHECK(btf_type_map.count(12) == 0);
+}
+
+TEST_CASE("BTFTypeMap copies") {
+  BTFTypeMap btf_type_map;
+  CHECK(btf_type_map.insert({1, createIntType(1)}).second);
+  CHECK(btf_type_map.insert({3, createIntType(4)}).second);
+
+  BTFTypeMap btf_type_map_copy;
+  CHECK(btf_type_map_copy.insert({5, createIntType(2)}).second);
+
+  btf_type_map_copy = btf_type_map;
+  CHECK(btf_type_map_copy.size() == 2);
+  CHECK(getIDList(btf_type_map_copy) == std::vector<std::uint32_t>{1, 3});
+
+  btf_type_map.clear();
+  CHECK(btf_type_map.empty());
+  CHECK(btf_type_map_copy.count(3) == 1);
+}
+
+} // namespace btfparse
@@ -0,0 +1,251 @@
+//
+// Copyright (c) 2021-present, Trail of Bits, Inc.
+// All rights reserved.
+//
+// This source code is licensed in accordance with the terms specified in
+// the LICENSE file found in the root directory of this source tree.
+//
+
+#include "btfbuilder.h"
+
+#include <doctest/doctest.h>
+
+#include <btfparse/ibtf.h>
+
+namespace btfparse {
+
+namespace {
+
+const std::uint32_t kKindFlag{0x80000000U};
+
+// One type of each kind, including bitfields, a variadic function and
+// a negative enum value
+BTFBuilder createTestBuilder() {
+  BTFBuilder builder;
+  auto int_id = builder.addInt("int", 4);
+  auto ptr_id = builder.addPtr(int_id);
+
+  builder.addType({}, BTFKind::Array, 0, 0, {int_id, int_id, 16});
+
+  builder.addType("bits", BTFKind::Struct, 2 | kKindFlag, 4,
+                  {builder.addString("low"), int_id, (3U << 24) | 0U,
+                   builder.addString("high"), int_id, (5U << 24) | 3U});
+
+  builder.addType({}, BTFKind::Union, 1, 8,
+                  {builder.addString("ptr"), ptr_id, 0});
+
+  builder.addType("color", BTFKind::Enum, 2, 4,
+                  {builder.addString("RED"), 0, builder.addString("NONE"),
+                   static_cast<std::uint32_t>(-1)});
+
+  builder.addType("fwd_union", BTFKind::Fwd, kKindFlag, 0);
+  builder.addType("int_t", BTFKind::Typedef, 0, int_id);
+  builder.addType({}, BTFKind::Volatile, 0, int_id);
+  builder.addType({}, BTFKind::Const, 0, int_id);
+  builder.addType({}, BTFKind::Restrict, 0, ptr_id);
+
+  auto func_proto_id = builder.addType(
+      {}, BTFKind::FuncProto, 2, int_id,
+      {builder.addString("format"), ptr_id, 0, 0});
+
+  builder.addType("printk", BTFKind::Func, 1, func_proto_id);
+
+  auto var_id = builder.addType("counter", BTFKind::Var, 0, int_id, {1});
+  builder.addType(".data", BTFKind::DataSec, 1, 4, {var_id, 0, 4});
+  builder.addType("double", BTFKind::Float, 0, 8);
+
+  return builder;
+}
+
+Result<IBTF::Ptr, BTFError>
+createBTF(const std::vector<std::uint8_t> &buffer,
+          BTFOptions::DecodingMode decoding_mode) {
+  BTFOptions options;
+  options.decoding_mode = decoding_mode;
+
+  return IBTF::createFromBuffer(buffer.data(), buffer.size(), options);
+}
+
+IBTF::Ptr createTestBTF(const std::vector<std::uint8_t> &buffer,
+                        BTFOptions::DecodingMode decoding_mode) {
+  auto btf_res = createBTF(buffer, decoding_mode);
+  REQUIRE(!btf_res.failed());
+
+  return btf_res.takeValue();
+}
+
+void checkTypeViews(const IBTF &btf) {
+  CHECK(!btf.getTypeView(0).has_value());
+  CHECK(!btf.getTypeView(btf.count() + 1).has_value());
+
+  for (std::uint32_t id = 1; id <= btf.count(); ++id) {
+    auto opt_btf_type_view = btf.getTypeView(id);
+    REQUIRE(opt_btf_type_view.has_value());
+    CHECK(IBTF::getBTFTypeKind(opt_btf_type_view.value()) == btf.getKind(id));
+  }
+
+  auto int_view = std::get<IntBTFTypeView>(btf.getTypeView(1).value());
+  CHECK(int_view.name == "int");
+  CHECK(int_view.size == 4);
+  CHECK(int_view.bits == 32);
+
+  auto bits = std::get<StructBTFTypeView>(btf.getTypeView(4).value());
+  REQUIRE(bits.member_list.size() == 2);
+  CHECK(bits.opt_name.value() == "bits");
+  CHECK(bits.member_list[1].opt_name.value() == "high");
+  CHECK(bits.member_list[1].offset == 3);
+  CHECK(bits.member_list[1].opt_bitfield_size.value() == 5);
+
+  auto unnamed_union = std::get<UnionBTFTypeView>(btf.getTypeView(5).value());
+  CHECK(!unnamed_union.opt_name.has_value());
+  REQUIRE(unnamed_union.member_list.size() == 1);
+  CHECK(unnamed_union.member_list.back().type == 2);
+
+  auto color = std::get<EnumBTFTypeView>(btf.getTypeView(6).value());
+  REQUIRE(color.value_list.size() == 2);
+  CHECK(color.value_list[1].name == "NONE");
+  CHECK(color.value_list[1].val == -1);
+
+  CHECK(std::get<FwdBTFTypeView>(btf.getTypeView(7).value()).is_union);
+  CHECK(std::get<TypedefBTFTypeView>(btf.getTypeView(8).value()).name ==
+        "int_t");
+
+  auto func_proto = std::get<FuncProtoBTFTypeView>(btf.getTypeView(12).value());
+  CHECK(func_proto.is_variadic);
+  REQUIRE(func_proto.param_list.size() == 1);
+  CHECK(func_proto.param_list[0].opt_name.value() == "format");
+
+  auto func = std::get<FuncBTFTypeView>(btf.getTypeView(13).value());
+  CHECK(func.name == "printk");
+  CHECK(func.linkage == FuncBTFType::Linkage::Global);
+
+  auto data_sec = std::get<DataSecBTFTypeView>(btf.getTypeView(15).value());
+  CHECK(data_sec.name == ".data");
+  REQUIRE(data_sec.variable_list.size() == 1);
+  CHECK(data_sec.variable_list[0].type == 14);
+  CHECK(data_sec.variable_list[0].size == 4);
+}
+
+} // namespace
+
+TEST_CASE("BTFOptions::DecodingMode::Compact") {
+  auto buffer = createTestBuilder().build();
+  auto eager_btf = createTestBTF(buffer, BTFOptions::DecodingMode::Eager);
+  auto compact_btf = createTestBTF(buffer, BTFOptions::DecodingMode::Compact);
+
+  REQUIRE(compact_btf->count() == eager_btf->count());
+
+  for (std::uint32_t id = 1; id <= eager_btf->count(); ++id) {
+    CHECK(compact_btf->getKind(id) == eager_btf->getKind(id));
+  }
+
+  CHECK(!compact_btf->getKind(0).has_value());
+  CHECK(!compact_btf->getKind(compact_btf->count() + 1).has_value());
+  CHECK(compact_btf->getTypeRef(compact_btf->count() + 1) == nullptr);
+
+  // The owned copies are created once, and then returned again
+  const auto *btf_type = compact_btf->getTypeRef(4);
+  REQUIRE(btf_type != nullptr);
+  CHECK(btf_type == compact_btf->getTypeRef(4));
+
+  // Snapshots encode every field, so the types are the same if the
+  // snapshots are
+  CHECK(createSnapshotBuffer(*compact_btf) == createSnapshotBuffer(*eager_btf));
+  CHECK(compact_btf->getAll().size() == eager_btf->getAll().size());
+
+  auto id_range = compact_btf->findByName("color");
+  REQUIRE(id_range.size() == 1);
+  CHECK(*id_range.begin() == 6);
+  CHECK(compact_btf->findByKind(BTFKind::Struct).size() == 1);
+}
+
+TEST_CASE("BTFOptions::DecodingMode::Compact decoding errors") {
+  auto builder = createTestBuilder();
+  builder.addRawType(0xFFFFFF, static_cast<std::uint32_t>(BTFKind::Typedef), 0,
+                     1);
+
+  auto buffer = builder.build();
+  CHECK(getErrorCode(createBTF(buffer, BTFOptions::DecodingMode::Compact)) ==
+        getErrorCode(createBTF(buffer, BTFOptions::DecodingMode::Eager)));
+
+  // The decoding errors that precede an index error are reported first
+  builder.addRawType(0, 31, 0, 0);
+
+  buffer = builder.build();
+  CHECK(getErrorCode(createBTF(buffer, BTFOptions::DecodingMode::Compact)) ==
+        getErrorCode(createBTF(buffer, BTFOptions::DecodingMode::Eager)));
+
+  builder = createTestBuilder();
+  builder.addRawType(0, 31, 0, 0);
+
+  buffer = builder.build();
+  CHECK(getErrorCode(createBTF(buffer, BTFOptions::DecodingMode::Compact)) ==
+        BTFErrorInformation::Code::InvalidBTFKind);
+}
+
+TEST_CASE("IBTF::getTypeView()") {
+  auto buffer = createTestBuilder().build();
+
+  for (auto decoding_mode :
+       {BTFOptions::DecodingMode::Eager, BTFOptions::DecodingMode::Lazy,
+        BTFOptions::DecodingMode::Compact}) {
+
+    auto btf = createTestBTF(buffer, decoding_mode);
+    checkTypeViews(*btf);
+  }
+
+  auto btf = createTestBTF(buffer, BTFOptions::DecodingMode::Eager);
+  auto snapshot = createSnapshotBuffer(*btf);
+
+  auto snapshot_btf_res =
+      IBTF::createFromSnapshotBuffer(snapshot.data(), snapshot.size());
+  REQUIRE(!snapshot_btf_res.failed());
+
+  checkTypeViews(*snapshot_btf_res.takeValue());
+}
+
+TEST_CASE("IBTF::getTypeView() (split BTF)") {
+  BTFBuilder base_builder;
+  auto int_id = base_builder.addInt("int", 4);
+
+  auto split_builder = BTFBuilder::createSplit(base_builder);
+  split_builder.addStruct("split_struct", 4, {{"value", int_id, 0}});
+
+  auto base_buffer = base_builder.build();
+  IBTF::SharedPtr base_btf =
+      createTestBTF(base_buffer, BTFOptions::DecodingMode::Compact);
+
+  auto split_path = split_builder.save("split");
+
+  for (auto decoding_mode :
+       {BTFOptions::DecodingMode::Eager, BTFOptions::DecodingMode::Compact}) {
+
+    BTFOptions options;
+    options.decoding_mode = decoding_mode;
+
+    auto split_btf_res =
+        IBTF::createSplitFromPath(base_btf, split_path, options);
+
+    REQUIRE(!split_btf_res.failed());
+
+    auto split_btf = split_btf_res.takeValue();
+    REQUIRE(split_btf->count() == 2);
+
+    auto int_view = std::get<IntBTFTypeView>(split_btf->getTypeView(1).value());
+    CHECK(int_view.name == "int");
+
+    auto split_struct =
+        std::get<StructBTFTypeView>(split_btf->getTypeView(2).value());
+
+    CHECK(split_struct.opt_name.value() == "split_struct");
+    REQUIRE(split_struct.member_list.size() == 1);
+    CHECK(split_struct.member_list[0].opt_name.value() == "value");
+    CHECK(split_struct.member_list[0].type == int_id);
+
+    CHECK(!split_btf->getTypeView(3).has_value());
+  }
+
+  std::filesystem::remove(split_path);
+}
+
+} // namespace btfparse
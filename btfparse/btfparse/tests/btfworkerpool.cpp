@@ -0,0 +1,122 @@
+//
+// Copyright (c) 2021-present, Trail of Bits, Inc.
+// All rights reserved.
+//
+// This source code is licensed in accordance with the terms specified in
+// the LICENSE file found in the root directory of this source tree.
+//
+
+#include "btfbuilder.h"
+
+#include <doctest/doctest.h>
+
+#include <btfparse/ibtfworkerpool.h>
+
+#include <atomic>
+#include <mutex>
+#include <set>
+#include <thread>
+
+namespace btfparse {
+
+TEST_CASE("IBTFWorkerPool::run()") {
+  auto worker_pool = IBTFWorkerPool::create(4);
+  REQUIRE(worker_pool != nullptr);
+  CHECK(worker_pool->threadCount() == 4);
+
+  worker_pool->run({});
+
+  std::vector<std::size_t> result_list(256);
+
+  std::mutex thread_id_set_mutex;
+  std::set<std::thread::id> thread_id_set;
+
+  BTFOptions::TaskList task_list;
+  for (std::size_t i = 0; i < result_list.size(); ++i) {
+    task_list.push_back([&, i]() {
+      result_list[i] = i * 2;
+
+      std::lock_guard<std::mutex> lock(thread_id_set_mutex);
+      thread_id_set.insert(std::this_thread::get_id());
+    });
+  }
+
+  worker_pool->run(task_list);
+
+  for (std::size_t i = 0; i < result_list.size(); ++i) {
+    CHECK(result_list[i] == i * 2);
+  }
+
+  // At most the four workers and the calling thread
+  CHECK(thread_id_set.size() <= 5);
+}
+
+TEST_CASE("IBTFWorkerPool::run() (nested)") {
+  auto worker_pool = IBTFWorkerPool::create(3);
+  REQUIRE(worker_pool != nullptr);
+
+  // More outer tasks than workers, each one blocked until all of its own
+  // subtasks have run
+  std::atomic_size_t subtask_count{0};
+  std::atomic_size_t outer_task_count{0};
+
+  BTFOptions::TaskList task_list;
+  for (std::size_t i = 0; i < 8; ++i) {
+    task_list.push_back([&]() {
+      BTFOptions::TaskList subtask_list;
+      for (std::size_t j = 0; j < 16; ++j) {
+        subtask_list.push_back([&]() { ++subtask_count; });
+      }
+
+      worker_pool->run(subtask_list);
+      ++outer_task_count;
+    });
+  }
+
+  worker_pool->run(task_list);
+
+  CHECK(outer_task_count == 8);
+  CHECK(subtask_count == 8 * 16);
+}
+
+TEST_CASE("IBTFWorkerPool (BTFOptions::executor)") {
+  auto worker_pool = IBTFWorkerPool::create(4);
+  REQUIRE(worker_pool != nullptr);
+
+  BTFBuilder builder;
+  auto int_id = builder.addInt("int", 4);
+  for (std::uint32_t i = 0; i < 256; ++i) {
+    builder.addStruct("s" + std::to_string(i), 4, {{"value", int_id, 0}});
+  }
+
+  BTFOptions options;
+  options.thread_count = worker_pool->threadCount();
+  options.executor = [&worker_pool](const BTFOptions::TaskList &task_list) {
+    worker_pool->run(task_list);
+  };
+
+  // Parses that run on the pool can also use it for their own tasks
+  auto buffer = builder.build();
+  std::vector<IBTF::Ptr> btf_list(4);
+
+  BTFOptions::TaskList task_list;
+  for (auto &btf : btf_list) {
+    task_list.push_back([&]() {
+      auto btf_res =
+          IBTF::createFromBuffer(buffer.data(), buffer.size(), options);
+      if (!btf_res.failed()) {
+        btf = btf_res.takeValue();
+      }
+    });
+  }
+
+  worker_pool->run(task_list);
+
+  for (const auto &btf : btf_list) {
+    REQUIRE(btf != nullptr);
+    CHECK(btf->count() == 257);
+    CHECK(btf->findByName("s255").size() == 1);
+  }
+}
+
+} // namespace btfparse
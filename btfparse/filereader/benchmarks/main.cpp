@@ -0,0 +1,134 @@
+//
+// Copyright (c) 2021-present, Trail of Bits, Inc.
+// All rights reserved.
+//
+// This source code is licensed in accordance with the terms specified in
+// the LICENSE file found in the root directory of this source tree.
+//
+
+#include <btfparse/ifilereader.h>
+
+#include <benchmark/benchmark.h>
+
+#include <cstring>
+#include <vector>
+
+namespace btfparse {
+
+namespace {
+
+// Same size as a BTFTypeHeader or a struct member
+const std::size_t kRecordSize{12U};
+const std::size_t kRecordCount{100000U};
+
+class BenchmarkStream final : public IStream {
+public:
+  BenchmarkStream(bool expose_buffer)
+      : data(kRecordSize * kRecordCount, 0x01),
+        memory_resident(expose_buffer) {}
+
+  virtual ~BenchmarkStream() override = default;
+
+  virtual bool seek(std::uint64_t offset) override {
+    if (offset >= data.size()) {
+      return false;
+    }
+
+    current_offset = static_cast<std::size_t>(offset);
+    return true;
+  }
+
+  virtual std::uint64_t offset() const override { return current_offset; }
+
+  virtual bool read(std::uint8_t *buffer, std::size_t size) override {
+    if (size > data.size() - current_offset) {
+      return false;
+    }
+
+    std::memcpy(buffer, &data[current_offset], size);
+    current_offset += size;
+
+    return true;
+  }
+
+  virtual OptionalBuffer buffer() const override {
+    if (!memory_resident) {
+      return std::nullopt;
+    }
+
+    return Buffer{data.data(), data.size()};
+  }
+
+private:
+  std::vector<std::uint8_t> data;
+  bool memory_resident{false};
+  std::size_t current_offset{};
+};
+
+IFileReader::Ptr createFileReader(bool memory_resident, bool little_endian) {
+  auto file_reader_res = IFileReader::createFromStream(
+      std::make_unique<BenchmarkStream>(memory_resident));
+
+  if (file_reader_res.failed()) {
+    throw std::runtime_error(file_reader_res.takeError().toString());
+  }
+
+  auto file_reader = file_reader_res.takeValue();
+  file_reader->setEndianness(little_endian);
+
+  return file_reader;
+}
+
+void BM_IntegerReads(benchmark::State &state) {
+  auto file_reader = createFileReader(state.range(0) != 0, state.range(1) != 0);
+
+  for (auto _ : state) {
+    file_reader->seek(0);
+
+    for (std::size_t i = 0; i < kRecordCount; ++i) {
+      benchmark::DoNotOptimize(file_reader->u32());
+      benchmark::DoNotOptimize(file_reader->u32());
+      benchmark::DoNotOptimize(file_reader->u32());
+    }
+  }
+
+  state.SetBytesProcessed(static_cast<std::int64_t>(
+      state.iterations() * kRecordSize * kRecordCount));
+}
+
+void BM_RecordReads(benchmark::State &state) {
+  auto file_reader = createFileReader(state.range(0) != 0, state.range(1) != 0);
+
+  for (auto _ : state) {
+    file_reader->seek(0);
+
+    for (std::size_t i = 0; i < kRecordCount; ++i) {
+      auto record = file_reader->readRecord(kRecordSize);
+      benchmark::DoNotOptimize(record.u32());
+      benchmark::DoNotOptimize(record.u32());
+      benchmark::DoNotOptimize(record.u32());
+    }
+  }
+
+  state.SetBytesProcessed(static_cast<std::int64_t>(
+      state.iterations() * kRecordSize * kRecordCount));
+}
+
+} // namespace
+
+// Arguments: memory resident stream, little endian
+BENCHMARK(BM_IntegerReads)
+    ->ArgNames({"memory_resident", "little_endian"})
+    ->Args({0, 1})
+    ->Args({1, 1})
+    ->Args({1, 0});
+
+BENCHMARK(BM_RecordReads)
+    ->ArgNames({"memory_resident", "little_endian"})
+    ->Args({0, 1})
+    ->Args({1, 1})
+    ->Args({1, 0});
+
+} // namespace btfparse
+
+BENCHMARK_MAIN();
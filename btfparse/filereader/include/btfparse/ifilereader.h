@@ -10,11 +10,13 @@
 
 #include <btfparse/error.h>
 #include <btfparse/istream.h>
+#include <btfparse/recordreader.h>
 #include <btfparse/result.h>
 
 #include <filesystem>
 #include <optional>
 #include <sstream>
+#include <string_view>
 
 namespace btfparse {
 
@@ -24,6 +26,8 @@ struct FileReaderErrorInformation final {
     MemoryAllocationFailure,
     FileNotFound,
     IOError,
+    InvalidELFFile,
+    ELFSectionNotFound,
   };
 
   struct ReadOperation final {
@@ -59,6 +63,14 @@ struct FileReaderErrorInformationPrinter final {
     case FileReaderErrorInformation::Code::IOError:
       buffer << "IO error";
       break;
+
+    case FileReaderErrorInformation::Code::InvalidELFFile:
+      buffer << "Invalid ELF file";
+      break;
+
+    case FileReaderErrorInformation::Code::ELFSectionNotFound:
+      buffer << "ELF section not found";
+      break;
     }
 
     buffer << "'";
@@ -76,6 +88,22 @@ struct FileReaderErrorInformationPrinter final {
 using FileReaderError =
     Error<FileReaderErrorInformation, FileReaderErrorInformationPrinter>;
 
+struct FileReaderOptions final {
+  enum class AccessMode {
+    // Map the file in memory, falling back to Buffered for files
+    // that can't be mapped (i.e. some sysfs nodes)
+    Automatic,
+
+    // Map the file in memory, failing if that is not possible
+    MemoryMapped,
+
+    // Read the whole file into a heap buffer
+    Buffered,
+  };
+
+  AccessMode access_mode{AccessMode::Automatic};
+};
+
 class IFileReader {
 public:
   using Ptr = std::unique_ptr<IFileReader>;
@@ -83,8 +111,26 @@ public:
   static Result<Ptr, FileReaderError>
   open(const std::filesystem::path &path) noexcept;
   static Result<Ptr, FileReaderError>
+  open(const std::filesystem::path &path,
+       const FileReaderOptions &options) noexcept;
+  static Result<Ptr, FileReaderError>
   createFromStream(IStream::Ptr stream) noexcept;
 
+  // The buffer is not copied, and must outlive the returned reader
+  static Result<Ptr, FileReaderError>
+  createFromBuffer(const std::uint8_t *data, std::size_t size) noexcept;
+
+  // Opens the contents of the given section of an ELF file
+  static Result<Ptr, FileReaderError>
+  openELFSection(const std::filesystem::path &path,
+                 std::string_view section_name) noexcept;
+
+  // Same as openELFSection, for an ELF image that is already in memory.
+  // The image is not copied, and must outlive the returned reader
+  static Result<Ptr, FileReaderError>
+  createFromELFSection(const std::uint8_t *data, std::size_t size,
+                       std::string_view section_name) noexcept;
+
   IFileReader() = default;
   virtual ~IFileReader() = default;
 
@@ -99,6 +145,22 @@ public:
   virtual std::uint32_t u32() = 0;
   virtual std::uint64_t u64() = 0;
 
+  // Reads `size` bytes with a single bounds check; the returned cursor
+  // is only valid until the next read operation
+  virtual RecordReader readRecord(std::size_t size) = 0;
+
+  // Non-throwing versions of seek and readRecord, that return the error
+  // instead. Callers that expect many reads to fail (i.e. when validating
+  // untrusted data) do not pay for the exceptions
+  virtual std::optional<FileReaderError>
+  trySeek(std::uint64_t offset) noexcept = 0;
+
+  virtual Result<RecordReader, FileReaderError>
+  tryReadRecord(std::size_t size) noexcept = 0;
+
+  // Returns the backing buffer of memory-resident files
+  virtual IStream::OptionalBuffer buffer() const = 0;
+
   IFileReader(const IFileReader &) = delete;
   IFileReader &operator=(const IFileReader &) = delete;
 };
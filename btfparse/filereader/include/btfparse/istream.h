@@ -10,6 +10,7 @@
 
 #include <cstdint>
 #include <memory>
+#include <optional>
 
 namespace btfparse {
 
@@ -17,6 +18,13 @@ class IStream {
 public:
   using Ptr = std::unique_ptr<IStream>;
 
+  struct Buffer final {
+    const std::uint8_t *data{nullptr};
+    std::size_t size{};
+  };
+
+  using OptionalBuffer = std::optional<Buffer>;
+
   IStream() = default;
   virtual ~IStream() = default;
 
@@ -25,6 +33,10 @@ public:
 
   virtual bool read(std::uint8_t *buffer, std::size_t size) = 0;
 
+  // Memory-resident streams return their backing bytes here; the
+  // buffer remains valid for as long as the stream is alive
+  virtual OptionalBuffer buffer() const { return std::nullopt; }
+
   IStream(const IStream &) = delete;
   IStream &operator=(const IStream &) = delete;
 };
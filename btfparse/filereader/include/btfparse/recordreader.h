@@ -0,0 +1,115 @@
+//
+// Copyright (c) 2021-present, Trail of Bits, Inc.
+// All rights reserved.
+//
+// This source code is licensed in accordance with the terms specified in
+// the LICENSE file found in the root directory of this source tree.
+//
+
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+
+namespace btfparse {
+
+// A cursor over a contiguous, already bounds-checked record. Loads are
+// not checked again: callers must not read past the size they requested
+// from IFileReader::readRecord
+class RecordReader final {
+  const std::uint8_t *cursor{nullptr};
+  const std::uint8_t *end{nullptr};
+  bool byte_swap{false};
+
+public:
+  RecordReader() = default;
+
+  RecordReader(const std::uint8_t *buffer, std::size_t size,
+               bool little_endian)
+      : cursor(buffer), end(buffer + size),
+        byte_swap(little_endian != isHostLittleEndian()) {}
+
+  const std::uint8_t *data() const { return cursor; }
+
+  std::size_t remaining() const {
+    return static_cast<std::size_t>(end - cursor);
+  }
+
+  void skip(std::size_t size) { cursor += size; }
+
+  // True if the record is not stored in the byte order of the host
+  bool byteSwap() const { return byte_swap; }
+
+  std::uint8_t u8() { return *cursor++; }
+  std::uint16_t u16() { return load<std::uint16_t>(); }
+  std::uint32_t u32() { return load<std::uint32_t>(); }
+  std::uint64_t u64() { return load<std::uint64_t>(); }
+
+  // Copies `count` consecutive 32-bit fields, and byte swaps them in a
+  // single pass that the compiler can vectorize
+  void u32Array(std::uint32_t *output, std::size_t count) {
+    if (byte_swap) {
+      u32Array<true>(output, count);
+    } else {
+      u32Array<false>(output, count);
+    }
+  }
+
+  // Same as the loads above, but the byte order is fixed at compile time.
+  // Decoders that are specialized for it check byteSwap() once, and then
+  // use these for the rest of the type
+  template <bool kByteSwap> std::uint16_t u16() {
+    return load<std::uint16_t, kByteSwap>();
+  }
+
+  template <bool kByteSwap> std::uint32_t u32() {
+    return load<std::uint32_t, kByteSwap>();
+  }
+
+  template <bool kByteSwap> std::uint64_t u64() {
+    return load<std::uint64_t, kByteSwap>();
+  }
+
+  template <bool kByteSwap>
+  void u32Array(std::uint32_t *output, std::size_t count) {
+    std::memcpy(output, cursor, count * sizeof(std::uint32_t));
+    cursor += count * sizeof(std::uint32_t);
+
+    if (kByteSwap) {
+      for (std::size_t i = 0; i < count; ++i) {
+        output[i] = byteSwap(output[i]);
+      }
+    }
+  }
+
+  static constexpr bool isHostLittleEndian() {
+    return __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__;
+  }
+
+  static std::uint16_t byteSwap(std::uint16_t value) {
+    return __builtin_bswap16(value);
+  }
+
+  static std::uint32_t byteSwap(std::uint32_t value) {
+    return __builtin_bswap32(value);
+  }
+
+  static std::uint64_t byteSwap(std::uint64_t value) {
+    return __builtin_bswap64(value);
+  }
+
+private:
+  template <typename Type> Type load() {
+    return byte_swap ? load<Type, true>() : load<Type, false>();
+  }
+
+  template <typename Type, bool kByteSwap> Type load() {
+    Type value;
+    std::memcpy(&value, cursor, sizeof(Type));
+    cursor += sizeof(Type);
+
+    return kByteSwap ? byteSwap(value) : value;
+  }
+};
+
+} // namespace btfparse
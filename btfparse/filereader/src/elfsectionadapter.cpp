@@ -0,0 +1,270 @@
+//
+// Copyright (c) 2021-present, Trail of Bits, Inc.
+// All rights reserved.
+//
+// This source code is licensed in accordance with the terms specified in
+// the LICENSE file found in the root directory of this source tree.
+//
+
+#include "elfsectionadapter.h"
+
+#include <array>
+#include <cstring>
+
+#include <btfparse/ifilereader.h>
+
+namespace btfparse {
+
+namespace {
+
+const std::array<std::uint8_t, 4> kELFMagicValue{0x7F, 'E', 'L', 'F'};
+const std::size_t kELFIdentSize{16U};
+const std::uint8_t kELFClass32{1U};
+const std::uint8_t kELFClass64{2U};
+const std::uint8_t kELFDataLittleEndian{1U};
+const std::uint8_t kELFDataBigEndian{2U};
+const std::uint32_t kSectionTypeNoBits{8U};
+const std::uint16_t kSectionIndexExtended{0xFFFFU};
+
+struct ELFSectionHeader final {
+  std::uint32_t name{};
+  std::uint32_t type{};
+  std::uint64_t offset{};
+  std::uint64_t size{};
+  std::uint32_t link{};
+};
+
+[[noreturn]] void throwInvalidELFFile() {
+  throw FileReaderError(FileReaderErrorInformation{
+      FileReaderErrorInformation::Code::InvalidELFFile});
+}
+
+RecordReader readELFRecord(const IStream::Buffer &elf_image,
+                           std::uint64_t offset, std::size_t size,
+                           bool little_endian) {
+  if (offset > elf_image.size || size > elf_image.size - offset) {
+    throwInvalidELFFile();
+  }
+
+  return RecordReader(elf_image.data + offset, size, little_endian);
+}
+
+class ELFReader final {
+public:
+  ELFReader(const IStream::Buffer &image) : elf_image(image) {
+    auto ident = readELFRecord(elf_image, 0, kELFIdentSize, true);
+    if (std::memcmp(ident.data(), kELFMagicValue.data(),
+                    kELFMagicValue.size()) != 0) {
+      throwInvalidELFFile();
+    }
+
+    ident.skip(kELFMagicValue.size());
+
+    auto elf_class = ident.u8();
+    if (elf_class != kELFClass32 && elf_class != kELFClass64) {
+      throwInvalidELFFile();
+    }
+
+    auto elf_data = ident.u8();
+    if (elf_data != kELFDataLittleEndian && elf_data != kELFDataBigEndian) {
+      throwInvalidELFFile();
+    }
+
+    is_64bit = elf_class == kELFClass64;
+    little_endian = elf_data == kELFDataLittleEndian;
+
+    // e_shoff, e_shentsize, e_shnum and e_shstrndx
+    if (is_64bit) {
+      section_header_table_offset = read(0x28, 8).u64();
+
+      auto record = read(0x3A, 6);
+      section_header_size = record.u16();
+      section_count = record.u16();
+      string_section_index = record.u16();
+
+    } else {
+      section_header_table_offset = read(0x20, 4).u32();
+
+      auto record = read(0x2E, 6);
+      section_header_size = record.u16();
+      section_count = record.u16();
+      string_section_index = record.u16();
+    }
+
+    if (section_header_table_offset == 0 ||
+        section_header_table_offset >= elf_image.size ||
+        section_header_size < (is_64bit ? 0x40U : 0x28U)) {
+      throwInvalidELFFile();
+    }
+
+    // Files with many sections store the real values in the first
+    // section header
+    if (section_count == 0 || string_section_index == kSectionIndexExtended) {
+      auto first_section_header = readSectionHeader(0);
+
+      if (section_count == 0) {
+        section_count = first_section_header.size;
+      }
+
+      if (string_section_index == kSectionIndexExtended) {
+        string_section_index = first_section_header.link;
+      }
+    }
+
+    if (string_section_index >= section_count) {
+      throwInvalidELFFile();
+    }
+  }
+
+  IStream::Buffer locateSection(std::string_view section_name) const {
+    auto string_section_header = readSectionHeader(string_section_index);
+    auto string_section = getSectionData(string_section_header);
+
+    std::string_view string_table(
+        reinterpret_cast<const char *>(string_section.data),
+        string_section.size);
+
+    for (std::uint64_t i = 1; i < section_count; ++i) {
+      auto section_header = readSectionHeader(i);
+      if (section_header.name >= string_table.size()) {
+        throwInvalidELFFile();
+      }
+
+      auto name = string_table.substr(section_header.name);
+      name = name.substr(0, name.find('\0'));
+
+      if (name == section_name) {
+        return getSectionData(section_header);
+      }
+    }
+
+    throw FileReaderError(FileReaderErrorInformation{
+        FileReaderErrorInformation::Code::ELFSectionNotFound});
+  }
+
+private:
+  IStream::Buffer elf_image;
+  bool is_64bit{true};
+  bool little_endian{true};
+
+  std::uint64_t section_header_table_offset{};
+  std::uint64_t section_header_size{};
+  std::uint64_t section_count{};
+  std::uint64_t string_section_index{};
+
+  RecordReader read(std::uint64_t offset, std::size_t size) const {
+    return readELFRecord(elf_image, offset, size, little_endian);
+  }
+
+  ELFSectionHeader readSectionHeader(std::uint64_t index) const {
+    if (index > (elf_image.size - section_header_table_offset) /
+                    section_header_size) {
+      throwInvalidELFFile();
+    }
+
+    auto offset = section_header_table_offset + index * section_header_size;
+
+    ELFSectionHeader section_header;
+
+    if (is_64bit) {
+      auto record = read(offset, 0x40);
+      section_header.name = record.u32();
+      section_header.type = record.u32();
+      record.skip(16);
+      section_header.offset = record.u64();
+      section_header.size = record.u64();
+      section_header.link = record.u32();
+
+    } else {
+      auto record = read(offset, 0x28);
+      section_header.name = record.u32();
+      section_header.type = record.u32();
+      record.skip(8);
+      section_header.offset = record.u32();
+      section_header.size = record.u32();
+      section_header.link = record.u32();
+    }
+
+    return section_header;
+  }
+
+  IStream::Buffer getSectionData(const ELFSectionHeader &section_header) const {
+    if (section_header.type == kSectionTypeNoBits ||
+        section_header.offset > elf_image.size ||
+        section_header.size > elf_image.size - section_header.offset) {
+      throwInvalidELFFile();
+    }
+
+    return IStream::Buffer{elf_image.data + section_header.offset,
+                           static_cast<std::size_t>(section_header.size)};
+  }
+};
+
+} // namespace
+
+ELFSectionAdapter::ELFSectionAdapter(IStream::Ptr stream, Buffer buffer)
+    : file_stream(std::move(stream)), section_buffer(buffer), section_pos(0) {}
+
+ELFSectionAdapter::~ELFSectionAdapter() {}
+
+IStream::Ptr ELFSectionAdapter::create(IStream::Ptr file_stream,
+                                       Buffer elf_image,
+                                       std::string_view section_name) {
+  auto section = locateSection(elf_image, section_name);
+  if (section.size == 0) {
+    throw FileReaderError(
+        FileReaderErrorInformation{FileReaderErrorInformation::Code::IOError});
+  }
+
+  try {
+    return Ptr(new ELFSectionAdapter(std::move(file_stream), section));
+
+  } catch (const std::bad_alloc &) {
+    throw FileReaderError(FileReaderErrorInformation{
+        FileReaderErrorInformation::Code::MemoryAllocationFailure,
+    });
+  }
+}
+
+IStream::Buffer
+ELFSectionAdapter::locateSection(Buffer elf_image,
+                                 std::string_view section_name) {
+  if (elf_image.data == nullptr) {
+    throwInvalidELFFile();
+  }
+
+  ELFReader elf_reader(elf_image);
+  return elf_reader.locateSection(section_name);
+}
+
+bool ELFSectionAdapter::seek(std::uint64_t offset) {
+  if (offset >= section_buffer.size) {
+    return false;
+  }
+
+  section_pos = offset;
+
+  return true;
+}
+
+std::uint64_t ELFSectionAdapter::offset() const {
+  return static_cast<std::uint64_t>(section_pos);
+}
+
+bool ELFSectionAdapter::read(std::uint8_t *buffer, std::size_t size) {
+  if (size > section_buffer.size - section_pos) {
+    return false;
+  }
+
+  std::memcpy(buffer, section_buffer.data + section_pos, size);
+
+  section_pos += size;
+
+  return true;
+}
+
+IStream::OptionalBuffer ELFSectionAdapter::buffer() const {
+  return section_buffer;
+}
+
+} // namespace btfparse
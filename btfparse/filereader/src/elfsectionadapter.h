@@ -0,0 +1,45 @@
+//
+// Copyright (c) 2021-present, Trail of Bits, Inc.
+// All rights reserved.
+//
+// This source code is licensed in accordance with the terms specified in
+// the LICENSE file found in the root directory of this source tree.
+//
+
+#pragma once
+
+#include <btfparse/istream.h>
+
+#include <string_view>
+
+namespace btfparse {
+
+class ELFSectionAdapter final : public IStream {
+private:
+  IStream::Ptr file_stream;
+  Buffer section_buffer;
+  std::size_t section_pos;
+
+public:
+  ELFSectionAdapter() = delete;
+
+  // Exposes the given section of a memory-resident ELF file. When
+  // file_stream is null, the ELF image is borrowed and must outlive the
+  // returned stream
+  static Ptr create(IStream::Ptr file_stream, Buffer elf_image,
+                    std::string_view section_name);
+
+  static Buffer locateSection(Buffer elf_image, std::string_view section_name);
+
+  virtual ~ELFSectionAdapter() override;
+
+  virtual bool seek(std::uint64_t offset) override;
+  virtual std::uint64_t offset() const override;
+  virtual bool read(std::uint8_t *buffer, std::size_t size) override;
+  virtual OptionalBuffer buffer() const override;
+
+private:
+  ELFSectionAdapter(IStream::Ptr stream, Buffer buffer);
+};
+
+} // namespace btfparse
@@ -8,9 +8,7 @@
 
 #include "filereader.h"
 
-#include <array>
 #include <cstring>
-#include <fstream>
 
 namespace btfparse {
 
@@ -55,8 +53,43 @@ std::uint32_t FileReader::u32() { return u32(d->context); }
 
 std::uint64_t FileReader::u64() { return u64(d->context); }
 
+RecordReader FileReader::readRecord(std::size_t size) {
+  return readRecord(d->context, size);
+}
+
+std::optional<FileReaderError>
+FileReader::trySeek(std::uint64_t offset) noexcept {
+  return trySeek(d->context, offset);
+}
+
+Result<RecordReader, FileReaderError>
+FileReader::tryReadRecord(std::size_t size) noexcept {
+  return tryReadRecord(d->context, size);
+}
+
+IStream::OptionalBuffer FileReader::buffer() const {
+  return buffer(d->context);
+}
+
 FileReader::FileReader(IStream::Ptr stream) : d(new PrivateData) {
-  d->context.stream = std::move(stream);
+  setStream(d->context, std::move(stream));
+}
+
+void FileReader::setStream(Context &context, IStream::Ptr stream) {
+  context.stream = std::move(stream);
+
+  context.buffer = nullptr;
+  context.buffer_size = 0;
+  context.buffer_offset = 0;
+
+  auto opt_buffer = context.stream->buffer();
+  if (opt_buffer.has_value()) {
+    const auto &buffer = opt_buffer.value();
+
+    context.buffer = buffer.data;
+    context.buffer_size = buffer.size;
+    context.buffer_offset = static_cast<std::size_t>(context.stream->offset());
+  }
 }
 
 void FileReader::setEndianness(Context &context, bool little_endian) {
@@ -64,19 +97,27 @@ void FileReader::setEndianness(Context &context, bool little_endian) {
 }
 
 void FileReader::seek(Context &context, std::uint64_t offset) {
-  if (!context.stream->seek(offset)) {
-    throw FileReaderError(
-        {FileReaderErrorInformation::Code::IOError,
-         FileReaderErrorInformation::ReadOperation{offset, 0}});
+  auto opt_error = trySeek(context, offset);
+  if (opt_error.has_value()) {
+    throw opt_error.value();
   }
 }
 
 std::uint64_t FileReader::offset(Context &context) {
+  if (context.buffer != nullptr) {
+    return context.buffer_offset;
+  }
+
   return context.stream->offset();
 }
 
 void FileReader::read(Context &context, std::uint8_t *buffer,
                       std::size_t size) {
+  if (context.buffer != nullptr) {
+    std::memcpy(buffer, readRecord(context, size).data(), size);
+    return;
+  }
+
   auto read_offset = offset(context);
   if (!context.stream->read(buffer, size)) {
     throw FileReaderError(
@@ -86,6 +127,10 @@ void FileReader::read(Context &context, std::uint8_t *buffer,
 }
 
 std::uint8_t FileReader::u8(Context &context) {
+  if (context.buffer != nullptr) {
+    return readRecord(context, 1).u8();
+  }
+
   std::uint8_t value{};
   read(context, &value, 1);
 
@@ -93,68 +138,107 @@ std::uint8_t FileReader::u8(Context &context) {
 }
 
 std::uint16_t FileReader::u16(Context &context) {
-  std::array<std::uint8_t, 2> read_buffer;
-  read(context, read_buffer.data(), read_buffer.size());
-
-  std::uint16_t value{};
-  if (context.little_endian) {
-    value = static_cast<std::uint16_t>(read_buffer[0] | (read_buffer[1] << 8));
-  } else {
-    value = static_cast<std::uint16_t>(read_buffer[1] | (read_buffer[0] << 8));
+  return readRecord(context, 2).u16();
+}
+
+std::uint32_t FileReader::u32(Context &context) {
+  return readRecord(context, 4).u32();
+}
+
+std::uint64_t FileReader::u64(Context &context) {
+  return readRecord(context, 8).u64();
+}
+
+RecordReader FileReader::readRecord(Context &context, std::size_t size) {
+  auto record_res = tryReadRecord(context, size);
+  if (record_res.failed()) {
+    throw record_res.takeError();
   }
 
-  return value;
+  return record_res.takeValue();
 }
 
-std::uint32_t FileReader::u32(Context &context) {
-  std::array<std::uint8_t, 4> read_buffer;
-  read(context, read_buffer.data(), read_buffer.size());
-
-  std::uint32_t value{};
-  if (context.little_endian) {
-    value = static_cast<std::uint32_t>(read_buffer[0] | (read_buffer[1] << 8) |
-                                       (read_buffer[2] << 16) |
-                                       (read_buffer[3] << 24));
-
-  } else {
-    value = static_cast<std::uint32_t>(read_buffer[3] | (read_buffer[2] << 8) |
-                                       (read_buffer[1] << 16) |
-                                       (read_buffer[0] << 24));
+std::optional<FileReaderError>
+FileReader::trySeek(Context &context, std::uint64_t offset) noexcept {
+  if (context.buffer != nullptr) {
+    if (offset >= context.buffer_size) {
+      return FileReaderError(
+          {FileReaderErrorInformation::Code::IOError,
+           FileReaderErrorInformation::ReadOperation{offset, 0}});
+    }
+
+    context.buffer_offset = static_cast<std::size_t>(offset);
+    return std::nullopt;
   }
 
-  return value;
+  bool succeeded{false};
+
+  try {
+    succeeded = context.stream->seek(offset);
+
+  } catch (const std::exception &) {
+  }
+
+  if (!succeeded) {
+    return FileReaderError(
+        {FileReaderErrorInformation::Code::IOError,
+         FileReaderErrorInformation::ReadOperation{offset, 0}});
+  }
+
+  return std::nullopt;
 }
 
-std::uint64_t FileReader::u64(Context &context) {
-  std::array<std::uint8_t, 8> read_buffer;
-  read(context, read_buffer.data(), read_buffer.size());
-
-  auto L_shiftInteger = [](std::uint8_t value,
-                           std::size_t shift_count) -> std::uint64_t {
-    return static_cast<std::uint64_t>(value) << shift_count;
-  };
-
-  std::uint64_t value{};
-  if (context.little_endian) {
-    value =
-        static_cast<std::uint64_t>(read_buffer[0]) |
-        L_shiftInteger(read_buffer[1], 8) | L_shiftInteger(read_buffer[2], 16) |
-        L_shiftInteger(read_buffer[3], 24) |
-        L_shiftInteger(read_buffer[4], 32) |
-        L_shiftInteger(read_buffer[5], 40) |
-        L_shiftInteger(read_buffer[6], 48) | L_shiftInteger(read_buffer[7], 56);
-
-  } else {
-    value =
-        static_cast<std::uint64_t>(read_buffer[7]) |
-        L_shiftInteger(read_buffer[6], 8) | L_shiftInteger(read_buffer[5], 16) |
-        L_shiftInteger(read_buffer[4], 24) |
-        L_shiftInteger(read_buffer[3], 32) |
-        L_shiftInteger(read_buffer[2], 40) |
-        L_shiftInteger(read_buffer[1], 48) | L_shiftInteger(read_buffer[0], 56);
+Result<RecordReader, FileReaderError>
+FileReader::tryReadRecord(Context &context, std::size_t size) noexcept {
+  if (context.buffer != nullptr) {
+    if (size > context.buffer_size - context.buffer_offset) {
+      return FileReaderError(
+          {FileReaderErrorInformation::Code::IOError,
+           FileReaderErrorInformation::ReadOperation{context.buffer_offset,
+                                                     size}});
+    }
+
+    RecordReader record(&context.buffer[context.buffer_offset], size,
+                        context.little_endian);
+
+    context.buffer_offset += size;
+    return record;
   }
 
-  return value;
+  // Custom streams may throw: this must not escape a noexcept function
+  std::uint64_t read_offset{};
+  bool succeeded{false};
+
+  try {
+    context.record_buffer.resize(size);
+
+    read_offset = context.stream->offset();
+    succeeded = context.stream->read(context.record_buffer.data(), size);
+
+  } catch (const std::bad_alloc &) {
+    return FileReaderError(FileReaderErrorInformation{
+        FileReaderErrorInformation::Code::MemoryAllocationFailure,
+    });
+
+  } catch (const std::exception &) {
+  }
+
+  if (!succeeded) {
+    return FileReaderError(
+        {FileReaderErrorInformation::Code::IOError,
+         FileReaderErrorInformation::ReadOperation{read_offset, size}});
+  }
+
+  return RecordReader(context.record_buffer.data(), size,
+                      context.little_endian);
+}
+
+IStream::OptionalBuffer FileReader::buffer(const Context &context) {
+  if (context.buffer == nullptr) {
+    return std::nullopt;
+  }
+
+  return IStream::Buffer{context.buffer, context.buffer_size};
 }
 
 } // namespace btfparse
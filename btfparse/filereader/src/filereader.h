@@ -10,6 +10,8 @@
 
 #include <btfparse/ifilereader.h>
 
+#include <vector>
+
 namespace btfparse {
 
 class FileReader final : public IFileReader {
@@ -29,6 +31,15 @@ public:
   virtual std::uint16_t u16() override;
   virtual std::uint32_t u32() override;
   virtual std::uint64_t u64() override;
+  virtual RecordReader readRecord(std::size_t size) override;
+
+  virtual std::optional<FileReaderError>
+  trySeek(std::uint64_t offset) noexcept override;
+
+  virtual Result<RecordReader, FileReaderError>
+  tryReadRecord(std::size_t size) noexcept override;
+
+  virtual IStream::OptionalBuffer buffer() const override;
 
 private:
   struct PrivateData;
@@ -40,8 +51,17 @@ public:
   struct Context final {
     IStream::Ptr stream;
     bool little_endian{true};
+
+    // Memory-resident streams are accessed directly through their
+    // backing buffer, bypassing the IStream interface
+    const std::uint8_t *buffer{nullptr};
+    std::size_t buffer_size{};
+    std::size_t buffer_offset{};
+
+    std::vector<std::uint8_t> record_buffer;
   };
 
+  static void setStream(Context &context, IStream::Ptr stream);
   static void setEndianness(Context &context, bool little_endian);
 
   static void seek(Context &context, std::uint64_t offset);
@@ -52,6 +72,15 @@ public:
   static std::uint16_t u16(Context &context);
   static std::uint32_t u32(Context &context);
   static std::uint64_t u64(Context &context);
+  static RecordReader readRecord(Context &context, std::size_t size);
+
+  static std::optional<FileReaderError> trySeek(Context &context,
+                                                std::uint64_t offset) noexcept;
+
+  static Result<RecordReader, FileReaderError>
+  tryReadRecord(Context &context, std::size_t size) noexcept;
+
+  static IStream::OptionalBuffer buffer(const Context &context);
 
   friend class IFileReader;
 };
@@ -6,19 +6,58 @@
 // the LICENSE file found in the root directory of this source tree.
 //
 
+#include "elfsectionadapter.h"
 #include "filereader.h"
+#include "mappedfileadapter.h"
+#include "memorybufferadapter.h"
 #include "memoryfileadapter.h"
 
 #include <btfparse/ifilereader.h>
 
 namespace btfparse {
 
+namespace {
+
+IStream::Ptr openStream(const std::filesystem::path &path,
+                        const FileReaderOptions &options) {
+  switch (options.access_mode) {
+  case FileReaderOptions::AccessMode::Automatic:
+    try {
+      return MappedFileAdapter::create(path);
+
+    } catch (const FileReaderError &e) {
+      if (e.get().code != FileReaderErrorInformation::Code::IOError) {
+        throw;
+      }
+
+      return MemoryFileAdapter::create(path);
+    }
+
+  case FileReaderOptions::AccessMode::MemoryMapped:
+    return MappedFileAdapter::create(path);
+
+  case FileReaderOptions::AccessMode::Buffered:
+    return MemoryFileAdapter::create(path);
+  }
+
+  throw FileReaderError(
+      FileReaderErrorInformation{FileReaderErrorInformation::Code::Unknown});
+}
+
+} // namespace
+
 Result<IFileReader::Ptr, FileReaderError>
 IFileReader::open(const std::filesystem::path &path) noexcept {
-  MemoryFileAdapter::Ptr memoryfile_ptr;
+  return open(path, FileReaderOptions{});
+}
+
+Result<IFileReader::Ptr, FileReaderError>
+IFileReader::open(const std::filesystem::path &path,
+                  const FileReaderOptions &options) noexcept {
+  IStream::Ptr stream;
 
   try {
-    memoryfile_ptr = MemoryFileAdapter::create(path);
+    stream = openStream(path, options);
 
   } catch (const std::bad_alloc &) {
     return FileReaderError(FileReaderErrorInformation{
@@ -29,7 +68,7 @@ IFileReader::open(const std::filesystem::path &path) noexcept {
     return e;
   }
 
-  return FileReader::create(std::move(memoryfile_ptr));
+  return FileReader::create(std::move(stream));
 }
 
 Result<IFileReader::Ptr, FileReaderError>
@@ -37,4 +76,64 @@ IFileReader::createFromStream(IStream::Ptr stream) noexcept {
   return FileReader::create(std::move(stream));
 }
 
+Result<IFileReader::Ptr, FileReaderError>
+IFileReader::createFromBuffer(const std::uint8_t *data,
+                              std::size_t size) noexcept {
+  IStream::Ptr stream;
+
+  try {
+    stream = MemoryBufferAdapter::create(data, size);
+
+  } catch (const FileReaderError &e) {
+    return e;
+  }
+
+  return FileReader::create(std::move(stream));
+}
+
+Result<IFileReader::Ptr, FileReaderError>
+IFileReader::openELFSection(const std::filesystem::path &path,
+                            std::string_view section_name) noexcept {
+  IStream::Ptr stream;
+
+  try {
+    auto file_stream = openStream(path, FileReaderOptions{});
+    auto elf_image = file_stream->buffer().value();
+
+    stream = ELFSectionAdapter::create(std::move(file_stream), elf_image,
+                                       section_name);
+
+  } catch (const std::bad_alloc &) {
+    return FileReaderError(FileReaderErrorInformation{
+        FileReaderErrorInformation::Code::MemoryAllocationFailure,
+    });
+
+  } catch (const FileReaderError &e) {
+    return e;
+  }
+
+  return FileReader::create(std::move(stream));
+}
+
+Result<IFileReader::Ptr, FileReaderError>
+IFileReader::createFromELFSection(const std::uint8_t *data, std::size_t size,
+                                  std::string_view section_name) noexcept {
+  IStream::Ptr stream;
+
+  try {
+    stream = ELFSectionAdapter::create(nullptr, IStream::Buffer{data, size},
+                                       section_name);
+
+  } catch (const std::bad_alloc &) {
+    return FileReaderError(FileReaderErrorInformation{
+        FileReaderErrorInformation::Code::MemoryAllocationFailure,
+    });
+
+  } catch (const FileReaderError &e) {
+    return e;
+  }
+
+  return FileReader::create(std::move(stream));
+}
+
 } // namespace btfparse
@@ -0,0 +1,104 @@
+//
+// Copyright (c) 2021-present, Trail of Bits, Inc.
+// All rights reserved.
+//
+// This source code is licensed in accordance with the terms specified in
+// the LICENSE file found in the root directory of this source tree.
+//
+
+#include "mappedfileadapter.h"
+
+#include <cstring>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <btfparse/ifilereader.h>
+
+namespace btfparse {
+
+MappedFileAdapter::MappedFileAdapter(const std::uint8_t *buffer,
+                                     std::size_t size)
+    : file_buffer(buffer), file_pos(0), file_buffer_size(size) {}
+
+MappedFileAdapter::~MappedFileAdapter() {
+  munmap(const_cast<std::uint8_t *>(file_buffer), file_buffer_size);
+}
+
+IStream::Ptr MappedFileAdapter::create(const std::filesystem::path &path) {
+  auto fd = open(path.string().c_str(), O_RDONLY);
+  if (fd < 0) {
+    throw FileReaderError(FileReaderErrorInformation{
+        FileReaderErrorInformation::Code::FileNotFound});
+  }
+
+  struct stat stat_data {};
+  auto stat_res = fstat(fd, &stat_data);
+
+  // Files reporting an empty size (i.e. some sysfs nodes) can't be mapped,
+  // and must be read with the buffered adapter instead
+  if (stat_res < 0 || !S_ISREG(stat_data.st_mode) || stat_data.st_size <= 0) {
+    close(fd);
+
+    throw FileReaderError(
+        FileReaderErrorInformation{FileReaderErrorInformation::Code::IOError});
+  }
+
+  auto file_size = static_cast<std::size_t>(stat_data.st_size);
+
+  auto mapping = mmap(nullptr, file_size, PROT_READ, MAP_PRIVATE, fd, 0);
+  close(fd);
+
+  if (mapping == MAP_FAILED) {
+    throw FileReaderError(
+        FileReaderErrorInformation{FileReaderErrorInformation::Code::IOError});
+  }
+
+  madvise(mapping, file_size, MADV_WILLNEED);
+
+  try {
+    return Ptr(new MappedFileAdapter(static_cast<const std::uint8_t *>(mapping),
+                                     file_size));
+
+  } catch (const std::bad_alloc &) {
+    munmap(mapping, file_size);
+
+    throw FileReaderError(FileReaderErrorInformation{
+        FileReaderErrorInformation::Code::MemoryAllocationFailure,
+    });
+  }
+}
+
+bool MappedFileAdapter::seek(std::uint64_t offset) {
+  if (offset >= file_buffer_size) {
+    return false;
+  }
+
+  file_pos = offset;
+
+  return true;
+}
+
+std::uint64_t MappedFileAdapter::offset() const {
+  return static_cast<std::uint64_t>(file_pos);
+}
+
+bool MappedFileAdapter::read(std::uint8_t *buffer, std::size_t size) {
+  if (size > file_buffer_size - file_pos) {
+    return false;
+  }
+
+  std::memcpy(buffer, &file_buffer[file_pos], size);
+
+  file_pos += size;
+
+  return true;
+}
+
+IStream::OptionalBuffer MappedFileAdapter::buffer() const {
+  return Buffer{file_buffer, file_buffer_size};
+}
+
+} // namespace btfparse
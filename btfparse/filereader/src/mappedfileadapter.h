@@ -0,0 +1,37 @@
+//
+// Copyright (c) 2021-present, Trail of Bits, Inc.
+// All rights reserved.
+//
+// This source code is licensed in accordance with the terms specified in
+// the LICENSE file found in the root directory of this source tree.
+//
+
+#pragma once
+
+#include <btfparse/istream.h>
+
+#include <filesystem>
+
+namespace btfparse {
+
+class MappedFileAdapter final : public IStream {
+private:
+  const std::uint8_t *file_buffer;
+  std::size_t file_pos;
+  const std::size_t file_buffer_size;
+
+public:
+  MappedFileAdapter() = delete;
+  static Ptr create(const std::filesystem::path &path);
+  virtual ~MappedFileAdapter() override;
+
+  virtual bool seek(std::uint64_t offset) override;
+  virtual std::uint64_t offset() const override;
+  virtual bool read(std::uint8_t *buffer, std::size_t size) override;
+  virtual OptionalBuffer buffer() const override;
+
+private:
+  MappedFileAdapter(const std::uint8_t *buffer, std::size_t size);
+};
+
+} // namespace btfparse
@@ -0,0 +1,69 @@
+//
+// Copyright (c) 2021-present, Trail of Bits, Inc.
+// All rights reserved.
+//
+// This source code is licensed in accordance with the terms specified in
+// the LICENSE file found in the root directory of this source tree.
+//
+
+#include "memorybufferadapter.h"
+
+#include <cstring>
+
+#include <btfparse/ifilereader.h>
+
+namespace btfparse {
+
+MemoryBufferAdapter::MemoryBufferAdapter(Buffer buffer)
+    : memory_buffer(buffer), buffer_pos(0) {}
+
+MemoryBufferAdapter::~MemoryBufferAdapter() {}
+
+IStream::Ptr MemoryBufferAdapter::create(const std::uint8_t *data,
+                                         std::size_t size) {
+  if (data == nullptr || size == 0) {
+    throw FileReaderError(
+        FileReaderErrorInformation{FileReaderErrorInformation::Code::IOError});
+  }
+
+  try {
+    return Ptr(new MemoryBufferAdapter(Buffer{data, size}));
+
+  } catch (const std::bad_alloc &) {
+    throw FileReaderError(FileReaderErrorInformation{
+        FileReaderErrorInformation::Code::MemoryAllocationFailure,
+    });
+  }
+}
+
+bool MemoryBufferAdapter::seek(std::uint64_t offset) {
+  if (offset >= memory_buffer.size) {
+    return false;
+  }
+
+  buffer_pos = offset;
+
+  return true;
+}
+
+std::uint64_t MemoryBufferAdapter::offset() const {
+  return static_cast<std::uint64_t>(buffer_pos);
+}
+
+bool MemoryBufferAdapter::read(std::uint8_t *buffer, std::size_t size) {
+  if (size > memory_buffer.size - buffer_pos) {
+    return false;
+  }
+
+  std::memcpy(buffer, memory_buffer.data + buffer_pos, size);
+
+  buffer_pos += size;
+
+  return true;
+}
+
+IStream::OptionalBuffer MemoryBufferAdapter::buffer() const {
+  return memory_buffer;
+}
+
+} // namespace btfparse
@@ -0,0 +1,34 @@
+//
+// Copyright (c) 2021-present, Trail of Bits, Inc.
+// All rights reserved.
+//
+// This source code is licensed in accordance with the terms specified in
+// the LICENSE file found in the root directory of this source tree.
+//
+
+#pragma once
+
+#include <btfparse/istream.h>
+
+namespace btfparse {
+
+class MemoryBufferAdapter final : public IStream {
+private:
+  Buffer memory_buffer;
+  std::size_t buffer_pos;
+
+public:
+  MemoryBufferAdapter() = delete;
+  static Ptr create(const std::uint8_t *data, std::size_t size);
+  virtual ~MemoryBufferAdapter() override;
+
+  virtual bool seek(std::uint64_t offset) override;
+  virtual std::uint64_t offset() const override;
+  virtual bool read(std::uint8_t *buffer, std::size_t size) override;
+  virtual OptionalBuffer buffer() const override;
+
+private:
+  MemoryBufferAdapter(Buffer buffer);
+};
+
+} // namespace btfparse
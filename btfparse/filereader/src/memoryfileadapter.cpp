@@ -8,78 +8,97 @@
 
 #include "memoryfileadapter.h"
 
+#include <algorithm>
 #include <cstring>
 
 #include <fcntl.h>
-#include <sys/mman.h>
 #include <sys/stat.h>
 #include <unistd.h>
 
 #include <btfparse/ifilereader.h>
 
 namespace btfparse {
-MemoryFileAdapter::MemoryFileAdapter(std::unique_ptr<char[]> buffer,
-                                     std::size_t size)
-    : file_buffer(std::move(buffer)), file_pos(0), file_buffer_size(size) {}
 
-MemoryFileAdapter::~MemoryFileAdapter() {}
+namespace {
 
-IStream::Ptr MemoryFileAdapter::create(const std::filesystem::path &path) {
-  try {
-    auto fd = open(path.string().c_str(), O_RDONLY);
+const std::size_t kMinimumReadSize{4096U};
 
-    if (fd < 0) {
-      throw FileReaderError(FileReaderErrorInformation{
-          FileReaderErrorInformation::Code::FileNotFound});
+std::vector<std::uint8_t> readFile(int fd) {
+  struct stat stat_data {};
+  if (fstat(fd, &stat_data) < 0) {
+    throw FileReaderError(
+        FileReaderErrorInformation{FileReaderErrorInformation::Code::IOError});
+  }
+
+  // The reported size is only used as a hint, since some sysfs nodes
+  // do not report the real size of their contents. Reserve one more
+  // byte so that regular files reach EOF without growing the buffer
+  auto size_hint = stat_data.st_size > 0
+                       ? static_cast<std::size_t>(stat_data.st_size)
+                       : std::size_t{0};
+
+  std::vector<std::uint8_t> file_buffer(
+      std::max(size_hint + 1, kMinimumReadSize));
+
+  std::size_t pos = 0;
+
+  for (;;) {
+    if (pos == file_buffer.size()) {
+      file_buffer.resize(file_buffer.size() * 2);
     }
 
-    struct stat stat_data {};
-    auto stat_res = fstat(fd, &stat_data);
+    auto read_res = ::read(fd, &file_buffer[pos], file_buffer.size() - pos);
+    if (read_res == 0) {
+      break;
 
-    if (stat_res < 0) {
+    } else if (read_res < 0) {
       throw FileReaderError(FileReaderErrorInformation{
           FileReaderErrorInformation::Code::IOError});
     }
 
-    auto file_size = static_cast<std::size_t>(stat_data.st_size);
+    pos += static_cast<std::size_t>(read_res);
+  }
 
-    if (file_size >= 1024 * 1024 * 10) {
-      throw FileReaderError(FileReaderErrorInformation{
-          FileReaderErrorInformation::Code::MemoryAllocationFailure,
-      });
-    }
+  file_buffer.resize(pos);
 
-    auto file_buffer = std::unique_ptr<char[]>(new char[file_size]);
+  return file_buffer;
+}
 
-    ssize_t read_res = 0;
-    std::size_t pos = 0;
+} // namespace
 
-    do {
-      auto read_size = std::min(file_size - pos, 4096UL);
+MemoryFileAdapter::MemoryFileAdapter(std::vector<std::uint8_t> buffer)
+    : file_buffer(std::move(buffer)), file_pos(0) {}
 
-      read_res = ::read(fd, &file_buffer[pos], read_size);
+MemoryFileAdapter::~MemoryFileAdapter() {}
 
-      if (read_res > 0) {
-        pos += static_cast<std::size_t>(read_res);
-      }
-    } while (read_res > 0 && pos < file_size);
+IStream::Ptr MemoryFileAdapter::create(const std::filesystem::path &path) {
+  auto fd = open(path.string().c_str(), O_RDONLY);
+  if (fd < 0) {
+    throw FileReaderError(FileReaderErrorInformation{
+        FileReaderErrorInformation::Code::FileNotFound});
+  }
 
-    if (read_res < 0 || (pos + 1) < file_size) {
-      throw FileReaderError(FileReaderErrorInformation{
-          FileReaderErrorInformation::Code::IOError});
-    }
+  try {
+    auto file_buffer = readFile(fd);
+    close(fd);
 
-    return Ptr(new MemoryFileAdapter(std::move(file_buffer), file_size));
+    return Ptr(new MemoryFileAdapter(std::move(file_buffer)));
 
   } catch (const std::bad_alloc &) {
+    close(fd);
+
     throw FileReaderError(FileReaderErrorInformation{
         FileReaderErrorInformation::Code::MemoryAllocationFailure,
     });
+
+  } catch (const FileReaderError &) {
+    close(fd);
+    throw;
   }
 }
 
 bool MemoryFileAdapter::seek(std::uint64_t offset) {
-  if (offset >= file_buffer_size) {
+  if (offset >= file_buffer.size()) {
     return false;
   }
 
@@ -93,7 +112,7 @@ std::uint64_t MemoryFileAdapter::offset() const {
 }
 
 bool MemoryFileAdapter::read(std::uint8_t *buffer, std::size_t size) {
-  if ((file_pos + size) > file_buffer_size) {
+  if (size > file_buffer.size() - file_pos) {
     return false;
   }
 
@@ -104,4 +123,8 @@ bool MemoryFileAdapter::read(std::uint8_t *buffer, std::size_t size) {
   return true;
 }
 
+IStream::OptionalBuffer MemoryFileAdapter::buffer() const {
+  return Buffer{file_buffer.data(), file_buffer.size()};
+}
+
 } // namespace btfparse
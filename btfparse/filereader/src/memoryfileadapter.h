@@ -17,9 +17,8 @@ namespace btfparse {
 
 class MemoryFileAdapter final : public IStream {
 private:
-  std::unique_ptr<char[]> file_buffer;
+  std::vector<std::uint8_t> file_buffer;
   std::size_t file_pos;
-  const std::size_t file_buffer_size;
 
 public:
   MemoryFileAdapter() = delete;
@@ -29,9 +28,10 @@ public:
   virtual bool seek(std::uint64_t offset) override;
   virtual std::uint64_t offset() const override;
   virtual bool read(std::uint8_t *buffer, std::size_t size) override;
+  virtual OptionalBuffer buffer() const override;
 
 private:
-  MemoryFileAdapter(std::unique_ptr<char[]> buffer, std::size_t size);
+  MemoryFileAdapter(std::vector<std::uint8_t> buffer);
 };
 
 } // namespace btfparse
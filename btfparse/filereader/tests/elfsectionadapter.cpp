@@ -0,0 +1,165 @@
+//
+// Copyright (c) 2021-present, Trail of Bits, Inc.
+// All rights reserved.
+//
+// This source code is licensed in accordance with the terms specified in
+// the LICENSE file found in the root directory of this source tree.
+//
+
+#include "elfsectionadapter.h"
+
+#include <doctest/doctest.h>
+
+#include <btfparse/ifilereader.h>
+
+#include <string>
+#include <vector>
+
+namespace btfparse {
+
+namespace {
+
+const std::string kTestSectionContents{"\x9F\xEB\x01\x00", 4};
+
+void writeInteger(std::vector<std::uint8_t> &image, std::size_t offset,
+                  std::uint64_t value, std::size_t size, bool little_endian) {
+  if (image.size() < offset + size) {
+    image.resize(offset + size);
+  }
+
+  for (std::size_t i = 0; i < size; ++i) {
+    auto shift = (little_endian ? i : size - i - 1) * 8U;
+    image[offset + i] = static_cast<std::uint8_t>(value >> shift);
+  }
+}
+
+// Creates an ELF image with three sections: the null section, `.test`
+// and the section name string table
+std::vector<std::uint8_t> createELFImage(bool is_64bit, bool little_endian) {
+  const std::string kStringTable{"\0.test\0.shstrtab\0", 17};
+
+  std::size_t header_size = is_64bit ? 0x40 : 0x34;
+  std::size_t section_header_size = is_64bit ? 0x40 : 0x28;
+
+  auto test_section_offset = header_size;
+  auto string_table_offset = test_section_offset + kTestSectionContents.size();
+  auto section_header_table_offset = string_table_offset + kStringTable.size();
+
+  std::vector<std::uint8_t> image(header_size);
+  image[0] = 0x7F;
+  image[1] = 'E';
+  image[2] = 'L';
+  image[3] = 'F';
+  image[4] = is_64bit ? 2 : 1;
+  image[5] = little_endian ? 1 : 2;
+  image[6] = 1;
+
+  image.insert(image.end(), kTestSectionContents.begin(),
+               kTestSectionContents.end());
+
+  image.insert(image.end(), kStringTable.begin(), kStringTable.end());
+
+  auto write = [&](std::size_t offset, std::uint64_t value, std::size_t size) {
+    writeInteger(image, offset, value, size, little_endian);
+  };
+
+  // e_shoff, e_shentsize, e_shnum, e_shstrndx
+  auto word_size = is_64bit ? 8U : 4U;
+  write(is_64bit ? 0x28 : 0x20, section_header_table_offset, word_size);
+  write(is_64bit ? 0x3A : 0x2E, section_header_size, 2);
+  write(is_64bit ? 0x3C : 0x30, 3, 2);
+  write(is_64bit ? 0x3E : 0x32, 2, 2);
+
+  struct SectionHeader final {
+    std::uint32_t name{};
+    std::uint32_t type{};
+    std::uint64_t offset{};
+    std::uint64_t size{};
+  };
+
+  std::vector<SectionHeader> section_header_list{
+      {},
+      {1, 1, test_section_offset, kTestSectionContents.size()},
+      {7, 3, string_table_offset, kStringTable.size()},
+  };
+
+  for (std::size_t i = 0; i < section_header_list.size(); ++i) {
+    const auto &section_header = section_header_list[i];
+    auto offset = section_header_table_offset + i * section_header_size;
+
+    image.resize(offset + section_header_size);
+    write(offset, section_header.name, 4);
+    write(offset + 4, section_header.type, 4);
+    write(offset + (is_64bit ? 0x18 : 0x10), section_header.offset, word_size);
+    write(offset + (is_64bit ? 0x20 : 0x14), section_header.size, word_size);
+  }
+
+  return image;
+}
+
+FileReaderErrorInformation::Code
+getLocateSectionError(const std::vector<std::uint8_t> &image,
+                      std::string_view section_name) {
+  try {
+    ELFSectionAdapter::locateSection({image.data(), image.size()},
+                                     section_name);
+
+  } catch (const FileReaderError &e) {
+    return e.get().code;
+  }
+
+  return FileReaderErrorInformation::Code::Unknown;
+}
+
+} // namespace
+
+TEST_CASE("ELFSectionAdapter::locateSection()") {
+  for (auto is_64bit : {true, false}) {
+    for (auto little_endian : {true, false}) {
+      auto image = createELFImage(is_64bit, little_endian);
+
+      auto section =
+          ELFSectionAdapter::locateSection({image.data(), image.size()},
+                                           ".test");
+
+      CHECK(section.data == image.data() + (is_64bit ? 0x40 : 0x34));
+      CHECK(std::string(reinterpret_cast<const char *>(section.data),
+                        section.size) == kTestSectionContents);
+
+      CHECK(getLocateSectionError(image, ".BTF") ==
+            FileReaderErrorInformation::Code::ELFSectionNotFound);
+    }
+  }
+
+  auto image = createELFImage(true, true);
+  image[1] = 'X';
+  CHECK(getLocateSectionError(image, ".test") ==
+        FileReaderErrorInformation::Code::InvalidELFFile);
+
+  image = createELFImage(true, true);
+  image.resize(image.size() - 1);
+  CHECK(getLocateSectionError(image, ".test") ==
+        FileReaderErrorInformation::Code::InvalidELFFile);
+}
+
+TEST_CASE("IFileReader::createFromELFSection()") {
+  auto image = createELFImage(true, true);
+
+  auto file_reader_res =
+      IFileReader::createFromELFSection(image.data(), image.size(), ".test");
+
+  REQUIRE(!file_reader_res.failed());
+
+  auto file_reader = file_reader_res.takeValue();
+  CHECK(file_reader->u16() == 0xEB9F);
+  CHECK(file_reader->buffer().value().size == kTestSectionContents.size());
+
+  file_reader_res =
+      IFileReader::createFromELFSection(image.data(), image.size(), ".BTF");
+
+  REQUIRE(file_reader_res.failed());
+  CHECK(file_reader_res.error().get().code ==
+        FileReaderErrorInformation::Code::ELFSectionNotFound);
+}
+
+} // namespace btfparse
@@ -51,6 +51,22 @@ public:
   std::uint64_t current_offset{};
 };
 
+class MockedBufferStream final : public IStream {
+public:
+  MockedBufferStream() = default;
+  virtual ~MockedBufferStream() override = default;
+
+  virtual bool seek(std::uint64_t) override { return false; }
+  virtual std::uint64_t offset() const override { return 0; }
+  virtual bool read(std::uint8_t *, std::size_t) override { return false; }
+
+  virtual OptionalBuffer buffer() const override {
+    return Buffer{data.data(), data.size()};
+  }
+
+  std::array<std::uint8_t, 8> data{0xFF, 0, 0, 0, 0, 0, 0, 0xFF};
+};
+
 TEST_CASE("FileReader::setEndianness()") {
   FileReader::Context context;
   context.little_endian = true;
@@ -175,4 +191,143 @@ TEST_CASE("FileReader::u64()") {
   CHECK(value == 0xFF00000000000000ULL);
 }
 
+TEST_CASE("FileReader::readRecord()") {
+  FileReader::Context context;
+  context.stream = std::make_unique<MockedStream>();
+
+  auto record = FileReader::readRecord(context, 6);
+  CHECK(FileReader::offset(context) == 6);
+  CHECK(record.remaining() == 6);
+  CHECK(record.u16() == 0xFF);
+  CHECK(record.u32() == 0);
+  CHECK(record.remaining() == 0);
+
+  FileReader::setEndianness(context, false);
+  record = FileReader::readRecord(context, 4);
+  CHECK(record.u32() == 0xFF000000);
+}
+
+TEST_CASE("FileReader::trySeek(), FileReader::tryReadRecord()") {
+  FileReader::Context context;
+  context.stream = std::make_unique<MockedStream>();
+
+  auto &mocked_stream = *static_cast<MockedStream *>(context.stream.get());
+
+  CHECK(!FileReader::trySeek(context, 10).has_value());
+  CHECK(FileReader::offset(context) == 10);
+
+  auto record_res = FileReader::tryReadRecord(context, 4);
+  REQUIRE(!record_res.failed());
+
+  auto record = record_res.takeValue();
+  CHECK(record.u32() == 0xFF);
+  CHECK(FileReader::offset(context) == 14);
+
+  mocked_stream.fail_seeks = true;
+  auto opt_error = FileReader::trySeek(context, 20);
+  REQUIRE(opt_error.has_value());
+  CHECK(opt_error.value().get().code ==
+        FileReaderErrorInformation::Code::IOError);
+
+  mocked_stream.fail_reads = true;
+  record_res = FileReader::tryReadRecord(context, 4);
+  REQUIRE(record_res.failed());
+
+  const auto &error_information = record_res.error().get();
+  CHECK(error_information.code == FileReaderErrorInformation::Code::IOError);
+
+  REQUIRE(error_information.opt_read_operation.has_value());
+  CHECK(error_information.opt_read_operation.value().offset == 14);
+  CHECK(error_information.opt_read_operation.value().size == 4);
+
+  FileReader::setStream(context, std::make_unique<MockedBufferStream>());
+
+  CHECK(!FileReader::trySeek(context, 6).has_value());
+  CHECK(FileReader::trySeek(context, 8).has_value());
+
+  record_res = FileReader::tryReadRecord(context, 4);
+  REQUIRE(record_res.failed());
+  CHECK(record_res.error().get().code ==
+        FileReaderErrorInformation::Code::IOError);
+
+  record_res = FileReader::tryReadRecord(context, 2);
+  REQUIRE(!record_res.failed());
+  CHECK(record_res.takeValue().u16() == 0xFF00);
+}
+
+TEST_CASE("RecordReader::u32Array()") {
+  const std::uint8_t kBuffer[]{0x01, 0x02, 0x03, 0x04, 0x05, 0x06,
+                               0x07, 0x08, 0x09, 0x0A, 0x0B, 0x0C};
+
+  std::uint32_t field_list[3]{};
+
+  RecordReader little_endian_record(kBuffer, sizeof(kBuffer), true);
+  little_endian_record.u32Array(field_list, 2);
+  CHECK(field_list[0] == 0x04030201U);
+  CHECK(field_list[1] == 0x08070605U);
+  CHECK(little_endian_record.remaining() == 4);
+  CHECK(little_endian_record.u32() == 0x0C0B0A09U);
+
+  RecordReader big_endian_record(kBuffer, sizeof(kBuffer), false);
+  big_endian_record.u32Array(field_list, 3);
+  CHECK(field_list[0] == 0x01020304U);
+  CHECK(field_list[1] == 0x05060708U);
+  CHECK(field_list[2] == 0x090A0B0CU);
+  CHECK(big_endian_record.remaining() == 0);
+}
+
+TEST_CASE("FileReader memory-resident streams") {
+  FileReader::Context context;
+  FileReader::setStream(context, std::make_unique<MockedBufferStream>());
+
+  REQUIRE(context.buffer != nullptr);
+  CHECK(context.buffer_size == 8);
+
+  // The stream itself always fails; all the reads must go
+  // through the backing buffer
+  CHECK(FileReader::u32(context) == 0xFF);
+  CHECK(FileReader::offset(context) == 4);
+
+  FileReader::setEndianness(context, false);
+  CHECK(FileReader::u32(context) == 0xFF);
+  CHECK(FileReader::offset(context) == 8);
+
+  FileReader::seek(context, 7);
+  CHECK(FileReader::u8(context) == 0xFF);
+
+  FileReader::seek(context, 0);
+  auto record = FileReader::readRecord(context, 8);
+  CHECK(record.u64() == 0xFF000000000000FFULL);
+
+  FileReader::seek(context, 6);
+  std::optional<FileReaderError> opt_file_reader_error;
+
+  try {
+    FileReader::readRecord(context, 4);
+  } catch (FileReaderError error) {
+    opt_file_reader_error = std::move(error);
+  }
+
+  REQUIRE(opt_file_reader_error.has_value());
+
+  const auto &error_information = opt_file_reader_error.value().get();
+  CHECK(error_information.code == FileReaderErrorInformation::Code::IOError);
+
+  REQUIRE(error_information.opt_read_operation.has_value());
+  const auto &read_operation = error_information.opt_read_operation.value();
+
+  CHECK(read_operation.offset == 6);
+  CHECK(read_operation.size == 4);
+
+  opt_file_reader_error = std::nullopt;
+
+  try {
+    FileReader::seek(context, 8);
+  } catch (FileReaderError error) {
+    opt_file_reader_error = std::move(error);
+  }
+
+  CHECK(opt_file_reader_error.has_value());
+}
+
 } // namespace btfparse
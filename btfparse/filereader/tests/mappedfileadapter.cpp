@@ -0,0 +1,129 @@
+//
+// Copyright (c) 2021-present, Trail of Bits, Inc.
+// All rights reserved.
+//
+// This source code is licensed in accordance with the terms specified in
+// the LICENSE file found in the root directory of this source tree.
+//
+
+#include "mappedfileadapter.h"
+#include "memorybufferadapter.h"
+#include "memoryfileadapter.h"
+
+#include <doctest/doctest.h>
+
+#include <btfparse/ifilereader.h>
+
+#include <array>
+#include <cstring>
+#include <fstream>
+
+#include <unistd.h>
+
+namespace btfparse {
+
+namespace {
+
+const std::array<std::uint8_t, 8> kTestFileContents{0x9F, 0xEB, 0x01, 0x00,
+                                                    0x18, 0x00, 0x00, 0x00};
+
+std::filesystem::path createTestFile() {
+  auto path = std::filesystem::temp_directory_path() /
+              ("btfparse-filereader-tests-" + std::to_string(getpid()));
+
+  std::ofstream test_file(path, std::ios::binary | std::ios::trunc);
+  test_file.write(reinterpret_cast<const char *>(kTestFileContents.data()),
+                  static_cast<std::streamsize>(kTestFileContents.size()));
+
+  return path;
+}
+
+void testStream(IStream &stream) {
+  auto opt_buffer = stream.buffer();
+  REQUIRE(opt_buffer.has_value());
+
+  const auto &buffer = opt_buffer.value();
+  REQUIRE(buffer.size == kTestFileContents.size());
+  CHECK(std::memcmp(buffer.data, kTestFileContents.data(), buffer.size) == 0);
+
+  std::array<std::uint8_t, 4> read_buffer;
+  CHECK(stream.read(read_buffer.data(), read_buffer.size()));
+  CHECK(read_buffer[0] == 0x9F);
+  CHECK(stream.offset() == 4);
+
+  CHECK(stream.seek(6));
+  CHECK(!stream.read(read_buffer.data(), read_buffer.size()));
+  CHECK(stream.offset() == 6);
+
+  CHECK(!stream.seek(kTestFileContents.size()));
+}
+
+} // namespace
+
+TEST_CASE("MappedFileAdapter") {
+  auto path = createTestFile();
+
+  auto stream = MappedFileAdapter::create(path);
+  testStream(*stream.get());
+
+  std::filesystem::remove(path);
+}
+
+TEST_CASE("MemoryFileAdapter") {
+  auto path = createTestFile();
+
+  auto stream = MemoryFileAdapter::create(path);
+  testStream(*stream.get());
+
+  std::filesystem::remove(path);
+}
+
+TEST_CASE("MemoryBufferAdapter") {
+  auto stream = MemoryBufferAdapter::create(kTestFileContents.data(),
+                                            kTestFileContents.size());
+  testStream(*stream.get());
+
+  CHECK(stream->buffer().value().data == kTestFileContents.data());
+}
+
+TEST_CASE("IFileReader::createFromBuffer()") {
+  auto file_reader_res = IFileReader::createFromBuffer(
+      kTestFileContents.data(), kTestFileContents.size());
+
+  REQUIRE(!file_reader_res.failed());
+
+  auto file_reader = file_reader_res.takeValue();
+  CHECK(file_reader->u16() == 0xEB9F);
+  CHECK(file_reader->buffer().value().data == kTestFileContents.data());
+
+  CHECK(IFileReader::createFromBuffer(nullptr, 0).failed());
+}
+
+TEST_CASE("IFileReader::open()") {
+  auto path = createTestFile();
+
+  for (auto access_mode : {FileReaderOptions::AccessMode::Automatic,
+                           FileReaderOptions::AccessMode::MemoryMapped,
+                           FileReaderOptions::AccessMode::Buffered}) {
+
+    FileReaderOptions options;
+    options.access_mode = access_mode;
+
+    auto file_reader_res = IFileReader::open(path, options);
+    REQUIRE(!file_reader_res.failed());
+
+    auto file_reader = file_reader_res.takeValue();
+    CHECK(file_reader->u16() == 0xEB9F);
+  }
+
+  std::filesystem::remove(path);
+
+  auto file_reader_res = IFileReader::open(path);
+  REQUIRE(file_reader_res.failed());
+
+  const auto &error_information = file_reader_res.error().get();
+  CHECK(error_information.code ==
+        FileReaderErrorInformation::Code::FileNotFound);
+}
+
+} // namespace btfparse
@@ -8,6 +8,7 @@
 
 #pragma once
 
+#include <optional>
 #include <string>
 
 namespace btfparse {
@@ -21,22 +22,31 @@ template <typename Enum> struct DefaultErrorCodePrinter final {
   }
 };
 
+// The error message is only formatted the first time it is requested:
+// callers that just inspect the error information (i.e. when validating
+// many inputs that are expected to fail) do not pay for it. The message
+// is cached inside the object, so toString must not be called on the
+// same Error object from multiple threads at the same time
 template <typename ErrorType,
           typename ErrorPrinter = DefaultErrorCodePrinter<ErrorType>>
 class Error final {
-  std::string string_error;
   ErrorType data;
+  mutable std::optional<std::string> opt_string_error;
 
 public:
-  Error(const ErrorType &error)
-      : string_error(getStringError(error)), data(error) {}
-
-  Error(ErrorType &&error) noexcept
-      : string_error(getStringError(error)), data(std::move(error)) {}
+  Error(const ErrorType &error) : data(error) {}
+  Error(ErrorType &&error) noexcept : data(std::move(error)) {}
 
   const ErrorType &get() const { return data; }
 
-  const std::string &toString() const { return string_error; }
+  const std::string &toString() const {
+    if (!opt_string_error.has_value()) {
+      opt_string_error = getStringError(data);
+    }
+
+    return opt_string_error.value();
+  }
+
   operator const char *() const { return toString().c_str(); }
 
 private:
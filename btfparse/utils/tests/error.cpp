@@ -0,0 +1,56 @@
+//
+// Copyright (c) 2021-present, Trail of Bits, Inc.
+// All rights reserved.
+//
+// This source code is licensed in accordance with the terms specified in
+// the LICENSE file found in the root directory of this source tree.
+//
+
+#include <doctest/doctest.h>
+
+#include <btfparse/error.h>
+
+namespace btfparse {
+
+namespace {
+
+std::size_t printer_call_count{0};
+
+struct CountingErrorPrinter final {
+  std::string operator()(const int &error_code) const {
+    ++printer_call_count;
+    return "Error " + std::to_string(error_code);
+  }
+};
+
+using CountingError = Error<int, CountingErrorPrinter>;
+
+} // namespace
+
+TEST_CASE("Error::toString()") {
+  printer_call_count = 0;
+
+  CountingError error(1);
+  CHECK(error.get() == 1);
+  CHECK(printer_call_count == 0);
+
+  CHECK(error.toString() == "Error 1");
+  CHECK(printer_call_count == 1);
+
+  CHECK(error.toString() == "Error 1");
+  CHECK(std::string(static_cast<const char *>(error)) == "Error 1");
+  CHECK(printer_call_count == 1);
+
+  auto error_copy = error;
+  CHECK(error_copy.toString() == "Error 1");
+  CHECK(printer_call_count == 1);
+
+  CountingError other_error(2);
+  auto other_error_copy = other_error;
+  CHECK(printer_call_count == 1);
+
+  CHECK(other_error_copy.toString() == "Error 2");
+  CHECK(printer_call_count == 2);
+}
+
+} // namespace btfparse
@@ -0,0 +1,150 @@
+//
+// Copyright (c) 2021-present, Trail of Bits, Inc.
+// All rights reserved.
+//
+// This source code is licensed in accordance with the terms specified in
+// the LICENSE file found in the root directory of this source tree.
+//
+
+#include "batch.h"
+
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <iostream>
+#include <set>
+#include <sstream>
+
+bool loadBatchManifest(BatchManifest &manifest,
+                       const std::filesystem::path &path) {
+  manifest.clear();
+
+  std::ifstream manifest_file(path);
+  if (!manifest_file) {
+    std::cerr << "Failed to open the batch manifest: " << path.string()
+              << "\n";
+    return false;
+  }
+
+  std::set<std::filesystem::path> output_path_set;
+
+  std::string line;
+  for (std::size_t line_number = 1; std::getline(manifest_file, line);
+       ++line_number) {
+
+    std::istringstream line_stream(line);
+
+    std::string first_word;
+    if (!(line_stream >> first_word) || first_word.front() == '#') {
+      continue;
+    }
+
+    BatchItem item;
+    item.output_path = first_word;
+
+    std::string word;
+    while (line_stream >> word) {
+      item.path_list.emplace_back(word);
+    }
+
+    if (item.path_list.empty()) {
+      std::cerr << path.string() << ":" << line_number
+                << ": Expected an output path followed by at least one "
+                   "BTF file\n";
+      return false;
+    }
+
+    // Two items writing to the same file would race with each other
+    if (!output_path_set.insert(item.output_path.lexically_normal())
+             .second) {
+      std::cerr << path.string() << ":" << line_number
+                << ": Duplicated output path: " << item.output_path.string()
+                << "\n";
+      return false;
+    }
+
+    manifest.push_back(std::move(item));
+  }
+
+  if (manifest_file.bad()) {
+    std::cerr << "Failed to read the batch manifest: " << path.string()
+              << "\n";
+    return false;
+  }
+
+  return true;
+}
+
+int runBatch(const BatchManifest &manifest, std::size_t thread_count,
+             const BatchItemProcessor &processor) {
+  auto worker_pool = btfparse::IBTFWorkerPool::create(thread_count);
+  if (worker_pool == nullptr) {
+    std::cerr << "Failed to create the worker pool\n";
+    return 1;
+  }
+
+  auto start_time = std::chrono::steady_clock::now();
+
+  // Each item only writes its own error, so they need no locking
+  std::vector<std::optional<std::string>> opt_error_list(manifest.size());
+
+  btfparse::BTFOptions::TaskList task_list;
+  for (std::size_t i = 0; i < manifest.size(); ++i) {
+    task_list.push_back([&, i]() {
+      const auto &item = manifest[i];
+      auto &opt_error = opt_error_list[i];
+
+      try {
+        opt_error = processor(item, *worker_pool);
+
+      } catch (const std::exception &exception) {
+        opt_error = exception.what();
+      }
+
+      if (opt_error.has_value()) {
+        std::error_code error_code;
+        std::filesystem::remove(item.output_path, error_code);
+      }
+    });
+  }
+
+  worker_pool->run(task_list);
+
+  auto elapsed_time = std::chrono::duration<double>(
+      std::chrono::steady_clock::now() - start_time);
+
+  std::size_t failed_item_count{};
+  for (std::size_t i = 0; i < manifest.size(); ++i) {
+    const auto &opt_error = opt_error_list[i];
+    if (!opt_error.has_value()) {
+      continue;
+    }
+
+    std::cerr << manifest[i].output_path.string() << ": "
+              << opt_error.value() << "\n";
+
+    ++failed_item_count;
+  }
+
+  auto thread_count_suffix =
+      worker_pool->threadCount() == 1 ? " thread" : " threads";
+
+  std::cerr << "Processed " << manifest.size() << " items in "
+            << elapsed_time.count() << " s on " << worker_pool->threadCount()
+            << thread_count_suffix << ": "
+            << (manifest.size() - failed_item_count) << " succeeded, "
+            << failed_item_count << " failed\n";
+
+  return failed_item_count == 0 ? 0 : 1;
+}
+
+btfparse::BTFOptions getBatchOptions(btfparse::IBTFWorkerPool &worker_pool) {
+  btfparse::BTFOptions options;
+  options.thread_count = std::max<std::size_t>(worker_pool.threadCount(), 1);
+  options.executor =
+      [&worker_pool](const btfparse::BTFOptions::TaskList &task_list) {
+        worker_pool.run(task_list);
+      };
+
+  return options;
+}
@@ -0,0 +1,50 @@
+//
+// Copyright (c) 2021-present, Trail of Bits, Inc.
+// All rights reserved.
+//
+// This source code is licensed in accordance with the terms specified in
+// the LICENSE file found in the root directory of this source tree.
+//
+
+#pragma once
+
+#include <btfparse/ibtfworkerpool.h>
+
+#include <filesystem>
+#include <functional>
+#include <optional>
+#include <string>
+#include <vector>
+
+// A single output of a batch: the base BTF file comes first in the path
+// list, followed by the split (module) files
+struct BatchItem final {
+  std::filesystem::path output_path;
+  std::vector<std::filesystem::path> path_list;
+};
+
+using BatchManifest = std::vector<BatchItem>;
+
+// One item per line, made of whitespace separated paths:
+//
+//   <output> <base BTF file> [<module BTF file> ...]
+//
+// Empty lines and lines starting with '#' are skipped
+bool loadBatchManifest(BatchManifest &manifest,
+                       const std::filesystem::path &path);
+
+// Writes the output of the given item, returning an error message if it
+// fails. The worker pool can be used to run the tasks of the item, such
+// as its parallel decoding
+using BatchItemProcessor = std::function<std::optional<std::string>(
+    const BatchItem &item, btfparse::IBTFWorkerPool &worker_pool)>;
+
+// Processes all the items on a pool of the given size (0 uses one worker
+// per core). Errors are printed for each item in manifest order, and the
+// partial output of a failed item is removed. Returns the exit code of
+// the tool
+int runBatch(const BatchManifest &manifest, std::size_t thread_count,
+             const BatchItemProcessor &processor);
+
+// Options that let an item share the worker pool it runs on
+btfparse::BTFOptions getBatchOptions(btfparse::IBTFWorkerPool &worker_pool);
@@ -6,16 +6,233 @@
 // the LICENSE file found in the root directory of this source tree.
 //
 
+#include "batch.h"
 #include "utils.h"
 
+#include <btfparse/ibtftypehasher.h>
+
+#include <chrono>
+#include <cstdlib>
 #include <cstring>
+#include <fstream>
+#include <optional>
 
 namespace {
 
 void showHelp() {
-  std::cerr << "Usage:\n"
-            << "\tdump-btf /sys/kernel/btf/vmlinux\n"
-            << "\tdump-btf /sys/kernel/btf/vmlinux [/sys/kernel/btf/btusb]\n";
+  std::cerr
+      << "Usage:\n"
+      << "\tdump-btf /sys/kernel/btf/vmlinux\n"
+      << "\tdump-btf /sys/kernel/btf/vmlinux [/sys/kernel/btf/btusb]\n"
+      << "\tdump-btf --save-snapshot vmlinux.snapshot /sys/kernel/btf/vmlinux\n"
+      << "\tdump-btf --snapshot vmlinux.snapshot\n"
+      << "\tdump-btf --stream /sys/kernel/btf/vmlinux\n"
+      << "\tdump-btf --stats /sys/kernel/btf/vmlinux\n"
+      << "\tdump-btf --batch manifest.txt [--threads <count>]\n"
+      << "\tdump-btf --diff old/vmlinux new/vmlinux\n\n"
+      << "Options:\n"
+      << "\t--save-snapshot <path>  Save the parsed types to a snapshot "
+         "instead\n"
+      << "\t                        of printing them\n"
+      << "\t--snapshot <path>       Print the types of a snapshot\n"
+      << "\t--stream                Print each type as soon as it is decoded,\n"
+      << "\t                        without keeping the types in memory\n"
+      << "\t--stats                 Print the parse statistics to stderr "
+         "(needs\n"
+      << "\t                        btfparse to be built with telemetry)\n"
+      << "\t--threads <count>       Decode the types with the given number "
+         "of\n"
+      << "\t                        threads, or 0 to use one per core\n"
+      << "\t--batch <path>          Dump the BTF files listed in a manifest, "
+         "one\n"
+      << "\t                        '<output> <base> [<module> ...]' line "
+         "per\n"
+      << "\t                        dump. --threads sets the size of the "
+         "shared\n"
+      << "\t                        worker pool, and defaults to one thread "
+         "per\n"
+      << "\t                        core\n"
+      << "\t--diff                  Print the structs, unions and enums "
+         "that\n"
+      << "\t                        differ between two BTF files\n";
+}
+
+btfparse::Result<btfparse::IBTF::Ptr, btfparse::BTFError>
+openBTF(const std::optional<std::filesystem::path> &opt_snapshot_path,
+        const std::vector<std::filesystem::path> &path_list,
+        const btfparse::BTFOptions &options) {
+  if (opt_snapshot_path.has_value()) {
+    return btfparse::IBTF::createFromSnapshot(opt_snapshot_path.value());
+  }
+
+  return btfparse::IBTF::createFromPathList(path_list, options);
+}
+
+double toMilliseconds(std::chrono::nanoseconds duration) {
+  return std::chrono::duration<double, std::milli>(duration).count();
+}
+
+void printPhase(std::string_view phase, std::chrono::nanoseconds duration) {
+  std::cerr << "[trace] " << phase << ": " << toMilliseconds(duration)
+            << " ms\n";
+}
+
+void printParseStats(const btfparse::BTFParseStats &stats) {
+  std::cerr << "Bytes read: " << stats.bytes_read << "\n"
+            << "Stream reads: " << stats.stream_read_count << "\n"
+            << "Stream seeks: " << stats.stream_seek_count << "\n"
+            << "String lookups: " << stats.string_lookup_count << "\n"
+            << "Parse time: " << toMilliseconds(stats.parse_time) << " ms\n";
+
+  for (std::size_t i = 0; i < stats.kind_stats_list.size(); ++i) {
+    const auto &kind_stats = stats.kind_stats_list[i];
+    if (kind_stats.type_count == 0) {
+      continue;
+    }
+
+    std::cerr << static_cast<btfparse::BTFKind>(i) << ": "
+              << kind_stats.type_count << " types, "
+              << toMilliseconds(kind_stats.decode_time) << " ms\n";
+  }
+}
+
+std::optional<std::string>
+dumpBatchItem(const BatchItem &item, btfparse::IBTFWorkerPool &worker_pool) {
+  auto btf_res = btfparse::IBTF::createFromPathList(
+      item.path_list, getBatchOptions(worker_pool));
+
+  if (btf_res.failed()) {
+    return "Failed to open the BTF file: " + btf_res.takeError().toString();
+  }
+
+  auto btf = btf_res.takeValue();
+  if (btf->count() == 0) {
+    return "No types were found!";
+  }
+
+  std::ofstream output_file(item.output_path);
+  if (!output_file) {
+    return "Failed to create the output file";
+  }
+
+  btf->forEach([&output_file](std::uint32_t id,
+                              const btfparse::BTFType &btf_type) {
+    output_file << "[" << id << "] "
+                << btfparse::IBTF::getBTFTypeKind(btf_type) << " " << btf_type
+                << "\n";
+
+    return true;
+  });
+
+  output_file.close();
+  if (!output_file) {
+    return "Failed to write the output file";
+  }
+
+  return std::nullopt;
+}
+
+char getChangeSymbol(btfparse::BTFDiffChange change) {
+  switch (change) {
+  case btfparse::BTFDiffChange::Added:
+    return '+';
+
+  case btfparse::BTFDiffChange::Removed:
+    return '-';
+
+  case btfparse::BTFDiffChange::Changed:
+    break;
+  }
+
+  return '~';
+}
+
+// Prints either side of the change, or both of them when they differ
+template <typename Value>
+void printChange(const std::optional<Value> &opt_old_value,
+                 const std::optional<Value> &opt_new_value) {
+  if (opt_old_value.has_value()) {
+    std::cout << opt_old_value.value();
+  }
+
+  if (opt_new_value.has_value() && opt_new_value != opt_old_value) {
+    if (opt_old_value.has_value()) {
+      std::cout << " -> ";
+    }
+
+    std::cout << opt_new_value.value();
+  }
+}
+
+void printMemberDiff(const btfparse::BTFMemberDiff &member_diff) {
+  std::cout << "    " << getChangeSymbol(member_diff.change) << " "
+            << (member_diff.name.empty() ? "<anonymous>" : member_diff.name);
+
+  if (member_diff.opt_old_value.has_value() ||
+      member_diff.opt_new_value.has_value()) {
+    std::cout << " = ";
+    printChange(member_diff.opt_old_value, member_diff.opt_new_value);
+
+  } else {
+    std::cout << " @ bit ";
+    printChange(member_diff.opt_old_offset, member_diff.opt_new_offset);
+
+    if (member_diff.type_changed) {
+      std::cout << ", type changed";
+    }
+  }
+
+  std::cout << "\n";
+}
+
+int printDiff(const std::filesystem::path &old_path,
+              const std::filesystem::path &new_path) {
+  auto old_btf_res = btfparse::IBTF::createFromPath(old_path);
+  if (old_btf_res.failed()) {
+    std::cerr << "Failed to open the BTF file: " << old_btf_res.takeError()
+              << "\n";
+    return 1;
+  }
+
+  auto new_btf_res = btfparse::IBTF::createFromPath(new_path);
+  if (new_btf_res.failed()) {
+    std::cerr << "Failed to open the BTF file: " << new_btf_res.takeError()
+              << "\n";
+    return 1;
+  }
+
+  auto old_btf = old_btf_res.takeValue();
+  auto new_btf = new_btf_res.takeValue();
+
+  auto btf_diff_res = btfparse::IBTFTypeHasher::diff(*old_btf, *new_btf);
+  if (btf_diff_res.failed()) {
+    std::cerr << "Failed to compare the BTF files: "
+              << btf_diff_res.takeError() << "\n";
+    return 1;
+  }
+
+  auto btf_diff = btf_diff_res.takeValue();
+  for (const auto &type_diff : btf_diff) {
+    std::cout << getChangeSymbol(type_diff.change) << " " << type_diff.kind
+              << " " << type_diff.name << " (";
+
+    printChange(type_diff.opt_old_size, type_diff.opt_new_size);
+    std::cout << " bytes)\n";
+
+    for (const auto &member_diff : type_diff.member_diff_list) {
+      printMemberDiff(member_diff);
+    }
+  }
+
+  return 0;
+}
+
+bool printType(std::uint32_t id, const btfparse::BTFTypeView &btf_type_view) {
+  std::cout << "[" << id << "] "
+            << btfparse::IBTF::getBTFTypeKind(btf_type_view) << " "
+            << btf_type_view << "\n";
+
+  return true;
 }
 
 } // namespace
@@ -26,13 +243,148 @@ int main(int argc, char *argv[]) {
     return 0;
   }
 
+  std::optional<std::filesystem::path> opt_snapshot_path;
+  std::optional<std::filesystem::path> opt_save_snapshot_path;
+  std::optional<std::filesystem::path> opt_batch_manifest_path;
+  std::optional<std::size_t> opt_thread_count;
+  bool stream{false};
+  bool stats{false};
+  bool diff{false};
+
   std::vector<std::filesystem::path> path_list;
   for (int i = 1; i < argc; ++i) {
+    if (std::strcmp(argv[i], "--stream") == 0) {
+      stream = true;
+      continue;
+    }
+
+    if (std::strcmp(argv[i], "--stats") == 0) {
+      stats = true;
+      continue;
+    }
+
+    if (std::strcmp(argv[i], "--diff") == 0) {
+      diff = true;
+      continue;
+    }
+
+    if (std::strcmp(argv[i], "--snapshot") == 0 ||
+        std::strcmp(argv[i], "--save-snapshot") == 0) {
+      if (i + 1 >= argc) {
+        showHelp();
+        return 1;
+      }
+
+      auto &opt_path = std::strcmp(argv[i], "--snapshot") == 0
+                           ? opt_snapshot_path
+                           : opt_save_snapshot_path;
+
+      opt_path = argv[++i];
+      continue;
+    }
+
+    if (std::strcmp(argv[i], "--batch") == 0) {
+      if (i + 1 >= argc) {
+        showHelp();
+        return 1;
+      }
+
+      opt_batch_manifest_path = argv[++i];
+      continue;
+    }
+
+    if (std::strcmp(argv[i], "--threads") == 0) {
+      if (i + 1 >= argc) {
+        showHelp();
+        return 1;
+      }
+
+      char *end_ptr{nullptr};
+      auto thread_count = std::strtoul(argv[++i], &end_ptr, 10);
+      if (end_ptr == argv[i] || *end_ptr != 0) {
+        showHelp();
+        return 1;
+      }
+
+      opt_thread_count = static_cast<std::size_t>(thread_count);
+      continue;
+    }
+
     const char *input_path = argv[i];
     path_list.emplace_back(input_path);
   }
 
-  auto btf_res = btfparse::IBTF::createFromPathList(path_list);
+  if (opt_batch_manifest_path.has_value()) {
+    // Each item of the batch is parsed and dumped to its own file
+    if (!path_list.empty() || opt_snapshot_path.has_value() ||
+        opt_save_snapshot_path.has_value() || stream || stats || diff) {
+      showHelp();
+      return 1;
+    }
+
+    BatchManifest manifest;
+    if (!loadBatchManifest(manifest, opt_batch_manifest_path.value())) {
+      return 1;
+    }
+
+    return runBatch(manifest, opt_thread_count.value_or(0), dumpBatchItem);
+  }
+
+  if (diff) {
+    // Takes the old and the new file, without any module
+    if (path_list.size() != 2 || opt_snapshot_path.has_value() ||
+        opt_save_snapshot_path.has_value() || stream || stats ||
+        opt_thread_count.has_value()) {
+      showHelp();
+      return 1;
+    }
+
+    return printDiff(path_list[0], path_list[1]);
+  }
+
+  if (opt_snapshot_path.has_value() == !path_list.empty()) {
+    showHelp();
+    return 1;
+  }
+
+  // Snapshots and streaming parses do not take any options
+  if (stats && (stream || opt_snapshot_path.has_value())) {
+    showHelp();
+    return 1;
+  }
+
+  if (stats && !btfparse::IBTF::isTelemetryEnabled()) {
+    std::cerr << "btfparse was built without BTFPARSE_ENABLE_TELEMETRY\n";
+    return 1;
+  }
+
+  if (stream) {
+    if (opt_snapshot_path.has_value() || opt_save_snapshot_path.has_value()) {
+      showHelp();
+      return 1;
+    }
+
+    auto opt_error = btfparse::IBTF::parseFromPathList(path_list, printType);
+    if (opt_error.has_value()) {
+      std::cerr << "Failed to parse the BTF file: " << opt_error.value()
+                << "\n";
+      return 1;
+    }
+
+    return 0;
+  }
+
+  btfparse::BTFOptions options;
+  if (opt_thread_count.has_value()) {
+    options.thread_count = opt_thread_count.value();
+  }
+
+  if (stats) {
+    options.trace_callback = printPhase;
+    options.stats_callback = printParseStats;
+  }
+
+  auto btf_res = openBTF(opt_snapshot_path, path_list, options);
   if (btf_res.failed()) {
     std::cerr << "Failed to open the BTF file: " << btf_res.takeError() << "\n";
     return 1;
@@ -44,13 +396,25 @@ int main(int argc, char *argv[]) {
     return 1;
   }
 
-  for (const auto &btf_type_map_p : btf->getAll()) {
-    const auto &id = btf_type_map_p.first;
-    const auto &btf_type = btf_type_map_p.second;
+  if (opt_save_snapshot_path.has_value()) {
+    auto opt_error = btfparse::IBTF::saveSnapshot(
+        *btf.get(), opt_save_snapshot_path.value());
+
+    if (opt_error.has_value()) {
+      std::cerr << "Failed to save the snapshot: " << opt_error.value()
+                << "\n";
+      return 1;
+    }
 
+    return 0;
+  }
+
+  btf->forEach([](std::uint32_t id, const btfparse::BTFType &btf_type) {
     std::cout << "[" << id << "] " << btfparse::IBTF::getBTFTypeKind(btf_type)
               << " " << btf_type << "\n";
-  }
+
+    return true;
+  });
 
   return 0;
 }
@@ -15,8 +15,10 @@ namespace {
 template <typename Type>
 void printStructOrUnionBTFType(std::ostream &stream, const Type &type) {
   static_assert(std::is_same<Type, btfparse::StructBTFType>::value ||
-                    std::is_same<Type, btfparse::UnionBTFType>::value,
-                "Type must be either StructBTFType or UnionBTFType");
+                    std::is_same<Type, btfparse::UnionBTFType>::value ||
+                    std::is_same<Type, btfparse::StructBTFTypeView>::value ||
+                    std::is_same<Type, btfparse::UnionBTFTypeView>::value,
+                "Type must be a struct or union type (or view)");
 
   stream << "'"
          << (type.opt_name.has_value() ? type.opt_name.value() : "(anon)")
@@ -81,14 +83,24 @@ std::ostream &operator<<(std::ostream &stream,
   return stream;
 }
 
-std::ostream &operator<<(std::ostream &stream,
-                         const btfparse::IntBTFType &type) {
+template <typename Type>
+void printIntBTFType(std::ostream &stream, const Type &type) {
   stream << "'" << type.name << "' "
          << "size=" << type.size << " "
          << "bits_offset=" << static_cast<int>(type.offset) << " "
          << "nr_bits=" << static_cast<int>(type.bits) << " "
          << "encoding=" << type.encoding;
+}
+
+std::ostream &operator<<(std::ostream &stream,
+                         const btfparse::IntBTFType &type) {
+  printIntBTFType(stream, type);
+  return stream;
+}
 
+std::ostream &operator<<(std::ostream &stream,
+                         const btfparse::IntBTFTypeView &type) {
+  printIntBTFType(stream, type);
   return stream;
 }
 
@@ -118,16 +130,26 @@ std::ostream &operator<<(std::ostream &stream,
   return stream;
 }
 
-std::ostream &operator<<(std::ostream &stream,
-                         const btfparse::TypedefBTFType &type) {
+template <typename Type>
+void printTypedefBTFType(std::ostream &stream, const Type &type) {
   stream << "'" << type.name << "' "
          << "type_id=" << type.type;
+}
 
+std::ostream &operator<<(std::ostream &stream,
+                         const btfparse::TypedefBTFType &type) {
+  printTypedefBTFType(stream, type);
   return stream;
 }
 
 std::ostream &operator<<(std::ostream &stream,
-                         const btfparse::EnumBTFType &type) {
+                         const btfparse::TypedefBTFTypeView &type) {
+  printTypedefBTFType(stream, type);
+  return stream;
+}
+
+template <typename Type>
+void printEnumBTFType(std::ostream &stream, const Type &type) {
   stream << "'"
          << (type.opt_name.has_value() ? type.opt_name.value() : "(anon)")
          << "' "
@@ -151,7 +173,17 @@ std::ostream &operator<<(std::ostream &stream,
       stream << "\n";
     }
   }
+}
+
+std::ostream &operator<<(std::ostream &stream,
+                         const btfparse::EnumBTFType &type) {
+  printEnumBTFType(stream, type);
+  return stream;
+}
 
+std::ostream &operator<<(std::ostream &stream,
+                         const btfparse::EnumBTFTypeView &type) {
+  printEnumBTFType(stream, type);
   return stream;
 }
 
@@ -160,9 +192,8 @@ std::ostream &operator<<(std::ostream &stream,
 // `is_variadic` flag in the object.
 //
 // Retain this behavior when outputting data in bptftool format
-std::ostream &operator<<(std::ostream &stream,
-                         const btfparse::FuncProtoBTFType &type) {
-
+template <typename Type>
+void printFuncProtoBTFType(std::ostream &stream, const Type &type) {
   auto vlen = type.param_list.size();
   if (type.is_variadic) {
     ++vlen;
@@ -197,7 +228,17 @@ std::ostream &operator<<(std::ostream &stream,
 
     stream << "\t'(anon)' type_id=0";
   }
+}
+
+std::ostream &operator<<(std::ostream &stream,
+                         const btfparse::FuncProtoBTFType &type) {
+  printFuncProtoBTFType(stream, type);
+  return stream;
+}
 
+std::ostream &operator<<(std::ostream &stream,
+                         const btfparse::FuncProtoBTFTypeView &type) {
+  printFuncProtoBTFType(stream, type);
   return stream;
 }
 
@@ -215,6 +256,12 @@ std::ostream &operator<<(std::ostream &stream,
   return stream;
 }
 
+std::ostream &operator<<(std::ostream &stream,
+                         const btfparse::StructBTFTypeView &type) {
+  printStructOrUnionBTFType(stream, type);
+  return stream;
+}
+
 std::ostream &operator<<(std::ostream &stream,
                          const btfparse::UnionBTFType &type) {
   printStructOrUnionBTFType(stream, type);
@@ -222,18 +269,44 @@ std::ostream &operator<<(std::ostream &stream,
 }
 
 std::ostream &operator<<(std::ostream &stream,
-                         const btfparse::FwdBTFType &type) {
+                         const btfparse::UnionBTFTypeView &type) {
+  printStructOrUnionBTFType(stream, type);
+  return stream;
+}
+
+template <typename Type>
+void printFwdBTFType(std::ostream &stream, const Type &type) {
   stream << "'" << type.name << "' "
          << "fwd_kind=" << (type.is_union ? "union" : "struct");
+}
 
+std::ostream &operator<<(std::ostream &stream,
+                         const btfparse::FwdBTFType &type) {
+  printFwdBTFType(stream, type);
   return stream;
 }
 
 std::ostream &operator<<(std::ostream &stream,
-                         const btfparse::FloatBTFType &type) {
+                         const btfparse::FwdBTFTypeView &type) {
+  printFwdBTFType(stream, type);
+  return stream;
+}
+
+template <typename Type>
+void printFloatBTFType(std::ostream &stream, const Type &type) {
   stream << "'" << type.name << "' "
          << "size=" << type.size;
+}
+
+std::ostream &operator<<(std::ostream &stream,
+                         const btfparse::FloatBTFType &type) {
+  printFloatBTFType(stream, type);
+  return stream;
+}
 
+std::ostream &operator<<(std::ostream &stream,
+                         const btfparse::FloatBTFTypeView &type) {
+  printFloatBTFType(stream, type);
   return stream;
 }
 
@@ -245,8 +318,8 @@ std::ostream &operator<<(std::ostream &stream,
   return stream;
 }
 
-std::ostream &operator<<(std::ostream &stream,
-                         const btfparse::VarBTFType &type) {
+template <typename Type>
+void printVarBTFType(std::ostream &stream, const Type &type) {
   stream << "'" << type.name << "' "
          << "type_id=" << type.type << ", "
          << "linkage=";
@@ -263,12 +336,22 @@ std::ostream &operator<<(std::ostream &stream,
   default:
     stream << type.linkage;
   }
+}
 
+std::ostream &operator<<(std::ostream &stream,
+                         const btfparse::VarBTFType &type) {
+  printVarBTFType(stream, type);
   return stream;
 }
 
 std::ostream &operator<<(std::ostream &stream,
-                         const btfparse::DataSecBTFType &type) {
+                         const btfparse::VarBTFTypeView &type) {
+  printVarBTFType(stream, type);
+  return stream;
+}
+
+template <typename Type>
+void printDataSecBTFType(std::ostream &stream, const Type &type) {
   stream << "'" << type.name << "' "
          << "size=" << type.size << " "
          << "vlen=" << type.variable_list.size();
@@ -289,7 +372,17 @@ std::ostream &operator<<(std::ostream &stream,
       stream << "\n";
     }
   }
+}
+
+std::ostream &operator<<(std::ostream &stream,
+                         const btfparse::DataSecBTFType &type) {
+  printDataSecBTFType(stream, type);
+  return stream;
+}
 
+std::ostream &operator<<(std::ostream &stream,
+                         const btfparse::DataSecBTFTypeView &type) {
+  printDataSecBTFType(stream, type);
   return stream;
 }
 
@@ -312,12 +405,22 @@ std::ostream &operator<<(std::ostream &stream,
   return stream;
 }
 
-std::ostream &operator<<(std::ostream &stream,
-                         const btfparse::FuncBTFType &type) {
+template <typename Type>
+void printFuncBTFType(std::ostream &stream, const Type &type) {
   stream << "'" << type.name << "' "
          << "type_id=" << type.type << " "
          << "linkage=" << type.linkage;
+}
+
+std::ostream &operator<<(std::ostream &stream,
+                         const btfparse::FuncBTFType &type) {
+  printFuncBTFType(stream, type);
+  return stream;
+}
 
+std::ostream &operator<<(std::ostream &stream,
+                         const btfparse::FuncBTFTypeView &type) {
+  printFuncBTFType(stream, type);
   return stream;
 }
 
@@ -476,4 +579,82 @@ std::ostream &operator<<(std::ostream &stream, const btfparse::BTFType &type) {
   }
 
   return stream;
-}
\ No newline at end of file
+}
+
+std::ostream &operator<<(std::ostream &stream,
+                         const btfparse::BTFTypeView &type) {
+  switch (btfparse::IBTF::getBTFTypeKind(type)) {
+  case btfparse::BTFKind::Void:
+    break;
+
+  case btfparse::BTFKind::Int:
+    stream << std::get<btfparse::IntBTFTypeView>(type);
+    break;
+
+  case btfparse::BTFKind::Ptr:
+    stream << std::get<btfparse::PtrBTFType>(type);
+    break;
+
+  case btfparse::BTFKind::Array:
+    stream << std::get<btfparse::ArrayBTFType>(type);
+    break;
+
+  case btfparse::BTFKind::Struct:
+    stream << std::get<btfparse::StructBTFTypeView>(type);
+    break;
+
+  case btfparse::BTFKind::Union:
+    stream << std::get<btfparse::UnionBTFTypeView>(type);
+    break;
+
+  case btfparse::BTFKind::Enum:
+    stream << std::get<btfparse::EnumBTFTypeView>(type);
+    break;
+
+  case btfparse::BTFKind::Fwd:
+    stream << std::get<btfparse::FwdBTFTypeView>(type);
+    break;
+
+  case btfparse::BTFKind::Typedef:
+    stream << std::get<btfparse::TypedefBTFTypeView>(type);
+    break;
+
+  case btfparse::BTFKind::Volatile:
+    stream << std::get<btfparse::VolatileBTFType>(type);
+    break;
+
+  case btfparse::BTFKind::Const:
+    stream << std::get<btfparse::ConstBTFType>(type);
+    break;
+
+  case btfparse::BTFKind::Restrict:
+    stream << std::get<btfparse::RestrictBTFType>(type);
+    break;
+
+  case btfparse::BTFKind::Func:
+    stream << std::get<btfparse::FuncBTFTypeView>(type);
+    break;
+
+  case btfparse::BTFKind::FuncProto:
+    stream << std::get<btfparse::FuncProtoBTFTypeView>(type);
+    break;
+
+  case btfparse::BTFKind::Var:
+    stream << std::get<btfparse::VarBTFTypeView>(type);
+    break;
+
+  case btfparse::BTFKind::DataSec:
+    stream << std::get<btfparse::DataSecBTFTypeView>(type);
+    break;
+
+  case btfparse::BTFKind::Float:
+    stream << std::get<btfparse::FloatBTFTypeView>(type);
+    break;
+
+  default:
+    stream << "Unknown";
+    break;
+  }
+
+  return stream;
+}
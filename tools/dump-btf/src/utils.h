@@ -14,3 +14,6 @@
 
 std::ostream &operator<<(std::ostream &stream, btfparse::BTFKind kind);
 std::ostream &operator<<(std::ostream &stream, const btfparse::BTFType &type);
+
+std::ostream &operator<<(std::ostream &stream,
+                         const btfparse::BTFTypeView &type);
@@ -6,11 +6,18 @@
 // the LICENSE file found in the root directory of this source tree.
 //
 
+#include "batch.h"
+
 #include <algorithm>
+#include <chrono>
+#include <cstdlib>
 #include <cstring>
+#include <fstream>
 #include <iostream>
+#include <optional>
 #include <sstream>
 
+#include <btfparse/ibtfheadercache.h>
 #include <btfparse/ibtfheadergenerator.h>
 
 namespace {
@@ -19,7 +26,152 @@ void showHelp() {
   std::cerr
       << "Usage:\n"
       << "\tinclude-gen /sys/kernel/btf/vmlinux\n"
-      << "\tinclude-gen /sys/kernel/btf/vmlinux [/sys/kernel/btf/btusb]\n";
+      << "\tinclude-gen /sys/kernel/btf/vmlinux [/sys/kernel/btf/btusb]\n"
+      << "\tinclude-gen --type task_struct [--type ...] "
+         "/sys/kernel/btf/vmlinux\n"
+      << "\tinclude-gen --cache-dir ~/.cache/btfparse "
+         "/sys/kernel/btf/vmlinux\n"
+      << "\tinclude-gen --batch manifest.txt [--threads <count>]\n\n"
+      << "Options:\n"
+      << "\t--type <name>       Only emit the given type and its "
+         "dependencies.\n"
+      << "\t                    Can be repeated\n"
+      << "\t--cache-dir <path>  Reuse the headers previously generated "
+         "for the\n"
+      << "\t                    same BTF files and options\n"
+      << "\t--threads <count>   Render the declarations with the given "
+         "number\n"
+      << "\t                    of threads, or 0 to use one per core\n"
+      << "\t--batch <path>      Generate the headers listed in a manifest, "
+         "one\n"
+      << "\t                    '<output> <base> [<module> ...]' line per "
+         "header.\n"
+      << "\t                    --threads sets the size of the shared "
+         "worker\n"
+      << "\t                    pool, and defaults to one thread per core\n"
+      << "\t--stats             Print the parse and generation statistics "
+         "to\n"
+      << "\t                    stderr (needs btfparse to be built with "
+         "telemetry)\n"
+      << "\t--dedup             Merge the structurally equivalent types of "
+         "all\n"
+      << "\t                    the BTF files before generating the "
+         "header\n";
+}
+
+double toMilliseconds(std::chrono::nanoseconds duration) {
+  return std::chrono::duration<double, std::milli>(duration).count();
+}
+
+void printPhase(std::string_view phase, std::chrono::nanoseconds duration) {
+  std::cerr << "[trace] " << phase << ": " << toMilliseconds(duration)
+            << " ms\n";
+}
+
+void printParseStats(const btfparse::BTFParseStats &stats) {
+  std::uint64_t type_count{};
+  for (const auto &kind_stats : stats.kind_stats_list) {
+    type_count += kind_stats.type_count;
+  }
+
+  std::cerr << "Bytes read: " << stats.bytes_read << "\n"
+            << "String lookups: " << stats.string_lookup_count << "\n"
+            << "Types: " << type_count << "\n"
+            << "Parse time: " << toMilliseconds(stats.parse_time) << " ms\n";
+}
+
+void printGeneratorStats(const btfparse::BTFHeaderGeneratorStats &stats) {
+  std::cerr << "Header size: " << stats.output_size << "\n"
+            << "Generation time: " << toMilliseconds(stats.generation_time)
+            << " ms\n";
+}
+
+int generateCachedHeader(const std::filesystem::path &cache_directory,
+                         const std::vector<std::filesystem::path> &path_list,
+                         const btfparse::BTFHeaderGeneratorOptions &options) {
+  auto header_cache_res = btfparse::IBTFHeaderCache::create(cache_directory);
+  if (header_cache_res.failed()) {
+    std::cerr << "Failed to open the header cache: "
+              << header_cache_res.takeError() << "\n";
+    return 1;
+  }
+
+  auto header_cache = header_cache_res.takeValue();
+
+  auto opt_error = header_cache->generate(std::cout, path_list, options);
+  if (opt_error.has_value()) {
+    std::cerr << "Failed to generate the header: " << opt_error.value()
+              << "\n";
+    return 1;
+  }
+
+  std::cout << "\n";
+  return 0;
+}
+
+std::optional<std::string> generateBatchHeader(
+    const BatchItem &item,
+    const std::optional<std::filesystem::path> &opt_cache_directory,
+    const btfparse::BTFHeaderGeneratorOptions &options,
+    btfparse::IBTFWorkerPool &worker_pool) {
+
+  std::ofstream output_file(item.output_path);
+  if (!output_file) {
+    return "Failed to create the output file";
+  }
+
+  // The parse and the rendering of the declarations both run their tasks
+  // on the pool, where the idle workers can steal them
+  auto btf_options = getBatchOptions(worker_pool);
+
+  auto item_options = options;
+  item_options.thread_count = btf_options.thread_count;
+  item_options.executor = btf_options.executor;
+
+  if (opt_cache_directory.has_value()) {
+    auto header_cache_res =
+        btfparse::IBTFHeaderCache::create(opt_cache_directory.value());
+    if (header_cache_res.failed()) {
+      return "Failed to open the header cache: " +
+             header_cache_res.takeError().toString();
+    }
+
+    auto header_cache = header_cache_res.takeValue();
+
+    auto opt_error =
+        header_cache->generate(output_file, item.path_list, item_options);
+    if (opt_error.has_value()) {
+      return "Failed to generate the header: " + opt_error->toString();
+    }
+
+  } else {
+    auto btf_res =
+        btfparse::IBTF::createFromPathList(item.path_list, btf_options);
+
+    if (btf_res.failed()) {
+      return "Failed to open the BTF file: " + btf_res.takeError().toString();
+    }
+
+    auto btf = btf_res.takeValue();
+    if (btf->count() == 0) {
+      return "No types were found!";
+    }
+
+    auto header_generator = btfparse::IBTFHeaderGenerator::create();
+    if (header_generator == nullptr ||
+        !header_generator->generate(output_file, btf, item_options)) {
+      return "Failed to generate the header";
+    }
+  }
+
+  output_file << "\n";
+  output_file.close();
+
+  if (!output_file) {
+    return "Failed to write the output file";
+  }
+
+  return std::nullopt;
 }
 
 } // namespace
@@ -30,13 +182,131 @@ int main(int argc, char *argv[]) {
     return 0;
   }
 
+  btfparse::BTFHeaderGeneratorOptions options;
+  std::optional<std::filesystem::path> opt_cache_directory;
+  std::optional<std::filesystem::path> opt_batch_manifest_path;
+  std::optional<std::size_t> opt_thread_count;
+  bool stats{false};
+  bool dedup{false};
+
   std::vector<std::filesystem::path> path_list;
   for (int i = 1; i < argc; ++i) {
+    if (std::strcmp(argv[i], "--type") == 0) {
+      if (i + 1 >= argc) {
+        showHelp();
+        return 1;
+      }
+
+      options.root_type_name_list.emplace_back(argv[++i]);
+      continue;
+    }
+
+    if (std::strcmp(argv[i], "--cache-dir") == 0 ||
+        std::strcmp(argv[i], "--batch") == 0) {
+      if (i + 1 >= argc) {
+        showHelp();
+        return 1;
+      }
+
+      auto &opt_path = std::strcmp(argv[i], "--cache-dir") == 0
+                           ? opt_cache_directory
+                           : opt_batch_manifest_path;
+
+      opt_path = argv[++i];
+      continue;
+    }
+
+    if (std::strcmp(argv[i], "--stats") == 0) {
+      stats = true;
+      continue;
+    }
+
+    if (std::strcmp(argv[i], "--dedup") == 0) {
+      dedup = true;
+      continue;
+    }
+
+    if (std::strcmp(argv[i], "--threads") == 0) {
+      if (i + 1 >= argc) {
+        showHelp();
+        return 1;
+      }
+
+      char *end_ptr{nullptr};
+      auto thread_count = std::strtoul(argv[++i], &end_ptr, 10);
+      if (end_ptr == argv[i] || *end_ptr != 0) {
+        showHelp();
+        return 1;
+      }
+
+      opt_thread_count = static_cast<std::size_t>(thread_count);
+      continue;
+    }
+
     const char *input_path = argv[i];
     path_list.emplace_back(input_path);
   }
 
-  auto btf_res = btfparse::IBTF::createFromPathList(path_list);
+  if (path_list.empty() == !opt_batch_manifest_path.has_value()) {
+    showHelp();
+    return 1;
+  }
+
+  // Cache hits do not parse anything, and batches would interleave the
+  // statistics of all their items
+  if (stats && (opt_cache_directory.has_value() ||
+                opt_batch_manifest_path.has_value())) {
+    showHelp();
+    return 1;
+  }
+
+  // The cache entries are only keyed by the generator options
+  if (dedup && (opt_cache_directory.has_value() ||
+                opt_batch_manifest_path.has_value())) {
+    showHelp();
+    return 1;
+  }
+
+  if (stats && !btfparse::IBTF::isTelemetryEnabled()) {
+    std::cerr << "btfparse was built without BTFPARSE_ENABLE_TELEMETRY\n";
+    return 1;
+  }
+
+  if (opt_batch_manifest_path.has_value()) {
+    BatchManifest manifest;
+    if (!loadBatchManifest(manifest, opt_batch_manifest_path.value())) {
+      return 1;
+    }
+
+    return runBatch(
+        manifest, opt_thread_count.value_or(0),
+        [&](const BatchItem &item, btfparse::IBTFWorkerPool &worker_pool) {
+          return generateBatchHeader(item, opt_cache_directory, options,
+                                     worker_pool);
+        });
+  }
+
+  if (opt_thread_count.has_value()) {
+    options.thread_count = opt_thread_count.value();
+  }
+
+  if (opt_cache_directory.has_value()) {
+    return generateCachedHeader(opt_cache_directory.value(), path_list,
+                                options);
+  }
+
+  btfparse::BTFOptions btf_options;
+  btf_options.deduplicate = dedup;
+
+  if (stats) {
+    btf_options.trace_callback = printPhase;
+    btf_options.stats_callback = printParseStats;
+
+    options.trace_callback = printPhase;
+    options.stats_callback = printGeneratorStats;
+  }
+
+  auto btf_res = btfparse::IBTF::createFromPathList(path_list, btf_options);
   if (btf_res.failed()) {
     std::cerr << "Failed to open the BTF file: " << btf_res.takeError() << "\n";
     return 1;
@@ -50,12 +320,13 @@ int main(int argc, char *argv[]) {
 
   auto header_generator = btfparse::IBTFHeaderGenerator::create();
 
-  std::string header;
-  if (!header_generator->generate(header, btf)) {
+  // Write each declaration as soon as it is ready, instead of keeping the
+  // whole header in memory
+  if (!header_generator->generate(std::cout, btf, options)) {
     std::cerr << "Failed to generate the header\n";
     return 1;
   }
 
-  std::cout << header << "\n";
+  std::cout << "\n";
   return 0;
 }